@@ -31,6 +31,8 @@
 
 namespace AK {
 
+// Reads bits least significant first. Up to eight bytes are read ahead from the underlying
+// stream to keep the bit buffer full; read() hands out those bytes before reading any more.
 class InputBitStream final : public InputStream {
 public:
     explicit InputBitStream(InputStream& stream)
@@ -38,19 +40,19 @@ public:
     {
     }
 
+    // Reading whole bytes first drops the remaining bits of a partially read byte.
     size_t read(Bytes bytes) override
     {
         if (has_any_error())
             return 0;
 
-        size_t nread = 0;
-        if (bytes.size() >= 1) {
-            if (m_next_byte.has_value()) {
-                bytes[0] = m_next_byte.value();
-                m_next_byte.clear();
+        align_to_byte_boundary();
 
-                ++nread;
-            }
+        size_t nread = 0;
+        while (nread < bytes.size() && m_bit_count > 0) {
+            bytes[nread++] = static_cast<u8>(m_bit_buffer);
+            m_bit_buffer >>= 8;
+            m_bit_count -= 8;
         }
 
         return nread + m_stream.read(bytes.slice(nread));
@@ -66,61 +68,164 @@ public:
         return true;
     }
 
-    bool unreliable_eof() const override { return !m_next_byte.has_value() && m_stream.unreliable_eof(); }
+    bool unreliable_eof() const override { return m_bit_count == 0 && m_stream.unreliable_eof(); }
 
     bool discard_or_error(size_t count) override
     {
-        if (count >= 1) {
-            if (m_next_byte.has_value()) {
-                m_next_byte.clear();
-                --count;
-            }
+        align_to_byte_boundary();
+
+        while (count > 0 && m_bit_count > 0) {
+            m_bit_buffer >>= 8;
+            m_bit_count -= 8;
+            --count;
         }
 
         return m_stream.discard_or_error(count);
     }
 
-    u32 read_bits(size_t count)
+    // Makes `count` bits available to peek_bits(); returns false if the stream ends before that.
+    bool ensure_bits(size_t count)
     {
-        u32 result = 0;
+        VERIFY(count <= 32);
 
-        size_t nread = 0;
-        while (nread < count) {
-            if (m_stream.has_any_error()) {
-                set_fatal_error();
-                return 0;
-            }
-
-            if (m_next_byte.has_value()) {
-                const auto bit = (m_next_byte.value() >> m_bit_offset) & 1;
-                result |= bit << nread;
-                ++nread;
-
-                if (m_bit_offset++ == 7)
-                    m_next_byte.clear();
-            } else {
-                m_stream >> m_next_byte;
-                m_bit_offset = 0;
-            }
+        if (m_bit_count < count)
+            refill();
+
+        return m_bit_count >= count;
+    }
+
+    // Bits past the end of the stream read as zero.
+    u32 peek_bits(size_t count) const { return static_cast<u32>(m_bit_buffer & ((1ull << count) - 1)); }
+
+    void discard_bits(size_t count)
+    {
+        if (count > m_bit_count) {
+            set_fatal_error();
+            m_bit_buffer = 0;
+            m_bit_count = 0;
+            return;
+        }
+
+        m_bit_buffer >>= count;
+        m_bit_count -= count;
+    }
+
+    u32 read_bits(size_t count)
+    {
+        if (!ensure_bits(count)) {
+            set_fatal_error();
+            return 0;
         }
 
+        const auto result = peek_bits(count);
+        discard_bits(count);
         return result;
     }
 
     bool read_bit() { return static_cast<bool>(read_bits(1)); }
 
+    void align_to_byte_boundary() { discard_bits(m_bit_count % 8); }
+
+private:
+    void refill()
+    {
+        u8 bytes[8];
+        const auto nread = m_stream.read({ bytes, (64 - m_bit_count) / 8 });
+
+        for (size_t i = 0; i < nread; ++i) {
+            m_bit_buffer |= static_cast<u64>(bytes[i]) << m_bit_count;
+            m_bit_count += 8;
+        }
+    }
+
+    u64 m_bit_buffer { 0 };
+    size_t m_bit_count { 0 };
+    InputStream& m_stream;
+};
+
+class OutputBitStream final : public OutputStream {
+public:
+    explicit OutputBitStream(OutputStream& stream)
+        : m_stream(stream)
+    {
+    }
+
+    ~OutputBitStream()
+    {
+        align_to_byte_boundary();
+    }
+
+    size_t write(ReadonlyBytes bytes) override
+    {
+        if (has_any_error())
+            return 0;
+
+        align_to_byte_boundary();
+        if (has_fatal_error())
+            return 0;
+
+        return m_stream.write(bytes);
+    }
+
+    bool write_or_error(ReadonlyBytes bytes) override
+    {
+        if (write(bytes) < bytes.size()) {
+            set_fatal_error();
+            return false;
+        }
+
+        return true;
+    }
+
+    // Writes the lowest `count` bits of `value`, least significant bit first.
+    void write_bits(u32 value, size_t count)
+    {
+        VERIFY(count <= 32);
+        VERIFY(count == 32 || value < (1u << count));
+
+        m_bit_buffer |= static_cast<u64>(value) << m_bit_count;
+        m_bit_count += count;
+
+        if (m_bit_count >= 32) {
+            const u8 bytes[4] { static_cast<u8>(m_bit_buffer), static_cast<u8>(m_bit_buffer >> 8), static_cast<u8>(m_bit_buffer >> 16), static_cast<u8>(m_bit_buffer >> 24) };
+            write_to_stream({ bytes, sizeof(bytes) });
+            m_bit_buffer >>= 32;
+            m_bit_count -= 32;
+        }
+    }
+
+    void write_bit(bool bit) { write_bits(bit, 1); }
+
+    // Pads the last byte with zero bits and writes out everything buffered so far.
     void align_to_byte_boundary()
     {
-        if (m_next_byte.has_value())
-            m_next_byte.clear();
+        u8 bytes[5];
+        size_t count = 0;
+        while (m_bit_count > 0) {
+            bytes[count++] = static_cast<u8>(m_bit_buffer);
+            m_bit_buffer >>= 8;
+            m_bit_count = m_bit_count > 8 ? m_bit_count - 8 : 0;
+        }
+        m_bit_buffer = 0;
+        if (count > 0)
+            write_to_stream({ bytes, count });
     }
 
+    size_t bit_offset() const { return m_bit_count % 8; }
+
 private:
-    Optional<u8> m_next_byte;
-    size_t m_bit_offset { 0 };
-    InputStream& m_stream;
+    void write_to_stream(ReadonlyBytes bytes)
+    {
+        if (!m_stream.write_or_error(bytes))
+            set_fatal_error();
+    }
+
+    u64 m_bit_buffer { 0 };
+    size_t m_bit_count { 0 };
+    OutputStream& m_stream;
 };
 
 }
 
 using AK::InputBitStream;
+using AK::OutputBitStream;
@@ -31,18 +31,19 @@
 
 namespace AK {
 
-// FIXME: There are a lot of raw loops here, that's not necessary an issue but it
-//        has to be verified that the optimizer is able to insert memcpy instead.
 template<size_t Capacity>
-class CircularDuplexStream : public AK::DuplexStream {
+class CircularDuplexStream final : public AK::DuplexStream {
 public:
     size_t write(ReadonlyBytes bytes) override
     {
         const auto nwritten = min(bytes.size(), Capacity - m_queue.size());
 
-        for (size_t idx = 0; idx < nwritten; ++idx)
-            m_queue.enqueue(bytes[idx]);
+        const auto tail = (m_queue.head_index() + m_queue.size()) % Capacity;
+        const auto first_part = min(nwritten, Capacity - tail);
+        __builtin_memcpy(m_queue.m_storage + tail, bytes.data(), first_part);
+        __builtin_memcpy(m_queue.m_storage, bytes.data() + first_part, nwritten - first_part);
 
+        m_queue.m_size += nwritten;
         m_total_written += nwritten;
         return nwritten;
     }
@@ -66,9 +67,13 @@ public:
 
         const auto nread = min(bytes.size(), m_queue.size());
 
-        for (size_t idx = 0; idx < nread; ++idx)
-            bytes[idx] = m_queue.dequeue();
+        const auto head = m_queue.head_index();
+        const auto first_part = min(nread, Capacity - head);
+        __builtin_memcpy(bytes.data(), m_queue.m_storage + head, first_part);
+        __builtin_memcpy(bytes.data() + first_part, m_queue.m_storage, nread - first_part);
 
+        m_queue.m_head = (head + nread) % Capacity;
+        m_queue.m_size -= nread;
         return nread;
     }
 
@@ -89,6 +94,44 @@ public:
         return nread;
     }
 
+    // Appends `length` bytes starting `seekback` bytes before the end of what has been written, like an
+    // LZ77 back-reference: if the two ranges overlap, the last `seekback` bytes are repeated.
+    size_t copy_from_seekback(size_t seekback, size_t length)
+    {
+        if (seekback == 0 || seekback > Capacity || seekback > m_total_written) {
+            set_recoverable_error();
+            return 0;
+        }
+
+        const auto ncopied = min(length, Capacity - m_queue.size());
+        auto* storage = m_queue.m_storage;
+        auto destination = (m_queue.head_index() + m_queue.size()) % Capacity;
+        auto source = (destination + Capacity - seekback) % Capacity;
+
+        for (size_t remaining = ncopied; remaining > 0;) {
+            const auto chunk = min(remaining, min(Capacity - source, Capacity - destination));
+
+            if (destination <= source || destination - source >= chunk) {
+                __builtin_memmove(storage + destination, storage + source, chunk);
+            } else {
+                // Every copy doubles the length of the pattern that is already in place.
+                for (size_t copied = 0; copied < chunk;) {
+                    const auto count = min(chunk - copied, destination + copied - source);
+                    __builtin_memcpy(storage + destination + copied, storage + source, count);
+                    copied += count;
+                }
+            }
+
+            source = (source + chunk) % Capacity;
+            destination = (destination + chunk) % Capacity;
+            remaining -= chunk;
+        }
+
+        m_queue.m_size += ncopied;
+        m_total_written += ncopied;
+        return ncopied;
+    }
+
     bool read_or_error(Bytes bytes) override
     {
         if (m_queue.size() < bytes.size()) {
@@ -107,14 +150,15 @@ public:
             return false;
         }
 
-        for (size_t idx = 0; idx < count; ++idx)
-            m_queue.dequeue();
+        m_queue.m_head = (m_queue.head_index() + count) % Capacity;
+        m_queue.m_size -= count;
 
         return true;
     }
 
     bool unreliable_eof() const override { return eof(); }
     bool eof() const { return m_queue.size() == 0; }
+    size_t size() const { return m_queue.size(); }
 
     size_t remaining_contigous_space() const
     {
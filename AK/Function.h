@@ -111,7 +111,7 @@ private:
         }
 
     private:
-        CallableType m_callable;
+        mutable CallableType m_callable;
     };
 
     OwnPtr<CallableWrapperBase> m_callable_wrapper;
@@ -27,13 +27,14 @@
 #pragma once
 
 #include <AK/StdLibExtras.h>
+#include <AK/Types.h>
 
 namespace AK {
 
 /* This is a dual pivot quick sort. It is quite a bit faster than the single
- * pivot quick_sort below. The other quick_sort below should only be used when
- * you are stuck with simple iterators to a container and you don't have access
- * to the container itself.
+ * pivot quick sort below, but neither of them protects against quadratic
+ * behaviour on adversarial input; quick_sort() uses the pattern-defeating quick
+ * sort further down instead.
  */
 template<typename Collection, typename LessThan>
 void dual_pivot_quick_sort(Collection& col, int start, int end, LessThan less_than)
@@ -120,28 +121,298 @@ void single_pivot_quick_sort(Iterator start, Iterator end, LessThan less_than)
     }
 }
 
+namespace Detail {
+
+// Ranges up to this size are finished off with an insertion sort.
+static constexpr size_t pdq_insertion_sort_threshold = 24;
+// Ranges larger than this pick their pivot as the median of three medians of three.
+static constexpr size_t pdq_ninther_threshold = 128;
+// How far partial_insertion_sort() may move elements in total before giving up.
+static constexpr size_t pdq_partial_insertion_sort_limit = 8;
+
+// Moves col[i] left into the sorted range [start, i), returning where it ended up.
+template<typename Collection, typename LessThan>
+size_t insert_into_sorted_range(Collection& col, size_t start, size_t i, LessThan& less_than)
+{
+    size_t j = i;
+    if constexpr (IsLvalueReference<decltype(col[i])>::value) {
+        if (!less_than(col[i], col[i - 1]))
+            return i;
+        auto value = move(col[i]);
+        do {
+            col[j] = move(col[j - 1]);
+            --j;
+        } while (j > start && less_than(value, col[j - 1]));
+        col[j] = move(value);
+    } else {
+        // Proxy objects (like the ones qsort() uses) can only be swapped.
+        for (; j > start && less_than(col[j], col[j - 1]); --j)
+            swap(col[j], col[j - 1]);
+    }
+    return j;
+}
+
+template<typename Collection, typename LessThan>
+void insertion_sort(Collection& col, size_t start, size_t end, LessThan& less_than)
+{
+    for (size_t i = start + 1; i < end; ++i)
+        insert_into_sorted_range(col, start, i, less_than);
+}
+
+// Like insertion_sort(), but gives up (returning false) once the range turns out to be
+// more than slightly out of order.
+template<typename Collection, typename LessThan>
+bool partial_insertion_sort(Collection& col, size_t start, size_t end, LessThan& less_than)
+{
+    size_t moves = 0;
+    for (size_t i = start + 1; i < end; ++i) {
+        moves += i - insert_into_sorted_range(col, start, i, less_than);
+        if (moves > pdq_partial_insertion_sort_limit)
+            return false;
+    }
+    return true;
+}
+
+template<typename Collection, typename LessThan>
+void heap_sort(Collection& col, size_t start, size_t end, LessThan& less_than)
+{
+    size_t size = end - start;
+    auto sift_down = [&](size_t root, size_t heap_size) {
+        for (;;) {
+            size_t child = 2 * root + 1;
+            if (child >= heap_size)
+                return;
+            if (child + 1 < heap_size && less_than(col[start + child], col[start + child + 1]))
+                ++child;
+            if (!less_than(col[start + root], col[start + child]))
+                return;
+            swap(col[start + root], col[start + child]);
+            root = child;
+        }
+    };
+
+    for (size_t i = size / 2; i-- > 0;)
+        sift_down(i, size);
+    for (size_t i = size; i-- > 1;) {
+        swap(col[start], col[start + i]);
+        sift_down(0, i);
+    }
+}
+
+// Orders the three elements so that col[a] <= col[b] <= col[c].
+template<typename Collection, typename LessThan>
+void sort3(Collection& col, size_t a, size_t b, size_t c, LessThan& less_than)
+{
+    if (less_than(col[b], col[a]))
+        swap(col[a], col[b]);
+    if (less_than(col[c], col[b])) {
+        swap(col[b], col[c]);
+        if (less_than(col[b], col[a]))
+            swap(col[a], col[b]);
+    }
+}
+
+struct PartitionResult {
+    size_t pivot_position;
+    bool was_already_partitioned;
+};
+
+// Partitions [start, end) around the pivot at col[start]: smaller elements end up to
+// its left, the rest to its right. The pivot itself never moves until the very end,
+// so it can be compared against in place; this keeps the sort swap-only.
+// Since the pivot is a median of three, the scans mostly don't need bounds checks.
+template<typename Collection, typename LessThan>
+PartitionResult partition_right(Collection& col, size_t start, size_t end, LessThan& less_than)
+{
+    auto&& pivot = col[start];
+    size_t first = start;
+    size_t last = end;
+
+    // There is an element not less than the pivot to stop this scan, and unless the
+    // scan stopped right away, the element before that stops the next one.
+    while (less_than(col[++first], pivot)) { }
+    if (first - 1 == start) {
+        while (first < last && !less_than(col[--last], pivot)) { }
+    } else {
+        while (!less_than(col[--last], pivot)) { }
+    }
+
+    bool was_already_partitioned = first >= last;
+
+    // From here on, the elements just swapped stop the scans.
+    while (first < last) {
+        swap(col[first], col[last]);
+        while (less_than(col[++first], pivot)) { }
+        while (!less_than(col[--last], pivot)) { }
+    }
+
+    size_t pivot_position = first - 1;
+    swap(col[start], col[pivot_position]);
+    return { pivot_position, was_already_partitioned };
+}
+
+// Partitions [start, end) around the pivot at col[start], putting the elements equal to
+// it on the left. This is only used when the pivot is known to be the smallest element
+// of the range, so everything left of the returned position is equal and already done.
+template<typename Collection, typename LessThan>
+size_t partition_left(Collection& col, size_t start, size_t end, LessThan& less_than)
+{
+    auto&& pivot = col[start];
+    size_t first = start;
+    size_t last = end;
+
+    while (less_than(pivot, col[--last])) { }
+    if (last + 1 == end) {
+        while (first < last && !less_than(pivot, col[++first])) { }
+    } else {
+        while (!less_than(pivot, col[++first])) { }
+    }
+
+    while (first < last) {
+        swap(col[first], col[last]);
+        while (less_than(pivot, col[--last])) { }
+        while (!less_than(pivot, col[++first])) { }
+    }
+
+    swap(col[start], col[last]);
+    return last;
+}
+
+template<typename Collection, typename LessThan>
+void pattern_defeating_quick_sort(Collection& col, size_t start, size_t end, LessThan& less_than, size_t bad_partitions_allowed, bool leftmost)
+{
+    for (;;) {
+        size_t size = end - start;
+        if (size <= pdq_insertion_sort_threshold) {
+            insertion_sort(col, start, end, less_than);
+            return;
+        }
+
+        // Move the pivot to the start of the range.
+        size_t half = size / 2;
+        if (size > pdq_ninther_threshold) {
+            sort3(col, start, start + half, end - 1, less_than);
+            sort3(col, start + 1, start + half - 1, end - 2, less_than);
+            sort3(col, start + 2, start + half + 1, end - 3, less_than);
+            sort3(col, start + half - 1, start + half, start + half + 1, less_than);
+            swap(col[start], col[start + half]);
+        } else {
+            sort3(col, start + half, start, end - 1, less_than);
+        }
+
+        // The element before a range that isn't leftmost is the pivot of a previous partition
+        // and not greater than anything in the range. If it equals our pivot, there are lots of
+        // duplicates: split off everything equal to the pivot in one go and never look at it again.
+        if (!leftmost && !less_than(col[start - 1], col[start])) {
+            start = partition_left(col, start, end, less_than) + 1;
+            continue;
+        }
+
+        auto [pivot_position, was_already_partitioned] = partition_right(col, start, end, less_than);
+        size_t left_size = pivot_position - start;
+        size_t right_size = end - pivot_position - 1;
+
+        if (left_size < size / 8 || right_size < size / 8) {
+            // A bad partition; if this keeps happening, bail out to heap sort to stay O(n log n).
+            if (--bad_partitions_allowed == 0) {
+                heap_sort(col, start, end, less_than);
+                return;
+            }
+            // Otherwise, swap a few elements around to break up whatever pattern caused it.
+            if (left_size >= pdq_insertion_sort_threshold) {
+                swap(col[start], col[start + left_size / 4]);
+                swap(col[pivot_position - 1], col[pivot_position - left_size / 4]);
+            }
+            if (right_size >= pdq_insertion_sort_threshold) {
+                swap(col[pivot_position + 1], col[pivot_position + 1 + right_size / 4]);
+                swap(col[end - 1], col[end - right_size / 4]);
+            }
+        } else if (was_already_partitioned
+            && partial_insertion_sort(col, start, pivot_position, less_than)
+            && partial_insertion_sort(col, pivot_position + 1, end, less_than)) {
+            // The input was (nearly) sorted to begin with.
+            return;
+        }
+
+        // Recur into the shorter part to ensure a stack depth of at most log(n).
+        if (left_size < right_size) {
+            pattern_defeating_quick_sort(col, start, pivot_position, less_than, bad_partitions_allowed, leftmost);
+            start = pivot_position + 1;
+            leftmost = false;
+        } else {
+            pattern_defeating_quick_sort(col, pivot_position + 1, end, less_than, bad_partitions_allowed, false);
+            end = pivot_position;
+        }
+    }
+}
+
+template<typename Iterator>
+class IteratorIndexer {
+public:
+    explicit IteratorIndexer(Iterator start)
+        : m_start(start)
+    {
+    }
+
+    decltype(auto) operator[](size_t index) { return *(m_start + static_cast<ptrdiff_t>(index)); }
+
+private:
+    Iterator m_start;
+};
+
+}
+
+/* This is a pattern-defeating quick sort (due to Orson Peters). On random input it
+ * behaves like an ordinary quick sort with a median-of-three pivot, but it also:
+ * - finishes small ranges with an insertion sort,
+ * - splits off runs of elements equal to the pivot, so inputs with many duplicates
+ *   take O(n * number of distinct keys) instead of O(n^2),
+ * - notices (nearly) sorted ranges and finishes them with an insertion sort,
+ * - breaks up patterns that lead to bad partitions, and falls back to heap sort if
+ *   they keep happening, which makes the worst case O(n log n).
+ * It only ever swaps elements, so it works with move-only types and with collections
+ * whose operator[] returns a proxy object. It sorts the range [start, end).
+ */
+template<typename Collection, typename LessThan>
+void pattern_defeating_quick_sort(Collection& col, size_t start, size_t end, LessThan less_than)
+{
+    if (end - start <= 1)
+        return;
+    size_t bad_partitions_allowed = 1;
+    for (size_t size = end - start; size > 1; size >>= 1)
+        ++bad_partitions_allowed;
+    Detail::pattern_defeating_quick_sort(col, start, end, less_than, bad_partitions_allowed, true);
+}
+
+template<typename Iterator, typename LessThan>
+void pattern_defeating_quick_sort(Iterator start, Iterator end, LessThan less_than)
+{
+    Detail::IteratorIndexer<Iterator> indexer { start };
+    pattern_defeating_quick_sort(indexer, 0, end - start, move(less_than));
+}
+
 template<typename Iterator>
 void quick_sort(Iterator start, Iterator end)
 {
-    single_pivot_quick_sort(start, end, [](auto& a, auto& b) { return a < b; });
+    pattern_defeating_quick_sort(start, end, [](auto& a, auto& b) { return a < b; });
 }
 
 template<typename Iterator, typename LessThan>
 void quick_sort(Iterator start, Iterator end, LessThan less_than)
 {
-    single_pivot_quick_sort(start, end, move(less_than));
+    pattern_defeating_quick_sort(start, end, move(less_than));
 }
 
 template<typename Collection, typename LessThan>
 void quick_sort(Collection& collection, LessThan less_than)
 {
-    dual_pivot_quick_sort(collection, 0, collection.size() - 1, move(less_than));
+    pattern_defeating_quick_sort(collection, 0, collection.size(), move(less_than));
 }
 
 template<typename Collection>
 void quick_sort(Collection& collection)
 {
-    dual_pivot_quick_sort(collection, 0, collection.size() - 1,
+    pattern_defeating_quick_sort(collection, 0, collection.size(),
         [](auto& a, auto& b) { return a < b; });
 }
 
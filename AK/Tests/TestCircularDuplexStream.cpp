@@ -82,4 +82,45 @@ TEST_CASE(overwritting_is_well_defined)
     EXPECT(stream.eof());
 }
 
+TEST_CASE(copy_from_seekback_repeats_overlapping_bytes)
+{
+    constexpr size_t capacity = 32;
+
+    // Compares against copying one byte at a time, at every position in the buffer.
+    for (size_t offset = 0; offset < capacity; ++offset) {
+        for (size_t seekback = 1; seekback <= capacity; ++seekback) {
+            CircularDuplexStream<capacity> stream;
+            Vector<u8> expected;
+
+            for (size_t idx = 0; idx < offset + capacity; ++idx) {
+                stream << static_cast<u8>(idx);
+                expected.append(static_cast<u8>(idx));
+                EXPECT(stream.discard_or_error(1));
+            }
+
+            const size_t length = capacity - (offset % 5);
+            EXPECT_EQ(stream.copy_from_seekback(seekback, length), length);
+            for (size_t idx = 0; idx < length; ++idx)
+                expected.append(expected[expected.size() - seekback]);
+
+            Array<u8, capacity> buffer;
+            EXPECT_EQ(stream.read(buffer.span().trim(length)), length);
+            for (size_t idx = 0; idx < length; ++idx)
+                EXPECT_EQ(buffer[idx], expected[expected.size() - length + idx]);
+            EXPECT(stream.eof());
+        }
+    }
+}
+
+TEST_CASE(copy_from_seekback_checks_distance)
+{
+    CircularDuplexStream<16> stream;
+    stream << static_cast<u8>(1);
+
+    EXPECT_EQ(stream.copy_from_seekback(2, 1), 0u);
+    EXPECT(stream.handle_recoverable_error());
+    EXPECT_EQ(stream.copy_from_seekback(0, 1), 0u);
+    EXPECT(stream.handle_recoverable_error());
+}
+
 TEST_MAIN(CircularDuplexStream)
@@ -30,6 +30,8 @@
 #include <AK/Noncopyable.h>
 #include <AK/QuickSort.h>
 #include <AK/StdLibExtras.h>
+#include <AK/StringView.h>
+#include <AK/Vector.h>
 
 TEST_CASE(sorts_without_copy)
 {
@@ -64,6 +66,16 @@ TEST_CASE(sorts_without_copy)
 
     for (size_t i = 0; i < 63; ++i)
         EXPECT(array[i].value <= array[i + 1].value);
+
+    // Test the pattern-defeating quick sort, with enough elements that it doesn't just do an insertion sort.
+    Array<NoCopy, 256> big_array;
+    for (size_t i = 0; i < 256; ++i)
+        big_array[i].value = (256 - i) % 32 + 32;
+
+    quick_sort(big_array, [](auto& a, auto& b) { return a.value < b.value; });
+
+    for (size_t i = 0; i < 255; ++i)
+        EXPECT(big_array[i].value <= big_array[i + 1].value);
 }
 
 // This test case may fail to construct a worst-case input if the pivot choice
@@ -119,4 +131,113 @@ TEST_CASE(maximum_stack_depth)
     delete[] data;
 }
 
+// Inputs that tend to make naive quick sorts go quadratic, along with some random ones.
+static Vector<int> generate_pattern(StringView pattern, int size)
+{
+    Vector<int> data;
+    data.ensure_capacity(size);
+    u32 seed = 12345;
+    auto random = [&] {
+        seed = seed * 1103515245 + 12345;
+        return (int)(seed >> 8);
+    };
+    for (int i = 0; i < size; ++i) {
+        if (pattern == "sorted")
+            data.append(i);
+        else if (pattern == "reversed")
+            data.append(size - i);
+        else if (pattern == "organ_pipe")
+            data.append(i < size / 2 ? i : size - i);
+        else if (pattern == "sawtooth")
+            data.append(i % 64);
+        else if (pattern == "all_equal")
+            data.append(42);
+        else if (pattern == "few_distinct")
+            data.append(random() % 4);
+        else if (pattern == "sorted_with_noise")
+            data.append(i % 100 == 0 ? random() % size : i);
+        else
+            data.append(random());
+    }
+    // The input the maximum_stack_depth test above builds for a middle pivot.
+    if (pattern == "middle_pivot_killer") {
+        for (int i = 0; i < size; ++i)
+            data[i] = i;
+        for (int i = 0; i < size / 2; ++i)
+            swap(data[i], data[i + (size - i) / 2]);
+    }
+    return data;
+}
+
+static constexpr StringView patterns[] = { "random", "sorted", "reversed", "organ_pipe", "sawtooth", "all_equal", "few_distinct", "sorted_with_noise", "middle_pivot_killer" };
+
+TEST_CASE(sorts_patterns)
+{
+    for (auto pattern : patterns) {
+        for (int size : { 0, 1, 2, 3, 24, 25, 100, 129, 1000, 10000 }) {
+            auto data = generate_pattern(pattern, size);
+            auto expected_sum = 0ll;
+            for (auto value : data)
+                expected_sum += value;
+
+            quick_sort(data);
+
+            auto sum = 0ll;
+            for (auto value : data)
+                sum += value;
+            EXPECT_EQ(sum, expected_sum);
+            for (int i = 1; i < size; ++i)
+                EXPECT(data[i - 1] <= data[i]);
+        }
+    }
+}
+
+TEST_CASE(comparisons_are_n_log_n)
+{
+    const int size = 65536;
+    for (auto pattern : patterns) {
+        auto data = generate_pattern(pattern, size);
+        size_t comparisons = 0;
+        quick_sort(data, [&](int a, int b) {
+            ++comparisons;
+            return a < b;
+        });
+        // log2(65536) == 16; a quadratic sort needs thousands of times as many.
+        EXPECT(comparisons <= 4 * size * 16);
+    }
+}
+
+TEST_CASE(sorts_with_iterators)
+{
+    auto data = generate_pattern("random", 1000);
+    quick_sort(data.begin(), data.end());
+    for (size_t i = 1; i < data.size(); ++i)
+        EXPECT(data[i - 1] <= data[i]);
+
+    int array[100];
+    for (int i = 0; i < 100; ++i)
+        array[i] = (i * 37) % 100;
+    quick_sort(array, array + 100, [](int a, int b) { return a > b; });
+    for (int i = 0; i < 100; ++i)
+        EXPECT_EQ(array[i], 99 - i);
+}
+
+BENCHMARK_CASE(sort_many_duplicates)
+{
+    for (int i = 0; i < 3; ++i) {
+        auto data = generate_pattern("few_distinct", 1000000);
+        quick_sort(data);
+        EXPECT(data.first() <= data.last());
+    }
+}
+
+BENCHMARK_CASE(sort_random)
+{
+    for (int i = 0; i < 3; ++i) {
+        auto data = generate_pattern("random", 1000000);
+        quick_sort(data);
+        EXPECT(data.first() <= data.last());
+    }
+}
+
 TEST_MAIN(QuickSort)
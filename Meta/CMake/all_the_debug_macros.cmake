@@ -57,7 +57,6 @@ set(JOB_DEBUG ON)
 set(GIF_DEBUG ON)
 set(JPG_DEBUG ON)
 set(EMOJI_DEBUG ON)
-set(FILL_PATH_DEBUG ON)
 set(PNG_DEBUG ON)
 set(PORTABLE_IMAGE_LOADER_DEBUG ON)
 set(SYNTAX_HIGHLIGHTING_DEBUG ON)
@@ -40,6 +40,12 @@ struct Parameter {
     String name;
 };
 
+// Parameters of these types borrow from the buffer the message was received in.
+static bool is_view_type(const String& type)
+{
+    return type.contains("StringView") || type.contains("ReadonlyBytes");
+}
+
 struct Message {
     String name;
     bool is_synchronous { false };
@@ -204,6 +210,7 @@ int main(int argc, char** argv)
 
     generator.append(R"~~~(
 #pragma once
+#include <AK/ByteBuffer.h>
 #include <AK/MemoryStream.h>
 #include <AK/OwnPtr.h>
 #include <AK/URL.h>
@@ -317,11 +324,15 @@ public:
     static i32 static_message_id() { return (int)MessageID::@message.name@; }
     virtual const char* message_name() const override { return "@endpoint.name@::@message.name@"; }
 
-    static OwnPtr<@message.name@> decode(InputMemoryStream& stream, int sockfd)
+    static OwnPtr<@message.name@> decode(InputMemoryStream& stream, [[maybe_unused]] const ByteBuffer& buffer, int sockfd)
     {
         IPC::Decoder decoder { stream, sockfd };
 )~~~");
 
+            bool has_view_parameters = false;
+            for (auto& parameter : parameters)
+                has_view_parameters |= is_view_type(parameter.type);
+
             for (auto& parameter : parameters) {
                 auto parameter_generator = message_generator.fork();
 
@@ -359,10 +370,20 @@ public:
 
             message_generator.set("message.constructor_call_parameters", builder.build());
 
-            message_generator.append(R"~~~(
+            if (has_view_parameters) {
+                message_generator.append(R"~~~(
+        auto message = make<@message.name@>(@message.constructor_call_parameters@);
+        message->m_buffer = buffer;
+        message->m_anonymous_buffers = decoder.take_anonymous_buffers();
+        return message;
+    }
+)~~~");
+            } else {
+                message_generator.append(R"~~~(
         return make<@message.name@>(@message.constructor_call_parameters@);
     }
 )~~~");
+            }
 
             message_generator.append(R"~~~(
     virtual IPC::MessageBuffer encode() const override
@@ -409,6 +430,14 @@ private:
 )~~~");
             }
 
+            if (has_view_parameters) {
+                message_generator.append(R"~~~(
+    // What the views point into, when this message was received rather than constructed.
+    ByteBuffer m_buffer;
+    Vector<Core::AnonymousBuffer> m_anonymous_buffers;
+)~~~");
+            }
+
             message_generator.append(R"~~~(
 };
             )~~~");
@@ -437,9 +466,10 @@ public:
     static String static_name() { return "@endpoint.name@"; }
     virtual String name() const override { return "@endpoint.name@"; }
 
-    static OwnPtr<IPC::Message> decode_message(ReadonlyBytes buffer, int sockfd)
+    // `bytes` is the message itself, somewhere in `buffer`.
+    static OwnPtr<IPC::Message> decode_message(const ByteBuffer& buffer, ReadonlyBytes bytes, int sockfd)
     {
-        InputMemoryStream stream { buffer };
+        InputMemoryStream stream { bytes };
         i32 message_endpoint_magic = 0;
         stream >> message_endpoint_magic;
         if (stream.handle_any_error()) {
@@ -489,7 +519,7 @@ public:
 
                 message_generator.append(R"~~~(
         case (int)Messages::@endpoint.name@::MessageID::@message.name@:
-            message = Messages::@endpoint.name@::@message.name@::decode(stream, sockfd);
+            message = Messages::@endpoint.name@::@message.name@::decode(stream, buffer, sockfd);
             break;
 )~~~");
             };
@@ -32,6 +32,7 @@
 #include <LibELF/AuxiliaryVector.h>
 #include <LibThread/Lock.h>
 #include <assert.h>
+#include <malloc.h>
 #include <mallocdefs.h>
 #include <serenity.h>
 #include <stdio.h>
@@ -70,34 +71,53 @@ static LibThread::Lock& malloc_lock()
 constexpr size_t number_of_chunked_blocks_to_keep_around_per_size_class = 4;
 constexpr size_t number_of_big_blocks_to_keep_around_per_size_class = 8;
 
+// Chunks of the small size classes (up to 1016 bytes) are cached per thread, so that most
+// allocations and frees don't have to take the malloc lock. Chunks move between a thread's
+// cache and their blocks in batches of half the cache size.
+constexpr size_t number_of_thread_cached_size_classes = 8;
+constexpr size_t thread_cache_chunks_per_size_class = 64;
+constexpr size_t thread_cache_batch_size = thread_cache_chunks_per_size_class / 2;
+
+// Big allocations are spread over a few arenas (picked by thread ID), each with its own lock
+// and its own blocks kept around for recycling.
+constexpr size_t number_of_big_allocation_arenas = 4;
+
 static bool s_log_malloc = false;
 static bool s_scrub_malloc = true;
 static bool s_scrub_free = true;
 static bool s_profiling = false;
 
+// Protected by the malloc lock.
 struct MallocStats {
-    size_t number_of_malloc_calls;
-
-    size_t number_of_big_allocator_hits;
-    size_t number_of_big_allocator_purge_hits;
-    size_t number_of_big_allocs;
-
     size_t number_of_empty_block_hits;
     size_t number_of_empty_block_purge_hits;
     size_t number_of_block_allocs;
     size_t number_of_blocks_full;
 
-    size_t number_of_free_calls;
-
-    size_t number_of_big_allocator_keeps;
-    size_t number_of_big_allocator_frees;
-
     size_t number_of_freed_full_blocks;
     size_t number_of_keeps;
     size_t number_of_frees;
+
+    size_t number_of_thread_cache_refills;
+    size_t number_of_thread_cache_flushes;
+
+    // Collected from the thread caches of threads that have exited.
+    size_t number_of_malloc_calls;
+    size_t number_of_free_calls;
+    size_t number_of_thread_cache_hits;
 };
 static MallocStats g_malloc_stats = {};
 
+// Protected by the lock of their arena.
+struct BigAllocationStats {
+    size_t number_of_big_allocator_hits;
+    size_t number_of_big_allocator_purge_hits;
+    size_t number_of_big_allocs;
+
+    size_t number_of_big_allocator_keeps;
+    size_t number_of_big_allocator_frees;
+};
+
 struct Allocator {
     size_t size { 0 };
     size_t block_count { 0 };
@@ -108,9 +128,37 @@ struct Allocator {
 };
 
 struct BigAllocator {
+    LibThread::Lock lock;
     Vector<BigAllocationBlock*, number_of_big_blocks_to_keep_around_per_size_class> blocks;
+    BigAllocationStats stats {};
+};
+
+struct ThreadCache {
+    struct Bin {
+        FreelistEntry* chunks;
+        size_t count;
+    };
+    Bin bins[number_of_thread_cached_size_classes];
+
+    size_t number_of_malloc_calls;
+    size_t number_of_free_calls;
+    size_t number_of_hits;
+
+    // Every thread cache that holds chunks is on this list (protected by the malloc lock),
+    // so that malloc_info() can account for them.
+    bool is_registered;
+    ThreadCache* prev;
+    ThreadCache* next;
 };
 
+// Zero-initialized, so it can be used without running any constructor.
+#ifdef NO_TLS
+static ThreadCache s_thread_cache;
+#else
+static __thread ThreadCache s_thread_cache;
+#endif
+static ThreadCache* s_thread_caches;
+
 // Allocators will be initialized in __malloc_init.
 // We can not rely on global constructors to initialize them,
 // because they must be initialized before other global constructors
@@ -118,16 +166,16 @@ struct BigAllocator {
 // them. We could have used AK::NeverDestoyed to prevent the latter,
 // but it would have not helped with the former.
 static u8 g_allocators_storage[sizeof(Allocator) * num_size_classes];
-static u8 g_big_allocators_storage[sizeof(BigAllocator)];
+static u8 g_big_allocators_storage[sizeof(BigAllocator) * number_of_big_allocation_arenas];
 
 static inline Allocator (&allocators())[num_size_classes]
 {
     return reinterpret_cast<Allocator(&)[num_size_classes]>(g_allocators_storage);
 }
 
-static inline BigAllocator (&big_allocators())[1]
+static inline BigAllocator (&big_allocators())[number_of_big_allocation_arenas]
 {
-    return reinterpret_cast<BigAllocator(&)[1]>(g_big_allocators_storage);
+    return reinterpret_cast<BigAllocator(&)[number_of_big_allocation_arenas]>(g_big_allocators_storage);
 }
 
 static Allocator* allocator_for_size(size_t size, size_t& good_size)
@@ -142,12 +190,15 @@ static Allocator* allocator_for_size(size_t size, size_t& good_size)
     return nullptr;
 }
 
+static BigAllocator& big_allocator_for_current_thread()
+{
+    return big_allocators()[gettid() % number_of_big_allocation_arenas];
+}
+
 #ifdef RECYCLE_BIG_ALLOCATIONS
-static BigAllocator* big_allocator_for_size(size_t size)
+static bool should_recycle_big_allocation(size_t size)
 {
-    if (size == 65536)
-        return &big_allocators()[0];
-    return nullptr;
+    return size == 65536;
 }
 #endif
 
@@ -171,65 +222,83 @@ enum class CallerWillInitializeMemory {
     Yes,
 };
 
-static void* malloc_impl(size_t size, CallerWillInitializeMemory caller_will_initialize_memory)
+static void* allocate_big(size_t size)
 {
-    LOCKER(malloc_lock());
-
-    if (s_log_malloc)
-        dbgln("LibC: malloc({})", size);
-
-    if (!size)
-        return nullptr;
-
-    g_malloc_stats.number_of_malloc_calls++;
+    size_t real_size = round_up_to_power_of_two(sizeof(BigAllocationBlock) + size, ChunkedBlock::block_size);
+    auto& allocator = big_allocator_for_current_thread();
+    {
+        LOCKER(allocator.lock);
+#ifdef RECYCLE_BIG_ALLOCATIONS
+        if (should_recycle_big_allocation(real_size) && !allocator.blocks.is_empty()) {
+            allocator.stats.number_of_big_allocator_hits++;
+            auto* block = allocator.blocks.take_last();
+            int rc = madvise(block, real_size, MADV_SET_NONVOLATILE);
+            bool this_block_was_purged = rc == 1;
+            if (rc < 0) {
+                perror("madvise");
+                VERIFY_NOT_REACHED();
+            }
+            if (mprotect(block, real_size, PROT_READ | PROT_WRITE) < 0) {
+                perror("mprotect");
+                VERIFY_NOT_REACHED();
+            }
+            if (this_block_was_purged) {
+                allocator.stats.number_of_big_allocator_purge_hits++;
+                new (block) BigAllocationBlock(real_size);
+            }
 
-    size_t good_size;
-    auto* allocator = allocator_for_size(size, good_size);
+            ue_notify_malloc(&block->m_slot[0], size);
+            return &block->m_slot[0];
+        }
+#endif
+        allocator.stats.number_of_big_allocs++;
+    }
+    auto* block = (BigAllocationBlock*)os_alloc(real_size, "malloc: BigAllocationBlock");
+    new (block) BigAllocationBlock(real_size);
+    ue_notify_malloc(&block->m_slot[0], size);
+    return &block->m_slot[0];
+}
 
-    if (!allocator) {
-        size_t real_size = round_up_to_power_of_two(sizeof(BigAllocationBlock) + size, ChunkedBlock::block_size);
+static void free_big(BigAllocationBlock* block)
+{
+    auto& allocator = big_allocator_for_current_thread();
+    {
+        LOCKER(allocator.lock);
 #ifdef RECYCLE_BIG_ALLOCATIONS
-        if (auto* allocator = big_allocator_for_size(real_size)) {
-            if (!allocator->blocks.is_empty()) {
-                g_malloc_stats.number_of_big_allocator_hits++;
-                auto* block = allocator->blocks.take_last();
-                int rc = madvise(block, real_size, MADV_SET_NONVOLATILE);
-                bool this_block_was_purged = rc == 1;
-                if (rc < 0) {
-                    perror("madvise");
-                    VERIFY_NOT_REACHED();
-                }
-                if (mprotect(block, real_size, PROT_READ | PROT_WRITE) < 0) {
-                    perror("mprotect");
-                    VERIFY_NOT_REACHED();
-                }
-                if (this_block_was_purged) {
-                    g_malloc_stats.number_of_big_allocator_purge_hits++;
-                    new (block) BigAllocationBlock(real_size);
-                }
-
-                ue_notify_malloc(&block->m_slot[0], size);
-                return &block->m_slot[0];
+        if (should_recycle_big_allocation(block->m_size) && allocator.blocks.size() < number_of_big_blocks_to_keep_around_per_size_class) {
+            allocator.stats.number_of_big_allocator_keeps++;
+            allocator.blocks.append(block);
+            size_t this_block_size = block->m_size;
+            if (mprotect(block, this_block_size, PROT_NONE) < 0) {
+                perror("mprotect");
+                VERIFY_NOT_REACHED();
+            }
+            if (madvise(block, this_block_size, MADV_SET_VOLATILE) != 0) {
+                perror("madvise");
+                VERIFY_NOT_REACHED();
             }
+            return;
         }
 #endif
-        g_malloc_stats.number_of_big_allocs++;
-        auto* block = (BigAllocationBlock*)os_alloc(real_size, "malloc: BigAllocationBlock");
-        new (block) BigAllocationBlock(real_size);
-        ue_notify_malloc(&block->m_slot[0], size);
-        return &block->m_slot[0];
+        allocator.stats.number_of_big_allocator_frees++;
     }
+    os_free(block, block->m_size);
+}
 
+// Must be called with the malloc lock held.
+static void* allocate_chunk(Allocator& allocator)
+{
+    size_t good_size = allocator.size;
     ChunkedBlock* block = nullptr;
 
-    for (block = allocator->usable_blocks.head(); block; block = block->next()) {
+    for (block = allocator.usable_blocks.head(); block; block = block->next()) {
         if (block->free_chunks())
             break;
     }
 
-    if (!block && allocator->empty_block_count) {
+    if (!block && allocator.empty_block_count) {
         g_malloc_stats.number_of_empty_block_hits++;
-        block = allocator->empty_blocks[--allocator->empty_block_count];
+        block = allocator.empty_blocks[--allocator.empty_block_count];
         int rc = madvise(block, ChunkedBlock::block_size, MADV_SET_NONVOLATILE);
         bool this_block_was_purged = rc == 1;
         if (rc < 0) {
@@ -245,7 +314,7 @@ static void* malloc_impl(size_t size, CallerWillInitializeMemory caller_will_ini
             g_malloc_stats.number_of_empty_block_purge_hits++;
             new (block) ChunkedBlock(good_size);
         }
-        allocator->usable_blocks.append(block);
+        allocator.usable_blocks.append(block);
     }
 
     if (!block) {
@@ -254,8 +323,8 @@ static void* malloc_impl(size_t size, CallerWillInitializeMemory caller_will_ini
         snprintf(buffer, sizeof(buffer), "malloc: ChunkedBlock(%zu)", good_size);
         block = (ChunkedBlock*)os_alloc(ChunkedBlock::block_size, buffer);
         new (block) ChunkedBlock(good_size);
-        allocator->usable_blocks.append(block);
-        ++allocator->block_count;
+        allocator.usable_blocks.append(block);
+        ++allocator.block_count;
     }
 
     --block->m_free_chunks;
@@ -265,13 +334,150 @@ static void* malloc_impl(size_t size, CallerWillInitializeMemory caller_will_ini
     if (block->is_full()) {
         g_malloc_stats.number_of_blocks_full++;
         dbgln_if(MALLOC_DEBUG, "Block {:p} is now full in size class {}", block, good_size);
-        allocator->usable_blocks.remove(block);
-        allocator->full_blocks.append(block);
+        allocator.usable_blocks.remove(block);
+        allocator.full_blocks.append(block);
     }
     dbgln_if(MALLOC_DEBUG, "LibC: allocated {:p} (chunk in block {:p}, size {})", ptr, block, block->bytes_per_chunk());
+    return ptr;
+}
+
+// Must be called with the malloc lock held.
+static void release_chunk(Allocator& allocator, void* ptr)
+{
+    auto* block = (ChunkedBlock*)((FlatPtr)ptr & ChunkedBlock::block_mask);
+    size_t good_size = allocator.size;
+
+    auto* entry = (FreelistEntry*)ptr;
+    entry->next = block->m_freelist;
+    block->m_freelist = entry;
+
+    if (block->is_full()) {
+        dbgln_if(MALLOC_DEBUG, "Block {:p} no longer full in size class {}", block, good_size);
+        g_malloc_stats.number_of_freed_full_blocks++;
+        allocator.full_blocks.remove(block);
+        allocator.usable_blocks.prepend(block);
+    }
+
+    ++block->m_free_chunks;
+
+    if (!block->used_chunks()) {
+        if (allocator.block_count < number_of_chunked_blocks_to_keep_around_per_size_class) {
+            dbgln_if(MALLOC_DEBUG, "Keeping block {:p} around for size class {}", block, good_size);
+            g_malloc_stats.number_of_keeps++;
+            allocator.usable_blocks.remove(block);
+            allocator.empty_blocks[allocator.empty_block_count++] = block;
+            mprotect(block, ChunkedBlock::block_size, PROT_NONE);
+            madvise(block, ChunkedBlock::block_size, MADV_SET_VOLATILE);
+            return;
+        }
+        dbgln_if(MALLOC_DEBUG, "Releasing block {:p} for size class {}", block, good_size);
+        g_malloc_stats.number_of_frees++;
+        allocator.usable_blocks.remove(block);
+        --allocator.block_count;
+        os_free(block, ChunkedBlock::block_size);
+    }
+}
+
+// Must be called with the malloc lock held.
+static void register_thread_cache()
+{
+    auto& cache = s_thread_cache;
+    if (cache.is_registered)
+        return;
+    cache.is_registered = true;
+    cache.prev = nullptr;
+    cache.next = s_thread_caches;
+    if (s_thread_caches)
+        s_thread_caches->prev = &cache;
+    s_thread_caches = &cache;
+}
+
+// Must be called with the malloc lock held. Returns the least recently cached chunks to their blocks.
+static void flush_thread_cache_bin(size_t size_class, size_t chunks_to_keep)
+{
+    auto& bin = s_thread_cache.bins[size_class];
+    auto** link = &bin.chunks;
+    for (size_t i = 0; i < chunks_to_keep && *link; ++i)
+        link = &(*link)->next;
+
+    auto* entry = *link;
+    *link = nullptr;
+    while (entry) {
+        auto* next = entry->next;
+        release_chunk(allocators()[size_class], entry);
+        --bin.count;
+        entry = next;
+    }
+}
+
+static void* take_chunk_from_thread_cache(size_t size_class)
+{
+    auto& cache = s_thread_cache;
+    auto& bin = cache.bins[size_class];
+    if (bin.count) {
+        cache.number_of_hits++;
+    } else {
+        LOCKER(malloc_lock());
+        register_thread_cache();
+        g_malloc_stats.number_of_thread_cache_refills++;
+        auto** tail = &bin.chunks;
+        for (size_t i = 0; i < thread_cache_batch_size; ++i) {
+            auto* entry = (FreelistEntry*)allocate_chunk(allocators()[size_class]);
+            *tail = entry;
+            tail = &entry->next;
+        }
+        *tail = nullptr;
+        bin.count = thread_cache_batch_size;
+    }
+
+    auto* entry = bin.chunks;
+    bin.chunks = entry->next;
+    --bin.count;
+    return entry;
+}
+
+static void give_chunk_to_thread_cache(size_t size_class, void* ptr)
+{
+    auto& bin = s_thread_cache.bins[size_class];
+    auto* entry = (FreelistEntry*)ptr;
+    entry->next = bin.chunks;
+    bin.chunks = entry;
+    if (++bin.count < thread_cache_chunks_per_size_class)
+        return;
+
+    LOCKER(malloc_lock());
+    register_thread_cache();
+    g_malloc_stats.number_of_thread_cache_flushes++;
+    flush_thread_cache_bin(size_class, thread_cache_chunks_per_size_class - thread_cache_batch_size);
+}
+
+static void* malloc_impl(size_t size, CallerWillInitializeMemory caller_will_initialize_memory)
+{
+    if (s_log_malloc)
+        dbgln("LibC: malloc({})", size);
+
+    if (!size)
+        return nullptr;
+
+    s_thread_cache.number_of_malloc_calls++;
+
+    size_t good_size;
+    auto* allocator = allocator_for_size(size, good_size);
+
+    if (!allocator)
+        return allocate_big(size);
+
+    void* ptr;
+    size_t size_class = allocator - allocators();
+    if (size_class < number_of_thread_cached_size_classes) {
+        ptr = take_chunk_from_thread_cache(size_class);
+    } else {
+        LOCKER(malloc_lock());
+        ptr = allocate_chunk(*allocator);
+    }
 
     if (s_scrub_malloc && caller_will_initialize_memory == CallerWillInitializeMemory::No)
-        memset(ptr, MALLOC_SCRUB_BYTE, block->m_size);
+        memset(ptr, MALLOC_SCRUB_BYTE, good_size);
 
     ue_notify_malloc(ptr, size);
     return ptr;
@@ -284,79 +490,34 @@ static void free_impl(void* ptr)
     if (!ptr)
         return;
 
-    g_malloc_stats.number_of_free_calls++;
-
-    LOCKER(malloc_lock());
+    s_thread_cache.number_of_free_calls++;
 
     void* block_base = (void*)((FlatPtr)ptr & ChunkedBlock::ChunkedBlock::block_mask);
     size_t magic = *(size_t*)block_base;
 
     if (magic == MAGIC_BIGALLOC_HEADER) {
-        auto* block = (BigAllocationBlock*)block_base;
-#ifdef RECYCLE_BIG_ALLOCATIONS
-        if (auto* allocator = big_allocator_for_size(block->m_size)) {
-            if (allocator->blocks.size() < number_of_big_blocks_to_keep_around_per_size_class) {
-                g_malloc_stats.number_of_big_allocator_keeps++;
-                allocator->blocks.append(block);
-                size_t this_block_size = block->m_size;
-                if (mprotect(block, this_block_size, PROT_NONE) < 0) {
-                    perror("mprotect");
-                    VERIFY_NOT_REACHED();
-                }
-                if (madvise(block, this_block_size, MADV_SET_VOLATILE) != 0) {
-                    perror("madvise");
-                    VERIFY_NOT_REACHED();
-                }
-                return;
-            }
-        }
-#endif
-        g_malloc_stats.number_of_big_allocator_frees++;
-        os_free(block, block->m_size);
+        free_big((BigAllocationBlock*)block_base);
         return;
     }
 
     assert(magic == MAGIC_PAGE_HEADER);
     auto* block = (ChunkedBlock*)block_base;
 
-    dbgln_if(MALLOC_DEBUG, "LibC: freeing {:p} in allocator {:p} (size={}, used={})", ptr, block, block->bytes_per_chunk(), block->used_chunks());
+    dbgln_if(MALLOC_DEBUG, "LibC: freeing {:p} in allocator {:p} (size={})", ptr, block, block->bytes_per_chunk());
 
     if (s_scrub_free)
         memset(ptr, FREE_SCRUB_BYTE, block->bytes_per_chunk());
 
-    auto* entry = (FreelistEntry*)ptr;
-    entry->next = block->m_freelist;
-    block->m_freelist = entry;
-
-    if (block->is_full()) {
-        size_t good_size;
-        auto* allocator = allocator_for_size(block->m_size, good_size);
-        dbgln_if(MALLOC_DEBUG, "Block {:p} no longer full in size class {}", block, good_size);
-        g_malloc_stats.number_of_freed_full_blocks++;
-        allocator->full_blocks.remove(block);
-        allocator->usable_blocks.prepend(block);
+    size_t good_size;
+    auto* allocator = allocator_for_size(block->m_size, good_size);
+    size_t size_class = allocator - allocators();
+    if (size_class < number_of_thread_cached_size_classes) {
+        give_chunk_to_thread_cache(size_class, ptr);
+        return;
     }
 
-    ++block->m_free_chunks;
-
-    if (!block->used_chunks()) {
-        size_t good_size;
-        auto* allocator = allocator_for_size(block->m_size, good_size);
-        if (allocator->block_count < number_of_chunked_blocks_to_keep_around_per_size_class) {
-            dbgln_if(MALLOC_DEBUG, "Keeping block {:p} around for size class {}", block, good_size);
-            g_malloc_stats.number_of_keeps++;
-            allocator->usable_blocks.remove(block);
-            allocator->empty_blocks[allocator->empty_block_count++] = block;
-            mprotect(block, ChunkedBlock::block_size, PROT_NONE);
-            madvise(block, ChunkedBlock::block_size, MADV_SET_VOLATILE);
-            return;
-        }
-        dbgln_if(MALLOC_DEBUG, "Releasing block {:p} for size class {}", block, good_size);
-        g_malloc_stats.number_of_frees++;
-        allocator->usable_blocks.remove(block);
-        --allocator->block_count;
-        os_free(block, ChunkedBlock::block_size);
-    }
+    LOCKER(malloc_lock());
+    release_chunk(*allocator, ptr);
 }
 
 [[gnu::flatten]] void* malloc(size_t size)
@@ -388,7 +549,8 @@ size_t malloc_size(void* ptr)
 {
     if (!ptr)
         return 0;
-    LOCKER(malloc_lock());
+    // The header of a block doesn't change while any of its chunks are allocated,
+    // so this doesn't need the malloc lock.
     void* page_base = (void*)((FlatPtr)ptr & ChunkedBlock::block_mask);
     auto* header = (const CommonHeader*)page_base;
     auto size = header->m_size;
@@ -406,7 +568,6 @@ void* realloc(void* ptr, size_t size)
     if (!size)
         return nullptr;
 
-    LOCKER(malloc_lock());
     auto existing_allocation_size = malloc_size(ptr);
 
     if (size <= existing_allocation_size) {
@@ -439,29 +600,151 @@ void __malloc_init()
         allocators()[i].size = size_classes[i];
     }
 
-    new (&big_allocators()[0])(BigAllocator);
+    for (size_t i = 0; i < number_of_big_allocation_arenas; ++i)
+        new (&big_allocators()[i]) BigAllocator();
+}
+
+void __malloc_release_thread_cache()
+{
+    auto& cache = s_thread_cache;
+    LOCKER(malloc_lock());
+    for (size_t i = 0; i < number_of_thread_cached_size_classes; ++i)
+        flush_thread_cache_bin(i, 0);
+
+    g_malloc_stats.number_of_malloc_calls += exchange(cache.number_of_malloc_calls, 0);
+    g_malloc_stats.number_of_free_calls += exchange(cache.number_of_free_calls, 0);
+    g_malloc_stats.number_of_thread_cache_hits += exchange(cache.number_of_hits, 0);
+
+    if (!cache.is_registered)
+        return;
+    if (cache.prev)
+        cache.prev->next = cache.next;
+    else
+        s_thread_caches = cache.next;
+    if (cache.next)
+        cache.next->prev = cache.prev;
+    cache.is_registered = false;
+}
+
+struct MallocInfo {
+    MallocStats stats;
+    BigAllocationStats big_allocation_stats;
+    size_t number_of_recycled_big_blocks;
+    size_t number_of_thread_caches;
+
+    struct SizeClass {
+        size_t size;
+        size_t blocks;
+        size_t empty_blocks;
+        size_t used_chunks;
+        size_t free_chunks;
+        size_t cached_chunks;
+    };
+    SizeClass size_classes[num_size_classes];
+};
+
+static void collect_malloc_info(MallocInfo& info)
+{
+    for (auto& allocator : big_allocators()) {
+        LOCKER(allocator.lock);
+        info.big_allocation_stats.number_of_big_allocator_hits += allocator.stats.number_of_big_allocator_hits;
+        info.big_allocation_stats.number_of_big_allocator_purge_hits += allocator.stats.number_of_big_allocator_purge_hits;
+        info.big_allocation_stats.number_of_big_allocs += allocator.stats.number_of_big_allocs;
+        info.big_allocation_stats.number_of_big_allocator_keeps += allocator.stats.number_of_big_allocator_keeps;
+        info.big_allocation_stats.number_of_big_allocator_frees += allocator.stats.number_of_big_allocator_frees;
+        info.number_of_recycled_big_blocks += allocator.blocks.size();
+    }
+
+    LOCKER(malloc_lock());
+    info.stats = g_malloc_stats;
+
+    for (size_t i = 0; i < num_size_classes; ++i) {
+        auto& allocator = allocators()[i];
+        auto& size_class = info.size_classes[i];
+        size_class.size = allocator.size;
+        size_class.blocks = allocator.block_count;
+        size_class.empty_blocks = allocator.empty_block_count;
+        for (auto* block = allocator.usable_blocks.head(); block; block = block->next()) {
+            size_class.used_chunks += block->used_chunks();
+            size_class.free_chunks += block->free_chunks();
+        }
+        for (auto* block = allocator.full_blocks.head(); block; block = block->next())
+            size_class.used_chunks += block->used_chunks();
+    }
+
+    // The counters of the other threads are read while they may be changing, so they are only approximate.
+    for (auto* cache = s_thread_caches; cache; cache = cache->next) {
+        ++info.number_of_thread_caches;
+        info.stats.number_of_malloc_calls += cache->number_of_malloc_calls;
+        info.stats.number_of_free_calls += cache->number_of_free_calls;
+        info.stats.number_of_thread_cache_hits += cache->number_of_hits;
+        for (size_t i = 0; i < number_of_thread_cached_size_classes; ++i)
+            info.size_classes[i].cached_chunks += cache->bins[i].count;
+    }
+    if (!s_thread_cache.is_registered) {
+        info.stats.number_of_malloc_calls += s_thread_cache.number_of_malloc_calls;
+        info.stats.number_of_free_calls += s_thread_cache.number_of_free_calls;
+        info.stats.number_of_thread_cache_hits += s_thread_cache.number_of_hits;
+    }
+}
+
+int malloc_info(int options, FILE* stream)
+{
+    if (options != 0 || !stream) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    MallocInfo info {};
+    collect_malloc_info(info);
+
+    fprintf(stream, "<malloc version=\"1\">\n<sizes>\n");
+    for (auto& size_class : info.size_classes) {
+        fprintf(stream, "<size size=\"%zu\" blocks=\"%zu\" empty_blocks=\"%zu\" used_chunks=\"%zu\" free_chunks=\"%zu\" cached_chunks=\"%zu\"/>\n",
+            size_class.size, size_class.blocks, size_class.empty_blocks, size_class.used_chunks, size_class.free_chunks, size_class.cached_chunks);
+    }
+    fprintf(stream, "</sizes>\n");
+    fprintf(stream, "<total type=\"malloc\" count=\"%zu\"/>\n", info.stats.number_of_malloc_calls);
+    fprintf(stream, "<total type=\"free\" count=\"%zu\"/>\n", info.stats.number_of_free_calls);
+    fprintf(stream, "<total type=\"thread_cache_hits\" count=\"%zu\"/>\n", info.stats.number_of_thread_cache_hits);
+    fprintf(stream, "<total type=\"thread_cache_refills\" count=\"%zu\"/>\n", info.stats.number_of_thread_cache_refills);
+    fprintf(stream, "<total type=\"thread_cache_flushes\" count=\"%zu\"/>\n", info.stats.number_of_thread_cache_flushes);
+    fprintf(stream, "<total type=\"thread_caches\" count=\"%zu\"/>\n", info.number_of_thread_caches);
+    fprintf(stream, "<total type=\"block_allocs\" count=\"%zu\"/>\n", info.stats.number_of_block_allocs);
+    fprintf(stream, "<total type=\"big_allocs\" count=\"%zu\"/>\n", info.big_allocation_stats.number_of_big_allocs);
+    fprintf(stream, "<total type=\"big_allocator_hits\" count=\"%zu\"/>\n", info.big_allocation_stats.number_of_big_allocator_hits);
+    fprintf(stream, "<total type=\"recycled_big_blocks\" count=\"%zu\"/>\n", info.number_of_recycled_big_blocks);
+    fprintf(stream, "</malloc>\n");
+    return 0;
 }
 
 void serenity_dump_malloc_stats()
 {
-    dbgln("# malloc() calls: {}", g_malloc_stats.number_of_malloc_calls);
+    MallocInfo info {};
+    collect_malloc_info(info);
+
+    dbgln("# malloc() calls: {}", info.stats.number_of_malloc_calls);
+    dbgln();
+    dbgln("thread cache hits: {}", info.stats.number_of_thread_cache_hits);
+    dbgln("thread cache refills: {}", info.stats.number_of_thread_cache_refills);
+    dbgln("thread cache flushes: {}", info.stats.number_of_thread_cache_flushes);
     dbgln();
-    dbgln("big alloc hits: {}", g_malloc_stats.number_of_big_allocator_hits);
-    dbgln("big alloc hits that were purged: {}", g_malloc_stats.number_of_big_allocator_purge_hits);
-    dbgln("big allocs: {}", g_malloc_stats.number_of_big_allocs);
+    dbgln("big alloc hits: {}", info.big_allocation_stats.number_of_big_allocator_hits);
+    dbgln("big alloc hits that were purged: {}", info.big_allocation_stats.number_of_big_allocator_purge_hits);
+    dbgln("big allocs: {}", info.big_allocation_stats.number_of_big_allocs);
     dbgln();
-    dbgln("empty block hits: {}", g_malloc_stats.number_of_empty_block_hits);
-    dbgln("empty block hits that were purged: {}", g_malloc_stats.number_of_empty_block_purge_hits);
-    dbgln("block allocs: {}", g_malloc_stats.number_of_block_allocs);
-    dbgln("filled blocks: {}", g_malloc_stats.number_of_blocks_full);
+    dbgln("empty block hits: {}", info.stats.number_of_empty_block_hits);
+    dbgln("empty block hits that were purged: {}", info.stats.number_of_empty_block_purge_hits);
+    dbgln("block allocs: {}", info.stats.number_of_block_allocs);
+    dbgln("filled blocks: {}", info.stats.number_of_blocks_full);
     dbgln();
-    dbgln("# free() calls: {}", g_malloc_stats.number_of_free_calls);
+    dbgln("# free() calls: {}", info.stats.number_of_free_calls);
     dbgln();
-    dbgln("big alloc keeps: {}", g_malloc_stats.number_of_big_allocator_keeps);
-    dbgln("big alloc frees: {}", g_malloc_stats.number_of_big_allocator_frees);
+    dbgln("big alloc keeps: {}", info.big_allocation_stats.number_of_big_allocator_keeps);
+    dbgln("big alloc frees: {}", info.big_allocation_stats.number_of_big_allocator_frees);
     dbgln();
-    dbgln("full block frees: {}", g_malloc_stats.number_of_freed_full_blocks);
-    dbgln("number of keeps: {}", g_malloc_stats.number_of_keeps);
-    dbgln("number of frees: {}", g_malloc_stats.number_of_frees);
+    dbgln("full block frees: {}", info.stats.number_of_freed_full_blocks);
+    dbgln("number of keeps: {}", info.stats.number_of_keeps);
+    dbgln("number of frees: {}", info.stats.number_of_frees);
 }
 }
@@ -26,7 +26,9 @@
 
 #include <AK/Assertions.h>
 #include <AK/QuickSort.h>
+#include <AK/Types.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
 
 class SizedObject {
@@ -54,7 +56,14 @@ inline void swap(const SizedObject& a, const SizedObject& b)
     const size_t size = a.size();
     const auto a_data = reinterpret_cast<char*>(a.data());
     const auto b_data = reinterpret_cast<char*>(b.data());
-    for (auto i = 0u; i < size; ++i) {
+    size_t i = 0;
+    for (; i + sizeof(FlatPtr) <= size; i += sizeof(FlatPtr)) {
+        FlatPtr temp;
+        memcpy(&temp, a_data + i, sizeof(FlatPtr));
+        memcpy(a_data + i, b_data + i, sizeof(FlatPtr));
+        memcpy(b_data + i, &temp, sizeof(FlatPtr));
+    }
+    for (; i < size; ++i) {
         swap(a_data[i], b_data[i]);
     }
 }
@@ -79,24 +88,72 @@ private:
     size_t m_element_size;
 };
 
-void qsort(void* bot, size_t nmemb, size_t size, int (*compar)(const void*, const void*))
+// A pointer to a word-sized element. Like SizedObject, it can only be swapped, so the sort
+// never moves an element out of the array: C11 7.22.5 requires the comparison function to
+// be called with pointers to elements of the array, and some comparators rely on that.
+template<typename T>
+class Word {
+public:
+    explicit Word(T* data)
+        : m_data(data)
+    {
+    }
+    T* data() const { return m_data; }
+
+private:
+    T* m_data;
+};
+
+template<typename T>
+inline void swap(const Word<T>& a, const Word<T>& b)
 {
-    if (nmemb <= 1) {
-        return;
+    AK::swap(*a.data(), *b.data());
+}
+
+template<typename T>
+class WordSlice {
+public:
+    explicit WordSlice(T* data)
+        : m_data(data)
+    {
     }
+    const Word<T> operator[](size_t index) { return Word<T> { m_data + index }; }
 
-    SizedObjectSlice slice { bot, size };
+private:
+    T* m_data;
+};
 
-    AK::dual_pivot_quick_sort(slice, 0, nmemb - 1, [=](const SizedObject& a, const SizedObject& b) { return compar(a.data(), b.data()) < 0; });
+// Sorts 4 and 8 byte elements (ints, pointers, doubles, ...) as whole words instead of going
+// through SizedObject. Returns false if the elements don't have that size and alignment.
+template<typename T, typename Compare>
+static bool sort_as_words(void* bot, size_t nmemb, size_t size, Compare compare)
+{
+    if (size != sizeof(T) || reinterpret_cast<FlatPtr>(bot) % alignof(T) != 0)
+        return false;
+    WordSlice<T> slice { static_cast<T*>(bot) };
+    AK::pattern_defeating_quick_sort(slice, 0, nmemb, [&](const Word<T>& a, const Word<T>& b) { return compare(a.data(), b.data()) < 0; });
+    return true;
 }
 
-void qsort_r(void* bot, size_t nmemb, size_t size, int (*compar)(const void*, const void*, void*), void* arg)
+template<typename Compare>
+static void sort(void* bot, size_t nmemb, size_t size, Compare compare)
 {
-    if (nmemb <= 1) {
+    if (nmemb <= 1)
+        return;
+
+    if (sort_as_words<u32>(bot, nmemb, size, compare) || sort_as_words<u64>(bot, nmemb, size, compare))
         return;
-    }
 
     SizedObjectSlice slice { bot, size };
+    AK::pattern_defeating_quick_sort(slice, 0, nmemb, [&](const SizedObject& a, const SizedObject& b) { return compare(a.data(), b.data()) < 0; });
+}
 
-    AK::dual_pivot_quick_sort(slice, 0, nmemb - 1, [=](const SizedObject& a, const SizedObject& b) { return compar(a.data(), b.data(), arg) < 0; });
+void qsort(void* bot, size_t nmemb, size_t size, int (*compar)(const void*, const void*))
+{
+    sort(bot, nmemb, size, compar);
+}
+
+void qsort_r(void* bot, size_t nmemb, size_t size, int (*compar)(const void*, const void*, void*), void* arg)
+{
+    sort(bot, nmemb, size, [=](const void* a, const void* b) { return compar(a, b, arg); });
 }
@@ -31,13 +31,156 @@
 #include <assert.h>
 #include <ctype.h>
 #include <errno.h>
+#include <limits.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if ARCH(I386) || ARCH(X86_64)
+// SSE2 variants of the hot string functions, used if the CPU supports it (see __string_init()).
+// They look at 16 bytes at a time. Except where noted, they only load aligned blocks of 16 bytes
+// that contain at least one byte of the input, so they never touch a page the input isn't on.
+static bool s_use_sse2 = false;
+
+using ByteVector [[gnu::vector_size(16), gnu::may_alias]] = char;
+
+[[gnu::target("sse2")]] ALWAYS_INLINE static u32 mask_of_set_bytes(ByteVector vector)
+{
+    return __builtin_ia32_pmovmskb128(vector);
+}
+
+ALWAYS_INLINE static ByteVector load_aligned(const char* block)
+{
+    return *reinterpret_cast<const ByteVector*>(block);
+}
+
+ALWAYS_INLINE static ByteVector load_unaligned(const void* pointer)
+{
+    ByteVector vector;
+    __builtin_memcpy(&vector, pointer, sizeof(vector));
+    return vector;
+}
+
+ALWAYS_INLINE static ByteVector splat(char ch)
+{
+    return ByteVector {} + ch;
+}
+
+[[gnu::target("sse2")]] static size_t strlen_sse2(const char* str)
+{
+    auto offset = (FlatPtr)str & 15;
+    auto* block = str - offset;
+    u32 mask = mask_of_set_bytes((ByteVector)(load_aligned(block) == ByteVector {})) >> offset;
+    while (!mask) {
+        block += 16;
+        mask = mask_of_set_bytes((ByteVector)(load_aligned(block) == ByteVector {}));
+        offset = 0;
+    }
+    return block + offset + __builtin_ctz(mask) - str;
+}
+
+[[gnu::target("sse2")]] static const char* find_byte_sse2(const char* ptr, char ch, size_t size)
+{
+    if (!size)
+        return nullptr;
+    auto needle = splat(ch);
+    auto offset = (FlatPtr)ptr & 15;
+    u32 mask = mask_of_set_bytes((ByteVector)(load_aligned(ptr - offset) == needle)) >> offset;
+    size_t position = 0;
+    if (!mask) {
+        for (position = 16 - offset; position < size; position += 16) {
+            mask = mask_of_set_bytes((ByteVector)(load_aligned(ptr + position) == needle));
+            if (mask)
+                break;
+        }
+        if (!mask)
+            return nullptr;
+    }
+    position += __builtin_ctz(mask);
+    return position < size ? ptr + position : nullptr;
+}
+
+[[gnu::target("sse2")]] static size_t strnlen_sse2(const char* str, size_t maxlen)
+{
+    auto* terminator = find_byte_sse2(str, 0, maxlen);
+    return terminator ? terminator - str : maxlen;
+}
+
+[[gnu::target("sse2")]] static char* strchr_sse2(const char* str, char ch)
+{
+    auto needle = splat(ch);
+    auto offset = (FlatPtr)str & 15;
+    auto* block = str - offset;
+    auto data = load_aligned(block);
+    u32 mask = mask_of_set_bytes((ByteVector)((data == needle) | (data == ByteVector {}))) >> offset;
+    while (!mask) {
+        block += 16;
+        data = load_aligned(block);
+        mask = mask_of_set_bytes((ByteVector)((data == needle) | (data == ByteVector {})));
+        offset = 0;
+    }
+    auto* found = block + offset + __builtin_ctz(mask);
+    return *found == ch ? const_cast<char*>(found) : nullptr;
+}
+
+// Loads 16 bytes at a time from each side, unaligned; the loads stay clear of the ends of both inputs.
+[[gnu::target("sse2")]] static int memcmp_sse2(const u8* s1, const u8* s2, size_t n)
+{
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        u32 mask = mask_of_set_bytes((ByteVector)(load_unaligned(s1 + i) != load_unaligned(s2 + i)));
+        if (mask) {
+            i += __builtin_ctz(mask);
+            return s1[i] < s2[i] ? -1 : 1;
+        }
+    }
+    for (; i < n; ++i) {
+        if (s1[i] != s2[i])
+            return s1[i] < s2[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+// The strings can't be loaded in aligned blocks, as they are rarely aligned the same way.
+// Instead, unaligned blocks are loaded while neither of them crosses into the next page.
+[[gnu::target("sse2")]] static int strcmp_sse2(const char* s1, const char* s2)
+{
+    auto crosses_page = [](const char* pointer) {
+        return ((FlatPtr)pointer & (PAGE_SIZE - 1)) > PAGE_SIZE - 16;
+    };
+    for (size_t i = 0;;) {
+        if (crosses_page(s1 + i) || crosses_page(s2 + i)) {
+            if (s1[i] != s2[i] || !s1[i])
+                return (u8)s1[i] - (u8)s2[i];
+            ++i;
+            continue;
+        }
+        auto data1 = load_unaligned(s1 + i);
+        auto data2 = load_unaligned(s2 + i);
+        u32 mask = mask_of_set_bytes((ByteVector)((data1 != data2) | (data1 == ByteVector {})));
+        if (mask) {
+            i += __builtin_ctz(mask);
+            return (u8)s1[i] - (u8)s2[i];
+        }
+        i += 16;
+    }
+}
+#endif
+
 extern "C" {
 
+void __string_init()
+{
+#if ARCH(I386) || ARCH(X86_64)
+    u32 eax, ebx, ecx, edx;
+    asm("cpuid"
+        : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+        : "a"(1), "c"(0));
+    s_use_sse2 = edx & (1 << 26);
+#endif
+}
+
 size_t strspn(const char* s, const char* accept)
 {
     const char* p = s;
@@ -66,6 +209,10 @@ size_t strcspn(const char* s, const char* reject)
 
 size_t strlen(const char* str)
 {
+#if ARCH(I386) || ARCH(X86_64)
+    if (s_use_sse2)
+        return strlen_sse2(str);
+#endif
     size_t len = 0;
     while (*(str++))
         ++len;
@@ -74,6 +221,10 @@ size_t strlen(const char* str)
 
 size_t strnlen(const char* str, size_t maxlen)
 {
+#if ARCH(I386) || ARCH(X86_64)
+    if (s_use_sse2)
+        return strnlen_sse2(str, maxlen);
+#endif
     size_t len = 0;
     for (; len < maxlen && *str; str++)
         len++;
@@ -100,6 +251,10 @@ char* strndup(const char* str, size_t maxlen)
 
 int strcmp(const char* s1, const char* s2)
 {
+#if ARCH(I386) || ARCH(X86_64)
+    if (s_use_sse2)
+        return strcmp_sse2(s1, s2);
+#endif
     while (*s1 == *s2++)
         if (*s1++ == 0)
             return 0;
@@ -123,6 +278,10 @@ int memcmp(const void* v1, const void* v2, size_t n)
 {
     auto* s1 = (const uint8_t*)v1;
     auto* s2 = (const uint8_t*)v2;
+#if ARCH(I386) || ARCH(X86_64)
+    if (s_use_sse2)
+        return memcmp_sse2(s1, s2, n);
+#endif
     while (n-- > 0) {
         if (*s1++ != *s2++)
             return s1[-1] < s2[-1] ? -1 : 1;
@@ -220,6 +379,10 @@ size_t strlcpy(char* dest, const char* src, size_t n)
 char* strchr(const char* str, int c)
 {
     char ch = c;
+#if ARCH(I386) || ARCH(X86_64)
+    if (s_use_sse2)
+        return strchr_sse2(str, ch);
+#endif
     for (;; ++str) {
         if (*str == ch)
             return const_cast<char*>(str);
@@ -241,6 +404,10 @@ void* memchr(const void* ptr, int c, size_t size)
 {
     char ch = c;
     auto* cptr = (const char*)ptr;
+#if ARCH(I386) || ARCH(X86_64)
+    if (s_use_sse2)
+        return const_cast<char*>(find_byte_sse2(cptr, ch, size));
+#endif
     for (size_t i = 0; i < size; ++i) {
         if (cptr[i] == ch)
             return const_cast<char*>(cptr + i);
@@ -26,9 +26,9 @@
 
 #include <AK/Array.h>
 #include <AK/Assertions.h>
-#include <AK/BinarySearch.h>
 #include <AK/LogStream.h>
 #include <AK/MemoryStream.h>
+#include <AK/QuickSort.h>
 
 #include <LibCompress/Deflate.h>
 
@@ -36,68 +36,107 @@ namespace Compress {
 
 const CanonicalCode& CanonicalCode::fixed_literal_codes()
 {
-    static CanonicalCode code;
-    static bool initialized = false;
-
-    if (initialized)
-        return code;
-
-    Array<u8, 288> data;
-    data.span().slice(0, 144 - 0).fill(8);
-    data.span().slice(144, 256 - 144).fill(9);
-    data.span().slice(256, 280 - 256).fill(7);
-    data.span().slice(280, 288 - 280).fill(8);
-
-    code = CanonicalCode::from_bytes(data).value();
-    initialized = true;
+    static const CanonicalCode code = [] {
+        Array<u8, 288> data;
+        data.span().slice(0, 144 - 0).fill(8);
+        data.span().slice(144, 256 - 144).fill(9);
+        data.span().slice(256, 280 - 256).fill(7);
+        data.span().slice(280, 288 - 280).fill(8);
+        return CanonicalCode::from_bytes(data).value();
+    }();
 
     return code;
 }
 
 const CanonicalCode& CanonicalCode::fixed_distance_codes()
 {
-    static CanonicalCode code;
-    static bool initialized = false;
-
-    if (initialized)
-        return code;
-
-    Array<u8, 32> data;
-    data.span().fill(5);
-
-    code = CanonicalCode::from_bytes(data).value();
-    initialized = true;
+    static const CanonicalCode code = [] {
+        Array<u8, 32> data;
+        data.span().fill(5);
+        return CanonicalCode::from_bytes(data).value();
+    }();
 
     return code;
 }
 
 Optional<CanonicalCode> CanonicalCode::from_bytes(ReadonlyBytes bytes)
 {
-    // FIXME: I can't quite follow the algorithm here, but it seems to work.
-
     CanonicalCode code;
 
-    auto next_code = 0;
-    for (size_t code_length = 1; code_length <= 15; ++code_length) {
-        next_code <<= 1;
-        auto start_bit = 1 << code_length;
-
-        for (size_t symbol = 0; symbol < bytes.size(); ++symbol) {
-            if (bytes[symbol] != code_length)
-                continue;
+    Array<u16, max_code_length + 1> length_counts {};
+    for (auto length : bytes) {
+        if (length > max_code_length)
+            return {};
+        ++length_counts[length];
+    }
+    length_counts[0] = 0;
+
+    // The code has to use up all code space, except that a single code of length one is allowed
+    // (e.g. for the distances of a block with a single distance code).
+    i32 unused_codes = 1;
+    for (size_t length = 1; length <= max_code_length; ++length) {
+        unused_codes = (unused_codes << 1) - length_counts[length];
+        if (unused_codes < 0)
+            return {};
+    }
+    if (unused_codes != 0 && !(length_counts[1] == 1 && unused_codes == 1 << (max_code_length - 1)))
+        return {};
 
-            if (next_code > start_bit)
-                return {};
+    // Codes of the same length are consecutive, ordered by symbol; shorter codes come first.
+    Array<u16, max_code_length + 1> next_code {};
+    for (size_t length = 1; length <= max_code_length; ++length)
+        next_code[length] = (next_code[length - 1] + length_counts[length - 1]) << 1;
+
+    // The input is read least significant bit first, so the tables are indexed by the codes with
+    // their bits reversed.
+    Vector<u16> reversed_codes;
+    reversed_codes.resize(bytes.size());
+    for (size_t symbol = 0; symbol < bytes.size(); ++symbol) {
+        auto length = bytes[symbol];
+        if (length == 0)
+            continue;
 
-            code.m_symbol_codes.append(start_bit | next_code);
-            code.m_symbol_values.append(symbol);
+        u16 reversed = 0;
+        for (u16 value = next_code[length]++, i = 0; i < length; ++i, value >>= 1)
+            reversed = (reversed << 1) | (value & 1);
+        reversed_codes[symbol] = reversed;
+    }
 
-            next_code++;
+    // Each second-level table is as large as the longest code that continues in it requires.
+    Array<u8, 1 << primary_bits> secondary_bits {};
+    for (size_t symbol = 0; symbol < bytes.size(); ++symbol) {
+        if (bytes[symbol] > primary_bits) {
+            auto& bits = secondary_bits[reversed_codes[symbol] & ((1 << primary_bits) - 1)];
+            bits = max<u8>(bits, bytes[symbol] - primary_bits);
         }
     }
 
-    if (next_code != (1 << 15)) {
-        return {};
+    size_t secondary_size = 0;
+    for (size_t index = 0; index < code.m_primary_table.size(); ++index) {
+        if (secondary_bits[index] == 0)
+            continue;
+        code.m_primary_table[index] = { static_cast<u16>(secondary_size), secondary_bits[index], true };
+        secondary_size += 1 << secondary_bits[index];
+    }
+    code.m_secondary_table.resize(secondary_size);
+
+    for (size_t symbol = 0; symbol < bytes.size(); ++symbol) {
+        auto length = bytes[symbol];
+        if (length == 0)
+            continue;
+
+        auto reversed = reversed_codes[symbol];
+        Entry entry { static_cast<u16>(symbol), length, false };
+
+        if (length <= primary_bits) {
+            for (size_t index = reversed; index < code.m_primary_table.size(); index += 1 << length)
+                code.m_primary_table[index] = entry;
+            continue;
+        }
+
+        const auto& link = code.m_primary_table[reversed & ((1 << primary_bits) - 1)];
+        for (size_t index = reversed >> primary_bits; index < (1u << link.length); index += 1 << (length - primary_bits))
+            code.m_secondary_table[link.symbol_or_offset + index] = entry;
     }
 
     return code;
@@ -105,18 +144,20 @@ Optional<CanonicalCode> CanonicalCode::from_bytes(ReadonlyBytes bytes)
 
 u32 CanonicalCode::read_symbol(InputBitStream& stream) const
 {
-    u32 code_bits = 1;
+    stream.ensure_bits(max_code_length);
 
-    for (;;) {
-        code_bits = code_bits << 1 | stream.read_bits(1);
-        VERIFY(code_bits < (1 << 16));
+    auto entry = m_primary_table[stream.peek_bits(primary_bits)];
+    if (entry.is_link)
+        entry = m_secondary_table[entry.symbol_or_offset + (stream.peek_bits(primary_bits + entry.length) >> primary_bits)];
 
-        // FIXME: This is very inefficient and could greatly be improved by implementing this
-        //        algorithm: https://www.hanshq.net/zip.html#huffdec
-        size_t index;
-        if (binary_search(m_symbol_codes.span(), code_bits, &index))
-            return m_symbol_values[index];
+    if (entry.length == 0) {
+        // This can only happen for the unused half of a code with a single symbol.
+        stream.set_fatal_error();
+        return 0;
     }
+
+    stream.discard_bits(entry.length);
+    return entry.symbol_or_offset;
 }
 
 DeflateDecompressor::CompressedBlock::CompressedBlock(DeflateDecompressor& decompressor, CanonicalCode literal_codes, Optional<CanonicalCode> distance_codes)
@@ -131,31 +172,50 @@ bool DeflateDecompressor::CompressedBlock::try_read_more()
     if (m_eof == true)
         return false;
 
-    const auto symbol = m_literal_codes.read_symbol(m_decompressor.m_input_stream);
+    auto& input_stream = m_decompressor.m_input_stream;
+    auto& output_stream = m_decompressor.m_output_stream;
+
+    // Decode as much as fits into the window (while leaving room for the longest back-reference),
+    // so that the caller can read it out in large chunks.
+    while (output_stream.size() <= 32 * KiB - DeflateCompressor::max_match_length) {
+        const auto symbol = m_literal_codes.read_symbol(input_stream);
+
+        if (symbol < 256) {
+            const u8 byte = symbol;
+            output_stream.write({ &byte, sizeof(byte) });
+            continue;
+        }
+
+        if (symbol == 256) {
+            m_eof = true;
+            break;
+        }
 
-    if (symbol < 256) {
-        m_decompressor.m_output_stream << static_cast<u8>(symbol);
-        return true;
-    } else if (symbol == 256) {
-        m_eof = true;
-        return false;
-    } else {
         if (!m_distance_codes.has_value()) {
             m_decompressor.set_fatal_error();
             return false;
         }
 
         const auto length = m_decompressor.decode_length(symbol);
-        const auto distance = m_decompressor.decode_distance(m_distance_codes.value().read_symbol(m_decompressor.m_input_stream));
+        const auto distance = m_decompressor.decode_distance(m_distance_codes.value().read_symbol(input_stream));
+        if (!length.has_value() || !distance.has_value() || input_stream.has_any_error()) {
+            m_decompressor.set_fatal_error();
+            return false;
+        }
 
-        for (size_t idx = 0; idx < length; ++idx) {
-            u8 byte = 0;
-            m_decompressor.m_output_stream.read({ &byte, sizeof(byte) }, distance);
-            m_decompressor.m_output_stream << byte;
+        if (output_stream.copy_from_seekback(distance.value(), length.value()) != length.value()) {
+            output_stream.handle_any_error();
+            m_decompressor.set_fatal_error();
+            return false;
         }
+    }
 
-        return true;
+    if (input_stream.has_any_error()) {
+        m_decompressor.set_fatal_error();
+        return false;
     }
+
+    return true;
 }
 
 DeflateDecompressor::UncompressedBlock::UncompressedBlock(DeflateDecompressor& decompressor, size_t length)
@@ -174,10 +234,21 @@ bool DeflateDecompressor::UncompressedBlock::try_read_more()
 
     m_decompressor.m_input_stream >> m_decompressor.m_output_stream.reserve_contigous_space(nread);
 
+    if (m_decompressor.m_input_stream.has_any_error()) {
+        m_decompressor.set_fatal_error();
+        return false;
+    }
+
     return true;
 }
 
 DeflateDecompressor::DeflateDecompressor(InputStream& stream)
+    : m_owned_input_stream(make<InputBitStream>(stream))
+    , m_input_stream(*m_owned_input_stream)
+{
+}
+
+DeflateDecompressor::DeflateDecompressor(InputBitStream& stream)
     : m_input_stream(stream)
 {
 }
@@ -188,6 +259,9 @@ DeflateDecompressor::~DeflateDecompressor()
         m_compressed_block.~CompressedBlock();
     if (m_state == State::ReadingUncompressedBlock)
         m_uncompressed_block.~UncompressedBlock();
+
+    if (m_owned_input_stream)
+        m_owned_input_stream->handle_any_error();
 }
 
 size_t DeflateDecompressor::read(Bytes bytes)
@@ -202,13 +276,18 @@ size_t DeflateDecompressor::read(Bytes bytes)
         m_read_final_bock = m_input_stream.read_bit();
         const auto block_type = m_input_stream.read_bits(2);
 
+        if (m_input_stream.has_any_error()) {
+            set_fatal_error();
+            return 0;
+        }
+
         if (block_type == 0b00) {
             m_input_stream.align_to_byte_boundary();
 
             LittleEndian<u16> length, negated_length;
             m_input_stream >> length >> negated_length;
 
-            if ((length ^ 0xffff) != negated_length) {
+            if (m_input_stream.has_any_error() || (length ^ 0xffff) != negated_length) {
                 set_fatal_error();
                 return 0;
             }
@@ -231,6 +310,11 @@ size_t DeflateDecompressor::read(Bytes bytes)
             Optional<CanonicalCode> distance_codes;
             decode_codes(literal_codes, distance_codes);
 
+            if (m_input_stream.has_any_error()) {
+                set_fatal_error();
+                return 0;
+            }
+
             m_state = State::ReadingCompressedBlock;
             new (&m_compressed_block) CompressedBlock(*this, literal_codes, distance_codes);
 
@@ -323,37 +407,26 @@ Optional<ByteBuffer> DeflateDecompressor::decompress_all(ReadonlyBytes bytes)
     return output_stream.copy_into_contiguous_buffer();
 }
 
-u32 DeflateDecompressor::decode_length(u32 symbol)
+Optional<u32> DeflateDecompressor::decode_length(u32 symbol)
 {
-    // FIXME: I can't quite follow the algorithm here, but it seems to work.
+    static constexpr u16 base_lengths[] { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static constexpr u8 extra_bits[] { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
 
-    if (symbol <= 264)
-        return symbol - 254;
-
-    if (symbol <= 284) {
-        auto extra_bits = (symbol - 261) / 4;
-        return (((symbol - 265) % 4 + 4) << extra_bits) + 3 + m_input_stream.read_bits(extra_bits);
-    }
-
-    if (symbol == 285)
-        return 258;
+    if (symbol < 257 || symbol > 285)
+        return {};
 
-    VERIFY_NOT_REACHED();
+    return base_lengths[symbol - 257] + m_input_stream.read_bits(extra_bits[symbol - 257]);
 }
 
-u32 DeflateDecompressor::decode_distance(u32 symbol)
+Optional<u32> DeflateDecompressor::decode_distance(u32 symbol)
 {
-    // FIXME: I can't quite follow the algorithm here, but it seems to work.
-
-    if (symbol <= 3)
-        return symbol + 1;
+    static constexpr u16 base_distances[] { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    static constexpr u8 extra_bits[] { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
 
-    if (symbol <= 29) {
-        auto extra_bits = (symbol / 2) - 1;
-        return ((symbol % 2 + 2) << extra_bits) + 1 + m_input_stream.read_bits(extra_bits);
-    }
+    if (symbol > 29)
+        return {};
 
-    VERIFY_NOT_REACHED();
+    return base_distances[symbol] + m_input_stream.read_bits(extra_bits[symbol]);
 }
 
 void DeflateDecompressor::decode_codes(CanonicalCode& literal_code, Optional<CanonicalCode>& distance_code)
@@ -449,4 +522,629 @@ void DeflateDecompressor::decode_codes(CanonicalCode& literal_code, Optional<Can
     distance_code = distance_code_result.value();
 }
 
+static size_t length_symbol(size_t length)
+{
+    if (length == DeflateCompressor::max_match_length)
+        return 285;
+    auto offset = length - DeflateCompressor::min_match_length;
+    if (offset < 8)
+        return 257 + offset;
+    auto bits = 31 - __builtin_clz(offset);
+    return 257 + 4 * (bits - 1) + ((offset >> (bits - 2)) & 3);
+}
+
+static size_t length_extra_bits(size_t symbol)
+{
+    if (symbol < 265 || symbol == 285)
+        return 0;
+    return (symbol - 261) / 4;
+}
+
+static size_t distance_symbol(size_t distance)
+{
+    auto offset = distance - 1;
+    if (offset < 4)
+        return offset;
+    auto bits = 31 - __builtin_clz(offset);
+    return 2 * bits + ((offset >> (bits - 1)) & 1);
+}
+
+static size_t distance_extra_bits(size_t symbol)
+{
+    if (symbol < 4)
+        return 0;
+    return symbol / 2 - 1;
+}
+
+// The order in which the code lengths of the code length code are stored.
+static constexpr u8 code_length_code_order[] { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+DeflateCompressor::Parameters DeflateCompressor::parameters_for(CompressionLevel level)
+{
+    // These correspond to zlib's levels 1, 4, 6 and 9.
+    switch (level) {
+    case CompressionLevel::Store:
+    case CompressionLevel::Fastest:
+        return { 4, 4, 0, 8, false };
+    case CompressionLevel::Fast:
+        return { 16, 4, 4, 16, true };
+    case CompressionLevel::Good:
+        return { 128, 8, 16, 128, true };
+    case CompressionLevel::Best:
+        return { 4096, 32, 258, 258, true };
+    }
+    VERIFY_NOT_REACHED();
+}
+
+DeflateCompressor::DeflateCompressor(OutputStream& stream, CompressionLevel compression_level)
+    : m_output_stream(stream)
+    , m_compression_level(compression_level)
+    , m_parameters(parameters_for(compression_level))
+{
+    m_buffer = ByteBuffer::create_uninitialized(buffer_size);
+    m_hash_head.resize(hash_size);
+    m_hash_head.span().fill(no_position);
+    m_hash_previous.resize(window_size);
+    m_hash_previous.span().fill(no_position);
+    m_symbols.ensure_capacity(max_symbols_per_block);
+}
+
+DeflateCompressor::~DeflateCompressor()
+{
+    VERIFY(m_finished);
+}
+
+size_t DeflateCompressor::write(ReadonlyBytes bytes)
+{
+    VERIFY(!m_finished);
+    if (has_any_error())
+        return 0;
+
+    size_t nwritten = 0;
+    while (nwritten < bytes.size()) {
+        if (m_buffer_end == buffer_size) {
+            compress_buffer(false);
+            slide_window();
+        }
+
+        auto count = min(bytes.size() - nwritten, buffer_size - m_buffer_end);
+        __builtin_memcpy(m_buffer.data() + m_buffer_end, bytes.data() + nwritten, count);
+        m_buffer_end += count;
+        nwritten += count;
+    }
+
+    if (m_output_stream.handle_any_error()) {
+        set_fatal_error();
+        return 0;
+    }
+
+    return nwritten;
+}
+
+bool DeflateCompressor::write_or_error(ReadonlyBytes bytes)
+{
+    if (write(bytes) < bytes.size()) {
+        set_fatal_error();
+        return false;
+    }
+
+    return true;
+}
+
+void DeflateCompressor::final_flush()
+{
+    VERIFY(!m_finished);
+    m_finished = true;
+
+    compress_buffer(true);
+    flush_block(true);
+    m_output_stream.align_to_byte_boundary();
+
+    if (m_output_stream.handle_any_error())
+        set_fatal_error();
+}
+
+Optional<ByteBuffer> DeflateCompressor::compress_all(ReadonlyBytes bytes, CompressionLevel compression_level)
+{
+    DuplexMemoryStream output_stream;
+    DeflateCompressor deflate_stream { output_stream, compression_level };
+
+    deflate_stream.write_or_error(bytes);
+    deflate_stream.final_flush();
+
+    if (deflate_stream.handle_any_error())
+        return {};
+
+    return output_stream.copy_into_contiguous_buffer();
+}
+
+u32 DeflateCompressor::hash_at(size_t position) const
+{
+    auto* bytes = m_buffer.data() + position;
+    u32 value = bytes[0] << 16 | bytes[1] << 8 | bytes[2];
+    return (value * 2654435761u) >> (32 - hash_bits);
+}
+
+void DeflateCompressor::update_hashes_until(size_t position)
+{
+    for (; m_hashed_until < position && m_hashed_until + min_match_length <= m_buffer_end; ++m_hashed_until) {
+        auto hash = hash_at(m_hashed_until);
+        m_hash_previous[m_hashed_until % window_size] = m_hash_head[hash];
+        m_hash_head[hash] = m_hashed_until;
+    }
+}
+
+static size_t common_prefix_length(const u8* a, const u8* b, size_t max_length)
+{
+    size_t length = 0;
+    for (; length + sizeof(u64) <= max_length; length += sizeof(u64)) {
+        u64 a_word;
+        u64 b_word;
+        __builtin_memcpy(&a_word, a + length, sizeof(u64));
+        __builtin_memcpy(&b_word, b + length, sizeof(u64));
+        if (a_word != b_word)
+            return length + __builtin_ctzll(a_word ^ b_word) / 8;
+    }
+    while (length < max_length && a[length] == b[length])
+        ++length;
+    return length;
+}
+
+// Returns the length of the longest match for `position` in the window if it is longer than `previous_length`, or 0.
+size_t DeflateCompressor::longest_match(size_t position, size_t previous_length, size_t& distance) const
+{
+    if (position + min_match_length > m_buffer_end)
+        return 0;
+
+    auto max_length = min(max_match_length, m_buffer_end - position);
+    if (max_length <= previous_length)
+        return 0;
+
+    auto chain_length = m_parameters.max_chain;
+    if (previous_length >= m_parameters.good_length)
+        chain_length /= 4;
+    auto nice_length = min(m_parameters.nice_length, max_length);
+
+    auto* current = m_buffer.data() + position;
+    auto best_length = previous_length;
+    auto candidate = m_hash_previous[position % window_size];
+
+    // The distance has to stay below window_size, as the slot of `position - window_size` was just reused for `position`.
+    while (candidate < position && position - candidate < window_size && chain_length-- > 0) {
+        auto* match = m_buffer.data() + candidate;
+        if (match[best_length] == current[best_length] && match[0] == current[0]) {
+            auto length = common_prefix_length(match, current, max_length);
+            if (length > best_length) {
+                best_length = length;
+                distance = position - candidate;
+                if (length >= nice_length)
+                    break;
+            }
+        }
+
+        auto next = m_hash_previous[candidate % window_size];
+        if (next >= candidate)
+            break;
+        candidate = next;
+    }
+
+    return best_length > previous_length ? best_length : 0;
+}
+
+void DeflateCompressor::compress_buffer(bool final)
+{
+    // Unless this is the end of the input, only positions that can have a full-length match are done.
+    size_t end = m_buffer_end;
+    if (!final)
+        end = m_buffer_end > max_match_length ? m_buffer_end - max_match_length : 0;
+
+    if (m_compression_level == CompressionLevel::Store) {
+        m_position = max(m_position, end);
+        m_emitted_until = m_position;
+        return;
+    }
+
+    // A three byte match far away doesn't make up for the bits its distance costs.
+    constexpr size_t too_far_for_short_match = 4096;
+
+    if (!m_parameters.lazy) {
+        while (m_position < end) {
+            update_hashes_until(m_position + 1);
+            size_t distance = 0;
+            auto length = longest_match(m_position, min_match_length - 1, distance);
+            if (length == min_match_length && distance > too_far_for_short_match)
+                length = 0;
+
+            if (length >= min_match_length) {
+                emit_match(length, distance);
+                m_position += length;
+            } else {
+                emit_literal(m_buffer[m_position]);
+                ++m_position;
+            }
+        }
+        return;
+    }
+
+    // With lazy matching, a match is only taken once the next position has no longer match.
+    while (m_position < end) {
+        update_hashes_until(m_position + 1);
+        size_t distance = 0;
+        size_t length = 0;
+        if (!m_has_pending_match || m_pending_length < m_parameters.max_lazy_length) {
+            length = longest_match(m_position, m_has_pending_match ? max(m_pending_length, min_match_length - 1) : min_match_length - 1, distance);
+            if (length == min_match_length && distance > too_far_for_short_match)
+                length = 0;
+        }
+
+        if (m_has_pending_match) {
+            if (m_pending_length >= min_match_length && length <= m_pending_length) {
+                emit_match(m_pending_length, m_pending_distance);
+                m_position += m_pending_length - 1;
+                m_has_pending_match = false;
+                continue;
+            }
+            emit_literal(m_buffer[m_position - 1]);
+        }
+
+        m_has_pending_match = true;
+        m_pending_length = length;
+        m_pending_distance = distance;
+        ++m_position;
+    }
+
+    if (final && m_has_pending_match) {
+        if (m_pending_length >= min_match_length) {
+            emit_match(m_pending_length, m_pending_distance);
+            m_position += m_pending_length - 1;
+        } else {
+            emit_literal(m_buffer[m_position - 1]);
+        }
+        m_has_pending_match = false;
+    }
+}
+
+void DeflateCompressor::slide_window()
+{
+    // Everything more than a window behind the current position can go, in multiples of the
+    // window size so that the hash chain slots stay where they are.
+    auto shift = (m_position - window_size) / window_size * window_size;
+    VERIFY(shift > 0);
+
+    // Stored blocks are copied from the buffer, so the pending block must not be cut off.
+    if (m_block_start < shift)
+        flush_block(false);
+
+    __builtin_memmove(m_buffer.data(), m_buffer.data() + shift, m_buffer_end - shift);
+    m_buffer_end -= shift;
+    m_position -= shift;
+    m_block_start -= shift;
+    m_emitted_until -= shift;
+    m_hashed_until -= shift;
+
+    auto rebase = [&](u32& position) {
+        position = position == no_position || position < shift ? no_position : position - shift;
+    };
+    for (auto& position : m_hash_head)
+        rebase(position);
+    for (auto& position : m_hash_previous)
+        rebase(position);
+}
+
+void DeflateCompressor::emit_literal(u8 literal)
+{
+    m_symbols.unchecked_append({ 0, literal });
+    ++m_literal_frequencies[literal];
+    ++m_emitted_until;
+
+    if (m_symbols.size() == max_symbols_per_block)
+        flush_block(false);
+}
+
+void DeflateCompressor::emit_match(size_t length, size_t distance)
+{
+    m_symbols.unchecked_append({ static_cast<u16>(distance), static_cast<u16>(length) });
+    ++m_literal_frequencies[length_symbol(length)];
+    ++m_distance_frequencies[distance_symbol(distance)];
+    m_emitted_until += length;
+
+    if (m_symbols.size() == max_symbols_per_block)
+        flush_block(false);
+}
+
+static void assign_canonical_codes(Span<const u8> lengths, Span<u16> codes)
+{
+    u16 length_counts[16] {};
+    for (auto length : lengths)
+        ++length_counts[length];
+    length_counts[0] = 0;
+
+    u16 next_code[16] {};
+    u16 code = 0;
+    for (size_t length = 1; length < 16; ++length) {
+        code = (code + length_counts[length - 1]) << 1;
+        next_code[length] = code;
+    }
+
+    // The codes are written least significant bit first, but are defined most significant bit first.
+    for (size_t symbol = 0; symbol < lengths.size(); ++symbol) {
+        auto length = lengths[symbol];
+        if (length == 0)
+            continue;
+        u16 value = next_code[length]++;
+        u16 reversed = 0;
+        for (size_t bit = 0; bit < length; ++bit)
+            reversed |= ((value >> bit) & 1) << (length - 1 - bit);
+        codes[symbol] = reversed;
+    }
+}
+
+void DeflateCompressor::build_huffman_code(HuffmanCode& code, Span<const u32> frequencies, size_t max_bit_length)
+{
+    VERIFY(frequencies.size() <= code.lengths.size());
+    code.lengths.span().fill(0);
+
+    struct Leaf {
+        u32 frequency;
+        u16 symbol;
+    };
+    Vector<Leaf, 288> leaves;
+    for (size_t symbol = 0; symbol < frequencies.size(); ++symbol) {
+        if (frequencies[symbol] != 0)
+            leaves.append({ frequencies[symbol], static_cast<u16>(symbol) });
+    }
+
+    // A code needs at least two symbols to be complete, which the decoder insists on.
+    for (u16 symbol = 0; leaves.size() < 2; ++symbol) {
+        if (frequencies[symbol] == 0)
+            leaves.append({ 1, symbol });
+    }
+
+    quick_sort(leaves, [](auto& a, auto& b) { return a.frequency < b.frequency; });
+
+    // Builds the tree by always merging the two lightest nodes. The merged nodes come out in
+    // order of weight, so taking the lighter head of the leaves and of the merged nodes suffices.
+    // If the tree turns out too deep, the weights are flattened and it's built again.
+    auto leaf_count = leaves.size();
+    Vector<u32, 576> weights;
+    Vector<u16, 576> parents;
+    Vector<u8, 576> depths;
+    for (;;) {
+        weights.clear();
+        for (auto& leaf : leaves)
+            weights.append(leaf.frequency);
+        parents.resize(2 * leaf_count - 1);
+
+        size_t next_leaf = 0;
+        size_t next_node = leaf_count;
+        auto take_lightest = [&] {
+            if (next_leaf < leaf_count && (next_node == weights.size() || weights[next_leaf] <= weights[next_node]))
+                return next_leaf++;
+            return next_node++;
+        };
+        while (weights.size() < 2 * leaf_count - 1) {
+            auto first = take_lightest();
+            auto second = take_lightest();
+            parents[first] = weights.size();
+            parents[second] = weights.size();
+            weights.append(weights[first] + weights[second]);
+        }
+
+        depths.resize(weights.size());
+        depths.last() = 0;
+        size_t max_depth = 0;
+        for (size_t node = weights.size() - 1; node-- > 0;) {
+            depths[node] = depths[parents[node]] + 1;
+            max_depth = max<size_t>(max_depth, depths[node]);
+        }
+
+        if (max_depth <= max_bit_length)
+            break;
+
+        for (auto& leaf : leaves)
+            leaf.frequency = (leaf.frequency + 1) / 2;
+    }
+
+    for (size_t i = 0; i < leaf_count; ++i)
+        code.lengths[leaves[i].symbol] = depths[i];
+    assign_canonical_codes(code.lengths.span().trim(frequencies.size()), code.codes.span().trim(frequencies.size()));
+}
+
+const DeflateCompressor::HuffmanCode& DeflateCompressor::fixed_literal_code()
+{
+    static const HuffmanCode code = [] {
+        HuffmanCode code;
+        code.lengths.span().slice(0, 144 - 0).fill(8);
+        code.lengths.span().slice(144, 256 - 144).fill(9);
+        code.lengths.span().slice(256, 280 - 256).fill(7);
+        code.lengths.span().slice(280, 288 - 280).fill(8);
+        assign_canonical_codes(code.lengths.span(), code.codes.span());
+        return code;
+    }();
+
+    return code;
+}
+
+const DeflateCompressor::HuffmanCode& DeflateCompressor::fixed_distance_code()
+{
+    static const HuffmanCode code = [] {
+        HuffmanCode code;
+        code.lengths.span().trim(32).fill(5);
+        assign_canonical_codes(code.lengths.span().trim(32), code.codes.span().trim(32));
+        return code;
+    }();
+
+    return code;
+}
+
+void DeflateCompressor::write_stored_block(ReadonlyBytes bytes, bool final)
+{
+    do {
+        auto chunk = bytes.trim(0xffff);
+        bytes = bytes.slice(chunk.size());
+
+        m_output_stream.write_bit(final && bytes.is_empty());
+        m_output_stream.write_bits(0b00, 2);
+        m_output_stream.align_to_byte_boundary();
+        m_output_stream.write_bits(chunk.size(), 16);
+        m_output_stream.write_bits(chunk.size() ^ 0xffff, 16);
+        m_output_stream.write_or_error(chunk);
+    } while (!bytes.is_empty());
+}
+
+void DeflateCompressor::write_symbols(const HuffmanCode& literal_code, const HuffmanCode& distance_code)
+{
+    for (auto& symbol : m_symbols) {
+        if (symbol.distance == 0) {
+            auto literal = symbol.literal_or_length;
+            m_output_stream.write_bits(literal_code.codes[literal], literal_code.lengths[literal]);
+            continue;
+        }
+
+        auto length = symbol.literal_or_length;
+        auto symbol_for_length = length_symbol(length);
+        auto extra_bits = length_extra_bits(symbol_for_length);
+        auto extra_value = (length - min_match_length) & ((1u << extra_bits) - 1);
+        m_output_stream.write_bits(literal_code.codes[symbol_for_length] | extra_value << literal_code.lengths[symbol_for_length], literal_code.lengths[symbol_for_length] + extra_bits);
+
+        auto distance = symbol.distance;
+        auto symbol_for_distance = distance_symbol(distance);
+        extra_bits = distance_extra_bits(symbol_for_distance);
+        extra_value = (distance - 1) & ((1u << extra_bits) - 1);
+        m_output_stream.write_bits(distance_code.codes[symbol_for_distance] | extra_value << distance_code.lengths[symbol_for_distance], distance_code.lengths[symbol_for_distance] + extra_bits);
+    }
+
+    m_output_stream.write_bits(literal_code.codes[end_of_block], literal_code.lengths[end_of_block]);
+}
+
+void DeflateCompressor::flush_block(bool final)
+{
+    ReadonlyBytes block_data { m_buffer.data() + m_block_start, m_emitted_until - m_block_start };
+    if (!final && block_data.is_empty())
+        return;
+
+    if (m_compression_level == CompressionLevel::Store) {
+        write_stored_block(block_data, final);
+        m_block_start = m_emitted_until;
+        return;
+    }
+
+    m_literal_frequencies[end_of_block] = 1;
+
+    HuffmanCode literal_code;
+    HuffmanCode distance_code;
+    build_huffman_code(literal_code, m_literal_frequencies, 15);
+    build_huffman_code(distance_code, m_distance_frequencies, 15);
+
+    size_t literal_code_count = literal_length_code_count;
+    while (literal_code_count > 257 && literal_code.lengths[literal_code_count - 1] == 0)
+        --literal_code_count;
+    size_t distance_code_count_used = distance_code_count;
+    while (distance_code_count_used > 1 && distance_code.lengths[distance_code_count_used - 1] == 0)
+        --distance_code_count_used;
+
+    // The code lengths of both codes are run-length encoded with the code length code. Each
+    // entry is a code length symbol in the low 5 bits, and the repeat count above that.
+    Vector<u8, literal_length_code_count + distance_code_count> all_lengths;
+    all_lengths.append(literal_code.lengths.data(), literal_code_count);
+    all_lengths.append(distance_code.lengths.data(), distance_code_count_used);
+
+    Vector<u16, literal_length_code_count + distance_code_count> code_length_symbols;
+    Array<u32, code_length_code_count> code_length_frequencies {};
+    auto append_code_length_symbol = [&](u16 symbol, u16 repeat_value = 0) {
+        code_length_symbols.append(symbol | repeat_value << 5);
+        ++code_length_frequencies[symbol];
+    };
+    for (size_t i = 0; i < all_lengths.size();) {
+        auto length = all_lengths[i];
+        size_t run_length = 1;
+        while (i + run_length < all_lengths.size() && all_lengths[i + run_length] == length)
+            ++run_length;
+        i += run_length;
+
+        if (length == 0) {
+            while (run_length >= 11) {
+                auto count = min<size_t>(run_length, 138);
+                append_code_length_symbol(18, count - 11);
+                run_length -= count;
+            }
+            if (run_length >= 3) {
+                append_code_length_symbol(17, run_length - 3);
+                run_length = 0;
+            }
+        } else {
+            append_code_length_symbol(length);
+            --run_length;
+            while (run_length >= 3) {
+                auto count = min<size_t>(run_length, 6);
+                append_code_length_symbol(16, count - 3);
+                run_length -= count;
+            }
+        }
+        for (; run_length > 0; --run_length)
+            append_code_length_symbol(length);
+    }
+
+    HuffmanCode code_length_code;
+    build_huffman_code(code_length_code, code_length_frequencies, 7);
+    size_t code_length_code_count_used = code_length_code_count;
+    while (code_length_code_count_used > 4 && code_length_code.lengths[code_length_code_order[code_length_code_count_used - 1]] == 0)
+        --code_length_code_count_used;
+
+    // Pick whichever kind of block comes out smallest.
+    size_t extra_bits = 0;
+    size_t dynamic_bits = 3 + 5 + 5 + 4 + 3 * code_length_code_count_used;
+    size_t fixed_bits = 3;
+    for (size_t symbol = 0; symbol < literal_length_code_count; ++symbol) {
+        auto frequency = m_literal_frequencies[symbol];
+        extra_bits += frequency * length_extra_bits(symbol);
+        dynamic_bits += frequency * literal_code.lengths[symbol];
+        fixed_bits += frequency * fixed_literal_code().lengths[symbol];
+    }
+    for (size_t symbol = 0; symbol < distance_code_count; ++symbol) {
+        auto frequency = m_distance_frequencies[symbol];
+        extra_bits += frequency * distance_extra_bits(symbol);
+        dynamic_bits += frequency * distance_code.lengths[symbol];
+        fixed_bits += frequency * fixed_distance_code().lengths[symbol];
+    }
+    static constexpr u8 code_length_extra_bits[] { 2, 3, 7 };
+    for (size_t symbol = 0; symbol < code_length_code_count; ++symbol) {
+        auto frequency = code_length_frequencies[symbol];
+        dynamic_bits += frequency * code_length_code.lengths[symbol];
+        if (symbol >= 16)
+            dynamic_bits += frequency * code_length_extra_bits[symbol - 16];
+    }
+    dynamic_bits += extra_bits;
+    fixed_bits += extra_bits;
+    size_t stored_bits = (block_data.size() + 5 * (block_data.size() / 0xffff + 1)) * 8 + 7;
+
+    if (stored_bits < min(dynamic_bits, fixed_bits)) {
+        write_stored_block(block_data, final);
+    } else if (fixed_bits <= dynamic_bits) {
+        m_output_stream.write_bit(final);
+        m_output_stream.write_bits(0b01, 2);
+        write_symbols(fixed_literal_code(), fixed_distance_code());
+    } else {
+        m_output_stream.write_bit(final);
+        m_output_stream.write_bits(0b10, 2);
+        m_output_stream.write_bits(literal_code_count - 257, 5);
+        m_output_stream.write_bits(distance_code_count_used - 1, 5);
+        m_output_stream.write_bits(code_length_code_count_used - 4, 4);
+        for (size_t i = 0; i < code_length_code_count_used; ++i)
+            m_output_stream.write_bits(code_length_code.lengths[code_length_code_order[i]], 3);
+        for (auto entry : code_length_symbols) {
+            auto symbol = entry & 0x1f;
+            m_output_stream.write_bits(code_length_code.codes[symbol], code_length_code.lengths[symbol]);
+            if (symbol >= 16)
+                m_output_stream.write_bits(entry >> 5, code_length_extra_bits[symbol - 16]);
+        }
+        write_symbols(literal_code, distance_code);
+    }
+
+    m_symbols.clear_with_capacity();
+    m_literal_frequencies.span().fill(0);
+    m_distance_frequencies.span().fill(0);
+    m_block_start = m_emitted_until;
+}
+
 }
@@ -26,14 +26,19 @@
 
 #pragma once
 
+#include <AK/Array.h>
 #include <AK/BitStream.h>
 #include <AK/ByteBuffer.h>
 #include <AK/CircularDuplexStream.h>
 #include <AK/Endian.h>
+#include <AK/NumericLimits.h>
+#include <AK/OwnPtr.h>
 #include <AK/Vector.h>
 
 namespace Compress {
 
+// Decodes Huffman codes with a table indexed by the next `primary_bits` bits of input. Codes that
+// are longer than that continue in a second-level table, indexed by the bits that follow.
 class CanonicalCode {
 public:
     CanonicalCode() = default;
@@ -45,8 +50,19 @@ public:
     static Optional<CanonicalCode> from_bytes(ReadonlyBytes);
 
 private:
-    Vector<u32> m_symbol_codes;
-    Vector<u32> m_symbol_values;
+    static constexpr size_t primary_bits = 9;
+    static constexpr size_t max_code_length = 15;
+
+    // A symbol and the length of its code, or (if `is_link` is set) the offset of a second-level
+    // table and how many bits index it.
+    struct Entry {
+        u16 symbol_or_offset { 0 };
+        u8 length { 0 };
+        bool is_link { false };
+    };
+
+    Array<Entry, 1 << primary_bits> m_primary_table;
+    Vector<Entry> m_secondary_table;
 };
 
 class DeflateDecompressor final : public InputStream {
@@ -87,6 +103,8 @@ public:
     friend UncompressedBlock;
 
     DeflateDecompressor(InputStream&);
+    // Leaves any data that follows the compressed stream to be read from the given bit stream.
+    DeflateDecompressor(InputBitStream&);
     ~DeflateDecompressor();
 
     size_t read(Bytes) override;
@@ -98,8 +116,8 @@ public:
     static Optional<ByteBuffer> decompress_all(ReadonlyBytes);
 
 private:
-    u32 decode_length(u32);
-    u32 decode_distance(u32);
+    Optional<u32> decode_length(u32);
+    Optional<u32> decode_distance(u32);
     void decode_codes(CanonicalCode& literal_code, Optional<CanonicalCode>& distance_code);
 
     bool m_read_final_bock { false };
@@ -110,8 +128,114 @@ private:
         UncompressedBlock m_uncompressed_block;
     };
 
-    InputBitStream m_input_stream;
+    OwnPtr<InputBitStream> m_owned_input_stream;
+    InputBitStream& m_input_stream;
     CircularDuplexStream<32 * 1024> m_output_stream;
 };
 
+// Compresses into the DEFLATE format (RFC 1951).
+//
+// Matches are found with hash chains over a sliding 32 KiB window. Each block is emitted as
+// stored, fixed Huffman or dynamic Huffman, whichever comes out smallest.
+class DeflateCompressor final : public OutputStream {
+public:
+    enum class CompressionLevel {
+        Store,
+        Fastest,
+        Fast,
+        Good,
+        Best,
+    };
+
+    static constexpr size_t window_size = 32 * KiB;
+    static constexpr size_t min_match_length = 3;
+    static constexpr size_t max_match_length = 258;
+
+    DeflateCompressor(OutputStream&, CompressionLevel = CompressionLevel::Good);
+    ~DeflateCompressor();
+
+    size_t write(ReadonlyBytes) override;
+    bool write_or_error(ReadonlyBytes) override;
+
+    // Compresses all remaining input and writes the final block; nothing can be written afterwards.
+    void final_flush();
+
+    static Optional<ByteBuffer> compress_all(ReadonlyBytes, CompressionLevel = CompressionLevel::Good);
+
+private:
+    static constexpr size_t buffer_size = 3 * window_size;
+    static constexpr size_t hash_bits = 15;
+    static constexpr size_t hash_size = 1 << hash_bits;
+    static constexpr size_t max_symbols_per_block = 1 << 15;
+    static constexpr size_t literal_length_code_count = 286;
+    static constexpr size_t distance_code_count = 30;
+    static constexpr size_t code_length_code_count = 19;
+    static constexpr u16 end_of_block = 256;
+    static constexpr u32 no_position = NumericLimits<u32>::max();
+
+    struct Parameters {
+        size_t max_chain;
+        size_t good_length;
+        size_t max_lazy_length;
+        size_t nice_length;
+        bool lazy;
+    };
+    static Parameters parameters_for(CompressionLevel);
+
+    // A literal if distance is zero, a back-reference otherwise.
+    struct Symbol {
+        u16 distance;
+        u16 literal_or_length;
+    };
+
+    struct HuffmanCode {
+        Array<u8, 288> lengths {};
+        Array<u16, 288> codes {};
+    };
+
+    void compress_buffer(bool final);
+    void slide_window();
+    u32 hash_at(size_t position) const;
+    void update_hashes_until(size_t position);
+    size_t longest_match(size_t position, size_t previous_length, size_t& distance) const;
+
+    void emit_literal(u8);
+    void emit_match(size_t length, size_t distance);
+    void flush_block(bool final);
+    void write_stored_block(ReadonlyBytes, bool final);
+    void write_symbols(const HuffmanCode& literal_code, const HuffmanCode& distance_code);
+
+    static void build_huffman_code(HuffmanCode&, Span<const u32> frequencies, size_t max_bit_length);
+    static const HuffmanCode& fixed_literal_code();
+    static const HuffmanCode& fixed_distance_code();
+
+    OutputBitStream m_output_stream;
+    CompressionLevel m_compression_level;
+    Parameters m_parameters;
+    bool m_finished { false };
+
+    ByteBuffer m_buffer;
+    size_t m_buffer_end { 0 };
+    size_t m_position { 0 };
+    // The input from m_block_start to m_emitted_until is what the pending symbols encode.
+    size_t m_block_start { 0 };
+    size_t m_emitted_until { 0 };
+
+    // Positions in m_buffer of the most recent occurrence of each hash, and of the previous
+    // occurrence of the same hash for each window position.
+    Vector<u32> m_hash_head;
+    Vector<u32> m_hash_previous;
+    // Up to which position the hash chains are filled in.
+    size_t m_hashed_until { 0 };
+
+    // The match found at the previous position, while deciding whether the current one is better.
+    bool m_has_pending_match { false };
+    size_t m_pending_length { 0 };
+    size_t m_pending_distance { 0 };
+
+    Vector<Symbol> m_symbols;
+    Array<u32, literal_length_code_count> m_literal_frequencies {};
+    Array<u32, distance_code_count> m_distance_frequencies {};
+};
+
 }
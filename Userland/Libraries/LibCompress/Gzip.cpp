@@ -64,6 +64,7 @@ GzipDecompressor::GzipDecompressor(InputStream& stream)
 GzipDecompressor::~GzipDecompressor()
 {
     m_current_member.clear();
+    m_input_stream.handle_any_error();
 }
 
 // FIXME: Again, there are surely a ton of bugs because the code doesn't check for read errors.
@@ -74,6 +75,11 @@ size_t GzipDecompressor::read(Bytes bytes)
 
     if (m_current_member.has_value()) {
         size_t nread = current_member().m_stream.read(bytes);
+        if (current_member().m_stream.handle_any_error()) {
+            set_fatal_error();
+            return 0;
+        }
+
         current_member().m_checksum.update(bytes.trim(nread));
         current_member().m_nread += nread;
 
@@ -187,4 +193,73 @@ Optional<ByteBuffer> GzipDecompressor::decompress_all(ReadonlyBytes bytes)
 
 bool GzipDecompressor::unreliable_eof() const { return m_eof; }
 
+GzipCompressor::GzipCompressor(OutputStream& stream, DeflateCompressor::CompressionLevel compression_level)
+    : m_output_stream(stream)
+    , m_deflate_stream(stream, compression_level)
+{
+    u8 extra_flags = 0;
+    if (compression_level == DeflateCompressor::CompressionLevel::Best)
+        extra_flags = 2;
+    else if (compression_level == DeflateCompressor::CompressionLevel::Fastest)
+        extra_flags = 4;
+
+    // No file name or modification time is recorded; 3 is the operating system code for Unix.
+    const u8 header[] { gzip_magic_1, gzip_magic_2, 0x08, 0, 0, 0, 0, 0, extra_flags, 3 };
+    m_output_stream << ReadonlyBytes { header, sizeof(header) };
+}
+
+GzipCompressor::~GzipCompressor()
+{
+}
+
+size_t GzipCompressor::write(ReadonlyBytes bytes)
+{
+    if (has_any_error())
+        return 0;
+
+    auto nwritten = m_deflate_stream.write(bytes);
+    m_checksum.update(bytes.trim(nwritten));
+    m_total_size += nwritten;
+
+    if (m_deflate_stream.handle_any_error())
+        set_fatal_error();
+
+    return nwritten;
+}
+
+bool GzipCompressor::write_or_error(ReadonlyBytes bytes)
+{
+    if (write(bytes) < bytes.size()) {
+        set_fatal_error();
+        return false;
+    }
+
+    return true;
+}
+
+void GzipCompressor::final_flush()
+{
+    m_deflate_stream.final_flush();
+    if (m_deflate_stream.handle_any_error())
+        set_fatal_error();
+
+    LittleEndian<u32> crc32 = m_checksum.digest();
+    LittleEndian<u32> input_size = m_total_size;
+    m_output_stream << crc32 << input_size;
+}
+
+Optional<ByteBuffer> GzipCompressor::compress_all(ReadonlyBytes bytes, DeflateCompressor::CompressionLevel compression_level)
+{
+    DuplexMemoryStream output_stream;
+    GzipCompressor gzip_stream { output_stream, compression_level };
+
+    gzip_stream.write_or_error(bytes);
+    gzip_stream.final_flush();
+
+    if (gzip_stream.handle_any_error() || output_stream.handle_any_error())
+        return {};
+
+    return output_stream.copy_into_contiguous_buffer();
+}
+
 }
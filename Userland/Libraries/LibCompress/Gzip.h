@@ -74,7 +74,7 @@ private:
 
     class Member {
     public:
-        Member(BlockHeader header, InputStream& stream)
+        Member(BlockHeader header, InputBitStream& stream)
             : m_header(header)
             , m_stream(stream)
         {
@@ -89,10 +89,32 @@ private:
     const Member& current_member() const { return m_current_member.value(); }
     Member& current_member() { return m_current_member.value(); }
 
-    InputStream& m_input_stream;
+    // Headers and trailers are read through the same bit stream as the compressed data, which may
+    // have read ahead into them.
+    InputBitStream m_input_stream;
     Optional<Member> m_current_member;
 
     bool m_eof { false };
 };
 
+class GzipCompressor final : public OutputStream {
+public:
+    GzipCompressor(OutputStream&, DeflateCompressor::CompressionLevel = DeflateCompressor::CompressionLevel::Good);
+    ~GzipCompressor();
+
+    size_t write(ReadonlyBytes) override;
+    bool write_or_error(ReadonlyBytes) override;
+
+    // Finishes the compressed data and writes the trailer; nothing can be written afterwards.
+    void final_flush();
+
+    static Optional<ByteBuffer> compress_all(ReadonlyBytes, DeflateCompressor::CompressionLevel = DeflateCompressor::CompressionLevel::Good);
+
+private:
+    OutputStream& m_output_stream;
+    DeflateCompressor m_deflate_stream;
+    Crypto::Checksum::CRC32 m_checksum;
+    u32 m_total_size { 0 };
+};
+
 }
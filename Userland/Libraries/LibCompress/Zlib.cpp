@@ -25,11 +25,13 @@
  */
 
 #include <AK/Assertions.h>
+#include <AK/MemoryStream.h>
 #include <AK/Span.h>
 #include <AK/Types.h>
 #include <AK/Vector.h>
 #include <LibCompress/Deflate.h>
 #include <LibCompress/Zlib.h>
+#include <LibCrypto/Checksum/Adler32.h>
 
 namespace Compress {
 
@@ -66,6 +68,43 @@ Optional<ByteBuffer> Zlib::decompress_all(ReadonlyBytes bytes)
     return zlib.decompress();
 }
 
+Optional<ByteBuffer> Zlib::compress_all(ReadonlyBytes bytes, DeflateCompressor::CompressionLevel compression_level)
+{
+    DuplexMemoryStream output_stream;
+
+    // Deflate with a 32 KiB window, and a hint about how hard the compressor tried.
+    u8 compression_info = 0x78;
+    u8 flags = 0;
+    switch (compression_level) {
+    case DeflateCompressor::CompressionLevel::Store:
+    case DeflateCompressor::CompressionLevel::Fastest:
+        flags = 0 << 6;
+        break;
+    case DeflateCompressor::CompressionLevel::Fast:
+        flags = 1 << 6;
+        break;
+    case DeflateCompressor::CompressionLevel::Good:
+        flags = 2 << 6;
+        break;
+    case DeflateCompressor::CompressionLevel::Best:
+        flags = 3 << 6;
+        break;
+    }
+    flags |= 31 - (compression_info * 256 + flags) % 31;
+    output_stream << compression_info << flags;
+
+    DeflateCompressor deflate_stream { output_stream, compression_level };
+    deflate_stream.write_or_error(bytes);
+    deflate_stream.final_flush();
+    if (deflate_stream.handle_any_error())
+        return {};
+
+    BigEndian<u32> adler32 = Crypto::Checksum::Adler32(bytes).digest();
+    output_stream << adler32;
+
+    return output_stream.copy_into_contiguous_buffer();
+}
+
 u32 Zlib::checksum()
 {
     if (!m_checksum) {
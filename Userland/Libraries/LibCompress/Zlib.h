@@ -29,6 +29,7 @@
 #include <AK/ByteBuffer.h>
 #include <AK/Span.h>
 #include <AK/Types.h>
+#include <LibCompress/Deflate.h>
 
 namespace Compress {
 
@@ -40,6 +41,7 @@ public:
     u32 checksum();
 
     static Optional<ByteBuffer> decompress_all(ReadonlyBytes);
+    static Optional<ByteBuffer> compress_all(ReadonlyBytes, DeflateCompressor::CompressionLevel = DeflateCompressor::CompressionLevel::Good);
 
 private:
     u8 m_compression_method;
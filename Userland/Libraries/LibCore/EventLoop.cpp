@@ -31,6 +31,7 @@
 #include <AK/JsonObject.h>
 #include <AK/JsonValue.h>
 #include <AK/NeverDestroyed.h>
+#include <AK/ScopeGuard.h>
 #include <AK/Singleton.h>
 #include <AK/TemporaryChange.h>
 #include <AK/Time.h>
@@ -66,9 +67,170 @@ struct EventLoopTimer {
     bool should_reload { false };
     TimerShouldFireWhenNotVisible fire_when_not_visible { TimerShouldFireWhenNotVisible::No };
     WeakPtr<Object> owner;
+    // The position of the timer in s_timer_heap, or in s_parked_timers if it is parked.
+    size_t index { 0 };
+    bool is_parked { false };
 
     void reload(const timeval& now);
     bool has_expired(const timeval& now) const;
+    bool fires_before(const EventLoopTimer& other) const;
+    bool is_suppressed() const;
+};
+
+// A binary min-heap of timers ordered by fire time, so the next timer to expire is
+// always at the front. Every timer knows its own position in the heap, which makes
+// unregistering one O(log n) as well.
+class TimerHeap {
+public:
+    bool is_empty() const { return m_timers.is_empty(); }
+    EventLoopTimer& first() { return *m_timers.first(); }
+
+    void insert(EventLoopTimer& timer)
+    {
+        timer.index = m_timers.size();
+        m_timers.append(&timer);
+        sift_up(timer.index);
+    }
+
+    void remove(EventLoopTimer& timer)
+    {
+        size_t index = timer.index;
+        VERIFY(m_timers[index] == &timer);
+        auto* last = m_timers.take_last();
+        if (index == m_timers.size())
+            return;
+        m_timers[index] = last;
+        last->index = index;
+        sift_up(index);
+        sift_down(last->index);
+    }
+
+    void clear() { m_timers.clear(); }
+
+private:
+    void swap_entries(size_t a, size_t b)
+    {
+        swap(m_timers[a], m_timers[b]);
+        m_timers[a]->index = a;
+        m_timers[b]->index = b;
+    }
+
+    void sift_up(size_t index)
+    {
+        while (index > 0) {
+            size_t parent = (index - 1) / 2;
+            if (!m_timers[index]->fires_before(*m_timers[parent]))
+                return;
+            swap_entries(index, parent);
+            index = parent;
+        }
+    }
+
+    void sift_down(size_t index)
+    {
+        for (;;) {
+            size_t soonest = index;
+            for (size_t child = 2 * index + 1; child <= 2 * index + 2 && child < m_timers.size(); ++child) {
+                if (m_timers[child]->fires_before(*m_timers[soonest]))
+                    soonest = child;
+            }
+            if (soonest == index)
+                return;
+            swap_entries(index, soonest);
+            index = soonest;
+        }
+    }
+
+    Vector<EventLoopTimer*> m_timers;
+};
+
+// The fd_sets select() waits on, kept up to date as notifiers come, go and change
+// their event masks instead of being rebuilt from all notifiers on every iteration.
+class NotifierSet {
+public:
+    NotifierSet() { clear(); }
+
+    void add(Notifier& notifier)
+    {
+        auto& notifiers = m_notifiers_by_fd.ensure(notifier.fd());
+        if (!notifiers.contains_slow(&notifier))
+            notifiers.append(&notifier);
+        update_fd(notifier.fd());
+    }
+
+    void remove(Notifier& notifier)
+    {
+        auto it = m_notifiers_by_fd.find(notifier.fd());
+        if (it == m_notifiers_by_fd.end())
+            return;
+        it->value.remove_first_matching([&](auto* entry) { return entry == &notifier; });
+        update_fd(notifier.fd());
+    }
+
+    void update(Notifier& notifier)
+    {
+        if (m_notifiers_by_fd.contains(notifier.fd()))
+            update_fd(notifier.fd());
+    }
+
+    void clear()
+    {
+        m_notifiers_by_fd.clear();
+        FD_ZERO(&m_read_fds);
+        FD_ZERO(&m_write_fds);
+        m_max_fd = -1;
+    }
+
+    const fd_set& read_fds() const { return m_read_fds; }
+    const fd_set& write_fds() const { return m_write_fds; }
+    int max_fd() const { return m_max_fd; }
+
+    template<typename Callback>
+    void for_each_notifier_on(int fd, Callback callback)
+    {
+        auto it = m_notifiers_by_fd.find(fd);
+        if (it == m_notifiers_by_fd.end())
+            return;
+        for (auto* notifier : it->value)
+            callback(*notifier);
+    }
+
+private:
+    void update_fd(int fd)
+    {
+        auto it = m_notifiers_by_fd.find(fd);
+        VERIFY(it != m_notifiers_by_fd.end());
+        unsigned event_mask = 0;
+        for (auto* notifier : it->value)
+            event_mask |= notifier->event_mask();
+        if (event_mask & Notifier::Exceptional)
+            VERIFY_NOT_REACHED();
+
+        if (event_mask & Notifier::Read)
+            FD_SET(fd, &m_read_fds);
+        else
+            FD_CLR(fd, &m_read_fds);
+        if (event_mask & Notifier::Write)
+            FD_SET(fd, &m_write_fds);
+        else
+            FD_CLR(fd, &m_write_fds);
+
+        if (!it->value.is_empty()) {
+            m_max_fd = max(m_max_fd, fd);
+            return;
+        }
+        m_notifiers_by_fd.remove(it);
+        if (fd == m_max_fd) {
+            m_max_fd = -1;
+            for (auto& entry : m_notifiers_by_fd)
+                m_max_fd = max(m_max_fd, entry.key);
+        }
+    }
+
+    HashMap<int, Vector<Notifier*, 1>> m_notifiers_by_fd;
+    fd_set m_read_fds;
+    fd_set m_write_fds;
+    int m_max_fd { -1 };
 };
 
 struct EventLoop::Private {
@@ -79,11 +241,35 @@ static EventLoop* s_main_event_loop;
 static Vector<EventLoop*>* s_event_loop_stack;
 static NeverDestroyed<IDAllocator> s_id_allocator;
 static HashMap<int, NonnullOwnPtr<EventLoopTimer>>* s_timers;
-static HashTable<Notifier*>* s_notifiers;
+static TimerHeap* s_timer_heap;
+// Expired timers whose owners aren't visible; they fire once their owner becomes visible again.
+static Vector<EventLoopTimer*>* s_parked_timers;
+static NotifierSet* s_notifiers;
+static EventLoop::Statistics s_statistics;
+static timeval s_last_iteration_end;
 int EventLoop::s_wake_pipe_fds[2];
 static RefPtr<LocalServer> s_rpc_server;
 HashMap<int, RefPtr<RPCClient>> s_rpc_clients;
 
+static timeval current_time()
+{
+    timespec now_spec;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now_spec);
+    timeval now;
+    now.tv_sec = now_spec.tv_sec;
+    now.tv_usec = now_spec.tv_nsec / 1000;
+    return now;
+}
+
+static u64 microseconds_between(const timeval& start, const timeval& end)
+{
+    timeval difference;
+    timeval_sub(end, start, difference);
+    if (difference.tv_sec < 0)
+        return 0;
+    return (u64)difference.tv_sec * 1000000 + difference.tv_usec;
+}
+
 class SignalHandlers : public RefCounted<SignalHandlers> {
     AK_MAKE_NONCOPYABLE(SignalHandlers);
     AK_MAKE_NONMOVABLE(SignalHandlers);
@@ -258,6 +444,20 @@ public:
             return;
         }
 
+        if (type == "GetEventLoopStatistics") {
+            auto& statistics = EventLoop::statistics();
+            JsonObject response;
+            response.set("type", type);
+            response.set("iterations", statistics.iterations);
+            response.set("microseconds_waiting", statistics.microseconds_waiting);
+            response.set("microseconds_busy", statistics.microseconds_busy);
+            response.set("longest_iteration_microseconds", statistics.longest_iteration_microseconds);
+            response.set("timers_fired", statistics.timers_fired);
+            response.set("notifier_events", statistics.notifier_events);
+            send_response(response);
+            return;
+        }
+
         if (type == "Disconnect") {
             shutdown();
             return;
@@ -282,7 +482,9 @@ EventLoop::EventLoop()
     if (!s_event_loop_stack) {
         s_event_loop_stack = new Vector<EventLoop*>;
         s_timers = new HashMap<int, NonnullOwnPtr<EventLoopTimer>>;
-        s_notifiers = new HashTable<Notifier*>;
+        s_timer_heap = new TimerHeap;
+        s_parked_timers = new Vector<EventLoopTimer*>;
+        s_notifiers = new NotifierSet;
     }
 
     if (!s_main_event_loop) {
@@ -398,6 +600,15 @@ void EventLoop::pump(WaitMode mode)
 {
     wait_for_event(mode);
 
+    ScopeGuard update_statistics([] {
+        auto now = current_time();
+        auto iteration_time = microseconds_between(s_last_iteration_end, now);
+        s_last_iteration_end = now;
+        ++s_statistics.iterations;
+        s_statistics.microseconds_busy += iteration_time;
+        s_statistics.longest_iteration_microseconds = max(s_statistics.longest_iteration_microseconds, iteration_time);
+    });
+
     decltype(m_queued_events) events;
     {
         LOCKER(m_private->lock);
@@ -599,6 +810,8 @@ void EventLoop::notify_forked(ForkEvent event)
         s_main_event_loop = nullptr;
         s_event_loop_stack->clear();
         s_timers->clear();
+        s_timer_heap->clear();
+        s_parked_timers->clear();
         s_notifiers->clear();
         if (auto* info = signals_info<false>()) {
             info->signal_handlers.clear();
@@ -620,27 +833,10 @@ void EventLoop::wait_for_event(WaitMode mode)
     fd_set rfds;
     fd_set wfds;
 retry:
-    FD_ZERO(&rfds);
-    FD_ZERO(&wfds);
-
-    int max_fd = 0;
-    auto add_fd_to_set = [&max_fd](int fd, fd_set& set) {
-        FD_SET(fd, &set);
-        if (fd > max_fd)
-            max_fd = fd;
-    };
-
-    int max_fd_added = -1;
-    add_fd_to_set(s_wake_pipe_fds[0], rfds);
-    max_fd = max(max_fd, max_fd_added);
-    for (auto& notifier : *s_notifiers) {
-        if (notifier->event_mask() & Notifier::Read)
-            add_fd_to_set(notifier->fd(), rfds);
-        if (notifier->event_mask() & Notifier::Write)
-            add_fd_to_set(notifier->fd(), wfds);
-        if (notifier->event_mask() & Notifier::Exceptional)
-            VERIFY_NOT_REACHED();
-    }
+    rfds = s_notifiers->read_fds();
+    wfds = s_notifiers->write_fds();
+    FD_SET(s_wake_pipe_fds[0], &rfds);
+    int max_fd = max(s_notifiers->max_fd(), s_wake_pipe_fds[0]);
 
     bool queued_events_is_empty;
     {
@@ -654,10 +850,7 @@ retry:
     if (mode == WaitMode::WaitForEvents && queued_events_is_empty) {
         auto next_timer_expiration = get_next_timer_expiration();
         if (next_timer_expiration.has_value()) {
-            timespec now_spec;
-            clock_gettime(CLOCK_MONOTONIC_COARSE, &now_spec);
-            now.tv_sec = now_spec.tv_sec;
-            now.tv_usec = now_spec.tv_nsec / 1000;
+            now = current_time();
             timeval_sub(next_timer_expiration.value(), now, timeout);
             if (timeout.tv_sec < 0 || (timeout.tv_sec == 0 && timeout.tv_usec < 0)) {
                 timeout.tv_sec = 0;
@@ -683,6 +876,12 @@ try_select_again:
         // Blow up, similar to Core::safe_syscall.
         VERIFY_NOT_REACHED();
     }
+
+    now = current_time();
+    if (s_last_iteration_end.tv_sec || s_last_iteration_end.tv_usec)
+        s_statistics.microseconds_waiting += microseconds_between(s_last_iteration_end, now);
+    s_last_iteration_end = now;
+
     if (FD_ISSET(s_wake_pipe_fds[0], &rfds)) {
         int wake_events[8];
         auto nread = read(s_wake_pipe_fds[0], wake_events, sizeof(wake_events));
@@ -704,76 +903,128 @@ try_select_again:
             goto retry;
     }
 
-    if (!s_timers->is_empty()) {
-        timespec now_spec;
-        clock_gettime(CLOCK_MONOTONIC_COARSE, &now_spec);
-        now.tv_sec = now_spec.tv_sec;
-        now.tv_usec = now_spec.tv_nsec / 1000;
-    }
+    fire_expired_timers(now);
 
-    for (auto& it : *s_timers) {
-        auto& timer = *it.value;
-        if (!timer.has_expired(now))
+    if (!marked_fd_count)
+        return;
+
+    for (int fd = 0; fd <= max_fd && marked_fd_count > 0; ++fd) {
+        bool is_readable = FD_ISSET(fd, &rfds);
+        bool is_writable = FD_ISSET(fd, &wfds);
+        if (!is_readable && !is_writable)
             continue;
+        marked_fd_count -= is_readable + is_writable;
+        s_notifiers->for_each_notifier_on(fd, [&](Notifier& notifier) {
+            if (is_readable && (notifier.event_mask() & Notifier::Event::Read)) {
+                post_event(notifier, make<NotifierReadEvent>(fd));
+                ++s_statistics.notifier_events;
+            }
+            if (is_writable && (notifier.event_mask() & Notifier::Event::Write)) {
+                post_event(notifier, make<NotifierWriteEvent>(fd));
+                ++s_statistics.notifier_events;
+            }
+        });
+    }
+}
+
+void EventLoop::fire_expired_timers(const timeval& now)
+{
+    auto fire = [&](EventLoopTimer& timer) {
         auto owner = timer.owner.strong_ref();
-        if (timer.fire_when_not_visible == TimerShouldFireWhenNotVisible::No
-            && owner && !owner->is_visible_for_timer_purposes()) {
-            continue;
-        }
 #if EVENTLOOP_DEBUG
         dbgln("Core::EventLoop: Timer {} has expired, sending Core::TimerEvent to {}", timer.timer_id, *owner);
 #endif
         if (owner)
             post_event(*owner, make<TimerEvent>(timer.timer_id));
+        ++s_statistics.timers_fired;
         if (timer.should_reload) {
             timer.reload(now);
         } else {
             // FIXME: Support removing expired timers that don't want to reload.
             VERIFY_NOT_REACHED();
         }
-    }
-
-    if (!marked_fd_count)
-        return;
+    };
 
-    for (auto& notifier : *s_notifiers) {
-        if (FD_ISSET(notifier->fd(), &rfds)) {
-            if (notifier->event_mask() & Notifier::Event::Read)
-                post_event(*notifier, make<NotifierReadEvent>(notifier->fd()));
+    // Parked timers have expired already, so they fire as soon as their owner becomes visible.
+    for (size_t i = 0; i < s_parked_timers->size();) {
+        auto& timer = *s_parked_timers->at(i);
+        if (timer.is_suppressed()) {
+            ++i;
+            continue;
         }
-        if (FD_ISSET(notifier->fd(), &wfds)) {
-            if (notifier->event_mask() & Notifier::Event::Write)
-                post_event(*notifier, make<NotifierWriteEvent>(notifier->fd()));
+        unpark_timer(timer);
+        fire(timer);
+        s_timer_heap->insert(timer);
+    }
+
+    // Take all expired timers out first, as a reloaded timer with a zero interval is immediately due again.
+    Vector<EventLoopTimer*, 16> expired_timers;
+    while (!s_timer_heap->is_empty() && s_timer_heap->first().has_expired(now)) {
+        auto& timer = s_timer_heap->first();
+        s_timer_heap->remove(timer);
+        if (timer.is_suppressed()) {
+            timer.is_parked = true;
+            timer.index = s_parked_timers->size();
+            s_parked_timers->append(&timer);
+            continue;
         }
+        expired_timers.append(&timer);
+    }
+
+    for (auto* timer : expired_timers) {
+        fire(*timer);
+        s_timer_heap->insert(*timer);
     }
 }
 
+void EventLoop::unpark_timer(EventLoopTimer& timer)
+{
+    VERIFY(timer.is_parked);
+    auto* last = s_parked_timers->take_last();
+    if (last != &timer) {
+        s_parked_timers->at(timer.index) = last;
+        last->index = timer.index;
+    }
+    timer.is_parked = false;
+}
+
 bool EventLoopTimer::has_expired(const timeval& now) const
 {
     return now.tv_sec > fire_time.tv_sec || (now.tv_sec == fire_time.tv_sec && now.tv_usec >= fire_time.tv_usec);
 }
 
+bool EventLoopTimer::fires_before(const EventLoopTimer& other) const
+{
+    return fire_time.tv_sec < other.fire_time.tv_sec || (fire_time.tv_sec == other.fire_time.tv_sec && fire_time.tv_usec < other.fire_time.tv_usec);
+}
+
+// Whether the timer should hold off firing because its owner is hidden.
+bool EventLoopTimer::is_suppressed() const
+{
+    if (fire_when_not_visible == TimerShouldFireWhenNotVisible::Yes)
+        return false;
+    auto strong_owner = owner.strong_ref();
+    return strong_owner && !strong_owner->is_visible_for_timer_purposes();
+}
+
 void EventLoopTimer::reload(const timeval& now)
 {
     fire_time = now;
     fire_time.tv_sec += interval / 1000;
     fire_time.tv_usec += (interval % 1000) * 1000;
+    if (fire_time.tv_usec >= 1000000) {
+        fire_time.tv_sec += 1;
+        fire_time.tv_usec -= 1000000;
+    }
 }
 
 Optional<struct timeval> EventLoop::get_next_timer_expiration()
 {
-    Optional<struct timeval> soonest {};
-    for (auto& it : *s_timers) {
-        auto& fire_time = it.value->fire_time;
-        auto owner = it.value->owner.strong_ref();
-        if (it.value->fire_when_not_visible == TimerShouldFireWhenNotVisible::No
-            && owner && !owner->is_visible_for_timer_purposes()) {
-            continue;
-        }
-        if (!soonest.has_value() || fire_time.tv_sec < soonest.value().tv_sec || (fire_time.tv_sec == soonest.value().tv_sec && fire_time.tv_usec < soonest.value().tv_usec))
-            soonest = fire_time;
-    }
-    return soonest;
+    // Parked timers don't count, like before they expired. A timer at the front of the heap whose
+    // owner is hidden may cause one wakeup too many, after which it gets parked.
+    if (s_timer_heap->is_empty())
+        return {};
+    return s_timer_heap->first().fire_time;
 }
 
 int EventLoop::register_timer(Object& object, int milliseconds, bool should_reload, TimerShouldFireWhenNotVisible fire_when_not_visible)
@@ -782,16 +1033,12 @@ int EventLoop::register_timer(Object& object, int milliseconds, bool should_relo
     auto timer = make<EventLoopTimer>();
     timer->owner = object;
     timer->interval = milliseconds;
-    timeval now;
-    timespec now_spec;
-    clock_gettime(CLOCK_MONOTONIC_COARSE, &now_spec);
-    now.tv_sec = now_spec.tv_sec;
-    now.tv_usec = now_spec.tv_nsec / 1000;
-    timer->reload(now);
+    timer->reload(current_time());
     timer->should_reload = should_reload;
     timer->fire_when_not_visible = fire_when_not_visible;
     int timer_id = s_id_allocator->allocate();
     timer->timer_id = timer_id;
+    s_timer_heap->insert(*timer);
     s_timers->set(timer_id, move(timer));
     return timer_id;
 }
@@ -802,18 +1049,33 @@ bool EventLoop::unregister_timer(int timer_id)
     auto it = s_timers->find(timer_id);
     if (it == s_timers->end())
         return false;
+    auto& timer = *it->value;
+    if (timer.is_parked)
+        unpark_timer(timer);
+    else
+        s_timer_heap->remove(timer);
     s_timers->remove(it);
     return true;
 }
 
 void EventLoop::register_notifier(Badge<Notifier>, Notifier& notifier)
 {
-    s_notifiers->set(&notifier);
+    s_notifiers->add(notifier);
 }
 
 void EventLoop::unregister_notifier(Badge<Notifier>, Notifier& notifier)
 {
-    s_notifiers->remove(&notifier);
+    s_notifiers->remove(notifier);
+}
+
+void EventLoop::update_notifier(Badge<Notifier>, Notifier& notifier)
+{
+    s_notifiers->update(notifier);
+}
+
+const EventLoop::Statistics& EventLoop::statistics()
+{
+    return s_statistics;
 }
 
 void EventLoop::wake()
@@ -39,6 +39,8 @@
 
 namespace Core {
 
+struct EventLoopTimer;
+
 class EventLoop {
 public:
     EventLoop();
@@ -67,6 +69,18 @@ public:
 
     static void register_notifier(Badge<Notifier>, Notifier&);
     static void unregister_notifier(Badge<Notifier>, Notifier&);
+    static void update_notifier(Badge<Notifier>, Notifier&);
+
+    // Counters covering all event loops in this process.
+    struct Statistics {
+        u64 iterations { 0 };
+        u64 microseconds_waiting { 0 };
+        u64 microseconds_busy { 0 };
+        u64 longest_iteration_microseconds { 0 };
+        u64 timers_fired { 0 };
+        u64 notifier_events { 0 };
+    };
+    static const Statistics& statistics();
 
     void quit(int);
     void unquit();
@@ -92,6 +106,8 @@ private:
     bool start_rpc_server();
     void wait_for_event(WaitMode);
     Optional<struct timeval> get_next_timer_expiration();
+    void fire_expired_timers(const timeval& now);
+    static void unpark_timer(EventLoopTimer&);
     static void dispatch_signal(int);
     static void handle_signal(int);
 
@@ -143,6 +143,13 @@ void UnsignedBigInteger::set_to(const UnsignedBigInteger& other)
     m_cached_trimmed_length = {};
 }
 
+void UnsignedBigInteger::trim_leading_zero_words()
+{
+    while (!m_words.is_empty() && m_words.last() == 0)
+        m_words.take_last();
+    m_cached_trimmed_length = {};
+}
+
 size_t UnsignedBigInteger::trimmed_length() const
 {
     if (!m_cached_trimmed_length.has_value()) {
@@ -590,73 +597,274 @@ FLATTEN void UnsignedBigInteger::shift_left_without_allocation(
 /**
  * Complexity: O(N^2) where N is the number of words in the larger number
  * Multiplication method:
- * An integer is equal to the sum of the powers of two
- * according to the indexes of its 'on' bits.
- * So to multiple x*y, we go over each '1' bit in x (say the i'th bit), 
- * and add y<<i to the result.
+ * Grade school multiplication, one word of the left number at a time, keeping
+ * the 64-bit carry of each row of partial products.
+ */
+static void multiply_words_schoolbook(const u32* left, size_t left_length, const u32* right, size_t right_length, u32* output)
+{
+    __builtin_memset(output, 0, (left_length + right_length) * sizeof(u32));
+    for (size_t i = 0; i < left_length; ++i) {
+        u64 left_word = left[i];
+        if (left_word == 0)
+            continue;
+        u64 carry = 0;
+        for (size_t j = 0; j < right_length; ++j) {
+            u64 product = left_word * right[j] + output[i + j] + carry;
+            output[i + j] = (u32)product;
+            carry = product >> 32;
+        }
+        output[i + right_length] = (u32)carry;
+    }
+}
+
+// Adds the source words to the destination in place, and returns the carry out of the destination.
+static u32 add_words_in_place(u32* destination, size_t destination_length, const u32* source, size_t source_length)
+{
+    VERIFY(source_length <= destination_length);
+    u64 carry = 0;
+    for (size_t i = 0; i < source_length; ++i) {
+        u64 sum = (u64)destination[i] + source[i] + carry;
+        destination[i] = (u32)sum;
+        carry = sum >> 32;
+    }
+    for (size_t i = source_length; carry && i < destination_length; ++i) {
+        u64 sum = (u64)destination[i] + carry;
+        destination[i] = (u32)sum;
+        carry = sum >> 32;
+    }
+    return (u32)carry;
+}
+
+// Subtracts the source words from the destination in place, which has to be the larger of the two.
+static void subtract_words_in_place(u32* destination, size_t destination_length, const u32* source, size_t source_length)
+{
+    VERIFY(source_length <= destination_length);
+    u32 borrow = 0;
+    for (size_t i = 0; i < source_length; ++i) {
+        u64 difference = (u64)destination[i] - source[i] - borrow;
+        destination[i] = (u32)difference;
+        borrow = (difference >> 32) & 1;
+    }
+    for (size_t i = source_length; borrow && i < destination_length; ++i) {
+        borrow = destination[i] == 0;
+        --destination[i];
+    }
+    VERIFY(borrow == 0);
+}
+
+// Below this many words, the extra additions of Karatsuba multiplication cost more than they save.
+static constexpr size_t karatsuba_threshold = 32;
+
+/**
+ * Complexity: O(N^1.585) where N is the number of words in the larger number
+ * Multiplication method:
+ * Karatsuba's algorithm: split both numbers at the same word, x = x1 * B + x0 and y = y1 * B + y0,
+ * then x * y = z2 * B^2 + (z1 - z2 - z0) * B + z0, where z2 = x1 * y1, z0 = x0 * y0 and
+ * z1 = (x1 + x0) * (y1 + y0). That is three half-size multiplications instead of four.
+ */
+static void multiply_words(const u32* left, size_t left_length, const u32* right, size_t right_length, u32* output)
+{
+    if (left_length < right_length) {
+        swap(left, right);
+        swap(left_length, right_length);
+    }
+
+    if (right_length < karatsuba_threshold) {
+        multiply_words_schoolbook(left, left_length, right, right_length, output);
+        return;
+    }
+
+    if (left_length >= 2 * right_length) {
+        // The numbers are too unbalanced to split at the same place, so multiply
+        // slices of the longer one that are as long as the shorter one.
+        __builtin_memset(output, 0, (left_length + right_length) * sizeof(u32));
+        Vector<u32> product;
+        product.resize(2 * right_length);
+        for (size_t offset = 0; offset < left_length; offset += right_length) {
+            size_t slice_length = min(right_length, left_length - offset);
+            multiply_words(left + offset, slice_length, right, right_length, product.data());
+            add_words_in_place(output + offset, left_length + right_length - offset, product.data(), slice_length + right_length);
+        }
+        return;
+    }
+
+    size_t split = left_length / 2;
+    size_t left_high_length = left_length - split;
+    size_t right_high_length = right_length - split;
+    size_t output_length = left_length + right_length;
+
+    // z0 and z2 go straight into the low and high halves of the output.
+    multiply_words(left, split, right, split, output);
+    multiply_words(left + split, left_high_length, right + split, right_high_length, output + 2 * split);
+
+    size_t left_sum_length = left_high_length + 1;
+    size_t right_sum_length = max(split, right_high_length) + 1;
+    Vector<u32> scratch;
+    scratch.resize(left_sum_length + right_sum_length + left_sum_length + right_sum_length);
+    u32* left_sum = scratch.data();
+    u32* right_sum = left_sum + left_sum_length;
+    u32* middle = right_sum + right_sum_length;
+
+    __builtin_memcpy(left_sum, left + split, left_high_length * sizeof(u32));
+    left_sum[left_high_length] = add_words_in_place(left_sum, left_high_length, left, split);
+    __builtin_memset(right_sum, 0, right_sum_length * sizeof(u32));
+    __builtin_memcpy(right_sum, right + split, right_high_length * sizeof(u32));
+    add_words_in_place(right_sum, right_sum_length, right, split);
+
+    size_t middle_length = left_sum_length + right_sum_length;
+    multiply_words(left_sum, left_sum_length, right_sum, right_sum_length, middle);
+    subtract_words_in_place(middle, middle_length, output, 2 * split);
+    subtract_words_in_place(middle, middle_length, output + 2 * split, output_length - 2 * split);
+
+    // What is left of z1 fits in the output, so its top words are all zero.
+    while (middle_length > output_length - split) {
+        VERIFY(middle[middle_length - 1] == 0);
+        --middle_length;
+    }
+    add_words_in_place(output + split, output_length - split, middle, middle_length);
+}
+
+/**
+ * Complexity: O(N^2) where N is the number of words in the larger number,
+ * or O(N^1.585) once both numbers are longer than karatsuba_threshold words.
  */
 FLATTEN void UnsignedBigInteger::multiply_without_allocation(
     const UnsignedBigInteger& left,
     const UnsignedBigInteger& right,
-    UnsignedBigInteger& temp_shift_result,
-    UnsignedBigInteger& temp_shift_plus,
-    UnsignedBigInteger& temp_shift,
-    UnsignedBigInteger& temp_plus,
+    [[maybe_unused]] UnsignedBigInteger& temp_shift_result,
+    [[maybe_unused]] UnsignedBigInteger& temp_shift_plus,
+    [[maybe_unused]] UnsignedBigInteger& temp_shift,
+    [[maybe_unused]] UnsignedBigInteger& temp_plus,
     UnsignedBigInteger& output)
 {
     output.set_to_0();
 
-    // iterate all bits
-    for (size_t word_index = 0; word_index < left.length(); ++word_index) {
-        for (size_t bit_index = 0; bit_index < UnsignedBigInteger::BITS_IN_WORD; ++bit_index) {
-            // If the bit is off - skip over it
-            if (!(left.m_words[word_index] & (1 << bit_index)))
-                continue;
-
-            const size_t shift_amount = word_index * UnsignedBigInteger::BITS_IN_WORD + bit_index;
+    auto left_length = left.trimmed_length();
+    auto right_length = right.trimmed_length();
+    if (left_length == 0 || right_length == 0)
+        return;
 
-            // output += (right << shift_amount);
-            shift_left_without_allocation(right, shift_amount, temp_shift_result, temp_shift_plus, temp_shift);
-            add_without_allocation(output, temp_shift, temp_plus);
-            output.set_to(temp_plus);
-        }
-    }
+    output.m_words.resize_and_keep_capacity(left_length + right_length);
+    multiply_words(left.m_words.data(), left_length, right.m_words.data(), right_length, output.m_words.data());
+    output.trim_leading_zero_words();
 }
 
 /**
- * Complexity: O(N^2) where N is the number of words in the larger number
+ * Complexity: O(N * M) where N is the number of words in the numerator and M the number of words in the denominator
  * Division method:
- * We loop over the bits of the divisor, attempting to subtract divisor<<i from the dividend.
- * If the result is non-negative, it means that divisor*2^i "fits" in the dividend,
- * so we set the ith bit in the quotient and reduce divisor<<i from the dividend.
- * When we're done, what's left from the dividend is the remainder.
+ * Knuth's algorithm D (The Art of Computer Programming, volume 2, 4.3.1).
+ * Both numbers are shifted left until the top bit of the denominator is set, so that dividing the
+ * top two words of what is left of the numerator by the top word of the denominator estimates each
+ * word of the quotient with an error of at most two, which is then corrected.
  */
 FLATTEN void UnsignedBigInteger::divide_without_allocation(
     const UnsignedBigInteger& numerator,
     const UnsignedBigInteger& denominator,
-    UnsignedBigInteger& temp_shift_result,
-    UnsignedBigInteger& temp_shift_plus,
+    [[maybe_unused]] UnsignedBigInteger& temp_shift_result,
+    [[maybe_unused]] UnsignedBigInteger& temp_shift_plus,
     UnsignedBigInteger& temp_shift,
     UnsignedBigInteger& temp_minus,
     UnsignedBigInteger& quotient,
     UnsignedBigInteger& remainder)
 {
+    auto numerator_length = numerator.trimmed_length();
+    auto denominator_length = denominator.trimmed_length();
+
     quotient.set_to_0();
-    remainder.set_to(numerator);
-
-    // iterate all bits
-    for (int word_index = numerator.trimmed_length() - 1; word_index >= 0; --word_index) {
-        for (int bit_index = UnsignedBigInteger::BITS_IN_WORD - 1; bit_index >= 0; --bit_index) {
-            const size_t shift_amount = word_index * UnsignedBigInteger::BITS_IN_WORD + bit_index;
-            shift_left_without_allocation(denominator, shift_amount, temp_shift_result, temp_shift_plus, temp_shift);
-
-            subtract_without_allocation(remainder, temp_shift, temp_minus);
-            if (!temp_minus.is_invalid()) {
-                remainder.set_to(temp_minus);
-                quotient.set_bit_inplace(shift_amount);
+    if (denominator_length == 0) {
+        quotient.invalidate();
+        remainder.set_to_0();
+        remainder.invalidate();
+        return;
+    }
+
+    if (numerator < denominator) {
+        remainder.set_to(numerator);
+        remainder.trim_leading_zero_words();
+        return;
+    }
+
+    size_t quotient_length = numerator_length - denominator_length + 1;
+    quotient.m_words.resize_and_keep_capacity(quotient_length);
+    const u32* numerator_words = numerator.m_words.data();
+
+    if (denominator_length == 1) {
+        u64 divisor = denominator.m_words[0];
+        u64 remainder_word = 0;
+        for (size_t i = numerator_length; i > 0; --i) {
+            u64 dividend = (remainder_word << 32) | numerator_words[i - 1];
+            if (i - 1 < quotient_length)
+                quotient.m_words[i - 1] = (u32)(dividend / divisor);
+            remainder_word = dividend % divisor;
+        }
+        quotient.trim_leading_zero_words();
+        remainder.set_to((u32)remainder_word);
+        remainder.trim_leading_zero_words();
+        return;
+    }
+
+    // Normalize both numbers, the numerator gets an extra word for the bits shifted out of it.
+    auto shift = __builtin_clz(denominator.m_words[denominator_length - 1]);
+    temp_shift.set_to_0();
+    temp_shift.m_words.resize_and_keep_capacity(denominator_length);
+    temp_minus.set_to_0();
+    temp_minus.m_words.resize_and_keep_capacity(numerator_length + 1);
+    u32* divisor = temp_shift.m_words.data();
+    u32* dividend = temp_minus.m_words.data();
+    for (size_t i = denominator_length - 1; i > 0; --i)
+        divisor[i] = (u32)(((u64)denominator.m_words[i] << shift) | ((u64)denominator.m_words[i - 1] >> (BITS_IN_WORD - shift)));
+    divisor[0] = denominator.m_words[0] << shift;
+    dividend[numerator_length] = (u32)((u64)numerator_words[numerator_length - 1] >> (BITS_IN_WORD - shift));
+    for (size_t i = numerator_length - 1; i > 0; --i)
+        dividend[i] = (u32)(((u64)numerator_words[i] << shift) | ((u64)numerator_words[i - 1] >> (BITS_IN_WORD - shift)));
+    dividend[0] = numerator_words[0] << shift;
+
+    u64 divisor_high = divisor[denominator_length - 1];
+    u64 divisor_next = divisor[denominator_length - 2];
+    for (size_t j = quotient_length; j > 0;) {
+        --j;
+        u64 top = ((u64)dividend[j + denominator_length] << 32) | dividend[j + denominator_length - 1];
+        u64 estimate = top / divisor_high;
+        u64 estimate_remainder = top % divisor_high;
+        while (estimate >> 32 || estimate * divisor_next > ((estimate_remainder << 32) | dividend[j + denominator_length - 2])) {
+            --estimate;
+            estimate_remainder += divisor_high;
+            if (estimate_remainder >> 32)
+                break;
+        }
+
+        // Subtract estimate * divisor from the current part of the dividend.
+        i64 borrow = 0;
+        for (size_t i = 0; i < denominator_length; ++i) {
+            u64 product = estimate * divisor[i];
+            i64 difference = (i64)dividend[i + j] - borrow - (i64)(product & 0xffffffff);
+            dividend[i + j] = (u32)difference;
+            borrow = (i64)(product >> 32) - (difference >> 32);
+        }
+        i64 difference = (i64)dividend[j + denominator_length] - borrow;
+        dividend[j + denominator_length] = (u32)difference;
+
+        // The estimate was one too large, add the divisor back.
+        if (difference < 0) {
+            --estimate;
+            u64 carry = 0;
+            for (size_t i = 0; i < denominator_length; ++i) {
+                u64 sum = (u64)dividend[i + j] + divisor[i] + carry;
+                dividend[i + j] = (u32)sum;
+                carry = sum >> 32;
             }
+            dividend[j + denominator_length] += (u32)carry;
         }
+        quotient.m_words[j] = (u32)estimate;
     }
+    quotient.trim_leading_zero_words();
+
+    // The remainder is what is left of the dividend, shifted back.
+    remainder.set_to_0();
+    remainder.m_words.resize_and_keep_capacity(denominator_length);
+    for (size_t i = 0; i < denominator_length; ++i)
+        remainder.m_words[i] = (u32)(((u64)dividend[i] >> shift) | ((u64)dividend[i + 1] << (BITS_IN_WORD - shift)));
+    remainder.trim_leading_zero_words();
 }
 
 /**
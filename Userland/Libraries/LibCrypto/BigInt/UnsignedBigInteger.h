@@ -110,6 +110,8 @@ public:
     bool operator<(const UnsignedBigInteger& other) const;
 
 private:
+    void trim_leading_zero_words();
+
     ALWAYS_INLINE static void shift_left_by_n_words(const UnsignedBigInteger& number, size_t number_of_words, UnsignedBigInteger& output);
     ALWAYS_INLINE static u32 shift_left_get_one_word(const UnsignedBigInteger& number, size_t num_bits, size_t result_word_index);
 
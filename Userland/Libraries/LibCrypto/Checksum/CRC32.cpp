@@ -24,18 +24,142 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Endian.h>
 #include <AK/Span.h>
 #include <AK/Types.h>
+#include <LibCrypto/CPUFeatures.h>
 #include <LibCrypto/Checksum/CRC32.h>
 
+#if CRYPTO_HAS_X86_ACCELERATION
+#    include <smmintrin.h>
+#    include <wmmintrin.h>
+#endif
+
 namespace Crypto::Checksum {
 
+// tables[0] is the usual byte-at-a-time table. tables[n] advances a byte that is followed by
+// n more bytes, so that eight bytes can be processed at once ("slicing-by-8").
+struct Tables {
+    u32 data[8][256];
+
+    constexpr Tables()
+        : data()
+    {
+        for (auto i = 0; i < 256; i++) {
+            u32 value = i;
+
+            for (auto j = 0; j < 8; j++) {
+                if (value & 1) {
+                    value = 0xEDB88320 ^ (value >> 1);
+                } else {
+                    value = value >> 1;
+                }
+            }
+
+            data[0][i] = value;
+        }
+
+        for (auto i = 0; i < 256; i++) {
+            for (auto n = 1; n < 8; n++)
+                data[n][i] = (data[n - 1][i] >> 8) ^ data[0][data[n - 1][i] & 0xFF];
+        }
+    }
+};
+
+constexpr static auto tables = Tables();
+
+static u32 update_with_tables(u32 state, const u8* data, size_t size)
+{
+    for (; size >= 8; size -= 8, data += 8) {
+        u32 low;
+        u32 high;
+        __builtin_memcpy(&low, data, sizeof(low));
+        __builtin_memcpy(&high, data + 4, sizeof(high));
+        low = AK::convert_between_host_and_little_endian(low) ^ state;
+        high = AK::convert_between_host_and_little_endian(high);
+        state = tables.data[7][low & 0xFF] ^ tables.data[6][(low >> 8) & 0xFF] ^ tables.data[5][(low >> 16) & 0xFF] ^ tables.data[4][low >> 24]
+            ^ tables.data[3][high & 0xFF] ^ tables.data[2][(high >> 8) & 0xFF] ^ tables.data[1][(high >> 16) & 0xFF] ^ tables.data[0][high >> 24];
+    }
+
+    for (; size > 0; --size, ++data)
+        state = tables.data[0][(state ^ *data) & 0xFF] ^ (state >> 8);
+
+    return state;
+}
+
+#if CRYPTO_HAS_X86_ACCELERATION
+#    define CRC32_TARGET [[gnu::target("pclmul,sse4.1")]]
+
+// Multiplies the two halves of value by the two halves of constants, which moves them 128 (or 512) bits
+// further along the message, and adds them to the next 16 bytes of it.
+CRC32_TARGET ALWAYS_INLINE static __m128i fold(__m128i value, __m128i constants, __m128i next)
+{
+    auto low = _mm_clmulepi64_si128(value, constants, 0x00);
+    auto high = _mm_clmulepi64_si128(value, constants, 0x11);
+    return _mm_xor_si128(_mm_xor_si128(low, high), next);
+}
+
+// Folds the message with carry-less multiplications, as described in Intel's "Fast CRC Computation
+// for Generic Polynomials Using PCLMULQDQ Instruction". The constants are powers of x modulo the
+// bit-reflected polynomial. size has to be a multiple of 16, and at least 64.
+CRC32_TARGET static u32 update_with_pclmul(u32 state, const u8* data, size_t size)
+{
+    auto fold_by_four = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+    auto fold_by_one = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+    auto fold_to_32_bits = _mm_set_epi64x(0, 0x0163cd6124);
+    auto barrett_constants = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+    auto low_32_bits = _mm_setr_epi32(~0, 0, ~0, 0);
+
+    auto x0 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(data + 0)), _mm_cvtsi32_si128(state));
+    auto x1 = _mm_loadu_si128((const __m128i*)(data + 16));
+    auto x2 = _mm_loadu_si128((const __m128i*)(data + 32));
+    auto x3 = _mm_loadu_si128((const __m128i*)(data + 48));
+    data += 64;
+    size -= 64;
+
+    // Four independent streams keep the multiplier busy.
+    for (; size >= 64; size -= 64, data += 64) {
+        x0 = fold(x0, fold_by_four, _mm_loadu_si128((const __m128i*)(data + 0)));
+        x1 = fold(x1, fold_by_four, _mm_loadu_si128((const __m128i*)(data + 16)));
+        x2 = fold(x2, fold_by_four, _mm_loadu_si128((const __m128i*)(data + 32)));
+        x3 = fold(x3, fold_by_four, _mm_loadu_si128((const __m128i*)(data + 48)));
+    }
+
+    x0 = fold(x0, fold_by_one, x1);
+    x0 = fold(x0, fold_by_one, x2);
+    x0 = fold(x0, fold_by_one, x3);
+    for (; size >= 16; size -= 16, data += 16)
+        x0 = fold(x0, fold_by_one, _mm_loadu_si128((const __m128i*)data));
+
+    // Fold the remaining 128 bits down to 64, then reduce those to 32 with Barrett reduction.
+    auto product = _mm_clmulepi64_si128(x0, fold_by_one, 0x10);
+    x0 = _mm_xor_si128(_mm_srli_si128(x0, 8), product);
+    product = _mm_clmulepi64_si128(_mm_and_si128(x0, low_32_bits), fold_to_32_bits, 0x00);
+    x0 = _mm_xor_si128(_mm_srli_si128(x0, 4), product);
+
+    product = _mm_clmulepi64_si128(_mm_and_si128(x0, low_32_bits), barrett_constants, 0x10);
+    product = _mm_clmulepi64_si128(_mm_and_si128(product, low_32_bits), barrett_constants, 0x00);
+    x0 = _mm_xor_si128(x0, product);
+    return _mm_extract_epi32(x0, 1);
+}
+#endif
+
 void CRC32::update(ReadonlyBytes data)
 {
-    for (size_t i = 0; i < data.size(); i++) {
-        m_state = table[(m_state ^ data.at(i)) & 0xFF] ^ (m_state >> 8);
+    auto* bytes = data.data();
+    auto size = data.size();
+
+#if CRYPTO_HAS_X86_ACCELERATION
+    if (size >= 64 && cpu_features().has_pclmulqdq && cpu_features().has_sse41) {
+        auto folded_size = size & ~(size_t)15;
+        m_state = update_with_pclmul(m_state, bytes, folded_size);
+        bytes += folded_size;
+        size -= folded_size;
     }
-};
+#endif
+
+    m_state = update_with_tables(m_state, bytes, size);
+}
 
 u32 CRC32::digest()
 {
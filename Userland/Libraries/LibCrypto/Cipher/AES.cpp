@@ -25,8 +25,13 @@
  */
 
 #include <AK/StringBuilder.h>
+#include <LibCrypto/CPUFeatures.h>
 #include <LibCrypto/Cipher/AES.h>
 
+#if CRYPTO_HAS_X86_ACCELERATION
+#    include <wmmintrin.h>
+#endif
+
 namespace Crypto {
 namespace Cipher {
 
@@ -214,8 +219,118 @@ void AESCipherKey::expand_decrypt_key(ReadonlyBytes user_key, size_t bits)
     }
 }
 
+void AESCipherKey::prepare_hardware_round_keys()
+{
+    // AES-NI works on the state in memory order, so the round keys are simply stored big-endian.
+    // The decryption round keys are already in the reversed, inverse-mixed form that AESDEC expects.
+    for (size_t i = 0; i < (rounds() + 1) * 4; ++i) {
+        auto word = m_rd_keys[i];
+        m_hardware_round_keys[i * 4 + 0] = word >> 24;
+        m_hardware_round_keys[i * 4 + 1] = word >> 16;
+        m_hardware_round_keys[i * 4 + 2] = word >> 8;
+        m_hardware_round_keys[i * 4 + 3] = word;
+    }
+}
+
+#if CRYPTO_HAS_X86_ACCELERATION
+// Consecutive blocks are independent in the modes that call these with more than one block,
+// so four of them are kept in flight to hide the latency of the AES instructions.
+[[gnu::target("aes,sse2")]] static void aesni_encrypt_blocks(const u8* round_key_bytes, size_t rounds, const u8* in, u8* out, size_t block_count)
+{
+    __m128i round_keys[15];
+    for (size_t r = 0; r <= rounds; ++r)
+        round_keys[r] = _mm_loadu_si128((const __m128i*)round_key_bytes + r);
+
+    const auto* input = (const __m128i*)in;
+    auto* output = (__m128i*)out;
+    for (; block_count >= 4; block_count -= 4, input += 4, output += 4) {
+        auto b0 = _mm_xor_si128(_mm_loadu_si128(input + 0), round_keys[0]);
+        auto b1 = _mm_xor_si128(_mm_loadu_si128(input + 1), round_keys[0]);
+        auto b2 = _mm_xor_si128(_mm_loadu_si128(input + 2), round_keys[0]);
+        auto b3 = _mm_xor_si128(_mm_loadu_si128(input + 3), round_keys[0]);
+        for (size_t r = 1; r < rounds; ++r) {
+            b0 = _mm_aesenc_si128(b0, round_keys[r]);
+            b1 = _mm_aesenc_si128(b1, round_keys[r]);
+            b2 = _mm_aesenc_si128(b2, round_keys[r]);
+            b3 = _mm_aesenc_si128(b3, round_keys[r]);
+        }
+        _mm_storeu_si128(output + 0, _mm_aesenclast_si128(b0, round_keys[rounds]));
+        _mm_storeu_si128(output + 1, _mm_aesenclast_si128(b1, round_keys[rounds]));
+        _mm_storeu_si128(output + 2, _mm_aesenclast_si128(b2, round_keys[rounds]));
+        _mm_storeu_si128(output + 3, _mm_aesenclast_si128(b3, round_keys[rounds]));
+    }
+    for (; block_count > 0; --block_count, ++input, ++output) {
+        auto b = _mm_xor_si128(_mm_loadu_si128(input), round_keys[0]);
+        for (size_t r = 1; r < rounds; ++r)
+            b = _mm_aesenc_si128(b, round_keys[r]);
+        _mm_storeu_si128(output, _mm_aesenclast_si128(b, round_keys[rounds]));
+    }
+}
+
+[[gnu::target("aes,sse2")]] static void aesni_decrypt_blocks(const u8* round_key_bytes, size_t rounds, const u8* in, u8* out, size_t block_count)
+{
+    __m128i round_keys[15];
+    for (size_t r = 0; r <= rounds; ++r)
+        round_keys[r] = _mm_loadu_si128((const __m128i*)round_key_bytes + r);
+
+    const auto* input = (const __m128i*)in;
+    auto* output = (__m128i*)out;
+    for (; block_count >= 4; block_count -= 4, input += 4, output += 4) {
+        auto b0 = _mm_xor_si128(_mm_loadu_si128(input + 0), round_keys[0]);
+        auto b1 = _mm_xor_si128(_mm_loadu_si128(input + 1), round_keys[0]);
+        auto b2 = _mm_xor_si128(_mm_loadu_si128(input + 2), round_keys[0]);
+        auto b3 = _mm_xor_si128(_mm_loadu_si128(input + 3), round_keys[0]);
+        for (size_t r = 1; r < rounds; ++r) {
+            b0 = _mm_aesdec_si128(b0, round_keys[r]);
+            b1 = _mm_aesdec_si128(b1, round_keys[r]);
+            b2 = _mm_aesdec_si128(b2, round_keys[r]);
+            b3 = _mm_aesdec_si128(b3, round_keys[r]);
+        }
+        _mm_storeu_si128(output + 0, _mm_aesdeclast_si128(b0, round_keys[rounds]));
+        _mm_storeu_si128(output + 1, _mm_aesdeclast_si128(b1, round_keys[rounds]));
+        _mm_storeu_si128(output + 2, _mm_aesdeclast_si128(b2, round_keys[rounds]));
+        _mm_storeu_si128(output + 3, _mm_aesdeclast_si128(b3, round_keys[rounds]));
+    }
+    for (; block_count > 0; --block_count, ++input, ++output) {
+        auto b = _mm_xor_si128(_mm_loadu_si128(input), round_keys[0]);
+        for (size_t r = 1; r < rounds; ++r)
+            b = _mm_aesdec_si128(b, round_keys[r]);
+        _mm_storeu_si128(output, _mm_aesdeclast_si128(b, round_keys[rounds]));
+    }
+}
+#endif
+
+void AESCipher::encrypt_blocks(const u8* in, u8* out, size_t block_count)
+{
+#if CRYPTO_HAS_X86_ACCELERATION
+    if (cpu_features().has_aes) {
+        aesni_encrypt_blocks(key().hardware_round_keys(), key().rounds(), in, out, block_count);
+        return;
+    }
+#endif
+    Cipher::encrypt_blocks(in, out, block_count);
+}
+
+void AESCipher::decrypt_blocks(const u8* in, u8* out, size_t block_count)
+{
+#if CRYPTO_HAS_X86_ACCELERATION
+    if (cpu_features().has_aes) {
+        aesni_decrypt_blocks(key().hardware_round_keys(), key().rounds(), in, out, block_count);
+        return;
+    }
+#endif
+    Cipher::decrypt_blocks(in, out, block_count);
+}
+
 void AESCipher::encrypt_block(const AESCipherBlock& in, AESCipherBlock& out)
 {
+#if CRYPTO_HAS_X86_ACCELERATION
+    if (cpu_features().has_aes) {
+        aesni_encrypt_blocks(key().hardware_round_keys(), key().rounds(), in.bytes().data(), out.bytes().data(), 1);
+        return;
+    }
+#endif
+
     u32 s0, s1, s2, s3, t0, t1, t2, t3;
     size_t r { 0 };
 
@@ -308,6 +423,12 @@ void AESCipher::encrypt_block(const AESCipherBlock& in, AESCipherBlock& out)
 
 void AESCipher::decrypt_block(const AESCipherBlock& in, AESCipherBlock& out)
 {
+#if CRYPTO_HAS_X86_ACCELERATION
+    if (cpu_features().has_aes) {
+        aesni_decrypt_blocks(key().hardware_round_keys(), key().rounds(), in.bytes().data(), out.bytes().data(), 1);
+        return;
+    }
+#endif
 
     u32 s0, s1, s2, s3, t0, t1, t2, t3;
     size_t r { 0 };
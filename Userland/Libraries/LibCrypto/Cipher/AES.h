@@ -82,6 +82,9 @@ struct AESCipherKey : public CipherKey {
         return (const u32*)m_rd_keys;
     }
 
+    // The round keys as bytes in the order AES-NI expects them.
+    const u8* hardware_round_keys() const { return m_hardware_round_keys; }
+
     AESCipherKey(ReadonlyBytes user_key, size_t key_bits, Intent intent)
         : m_bits(key_bits)
     {
@@ -89,6 +92,7 @@ struct AESCipherKey : public CipherKey {
             expand_encrypt_key(user_key, key_bits);
         else
             expand_decrypt_key(user_key, key_bits);
+        prepare_hardware_round_keys();
     }
 
     virtual ~AESCipherKey() override { }
@@ -103,8 +107,11 @@ protected:
     }
 
 private:
+    void prepare_hardware_round_keys();
+
     static constexpr size_t MAX_ROUND_COUNT = 14;
     u32 m_rd_keys[(MAX_ROUND_COUNT + 1) * 4] { 0 };
+    u8 m_hardware_round_keys[(MAX_ROUND_COUNT + 1) * 16] { 0 };
     size_t m_rounds;
     size_t m_bits;
 };
@@ -129,6 +136,9 @@ public:
     virtual void encrypt_block(const BlockType& in, BlockType& out) override;
     virtual void decrypt_block(const BlockType& in, BlockType& out) override;
 
+    virtual void encrypt_blocks(const u8* in, u8* out, size_t block_count) override;
+    virtual void decrypt_blocks(const u8* in, u8* out, size_t block_count) override;
+
     virtual String class_name() const override { return "AES"; }
 
 protected:
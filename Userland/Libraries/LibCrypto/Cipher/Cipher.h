@@ -130,6 +130,30 @@ public:
     virtual void encrypt_block(const BlockType& in, BlockType& out) = 0;
     virtual void decrypt_block(const BlockType& in, BlockType& out) = 0;
 
+    // These process consecutive blocks independently of each other, which lets ciphers
+    // that can work on several blocks at once override them to do so.
+    virtual void encrypt_blocks(const u8* in, u8* out, size_t block_count)
+    {
+        auto size = block_size();
+        BlockType block;
+        for (size_t i = 0; i < block_count; ++i) {
+            block.overwrite(in + i * size, size);
+            encrypt_block(block, block);
+            __builtin_memcpy(out + i * size, block.bytes().data(), size);
+        }
+    }
+
+    virtual void decrypt_blocks(const u8* in, u8* out, size_t block_count)
+    {
+        auto size = block_size();
+        BlockType block;
+        for (size_t i = 0; i < block_count; ++i) {
+            block.overwrite(in + i * size, size);
+            decrypt_block(block, block);
+            __builtin_memcpy(out + i * size, block.bytes().data(), size);
+        }
+    }
+
     virtual String class_name() const = 0;
 
 private:
@@ -106,28 +106,38 @@ public:
         auto& cipher = this->cipher();
 
         VERIFY(!ivec.is_empty());
-        const auto* iv = ivec.data();
 
-        auto block_size = cipher.block_size();
+        constexpr size_t block_size = T::BlockType::BlockSizeInBits / 8;
 
         // if the data is not aligned, it's not correct encrypted data
         // FIXME (ponder): Should we simply decrypt as much as we can?
         VERIFY(length % block_size == 0);
 
-        m_cipher_block.set_padding_mode(cipher.padding_mode());
+        // Unlike encryption, decryption doesn't depend on the previous block, so the cipher
+        // can decrypt a few blocks at a time before the chaining is undone.
+        constexpr size_t blocks_per_batch = 8;
+        u8 ciphertext[blocks_per_batch * block_size];
+        u8 previous_block[block_size];
+        __builtin_memcpy(previous_block, ivec.data(), block_size);
         size_t offset { 0 };
 
         while (length > 0) {
-            auto* slice = in.offset(offset);
-            m_cipher_block.overwrite(slice, block_size);
-            cipher.decrypt_block(m_cipher_block, m_cipher_block);
-            m_cipher_block.apply_initialization_vector(iv);
-            auto decrypted = m_cipher_block.bytes();
-            VERIFY(offset + decrypted.size() <= out.size());
-            __builtin_memcpy(out.offset(offset), decrypted.data(), decrypted.size());
-            iv = slice;
-            length -= block_size;
-            offset += block_size;
+            size_t block_count = min(blocks_per_batch, length / block_size);
+            size_t batch_size = block_count * block_size;
+            VERIFY(offset + batch_size <= out.size());
+
+            // The ciphertext is copied first, as |out| may be the same buffer as |in|.
+            __builtin_memcpy(ciphertext, in.offset(offset), batch_size);
+            u8* decrypted = out.offset(offset);
+            cipher.decrypt_blocks(ciphertext, decrypted, block_count);
+            for (size_t i = 0; i < block_size; ++i)
+                decrypted[i] ^= previous_block[i];
+            for (size_t i = block_size; i < batch_size; ++i)
+                decrypted[i] ^= ciphertext[i - block_size];
+            __builtin_memcpy(previous_block, ciphertext + batch_size - block_size, block_size);
+
+            length -= batch_size;
+            offset += batch_size;
         }
         out = out.slice(0, offset);
         this->prune_padding(out);
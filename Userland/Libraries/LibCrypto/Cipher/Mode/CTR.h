@@ -151,7 +151,6 @@ public:
 
 private:
     u8 m_ivec_storage[IVSizeInBits / 8];
-    typename T::BlockType m_cipher_block {};
 
 protected:
     constexpr static IncrementFunctionType increment {};
@@ -175,27 +174,36 @@ protected:
         VERIFY(!ivec.is_empty());
         VERIFY(ivec.size() >= IV_length());
 
-        m_cipher_block.set_padding_mode(cipher.padding_mode());
-
         __builtin_memcpy(m_ivec_storage, ivec.data(), IV_length());
         Bytes iv { m_ivec_storage, IV_length() };
 
         size_t offset { 0 };
-        auto block_size = cipher.block_size();
+        constexpr size_t block_size = T::BlockType::BlockSizeInBits / 8;
 
-        while (length > 0) {
-            m_cipher_block.overwrite(iv.slice(0, block_size));
+        // The counter blocks are encrypted a few at a time, so that the cipher can work on them together.
+        constexpr size_t blocks_per_batch = 8;
+        u8 counters[blocks_per_batch * block_size];
+        u8 key_stream[blocks_per_batch * block_size];
 
-            cipher.encrypt_block(m_cipher_block, m_cipher_block);
-            if (in) {
-                m_cipher_block.apply_initialization_vector(in->data() + offset);
+        while (length > 0) {
+            size_t block_count = min(blocks_per_batch, (length + block_size - 1) / block_size);
+            for (size_t i = 0; i < block_count; ++i) {
+                __builtin_memcpy(counters + i * block_size, iv.data(), block_size);
+                increment(iv);
             }
-            auto write_size = min(block_size, length);
+            cipher.encrypt_blocks(counters, key_stream, block_count);
 
+            auto write_size = min(block_count * block_size, length);
             VERIFY(offset + write_size <= out.size());
-            __builtin_memcpy(out.offset(offset), m_cipher_block.bytes().data(), write_size);
+            if (in) {
+                const u8* input = in->offset(offset);
+                u8* output = out.offset(offset);
+                for (size_t i = 0; i < write_size; ++i)
+                    output[i] = input[i] ^ key_stream[i];
+            } else {
+                __builtin_memcpy(out.offset(offset), key_stream, write_size);
+            }
 
-            increment(iv);
             length -= write_size;
             offset += write_size;
         }
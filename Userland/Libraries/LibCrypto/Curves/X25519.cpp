@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Random.h>
+#include <LibCrypto/Curves/X25519.h>
+
+namespace Crypto {
+namespace Curves {
+
+// Elements of GF(2^255 - 19) are kept in ten signed limbs of alternately 26 and 25 bits,
+// so that products of two limbs and their sums fit into 64 bits. Nothing in here branches
+// on or indexes memory by the value of an element.
+struct FieldElement {
+    i32 limbs[10];
+};
+
+static constexpr size_t limb_bits(size_t index) { return index % 2 == 0 ? 26 : 25; }
+
+static void set_small(FieldElement& out, i32 value)
+{
+    out = {};
+    out.limbs[0] = value;
+}
+
+static void add(FieldElement& out, const FieldElement& a, const FieldElement& b)
+{
+    for (size_t i = 0; i < 10; ++i)
+        out.limbs[i] = a.limbs[i] + b.limbs[i];
+}
+
+static void subtract(FieldElement& out, const FieldElement& a, const FieldElement& b)
+{
+    for (size_t i = 0; i < 10; ++i)
+        out.limbs[i] = a.limbs[i] - b.limbs[i];
+}
+
+// Brings wide limbs back to (about) their nominal sizes, rounding each carry so that the limbs stay centered around zero.
+static void carry(FieldElement& out, i64 (&h)[10])
+{
+    for (size_t i = 0; i < 9; ++i) {
+        auto bits = limb_bits(i);
+        i64 c = (h[i] + ((i64)1 << (bits - 1))) >> bits;
+        h[i + 1] += c;
+        h[i] -= c * ((i64)1 << bits);
+    }
+    // 2^255 = 19 (mod p), so the carry out of the top limb wraps around.
+    i64 c = (h[9] + ((i64)1 << 24)) >> 25;
+    h[0] += c * 19;
+    h[9] -= c * ((i64)1 << 25);
+    c = (h[0] + ((i64)1 << 25)) >> 26;
+    h[1] += c;
+    h[0] -= c * ((i64)1 << 26);
+
+    for (size_t i = 0; i < 10; ++i)
+        out.limbs[i] = (i32)h[i];
+}
+
+static void multiply(FieldElement& out, const FieldElement& a, const FieldElement& b)
+{
+    // Limb i sits at bit ceil(25.5 * i), so the product of two odd limbs has twice the weight
+    // of limb i + j. Products past the top limb wrap around multiplied by 19.
+    i64 a0 = a.limbs[0], a1 = a.limbs[1], a2 = a.limbs[2], a3 = a.limbs[3], a4 = a.limbs[4];
+    i64 a5 = a.limbs[5], a6 = a.limbs[6], a7 = a.limbs[7], a8 = a.limbs[8], a9 = a.limbs[9];
+    i64 b0 = b.limbs[0], b1 = b.limbs[1], b2 = b.limbs[2], b3 = b.limbs[3], b4 = b.limbs[4];
+    i64 b5 = b.limbs[5], b6 = b.limbs[6], b7 = b.limbs[7], b8 = b.limbs[8], b9 = b.limbs[9];
+    i64 a1_2 = 2 * a1, a3_2 = 2 * a3, a5_2 = 2 * a5, a7_2 = 2 * a7, a9_2 = 2 * a9;
+    i64 b1_19 = 19 * b1, b2_19 = 19 * b2, b3_19 = 19 * b3, b4_19 = 19 * b4, b5_19 = 19 * b5;
+    i64 b6_19 = 19 * b6, b7_19 = 19 * b7, b8_19 = 19 * b8, b9_19 = 19 * b9;
+
+    i64 h0 = a0 * b0 + a1_2 * b9_19 + a2 * b8_19 + a3_2 * b7_19 + a4 * b6_19 + a5_2 * b5_19 + a6 * b4_19 + a7_2 * b3_19 + a8 * b2_19 + a9_2 * b1_19;
+    i64 h1 = a0 * b1 + a1 * b0 + a2 * b9_19 + a3 * b8_19 + a4 * b7_19 + a5 * b6_19 + a6 * b5_19 + a7 * b4_19 + a8 * b3_19 + a9 * b2_19;
+    i64 h2 = a0 * b2 + a1_2 * b1 + a2 * b0 + a3_2 * b9_19 + a4 * b8_19 + a5_2 * b7_19 + a6 * b6_19 + a7_2 * b5_19 + a8 * b4_19 + a9_2 * b3_19;
+    i64 h3 = a0 * b3 + a1 * b2 + a2 * b1 + a3 * b0 + a4 * b9_19 + a5 * b8_19 + a6 * b7_19 + a7 * b6_19 + a8 * b5_19 + a9 * b4_19;
+    i64 h4 = a0 * b4 + a1_2 * b3 + a2 * b2 + a3_2 * b1 + a4 * b0 + a5_2 * b9_19 + a6 * b8_19 + a7_2 * b7_19 + a8 * b6_19 + a9_2 * b5_19;
+    i64 h5 = a0 * b5 + a1 * b4 + a2 * b3 + a3 * b2 + a4 * b1 + a5 * b0 + a6 * b9_19 + a7 * b8_19 + a8 * b7_19 + a9 * b6_19;
+    i64 h6 = a0 * b6 + a1_2 * b5 + a2 * b4 + a3_2 * b3 + a4 * b2 + a5_2 * b1 + a6 * b0 + a7_2 * b9_19 + a8 * b8_19 + a9_2 * b7_19;
+    i64 h7 = a0 * b7 + a1 * b6 + a2 * b5 + a3 * b4 + a4 * b3 + a5 * b2 + a6 * b1 + a7 * b0 + a8 * b9_19 + a9 * b8_19;
+    i64 h8 = a0 * b8 + a1_2 * b7 + a2 * b6 + a3_2 * b5 + a4 * b4 + a5_2 * b3 + a6 * b2 + a7_2 * b1 + a8 * b0 + a9_2 * b9_19;
+    i64 h9 = a0 * b9 + a1 * b8 + a2 * b7 + a3 * b6 + a4 * b5 + a5 * b4 + a6 * b3 + a7 * b2 + a8 * b1 + a9 * b0;
+
+    i64 h[10] { h0, h1, h2, h3, h4, h5, h6, h7, h8, h9 };
+    carry(out, h);
+}
+
+static void square(FieldElement& out, const FieldElement& a)
+{
+    multiply(out, a, a);
+}
+
+static void multiply_small(FieldElement& out, const FieldElement& a, i32 factor)
+{
+    i64 h[10];
+    for (size_t i = 0; i < 10; ++i)
+        h[i] = (i64)a.limbs[i] * factor;
+    carry(out, h);
+}
+
+static void square_repeatedly(FieldElement& out, const FieldElement& a, size_t count)
+{
+    square(out, a);
+    for (size_t i = 1; i < count; ++i)
+        square(out, out);
+}
+
+// Computes a^(p - 2) = a^(2^255 - 21), which is the inverse of a, with a fixed addition chain.
+static void invert(FieldElement& out, const FieldElement& a)
+{
+    FieldElement a2, a9, a11, t, a_5_0, a_10_0, a_20_0, a_50_0, a_100_0;
+
+    square(a2, a);
+    square_repeatedly(t, a2, 2);
+    multiply(a9, t, a);
+    multiply(a11, a9, a2);
+    square(t, a11);
+    multiply(a_5_0, t, a9); // a^(2^5 - 1)
+    square_repeatedly(t, a_5_0, 5);
+    multiply(a_10_0, t, a_5_0);
+    square_repeatedly(t, a_10_0, 10);
+    multiply(a_20_0, t, a_10_0);
+    square_repeatedly(t, a_20_0, 20);
+    multiply(t, t, a_20_0);
+    square_repeatedly(t, t, 10);
+    multiply(a_50_0, t, a_10_0);
+    square_repeatedly(t, a_50_0, 50);
+    multiply(a_100_0, t, a_50_0);
+    square_repeatedly(t, a_100_0, 100);
+    multiply(t, t, a_100_0);
+    square_repeatedly(t, t, 50);
+    multiply(t, t, a_50_0); // a^(2^250 - 1)
+    square_repeatedly(t, t, 5);
+    multiply(out, t, a11);
+}
+
+// Swaps a and b if swap is 1, and leaves them alone if it is 0.
+static void conditional_swap(FieldElement& a, FieldElement& b, u32 swap)
+{
+    i32 mask = -(i32)swap;
+    for (size_t i = 0; i < 10; ++i) {
+        i32 difference = mask & (a.limbs[i] ^ b.limbs[i]);
+        a.limbs[i] ^= difference;
+        b.limbs[i] ^= difference;
+    }
+}
+
+static void from_bytes(FieldElement& out, ReadonlyBytes bytes)
+{
+    VERIFY(bytes.size() == X25519::KeySize);
+    u64 accumulator = 0;
+    size_t accumulated_bits = 0;
+    size_t offset = 0;
+    for (size_t i = 0; i < 10; ++i) {
+        auto bits = limb_bits(i);
+        while (accumulated_bits < bits) {
+            accumulator |= (u64)bytes[offset++] << accumulated_bits;
+            accumulated_bits += 8;
+        }
+        // The most significant bit of the last byte is ignored, as RFC 7748 asks us to.
+        out.limbs[i] = (i32)(accumulator & (((u64)1 << bits) - 1));
+        accumulator >>= bits;
+        accumulated_bits -= bits;
+    }
+}
+
+static void to_bytes(Bytes bytes, const FieldElement& a)
+{
+    i64 h[10];
+    for (size_t i = 0; i < 10; ++i)
+        h[i] = a.limbs[i];
+
+    // Work out whether the value is at least p, in which case it has to be reduced once more.
+    i64 q = (19 * h[9] + ((i64)1 << 24)) >> 25;
+    for (size_t i = 0; i < 10; ++i)
+        q = (h[i] + q) >> limb_bits(i);
+    h[0] += 19 * q;
+
+    for (size_t i = 0; i < 9; ++i) {
+        auto bits = limb_bits(i);
+        i64 c = h[i] >> bits;
+        h[i + 1] += c;
+        h[i] -= c * ((i64)1 << bits);
+    }
+    h[9] &= ((i64)1 << 25) - 1;
+
+    u64 accumulator = 0;
+    size_t accumulated_bits = 0;
+    size_t offset = 0;
+    for (size_t i = 0; i < 10; ++i) {
+        accumulator |= (u64)h[i] << accumulated_bits;
+        accumulated_bits += limb_bits(i);
+        while (accumulated_bits >= 8) {
+            bytes[offset++] = (u8)accumulator;
+            accumulator >>= 8;
+            accumulated_bits -= 8;
+        }
+    }
+    bytes[offset] = (u8)accumulator;
+}
+
+ByteBuffer X25519::compute_coordinate(ReadonlyBytes scalar_bytes, ReadonlyBytes u_coordinate)
+{
+    VERIFY(scalar_bytes.size() == KeySize);
+
+    u8 scalar[KeySize];
+    __builtin_memcpy(scalar, scalar_bytes.data(), KeySize);
+    scalar[0] &= 248;
+    scalar[31] &= 127;
+    scalar[31] |= 64;
+
+    FieldElement x1, x2, z2, x3, z3;
+    from_bytes(x1, u_coordinate);
+    set_small(x2, 1);
+    set_small(z2, 0);
+    x3 = x1;
+    set_small(z3, 1);
+
+    // The Montgomery ladder of RFC 7748, section 5.
+    FieldElement a, aa, b, bb, e, c, d, da, cb, t;
+    u32 swap = 0;
+    for (int bit = 254; bit >= 0; --bit) {
+        u32 scalar_bit = (scalar[bit / 8] >> (bit % 8)) & 1;
+        swap ^= scalar_bit;
+        conditional_swap(x2, x3, swap);
+        conditional_swap(z2, z3, swap);
+        swap = scalar_bit;
+
+        add(a, x2, z2);
+        square(aa, a);
+        subtract(b, x2, z2);
+        square(bb, b);
+        subtract(e, aa, bb);
+        add(c, x3, z3);
+        subtract(d, x3, z3);
+        multiply(da, d, a);
+        multiply(cb, c, b);
+
+        add(t, da, cb);
+        square(x3, t);
+        subtract(t, da, cb);
+        square(t, t);
+        multiply(z3, x1, t);
+        multiply(x2, aa, bb);
+        multiply_small(t, e, 121665);
+        add(t, aa, t);
+        multiply(z2, e, t);
+    }
+    conditional_swap(x2, x3, swap);
+    conditional_swap(z2, z3, swap);
+
+    invert(z2, z2);
+    multiply(x2, x2, z2);
+
+    auto result = ByteBuffer::create_uninitialized(KeySize);
+    to_bytes(result.bytes(), x2);
+    return result;
+}
+
+ByteBuffer X25519::generate_private_key()
+{
+    auto key = ByteBuffer::create_uninitialized(KeySize);
+    fill_with_random(key.data(), key.size());
+    return key;
+}
+
+ByteBuffer X25519::generate_public_key(ReadonlyBytes private_key)
+{
+    u8 base_point[KeySize] { 9 };
+    return compute_coordinate(private_key, { base_point, KeySize });
+}
+
+}
+}
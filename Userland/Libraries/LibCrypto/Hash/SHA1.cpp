@@ -26,11 +26,97 @@
 
 #include <AK/Endian.h>
 #include <AK/Types.h>
+#include <LibCrypto/CPUFeatures.h>
 #include <LibCrypto/Hash/SHA1.h>
 
+#if CRYPTO_HAS_X86_ACCELERATION
+#    include <immintrin.h>
+#endif
+
 namespace Crypto {
 namespace Hash {
 
+#if CRYPTO_HAS_X86_ACCELERATION
+#    define SHA_TARGET [[gnu::target("sha,sse4.1")]]
+
+// Four rounds with the SHA extensions. The message words for the later rounds are computed
+// along the way, in the four registers whose words have already been consumed.
+template<size_t Group>
+SHA_TARGET ALWAYS_INLINE static void sha1_four_rounds(__m128i& abcd, __m128i& e0, __m128i& e1, __m128i (&message)[4])
+{
+    auto& words = message[Group % 4];
+    if constexpr (Group == 0) {
+        e0 = _mm_add_epi32(e0, words);
+        e1 = abcd;
+        abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+    } else if constexpr (Group % 2 == 1) {
+        e1 = _mm_sha1nexte_epu32(e1, words);
+        e0 = abcd;
+        abcd = _mm_sha1rnds4_epu32(abcd, e1, Group / 5);
+    } else {
+        e0 = _mm_sha1nexte_epu32(e0, words);
+        e1 = abcd;
+        abcd = _mm_sha1rnds4_epu32(abcd, e0, Group / 5);
+    }
+
+    if constexpr (Group >= 3 && Group <= 18)
+        message[(Group + 1) % 4] = _mm_sha1msg2_epu32(message[(Group + 1) % 4], words);
+    if constexpr (Group >= 2 && Group <= 17)
+        message[(Group + 2) % 4] = _mm_xor_si128(message[(Group + 2) % 4], words);
+    if constexpr (Group >= 1 && Group <= 16)
+        message[(Group + 3) % 4] = _mm_sha1msg1_epu32(message[(Group + 3) % 4], words);
+}
+
+SHA_TARGET static void sha1_transform_blocks_shani(u32* state, const u8* data, size_t block_count)
+{
+    auto byte_swap_words = _mm_set_epi64x(0x0001020304050607ull, 0x08090a0b0c0d0e0full);
+    auto abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)state), 0x1b);
+    auto e0 = _mm_set_epi32(state[4], 0, 0, 0);
+    __m128i e1;
+
+    for (size_t block = 0; block < block_count; ++block, data += 64) {
+        auto saved_abcd = abcd;
+        auto saved_e = e0;
+
+        __m128i message[4];
+        for (size_t i = 0; i < 4; ++i)
+            message[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + i * 16)), byte_swap_words);
+
+        sha1_four_rounds<0>(abcd, e0, e1, message);
+        sha1_four_rounds<1>(abcd, e0, e1, message);
+        sha1_four_rounds<2>(abcd, e0, e1, message);
+        sha1_four_rounds<3>(abcd, e0, e1, message);
+        sha1_four_rounds<4>(abcd, e0, e1, message);
+        sha1_four_rounds<5>(abcd, e0, e1, message);
+        sha1_four_rounds<6>(abcd, e0, e1, message);
+        sha1_four_rounds<7>(abcd, e0, e1, message);
+        sha1_four_rounds<8>(abcd, e0, e1, message);
+        sha1_four_rounds<9>(abcd, e0, e1, message);
+        sha1_four_rounds<10>(abcd, e0, e1, message);
+        sha1_four_rounds<11>(abcd, e0, e1, message);
+        sha1_four_rounds<12>(abcd, e0, e1, message);
+        sha1_four_rounds<13>(abcd, e0, e1, message);
+        sha1_four_rounds<14>(abcd, e0, e1, message);
+        sha1_four_rounds<15>(abcd, e0, e1, message);
+        sha1_four_rounds<16>(abcd, e0, e1, message);
+        sha1_four_rounds<17>(abcd, e0, e1, message);
+        sha1_four_rounds<18>(abcd, e0, e1, message);
+        sha1_four_rounds<19>(abcd, e0, e1, message);
+
+        e0 = _mm_sha1nexte_epu32(e0, saved_e);
+        abcd = _mm_add_epi32(abcd, saved_abcd);
+    }
+
+    _mm_storeu_si128((__m128i*)state, _mm_shuffle_epi32(abcd, 0x1b));
+    state[4] = _mm_extract_epi32(e0, 3);
+}
+
+static bool can_use_sha_extensions()
+{
+    return cpu_features().has_sha && cpu_features().has_sse41;
+}
+#endif
+
 inline static constexpr auto ROTATE_LEFT(u32 value, size_t bits)
 {
     return (value << bits) | (value >> (32 - bits));
@@ -38,6 +124,13 @@ inline static constexpr auto ROTATE_LEFT(u32 value, size_t bits)
 
 inline void SHA1::transform(const u8* data)
 {
+#if CRYPTO_HAS_X86_ACCELERATION
+    if (can_use_sha_extensions()) {
+        sha1_transform_blocks_shani(m_state, data, 1);
+        return;
+    }
+#endif
+
     u32 blocks[80];
     for (size_t i = 0; i < 16; ++i)
         blocks[i] = AK::convert_between_host_and_network_endian(((const u32*)data)[i]);
@@ -86,15 +179,42 @@ inline void SHA1::transform(const u8* data)
     __builtin_memset(blocks, 0, 16 * sizeof(u32));
 }
 
+void SHA1::transform_blocks(const u8* data, size_t block_count)
+{
+#if CRYPTO_HAS_X86_ACCELERATION
+    if (can_use_sha_extensions()) {
+        sha1_transform_blocks_shani(m_state, data, block_count);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < block_count; ++i)
+        transform(data + i * BlockSize);
+}
+
 void SHA1::update(const u8* message, size_t length)
 {
-    for (size_t i = 0; i < length; ++i) {
+    while (length > 0) {
         if (m_data_length == BlockSize) {
             transform(m_data_buffer);
             m_bit_length += 512;
             m_data_length = 0;
         }
-        m_data_buffer[m_data_length++] = message[i];
+
+        // Whole blocks don't need to be copied into the buffer first.
+        if (m_data_length == 0 && length >= BlockSize) {
+            auto block_count = length / BlockSize;
+            transform_blocks(message, block_count);
+            m_bit_length += block_count * 512;
+            message += block_count * BlockSize;
+            length -= block_count * BlockSize;
+            continue;
+        }
+
+        auto copy_length = min(length, BlockSize - m_data_length);
+        __builtin_memcpy(m_data_buffer + m_data_length, message, copy_length);
+        m_data_length += copy_length;
+        message += copy_length;
+        length -= copy_length;
     }
 }
 
@@ -25,8 +25,13 @@
  */
 
 #include <AK/Types.h>
+#include <LibCrypto/CPUFeatures.h>
 #include <LibCrypto/Hash/SHA2.h>
 
+#if CRYPTO_HAS_X86_ACCELERATION
+#    include <immintrin.h>
+#endif
+
 namespace Crypto {
 namespace Hash {
 constexpr static auto ROTRIGHT(u32 a, size_t b) { return (a >> b) | (a << (32 - b)); }
@@ -45,8 +50,86 @@ constexpr static auto EP1(u64 x) { return ROTRIGHT(x, 14) ^ ROTRIGHT(x, 18) ^ RO
 constexpr static auto SIGN0(u64 x) { return ROTRIGHT(x, 1) ^ ROTRIGHT(x, 8) ^ (x >> 7); }
 constexpr static auto SIGN1(u64 x) { return ROTRIGHT(x, 19) ^ ROTRIGHT(x, 61) ^ (x >> 6); }
 
+#if CRYPTO_HAS_X86_ACCELERATION
+#    define SHA_TARGET [[gnu::target("sha,sse4.1")]]
+
+// Four rounds with the SHA extensions. Once its words have been consumed, each register is
+// refilled with the message words for the rounds sixteen later.
+template<size_t Group>
+SHA_TARGET ALWAYS_INLINE static void sha256_four_rounds(__m128i& state0, __m128i& state1, __m128i (&message)[4])
+{
+    auto& words = message[Group % 4];
+    auto words_and_constants = _mm_add_epi32(words, _mm_loadu_si128((const __m128i*)&SHA256Constants::RoundConstants[Group * 4]));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, words_and_constants);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(words_and_constants, 0x0e));
+
+    if constexpr (Group < 12) {
+        auto& previous_words = message[(Group + 3) % 4];
+        auto partial = _mm_sha256msg1_epu32(words, message[(Group + 1) % 4]);
+        partial = _mm_add_epi32(partial, _mm_alignr_epi8(previous_words, message[(Group + 2) % 4], 4));
+        words = _mm_sha256msg2_epu32(partial, previous_words);
+    }
+}
+
+// The instructions want the state as the two halves ABEF and CDGH.
+SHA_TARGET static void sha256_transform_blocks_shani(u32* state, const u8* data, size_t block_count)
+{
+    auto byte_swap_words = _mm_set_epi64x(0x0c0d0e0f08090a0bull, 0x0405060700010203ull);
+    auto dcba = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[0]), 0xb1);
+    auto efgh = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[4]), 0x1b);
+    auto state0 = _mm_alignr_epi8(dcba, efgh, 8);
+    auto state1 = _mm_blend_epi16(efgh, dcba, 0xf0);
+
+    for (size_t block = 0; block < block_count; ++block, data += 64) {
+        auto saved_state0 = state0;
+        auto saved_state1 = state1;
+
+        __m128i message[4];
+        for (size_t i = 0; i < 4; ++i)
+            message[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + i * 16)), byte_swap_words);
+
+        sha256_four_rounds<0>(state0, state1, message);
+        sha256_four_rounds<1>(state0, state1, message);
+        sha256_four_rounds<2>(state0, state1, message);
+        sha256_four_rounds<3>(state0, state1, message);
+        sha256_four_rounds<4>(state0, state1, message);
+        sha256_four_rounds<5>(state0, state1, message);
+        sha256_four_rounds<6>(state0, state1, message);
+        sha256_four_rounds<7>(state0, state1, message);
+        sha256_four_rounds<8>(state0, state1, message);
+        sha256_four_rounds<9>(state0, state1, message);
+        sha256_four_rounds<10>(state0, state1, message);
+        sha256_four_rounds<11>(state0, state1, message);
+        sha256_four_rounds<12>(state0, state1, message);
+        sha256_four_rounds<13>(state0, state1, message);
+        sha256_four_rounds<14>(state0, state1, message);
+        sha256_four_rounds<15>(state0, state1, message);
+
+        state0 = _mm_add_epi32(state0, saved_state0);
+        state1 = _mm_add_epi32(state1, saved_state1);
+    }
+
+    auto feba = _mm_shuffle_epi32(state0, 0x1b);
+    auto dchg = _mm_shuffle_epi32(state1, 0xb1);
+    _mm_storeu_si128((__m128i*)&state[0], _mm_blend_epi16(feba, dchg, 0xf0));
+    _mm_storeu_si128((__m128i*)&state[4], _mm_alignr_epi8(dchg, feba, 8));
+}
+
+static bool can_use_sha_extensions()
+{
+    return cpu_features().has_sha && cpu_features().has_sse41;
+}
+#endif
+
 inline void SHA256::transform(const u8* data)
 {
+#if CRYPTO_HAS_X86_ACCELERATION
+    if (can_use_sha_extensions()) {
+        sha256_transform_blocks_shani(m_state, data, 1);
+        return;
+    }
+#endif
+
     u32 m[64];
 
     size_t i = 0;
@@ -86,15 +169,42 @@ inline void SHA256::transform(const u8* data)
     m_state[7] += h;
 }
 
+void SHA256::transform_blocks(const u8* data, size_t block_count)
+{
+#if CRYPTO_HAS_X86_ACCELERATION
+    if (can_use_sha_extensions()) {
+        sha256_transform_blocks_shani(m_state, data, block_count);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < block_count; ++i)
+        transform(data + i * BlockSize);
+}
+
 void SHA256::update(const u8* message, size_t length)
 {
-    for (size_t i = 0; i < length; ++i) {
+    while (length > 0) {
         if (m_data_length == BlockSize) {
             transform(m_data_buffer);
             m_bit_length += 512;
             m_data_length = 0;
         }
-        m_data_buffer[m_data_length++] = message[i];
+
+        // Whole blocks don't need to be copied into the buffer first.
+        if (m_data_length == 0 && length >= BlockSize) {
+            auto block_count = length / BlockSize;
+            transform_blocks(message, block_count);
+            m_bit_length += block_count * 512;
+            message += block_count * BlockSize;
+            length -= block_count * BlockSize;
+            continue;
+        }
+
+        auto copy_length = min(length, BlockSize - m_data_length);
+        __builtin_memcpy(m_data_buffer + m_data_length, message, copy_length);
+        m_data_length += copy_length;
+        message += copy_length;
+        length -= copy_length;
     }
 }
 
@@ -205,13 +315,27 @@ inline void SHA512::transform(const u8* data)
 
 void SHA512::update(const u8* message, size_t length)
 {
-    for (size_t i = 0; i < length; ++i) {
+    while (length > 0) {
         if (m_data_length == BlockSize) {
             transform(m_data_buffer);
             m_bit_length += 1024;
             m_data_length = 0;
         }
-        m_data_buffer[m_data_length++] = message[i];
+
+        // Whole blocks don't need to be copied into the buffer first.
+        if (m_data_length == 0 && length >= BlockSize) {
+            transform(message);
+            m_bit_length += 1024;
+            message += BlockSize;
+            length -= BlockSize;
+            continue;
+        }
+
+        auto copy_length = min(length, BlockSize - m_data_length);
+        __builtin_memcpy(m_data_buffer + m_data_length, message, copy_length);
+        m_data_length += copy_length;
+        message += copy_length;
+        length -= copy_length;
     }
 }
 
@@ -250,8 +374,9 @@ SHA512::DigestType SHA512::peek()
         __builtin_memset(m_data_buffer, 0, FinalBlockDataSize);
     }
 
-    // append total message length
+    // append total message length, the upper 64 bits of which are always zero for us
     m_bit_length += m_data_length * 8;
+    __builtin_memset(m_data_buffer + FinalBlockDataSize, 0, 8);
     m_data_buffer[BlockSize - 1] = m_bit_length;
     m_data_buffer[BlockSize - 2] = m_bit_length >> 8;
     m_data_buffer[BlockSize - 3] = m_bit_length >> 16;
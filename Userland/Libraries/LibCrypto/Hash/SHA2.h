@@ -135,6 +135,7 @@ public:
 
 private:
     inline void transform(const u8*);
+    void transform_blocks(const u8*, size_t block_count);
 
     u8 m_data_buffer[BlockSize];
     size_t m_data_length { 0 };
@@ -194,7 +195,8 @@ private:
     u64 m_bit_length { 0 };
     u64 m_state[8];
 
-    constexpr static auto FinalBlockDataSize = BlockSize - 8;
+    // The message length takes up 128 bits at the end of the last block.
+    constexpr static auto FinalBlockDataSize = BlockSize - 16;
     constexpr static auto Rounds = 80;
 };
 
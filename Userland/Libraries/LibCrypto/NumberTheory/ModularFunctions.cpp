@@ -26,6 +26,7 @@
 
 #include <AK/Debug.h>
 #include <LibCrypto/NumberTheory/ModularFunctions.h>
+#include <LibCrypto/NumberTheory/MontgomeryContext.h>
 
 namespace Crypto {
 namespace NumberTheory {
@@ -122,6 +123,10 @@ UnsignedBigInteger ModularPower(const UnsignedBigInteger& b, const UnsignedBigIn
     if (m == 1)
         return 0;
 
+    // Montgomery multiplication only works with odd moduli.
+    if (m.trimmed_length() > 0 && (m.words()[0] & 1))
+        return MontgomeryContext(m).power(b, e);
+
     UnsignedBigInteger ep { e };
     UnsignedBigInteger base { b };
     UnsignedBigInteger exp { 1 };
@@ -258,16 +263,17 @@ static bool MR_primality_test(UnsignedBigInteger n, const Vector<UnsignedBigInte
         return n == 2;
     }
 
+    MontgomeryContext context(n);
     for (auto& a : tests) {
         // Technically: VERIFY(2 <= a && a <= n - 2)
         VERIFY(a < n);
-        auto x = ModularPower(a, d, n);
+        auto x = context.power(a, d);
         if (x == 1 || x == predecessor)
             continue;
         bool skip_this_witness = false;
         // r − 1 iterations.
         for (size_t i = 0; i < r - 1; ++i) {
-            x = ModularPower(x, 2, n);
+            x = context.power(x, 2);
             if (x == predecessor) {
                 skip_this_witness = true;
                 break;
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibCrypto/NumberTheory/MontgomeryContext.h>
+
+namespace Crypto {
+namespace NumberTheory {
+
+MontgomeryContext::MontgomeryContext(const UnsignedBigInteger& modulus)
+    : m_modulus(modulus)
+    , m_length(modulus.trimmed_length())
+{
+    VERIFY(m_length > 0 && (modulus.words()[0] & 1));
+
+    // Newton's iteration doubles the number of correct low bits of the inverse every step,
+    // and any odd number is its own inverse modulo 8.
+    u32 lowest_word = modulus.words()[0];
+    u32 inverse = lowest_word;
+    for (size_t i = 0; i < 4; ++i)
+        inverse *= 2 - lowest_word * inverse;
+    m_modulus_inverse = -inverse;
+
+    auto r_squared = UnsignedBigInteger { 1 }.shift_left(2 * 32 * m_length).divided_by(modulus).remainder;
+    m_r_squared.resize(m_length);
+    m_r_squared.span().fill(0);
+    for (size_t i = 0; i < r_squared.trimmed_length(); ++i)
+        m_r_squared[i] = r_squared.words()[i];
+}
+
+// Computes left * right / R mod m, interleaving the multiplication with the reduction one word at a time.
+// The output may be one of the inputs, and the scratch space needs room for m_length + 2 words.
+void MontgomeryContext::multiply(const u32* left, const u32* right, u32* output, u32* scratch) const
+{
+    const u32* modulus = m_modulus.words().data();
+    size_t length = m_length;
+    u32* accumulator = scratch;
+    __builtin_memset(accumulator, 0, (length + 2) * sizeof(u32));
+
+    for (size_t i = 0; i < length; ++i) {
+        u64 right_word = right[i];
+        u64 carry = 0;
+        for (size_t j = 0; j < length; ++j) {
+            u64 sum = left[j] * right_word + accumulator[j] + carry;
+            accumulator[j] = (u32)sum;
+            carry = sum >> 32;
+        }
+        u64 sum = accumulator[length] + carry;
+        accumulator[length] = (u32)sum;
+        accumulator[length + 1] = (u32)(sum >> 32);
+
+        // Adding this multiple of the modulus zeroes the lowest word, which is then shifted out.
+        u64 factor = (u32)(accumulator[0] * m_modulus_inverse);
+        sum = factor * modulus[0] + accumulator[0];
+        carry = sum >> 32;
+        for (size_t j = 1; j < length; ++j) {
+            sum = factor * modulus[j] + accumulator[j] + carry;
+            accumulator[j - 1] = (u32)sum;
+            carry = sum >> 32;
+        }
+        sum = accumulator[length] + carry;
+        accumulator[length - 1] = (u32)sum;
+        accumulator[length] = accumulator[length + 1] + (u32)(sum >> 32);
+    }
+
+    // The result is below 2m, so subtracting the modulus once brings it into range.
+    bool needs_subtraction = accumulator[length] != 0;
+    if (!needs_subtraction) {
+        needs_subtraction = true;
+        for (size_t i = length; i > 0; --i) {
+            if (accumulator[i - 1] != modulus[i - 1]) {
+                needs_subtraction = accumulator[i - 1] > modulus[i - 1];
+                break;
+            }
+        }
+    }
+
+    if (!needs_subtraction) {
+        __builtin_memcpy(output, accumulator, length * sizeof(u32));
+        return;
+    }
+
+    u32 borrow = 0;
+    for (size_t i = 0; i < length; ++i) {
+        u64 difference = (u64)accumulator[i] - modulus[i] - borrow;
+        output[i] = (u32)difference;
+        borrow = (difference >> 32) & 1;
+    }
+}
+
+void MontgomeryContext::to_montgomery_form(const UnsignedBigInteger& value, u32* output, u32* scratch) const
+{
+    const UnsignedBigInteger* reduced = &value;
+    UnsignedBigInteger remainder;
+    if (!(value < m_modulus)) {
+        remainder = value.divided_by(m_modulus).remainder;
+        reduced = &remainder;
+    }
+
+    __builtin_memset(output, 0, m_length * sizeof(u32));
+    for (size_t i = 0; i < reduced->trimmed_length(); ++i)
+        output[i] = reduced->words()[i];
+    multiply(output, m_r_squared.data(), output, scratch);
+}
+
+static size_t window_bits_for_exponent(size_t exponent_bits)
+{
+    // A window of w bits needs 2^(w-1) odd powers of the base to be precomputed,
+    // which only pays off once the exponent is long enough.
+    if (exponent_bits > 671)
+        return 6;
+    if (exponent_bits > 239)
+        return 5;
+    if (exponent_bits > 79)
+        return 4;
+    if (exponent_bits > 23)
+        return 3;
+    return 1;
+}
+
+UnsignedBigInteger MontgomeryContext::power(const UnsignedBigInteger& base, const UnsignedBigInteger& exponent) const
+{
+    if (m_modulus == 1)
+        return 0;
+
+    size_t exponent_length = exponent.trimmed_length();
+    if (exponent_length == 0)
+        return 1;
+    size_t exponent_bits = exponent_length * 32 - __builtin_clz(exponent.words()[exponent_length - 1]);
+    auto exponent_bit = [&](size_t index) {
+        return (exponent.words()[index / 32] >> (index % 32)) & 1;
+    };
+
+    size_t length = m_length;
+    size_t window_bits = window_bits_for_exponent(exponent_bits);
+    size_t table_size = 1u << (window_bits - 1);
+    Vector<u32> buffer;
+    buffer.resize((length + 2) + 2 * length + table_size * length);
+    u32* scratch = buffer.data();
+    u32* result = scratch + length + 2;
+    u32* base_squared = result + length;
+    // The odd powers of the base: base, base^3, base^5, ...
+    u32* table = base_squared + length;
+
+    to_montgomery_form(base, table, scratch);
+    if (table_size > 1) {
+        multiply(table, table, base_squared, scratch);
+        for (size_t i = 1; i < table_size; ++i)
+            multiply(table + (i - 1) * length, base_squared, table + i * length, scratch);
+    }
+
+    // Go through the exponent from the top, squaring for every bit, and multiplying by the
+    // matching odd power whenever a window of up to window_bits bits that ends with a one is done.
+    bool has_result = false;
+    for (ssize_t i = exponent_bits - 1; i >= 0;) {
+        if (!exponent_bit(i)) {
+            multiply(result, result, result, scratch);
+            --i;
+            continue;
+        }
+
+        ssize_t window_end = max<ssize_t>(i - window_bits + 1, 0);
+        while (!exponent_bit(window_end))
+            ++window_end;
+
+        size_t window_value = 0;
+        for (ssize_t j = i; j >= window_end; --j) {
+            window_value = (window_value << 1) | exponent_bit(j);
+            if (has_result)
+                multiply(result, result, result, scratch);
+        }
+
+        const u32* odd_power = table + (window_value >> 1) * length;
+        if (has_result) {
+            multiply(result, odd_power, result, scratch);
+        } else {
+            __builtin_memcpy(result, odd_power, length * sizeof(u32));
+            has_result = true;
+        }
+        i = window_end - 1;
+    }
+
+    // Multiplying by one takes the result out of Montgomery form.
+    __builtin_memset(base_squared, 0, length * sizeof(u32));
+    base_squared[0] = 1;
+    multiply(result, base_squared, result, scratch);
+
+    Vector<u32, STARTING_WORD_SIZE> words;
+    words.append(result, length);
+    while (words.size() > 1 && words.last() == 0)
+        words.take_last();
+    return UnsignedBigInteger(move(words));
+}
+
+}
+}
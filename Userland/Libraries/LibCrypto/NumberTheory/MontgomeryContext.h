@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Vector.h>
+#include <LibCrypto/BigInt/UnsignedBigInteger.h>
+
+namespace Crypto {
+namespace NumberTheory {
+
+// Modular exponentiation with Montgomery multiplication, which replaces the division after every
+// multiplication with a few extra multiplications by word. The values that only depend on the
+// modulus are computed once, so a context can be kept around for a modulus that is used repeatedly.
+class MontgomeryContext {
+public:
+    // The modulus has to be odd.
+    explicit MontgomeryContext(const UnsignedBigInteger& modulus);
+
+    const UnsignedBigInteger& modulus() const { return m_modulus; }
+
+    UnsignedBigInteger power(const UnsignedBigInteger& base, const UnsignedBigInteger& exponent) const;
+
+private:
+    // All numbers here are kept as exactly m_length words, and in Montgomery form (x * R mod m, with R = 2^(32 * m_length)).
+    void multiply(const u32* left, const u32* right, u32* output, u32* scratch) const;
+    void to_montgomery_form(const UnsignedBigInteger& value, u32* output, u32* scratch) const;
+
+    UnsignedBigInteger m_modulus;
+    size_t m_length { 0 };
+    // -m^-1 mod 2^32
+    u32 m_modulus_inverse { 0 };
+    // R^2 mod m, which converts numbers into Montgomery form.
+    Vector<u32> m_r_squared;
+};
+
+}
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <LibCrypto/Hash/SHA1.h>
+#include <LibCrypto/Hash/SHA2.h>
+#include <LibCrypto/PK/Code/Code.h>
+
+namespace Crypto {
+namespace PK {
+
+// The EMSA-PKCS1-v1_5 signature encoding of RFC 8017, section 9.2.
+template<typename HashFunction>
+class EMSA_PKCS1_V1_5 : public Code<HashFunction> {
+public:
+    template<typename... Args>
+    EMSA_PKCS1_V1_5(Args... args)
+        : Code<HashFunction>(args...)
+    {
+    }
+
+    virtual void encode(ReadonlyBytes in, ByteBuffer& out, size_t em_bits) override
+    {
+        auto& hash_fn = this->hasher();
+        hash_fn.update(in);
+        auto message_digest = hash_fn.digest();
+        auto digest_size = hash_fn.DigestSize;
+        auto digest_info = digest_info_prefix();
+
+        auto em_length = (em_bits + 7) / 8;
+        auto t_length = digest_info.size() + digest_size;
+        if (em_length < t_length + 11) {
+            dbgln("EMSA-PKCS1-V1_5-ENCODE: intended encoded message length too short");
+            return;
+        }
+
+        // EM = 0x00 || 0x01 || PS || 0x00 || T, where PS is a run of 0xff bytes.
+        out = ByteBuffer::create_uninitialized(em_length);
+        auto ps_length = em_length - t_length - 3;
+        out[0] = 0x00;
+        out[1] = 0x01;
+        __builtin_memset(out.data() + 2, 0xff, ps_length);
+        out[2 + ps_length] = 0x00;
+        out.overwrite(3 + ps_length, digest_info.data(), digest_info.size());
+        out.overwrite(3 + ps_length + digest_info.size(), message_digest.immutable_data(), digest_size);
+    }
+
+    virtual VerificationConsistency verify(ReadonlyBytes msg, ReadonlyBytes emsg, size_t em_bits) override
+    {
+        if (emsg.size() != (em_bits + 7) / 8)
+            return VerificationConsistency::Inconsistent;
+
+        ByteBuffer expected;
+        encode(msg, expected, em_bits);
+        if (expected.size() != emsg.size() || __builtin_memcmp(expected.data(), emsg.data(), emsg.size()) != 0)
+            return VerificationConsistency::Inconsistent;
+
+        return VerificationConsistency::Consistent;
+    }
+
+private:
+    // The DER encoding of the DigestInfo that precedes the digest, which identifies the hash function.
+    static ReadonlyBytes digest_info_prefix()
+    {
+        if constexpr (IsSame<HashFunction, Hash::SHA1>::value) {
+            static constexpr u8 prefix[] { 0x30, 0x21, 0x30, 0x09, 0x06, 0x05, 0x2b, 0x0e, 0x03, 0x02, 0x1a, 0x05, 0x00, 0x04, 0x14 };
+            return { prefix, sizeof(prefix) };
+        } else if constexpr (IsSame<HashFunction, Hash::SHA256>::value) {
+            static constexpr u8 prefix[] { 0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00, 0x04, 0x20 };
+            return { prefix, sizeof(prefix) };
+        } else if constexpr (IsSame<HashFunction, Hash::SHA512>::value) {
+            static constexpr u8 prefix[] { 0x30, 0x51, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x03, 0x05, 0x00, 0x04, 0x40 };
+            return { prefix, sizeof(prefix) };
+        } else {
+            static_assert(DependentFalse<HashFunction>, "Unsupported hash function for EMSA-PKCS1-v1_5");
+        }
+    }
+};
+
+}
+}
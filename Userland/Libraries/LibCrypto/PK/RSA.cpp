@@ -173,9 +173,24 @@ RSA::KeyPairType RSA::parse_rsa_key(ReadonlyBytes der)
             }
             auto private_exponent = private_exponent_result.release_value();
 
-            // Drop the rest of the fields on the floor, we don't use them.
-            // FIXME: Actually use them...
-            keypair.private_key = { modulus, move(private_exponent), public_exponent };
+            // The rest are the primes and the values that speed up private key operations,
+            // the key still works without them.
+            Vector<UnsignedBigInteger, 5> crt_parameters;
+            for (size_t i = 0; i < 5; ++i) {
+                auto parameter_result = decoder.read<UnsignedBigInteger>();
+                if (parameter_result.is_error()) {
+                    dbgln_if(RSA_PARSE_DEBUG, "RSA PKCS#1 private key has no CRT parameters: {}", parameter_result.error());
+                    break;
+                }
+                crt_parameters.append(parameter_result.release_value());
+            }
+
+            if (crt_parameters.size() == 5) {
+                keypair.private_key = { modulus, move(private_exponent), public_exponent,
+                    move(crt_parameters[0]), move(crt_parameters[1]), move(crt_parameters[2]), move(crt_parameters[3]), move(crt_parameters[4]) };
+            } else {
+                keypair.private_key = { modulus, move(private_exponent), public_exponent };
+            }
             keypair.public_key = { move(modulus), move(public_exponent) };
 
             return keypair;
@@ -225,6 +240,40 @@ RSA::KeyPairType RSA::parse_rsa_key(ReadonlyBytes der)
     }
 }
 
+static UnsignedBigInteger power_with_cached_context(Optional<NumberTheory::MontgomeryContext>& context, const UnsignedBigInteger& base, const UnsignedBigInteger& exponent, const UnsignedBigInteger& modulus)
+{
+    // A valid key always has an odd modulus, but don't trip over broken ones.
+    if (modulus.trimmed_length() == 0 || !(modulus.words()[0] & 1))
+        return NumberTheory::ModularPower(base, exponent, modulus);
+    if (!context.has_value() || context->modulus() != modulus)
+        context = NumberTheory::MontgomeryContext(modulus);
+    return context->power(base, exponent);
+}
+
+UnsignedBigInteger RSA::public_key_power(const UnsignedBigInteger& value)
+{
+    return power_with_cached_context(m_public_modulus_context, value, m_public_key.public_exponent(), m_public_key.modulus());
+}
+
+UnsignedBigInteger RSA::private_key_power(const UnsignedBigInteger& value)
+{
+    if (!m_private_key.has_crt_parameters())
+        return power_with_cached_context(m_private_modulus_context, value, m_private_key.private_exponent(), m_private_key.modulus());
+
+    // Garner's formula: with m1 = value^dP mod p and m2 = value^dQ mod q,
+    // the result is m2 + q * (qInv * (m1 - m2) mod p).
+    // Both exponentiations work with numbers half as long as the modulus.
+    auto& p = m_private_key.prime_1();
+    auto& q = m_private_key.prime_2();
+    auto m1 = power_with_cached_context(m_prime_1_context, value, m_private_key.exponent_1(), p);
+    auto m2 = power_with_cached_context(m_prime_2_context, value, m_private_key.exponent_2(), q);
+
+    auto m2_mod_p = m2.divided_by(p).remainder;
+    auto difference = m1 < m2_mod_p ? m1.plus(p).minus(m2_mod_p) : m1.minus(m2_mod_p);
+    auto h = m_private_key.coefficient().multiplied_by(difference).divided_by(p).remainder;
+    return m2.plus(h.multiplied_by(q));
+}
+
 void RSA::encrypt(ReadonlyBytes in, Bytes& out)
 {
     dbgln_if(CRYPTO_DEBUG, "in size: {}", in.size());
@@ -234,7 +283,7 @@ void RSA::encrypt(ReadonlyBytes in, Bytes& out)
         out = {};
         return;
     }
-    auto exp = NumberTheory::ModularPower(in_integer, m_public_key.public_exponent(), m_public_key.modulus());
+    auto exp = public_key_power(in_integer);
     auto size = exp.export_data(out);
     auto outsize = out.size();
     if (size != outsize) {
@@ -245,10 +294,8 @@ void RSA::encrypt(ReadonlyBytes in, Bytes& out)
 
 void RSA::decrypt(ReadonlyBytes in, Bytes& out)
 {
-    // FIXME: Actually use the private key properly
-
     auto in_integer = UnsignedBigInteger::import_data(in.data(), in.size());
-    auto exp = NumberTheory::ModularPower(in_integer, m_private_key.private_exponent(), m_private_key.modulus());
+    auto exp = private_key_power(in_integer);
     auto size = exp.export_data(out);
 
     auto align = m_private_key.length();
@@ -262,7 +309,7 @@ void RSA::decrypt(ReadonlyBytes in, Bytes& out)
 void RSA::sign(ReadonlyBytes in, Bytes& out)
 {
     auto in_integer = UnsignedBigInteger::import_data(in.data(), in.size());
-    auto exp = NumberTheory::ModularPower(in_integer, m_private_key.private_exponent(), m_private_key.modulus());
+    auto exp = private_key_power(in_integer);
     auto size = exp.export_data(out);
     out = out.slice(out.size() - size, size);
 }
@@ -270,7 +317,7 @@ void RSA::sign(ReadonlyBytes in, Bytes& out)
 void RSA::verify(ReadonlyBytes in, Bytes& out)
 {
     auto in_integer = UnsignedBigInteger::import_data(in.data(), in.size());
-    auto exp = NumberTheory::ModularPower(in_integer, m_public_key.public_exponent(), m_public_key.modulus());
+    auto exp = public_key_power(in_integer);
     auto size = exp.export_data(out);
     out = out.slice(out.size() - size, size);
 }
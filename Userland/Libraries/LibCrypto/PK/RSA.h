@@ -26,10 +26,12 @@
 
 #pragma once
 
+#include <AK/Optional.h>
 #include <AK/Span.h>
 #include <AK/Vector.h>
 #include <LibCrypto/BigInt/UnsignedBigInteger.h>
 #include <LibCrypto/NumberTheory/ModularFunctions.h>
+#include <LibCrypto/NumberTheory/MontgomeryContext.h>
 #include <LibCrypto/PK/Code/EMSA_PSS.h>
 #include <LibCrypto/PK/PK.h>
 
@@ -82,6 +84,19 @@ public:
     {
     }
 
+    RSAPrivateKey(Integer n, Integer d, Integer e, Integer p, Integer q, Integer dp, Integer dq, Integer qinv)
+        : m_modulus(move(n))
+        , m_private_exponent(move(d))
+        , m_public_exponent(move(e))
+        , m_prime_1(move(p))
+        , m_prime_2(move(q))
+        , m_exponent_1(move(dp))
+        , m_exponent_2(move(dq))
+        , m_coefficient(move(qinv))
+        , m_length(m_modulus.trimmed_length() * sizeof(u32))
+    {
+    }
+
     RSAPrivateKey()
     {
     }
@@ -93,11 +108,25 @@ public:
     size_t length() const { return m_length; }
     void set_length(size_t length) { m_length = length; }
 
+    // The factors of the modulus and the values derived from them (see RFC 8017, 3.2),
+    // which let the private key operation work modulo each prime separately.
+    bool has_crt_parameters() const { return m_prime_1 != 0 && m_prime_2 != 0; }
+    const Integer& prime_1() const { return m_prime_1; }
+    const Integer& prime_2() const { return m_prime_2; }
+    const Integer& exponent_1() const { return m_exponent_1; }
+    const Integer& exponent_2() const { return m_exponent_2; }
+    const Integer& coefficient() const { return m_coefficient; }
+
     void set(Integer n, Integer d, Integer e)
     {
         m_modulus = move(n);
         m_private_exponent = move(d);
         m_public_exponent = move(e);
+        m_prime_1 = {};
+        m_prime_2 = {};
+        m_exponent_1 = {};
+        m_exponent_2 = {};
+        m_coefficient = {};
         m_length = m_modulus.trimmed_length() * sizeof(u32);
     }
 
@@ -105,6 +134,11 @@ private:
     Integer m_modulus;
     Integer m_private_exponent;
     Integer m_public_exponent;
+    Integer m_prime_1;
+    Integer m_prime_2;
+    Integer m_exponent_1;
+    Integer m_exponent_2;
+    Integer m_coefficient;
     size_t m_length { 0 };
 };
 
@@ -139,10 +173,13 @@ public:
         auto n = p.multiplied_by(q);
 
         auto d = NumberTheory::ModularInverse(e, lambda);
+        auto dp = d.divided_by(p.minus(1)).remainder;
+        auto dq = d.divided_by(q.minus(1)).remainder;
+        auto qinv = NumberTheory::ModularInverse(q.divided_by(p).remainder, p);
         dbgln("Your keys are Pub(n={}, e={}) and Priv(n={}, d={})", n, e, n, d);
         RSAKeyPair<PublicKeyType, PrivateKeyType> keys {
             { n, e },
-            { n, d, e }
+            { n, d, e, p, q, dp, dq, qinv }
         };
         keys.public_key.set_length(bits / 2 / 8);
         keys.private_key.set_length(bits / 2 / 8);
@@ -195,6 +232,17 @@ public:
 
     const PrivateKeyType& private_key() const { return m_private_key; }
     const PublicKeyType& public_key() const { return m_public_key; }
+
+protected:
+    IntegerType public_key_power(const IntegerType&);
+    IntegerType private_key_power(const IntegerType&);
+
+private:
+    // Montgomery contexts for the moduli of the keys, created when they're first needed.
+    Optional<NumberTheory::MontgomeryContext> m_public_modulus_context;
+    Optional<NumberTheory::MontgomeryContext> m_private_modulus_context;
+    Optional<NumberTheory::MontgomeryContext> m_prime_1_context;
+    Optional<NumberTheory::MontgomeryContext> m_prime_2_context;
 };
 
 template<typename HashFunction>
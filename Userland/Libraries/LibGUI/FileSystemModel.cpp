@@ -34,6 +34,7 @@
 #include <LibGUI/FileSystemModel.h>
 #include <LibGUI/Painter.h>
 #include <LibGfx/Bitmap.h>
+#include <LibGfx/JPGLoader.h>
 #include <LibThread/BackgroundAction.h>
 #include <dirent.h>
 #include <grp.h>
@@ -491,18 +492,23 @@ static HashMap<String, RefPtr<Gfx::Bitmap>> s_thumbnail_cache;
 
 static RefPtr<Gfx::Bitmap> render_thumbnail(const StringView& path)
 {
-    auto png_bitmap = Gfx::Bitmap::load_from_file(path);
-    if (!png_bitmap)
+    RefPtr<Gfx::Bitmap> bitmap;
+    // JPEGs can be decoded at a fraction of their size, which is much cheaper than decoding them whole.
+    if (path.ends_with(".jpg", CaseSensitivity::CaseInsensitive) || path.ends_with(".jpeg", CaseSensitivity::CaseInsensitive))
+        bitmap = Gfx::load_jpg_downscaled(path, { 32, 32 });
+    else
+        bitmap = Gfx::Bitmap::load_from_file(path);
+    if (!bitmap)
         return nullptr;
 
-    double scale = min(32 / (double)png_bitmap->width(), 32 / (double)png_bitmap->height());
+    double scale = min(32 / (double)bitmap->width(), 32 / (double)bitmap->height());
 
     auto thumbnail = Gfx::Bitmap::create(Gfx::BitmapFormat::RGBA32, { 32, 32 });
-    Gfx::IntRect destination = Gfx::IntRect(0, 0, (int)(png_bitmap->width() * scale), (int)(png_bitmap->height() * scale));
+    Gfx::IntRect destination = Gfx::IntRect(0, 0, (int)(bitmap->width() * scale), (int)(bitmap->height() * scale));
     destination.center_within(thumbnail->rect());
 
     Painter painter(*thumbnail);
-    painter.draw_scaled_bitmap(destination, *png_bitmap, png_bitmap->rect());
+    painter.draw_scaled_bitmap(destination, *bitmap, bitmap->rect(), 1.0f, Painter::ScalingMode::BilinearBlend);
     return thumbnail;
 }
 
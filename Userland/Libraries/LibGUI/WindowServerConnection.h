@@ -40,6 +40,7 @@ public:
     WindowServerConnection()
         : IPC::ServerConnection<WindowClientEndpoint, WindowServerEndpoint>(*this, "/tmp/portal/window")
     {
+        enable_shared_memory_transport();
         handshake();
     }
 
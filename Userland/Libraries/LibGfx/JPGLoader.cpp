@@ -24,13 +24,14 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <AK/Bitmap.h>
+#include <AK/Array.h>
 #include <AK/ByteBuffer.h>
 #include <AK/Debug.h>
 #include <AK/HashMap.h>
 #include <AK/LexicalPath.h>
 #include <AK/MappedFile.h>
 #include <AK/MemoryStream.h>
+#include <AK/SIMD.h>
 #include <AK/String.h>
 #include <AK/Vector.h>
 #include <LibGfx/Bitmap.h>
@@ -87,6 +88,7 @@
 #define JPG_EOI 0xFFD9
 #define JPG_RST 0XFFDD
 #define JPG_SOF0 0XFFC0
+#define JPG_SOF1 0XFFC1
 #define JPG_SOF2 0xFFC2
 #define JPG_SOI 0XFFD8
 #define JPG_SOS 0XFFDA
@@ -107,39 +109,7 @@ constexpr static u8 zigzag_map[64] {
 
 using Marker = u16;
 
-/**
- * MCU means group of data units that are coded together. A data unit is an 8x8
- * block of component data. In interleaved scans, number of non-interleaved data
- * units of a component C is Ch * Cv, where Ch and Cv represent the horizontal &
- * vertical subsampling factors of the component, respectively. A MacroBlock is
- * an 8x8 block of RGB values before encoding, and 8x8 block of YCbCr values when
- * we're done decoding the huffman stream.
- */
-struct Macroblock {
-    union {
-        i32 y[64] = { 0 };
-        i32 r[64];
-    };
-
-    union {
-        i32 cb[64] = { 0 };
-        i32 g[64];
-    };
-
-    union {
-        i32 cr[64] = { 0 };
-        i32 b[64];
-    };
-};
-
-struct MacroblockMeta {
-    u32 total { 0 };
-    u32 padded_total { 0 };
-    u32 hcount { 0 };
-    u32 vcount { 0 };
-    u32 hpadded_count { 0 };
-    u32 vpadded_count { 0 };
-};
+struct HuffmanTableSpec;
 
 struct ComponentSpec {
     u8 serial_id { 255 }; // In the interval [0, 3).
@@ -149,6 +119,36 @@ struct ComponentSpec {
     u8 ac_destination_id { 0 };
     u8 dc_destination_id { 0 };
     u8 qtable_id { 0 }; // Quantization table id.
+
+    // Resolved at the start of every scan the component is part of.
+    const HuffmanTableSpec* dc_table { nullptr };
+    const HuffmanTableSpec* ac_table { nullptr };
+
+    // Copied from the quantization table when the component first appears in a scan, as
+    // the table may be redefined before the following scans.
+    bool has_quantization_table { false };
+    u16 quantization_table[64] = { 0 };
+
+    // The size of the component in blocks, padded out to whole MCUs.
+    u32 blocks_per_line { 0 };
+    u32 block_rows { 0 };
+    // Non-interleaved scans only code the blocks that overlap the image.
+    u32 unpadded_blocks_per_line { 0 };
+    u32 unpadded_block_rows { 0 };
+
+    // The coefficients of every block in natural order, for images that are decoded in several scans.
+    Vector<i16> coefficients;
+    // The decoded samples of the current row of MCUs.
+    Vector<u8> samples;
+    size_t samples_pitch { 0 };
+    // The number of samples along each side of a decoded block.
+    u8 block_output_size { 8 };
+    // How many times each sample is repeated to get to the size of the image.
+    u8 horizontal_upsampling { 1 };
+    u8 vertical_upsampling { 1 };
+    Vector<u8> upsampled_row;
+
+    i32 previous_dc { 0 };
 };
 
 struct StartOfFrame {
@@ -176,18 +176,42 @@ struct StartOfFrame {
     u16 width { 0 };
 };
 
+static constexpr u8 huffman_lookup_bits = 9;
+
 struct HuffmanTableSpec {
     u8 type { 0 };
     u8 destination_id { 0 };
     u8 code_counts[16] = { 0 };
     Vector<u8> symbols;
-    Vector<u16> codes;
+
+    // Indexed by the next huffman_lookup_bits bits of the stream. A length of 0 means that the code is longer.
+    u8 lookup_lengths[1 << huffman_lookup_bits] = { 0 };
+    u8 lookup_symbols[1 << huffman_lookup_bits] = { 0 };
+    // For the longer codes: the largest code of each length (or -1), and the offset from a code to its symbol.
+    i32 max_codes[17] = { 0 };
+    i32 symbol_offsets[17] = { 0 };
 };
 
 struct HuffmanStreamState {
-    Vector<u8> stream;
-    u8 bit_offset { 0 };
+    ReadonlyBytes data;
     size_t byte_offset { 0 };
+    // Buffered bits, most significant first.
+    u64 bits { 0 };
+    u8 bit_count { 0 };
+    // Zero bits that were made up after the end of the entropy-coded data.
+    u8 padding_bit_count { 0 };
+    bool reached_marker { false };
+    bool read_past_end { false };
+    // The number of blocks left that have no more coefficients in the current progressive band.
+    u32 end_of_band_run { 0 };
+};
+
+struct Scan {
+    Vector<ComponentSpec*, 3> components;
+    u8 spectral_selection_start { 0 };
+    u8 spectral_selection_end { 63 };
+    u8 successive_approximation_high { 0 };
+    u8 successive_approximation_low { 0 };
 };
 
 struct JPGLoadingContext {
@@ -201,238 +225,745 @@ struct JPGLoadingContext {
     State state { State::NotDecoded };
     const u8* data { nullptr };
     size_t data_size { 0 };
-    u32 luma_table[64] = { 0 };
-    u32 chroma_table[64] = { 0 };
+    u16 quantization_tables[4][64] = { { 0 } };
     StartOfFrame frame;
+    // The largest sampling factors of all components, which give the size of an MCU in blocks.
     u8 hsample_factor { 0 };
     u8 vsample_factor { 0 };
     u8 component_count { 0 };
-    HashMap<u8, ComponentSpec> components;
+    Vector<ComponentSpec, 3> components;
+    u32 mcus_per_line { 0 };
+    u32 mcu_rows { 0 };
     RefPtr<Gfx::Bitmap> bitmap;
     u16 dc_reset_interval { 0 };
     HashMap<u8, HuffmanTableSpec> dc_tables;
     HashMap<u8, HuffmanTableSpec> ac_tables;
     HuffmanStreamState huffman_stream;
-    i32 previous_dc_values[3] = { 0 };
-    MacroblockMeta mblock_meta;
+    Scan current_scan;
+    // Progressive images, and sequential ones that code their components in separate scans, can
+    // only be output once all scans are decoded. Everything else is output one row of MCUs at a time.
+    bool buffers_whole_image { false };
+    // If set, the image is decoded at 1/2, 1/4 or 1/8 of its size, as long as it stays at least this large.
+    Optional<IntSize> minimum_size;
+    u8 scale_denominator { 1 };
+
+    u8 block_output_size() const { return 8 / scale_denominator; }
 };
 
-static void generate_huffman_codes(HuffmanTableSpec& table)
+static bool generate_huffman_codes(HuffmanTableSpec& table)
 {
-    unsigned code = 0;
-    for (auto number_of_codes : table.code_counts) {
-        for (int i = 0; i < number_of_codes; i++)
-            table.codes.append(code++);
+    u32 code = 0;
+    size_t symbol_index = 0;
+    for (u8 length = 1; length <= 16; length++) {
+        auto number_of_codes = table.code_counts[length - 1];
+        table.symbol_offsets[length] = (i32)symbol_index - (i32)code;
+        for (int i = 0; i < number_of_codes; i++, code++, symbol_index++) {
+            if (code >= (1u << length)) {
+                dbgln_if(JPG_DEBUG, "Huffman table has too many codes of length {}!", length);
+                return false;
+            }
+            if (length <= huffman_lookup_bits) {
+                u32 first_entry = code << (huffman_lookup_bits - length);
+                u32 entry_count = 1u << (huffman_lookup_bits - length);
+                for (u32 entry = first_entry; entry < first_entry + entry_count; entry++) {
+                    table.lookup_lengths[entry] = length;
+                    table.lookup_symbols[entry] = table.symbols[symbol_index];
+                }
+            }
+        }
+        table.max_codes[length] = number_of_codes ? (i32)code - 1 : -1;
         code <<= 1;
     }
+    return true;
 }
 
-static Optional<size_t> read_huffman_bits(HuffmanStreamState& hstream, size_t count = 1)
+static void fill_huffman_bits(HuffmanStreamState& hstream)
 {
-    if (count > (8 * sizeof(size_t))) {
-        dbgln_if(JPG_DEBUG, "Can't read {} bits at once!", count);
-        return {};
-    }
-    size_t value = 0;
-    while (count--) {
-        if (hstream.byte_offset >= hstream.stream.size()) {
-            dbgln_if(JPG_DEBUG, "Huffman stream exhausted. This could be an error!");
-            return {};
-        }
-        u8 current_byte = hstream.stream[hstream.byte_offset];
-        u8 current_bit = 1u & (u32)(current_byte >> (7 - hstream.bit_offset)); // MSB first.
-        hstream.bit_offset++;
-        value = (value << 1) | (size_t)current_bit;
-        if (hstream.bit_offset == 8) {
-            hstream.byte_offset++;
-            hstream.bit_offset = 0;
+    while (hstream.bit_count <= 56) {
+        u8 byte = 0;
+        if (!hstream.reached_marker) {
+            if (hstream.byte_offset >= hstream.data.size()) {
+                hstream.reached_marker = true;
+            } else if (hstream.data[hstream.byte_offset] != 0xFF) {
+                byte = hstream.data[hstream.byte_offset++];
+            } else {
+                u8 next_byte = hstream.byte_offset + 1 < hstream.data.size() ? hstream.data[hstream.byte_offset + 1] : 0xD9;
+                if (next_byte == 0xFF) {
+                    // Fill byte.
+                    hstream.byte_offset++;
+                    continue;
+                }
+                if (next_byte == 0x00) {
+                    byte = 0xFF;
+                    hstream.byte_offset += 2;
+                } else {
+                    hstream.reached_marker = true;
+                }
+            }
         }
+        if (hstream.reached_marker)
+            hstream.padding_bit_count += 8;
+        hstream.bits |= (u64)byte << (56 - hstream.bit_count);
+        hstream.bit_count += 8;
     }
+}
+
+ALWAYS_INLINE static void discard_huffman_bits(HuffmanStreamState& hstream, u8 count)
+{
+    if (hstream.bit_count - hstream.padding_bit_count < count)
+        hstream.read_past_end = true;
+    hstream.bits <<= count;
+    hstream.bit_count -= count;
+    hstream.padding_bit_count = min(hstream.padding_bit_count, hstream.bit_count);
+}
+
+ALWAYS_INLINE static u32 read_huffman_bits(HuffmanStreamState& hstream, u8 count)
+{
+    if (count == 0)
+        return 0;
+    if (hstream.bit_count < count)
+        fill_huffman_bits(hstream);
+    u32 value = hstream.bits >> (64 - count);
+    discard_huffman_bits(hstream, count);
+    return value;
+}
+
+// Reads a value that was coded as `length` bits of magnitude, where a leading 0 bit means it is negative.
+ALWAYS_INLINE static i32 read_signed_huffman_value(HuffmanStreamState& hstream, u8 length)
+{
+    if (length == 0)
+        return 0;
+    i32 value = read_huffman_bits(hstream, length);
+    if (value < (1 << (length - 1)))
+        value -= (1 << length) - 1;
     return value;
 }
 
-static Optional<u8> get_next_symbol(HuffmanStreamState& hstream, const HuffmanTableSpec& table)
+ALWAYS_INLINE static Optional<u8> get_next_symbol(HuffmanStreamState& hstream, const HuffmanTableSpec& table)
 {
-    unsigned code = 0;
-    size_t code_cursor = 0;
-    for (int i = 0; i < 16; i++) { // Codes can't be longer than 16 bits.
-        auto result = read_huffman_bits(hstream);
-        if (!result.has_value())
-            return {};
-        code = (code << 1) | (i32)result.release_value();
-        for (int j = 0; j < table.code_counts[i]; j++) {
-            if (code == table.codes[code_cursor])
-                return table.symbols[code_cursor];
-            code_cursor++;
+    if (hstream.bit_count < 16)
+        fill_huffman_bits(hstream);
+
+    u32 lookahead = hstream.bits >> (64 - huffman_lookup_bits);
+    if (auto length = table.lookup_lengths[lookahead]) {
+        discard_huffman_bits(hstream, length);
+        return table.lookup_symbols[lookahead];
+    }
+
+    u32 code = hstream.bits >> (64 - 16);
+    for (u8 length = huffman_lookup_bits + 1; length <= 16; length++) { // Codes can't be longer than 16 bits.
+        i32 prefix = code >> (16 - length);
+        if (prefix <= table.max_codes[length]) {
+            size_t symbol_index = prefix + table.symbol_offsets[length];
+            if (symbol_index >= table.symbols.size())
+                return {};
+            discard_huffman_bits(hstream, length);
+            return table.symbols[symbol_index];
         }
     }
 
-#if JPG_DEBUG
-    dbgln("If you're seeing this...the jpeg decoder needs to support more kinds of JPEGs!");
-#endif
+    dbgln_if(JPG_DEBUG, "Invalid huffman code!");
     return {};
 }
 
-/**
- * Build the macroblocks possible by reading single (MCU) subsampled pair of CbCr.
- * Depending on the sampling factors, we may not see triples of y, cb, cr in that
- * order. If sample factors differ from one, we'll read more than one block of y-
- * coefficients before we get to read a cb-cr block.
-
- * In the function below, `hcursor` and `vcursor` denote the location of the block
- * we're building in the macroblock matrix. `vfactor_i` and `hfactor_i` are cursors
- * that iterate over the vertical and horizontal subsampling factors, respectively.
- * When we finish one iteration of the innermost loop, we'll have the coefficients
- * of one of the components of block at position `mb_index`. When the outermost loop
- * finishes first iteration, we'll have all the luminance coefficients for all the
- * macroblocks that share the chrominance data. Next two iterations (assuming that
- * we are dealing with three components) will fill up the blocks with chroma data.
- */
-static bool build_macroblocks(JPGLoadingContext& context, Vector<Macroblock>& macroblocks, u8 hcursor, u8 vcursor)
+ALWAYS_INLINE static i16 clamp_coefficient(i32 value)
+{
+    return min(max(value, -32768), 32767);
+}
+
+static bool decode_dc_difference(HuffmanStreamState& hstream, ComponentSpec& component)
 {
-    for (auto it = context.components.begin(); it != context.components.end(); ++it) {
-        ComponentSpec& component = it->value;
+    auto symbol_or_error = get_next_symbol(hstream, *component.dc_table);
+    if (!symbol_or_error.has_value())
+        return false;
+
+    // For DC coefficients, symbol encodes the length of the coefficient.
+    auto dc_length = symbol_or_error.release_value();
+    if (dc_length > 11) {
+        dbgln_if(JPG_DEBUG, "DC coefficient too long: {}!", dc_length);
+        return false;
+    }
+
+    // DC coefficients are encoded as the difference between previous and current DC values.
+    component.previous_dc = clamp_coefficient(component.previous_dc + read_signed_huffman_value(hstream, dc_length));
+    return true;
+}
 
-        if (component.dc_destination_id >= context.dc_tables.size())
+static bool decode_block_sequential(HuffmanStreamState& hstream, ComponentSpec& component, i16* block)
+{
+    if (!decode_dc_difference(hstream, component))
+        return false;
+    block[0] = component.previous_dc;
+
+    // Compute the AC coefficients.
+    for (u8 j = 1; j < 64;) {
+        auto symbol_or_error = get_next_symbol(hstream, *component.ac_table);
+        if (!symbol_or_error.has_value())
             return false;
-        if (component.ac_destination_id >= context.ac_tables.size())
+
+        // AC symbols encode 2 pieces of information, the high 4 bits represent
+        // number of zeroes to be stuffed before reading the coefficient. Low 4
+        // bits represent the magnitude of the coefficient.
+        auto ac_symbol = symbol_or_error.release_value();
+        u8 run_length = ac_symbol >> 4;
+        u8 coeff_length = ac_symbol & 0x0F;
+        if (coeff_length == 0) {
+            if (run_length != 15)
+                break;
+            // ac_symbol = 0xF0 means we need to skip 16 zeroes.
+            j += 16;
+            continue;
+        }
+
+        j += run_length;
+        if (j >= 64) {
+            dbgln_if(JPG_DEBUG, "Run-length exceeded boundaries. Cursor: {}, Skipping: {}!", j, run_length);
+            return false;
+        }
+        block[zigzag_map[j++]] = read_signed_huffman_value(hstream, coeff_length);
+    }
+
+    return true;
+}
+
+static bool decode_block_dc_first(HuffmanStreamState& hstream, ComponentSpec& component, const Scan& scan, i16* block)
+{
+    if (!decode_dc_difference(hstream, component))
+        return false;
+    block[0] = clamp_coefficient(component.previous_dc * (1 << scan.successive_approximation_low));
+    return true;
+}
+
+static void decode_block_dc_refine(HuffmanStreamState& hstream, const Scan& scan, i16* block)
+{
+    if (read_huffman_bits(hstream, 1))
+        block[0] |= 1 << scan.successive_approximation_low;
+}
+
+static bool decode_block_ac_first(HuffmanStreamState& hstream, const ComponentSpec& component, const Scan& scan, i16* block)
+{
+    if (hstream.end_of_band_run > 0) {
+        hstream.end_of_band_run--;
+        return true;
+    }
+
+    for (u8 j = scan.spectral_selection_start; j <= scan.spectral_selection_end; j++) {
+        auto symbol_or_error = get_next_symbol(hstream, *component.ac_table);
+        if (!symbol_or_error.has_value())
             return false;
 
-        for (u8 vfactor_i = 0; vfactor_i < component.vsample_factor; vfactor_i++) {
-            for (u8 hfactor_i = 0; hfactor_i < component.hsample_factor; hfactor_i++) {
-                u32 mb_index = (vcursor + vfactor_i) * context.mblock_meta.hpadded_count + (hfactor_i + hcursor);
-                Macroblock& block = macroblocks[mb_index];
+        auto ac_symbol = symbol_or_error.release_value();
+        u8 run_length = ac_symbol >> 4;
+        u8 coeff_length = ac_symbol & 0x0F;
+        if (coeff_length == 0) {
+            if (run_length != 15) {
+                // This block and the next 2^run_length - 1 + (run_length more bits) ones end here.
+                hstream.end_of_band_run = (1u << run_length) - 1 + read_huffman_bits(hstream, run_length);
+                break;
+            }
+            j += 15;
+            continue;
+        }
 
-                auto& dc_table = context.dc_tables.find(component.dc_destination_id)->value;
-                auto& ac_table = context.ac_tables.find(component.ac_destination_id)->value;
+        j += run_length;
+        if (j > scan.spectral_selection_end) {
+            dbgln_if(JPG_DEBUG, "Run-length exceeded the spectral band. Cursor: {}, Skipping: {}!", j, run_length);
+            return false;
+        }
+        block[zigzag_map[j]] = clamp_coefficient(read_signed_huffman_value(hstream, coeff_length) * (1 << scan.successive_approximation_low));
+    }
 
-                auto symbol_or_error = get_next_symbol(context.huffman_stream, dc_table);
-                if (!symbol_or_error.has_value())
-                    return false;
+    return true;
+}
+
+static bool decode_block_ac_refine(HuffmanStreamState& hstream, const ComponentSpec& component, const Scan& scan, i16* block)
+{
+    i16 positive_bit = 1 << scan.successive_approximation_low;
+    i16 negative_bit = -positive_bit;
+
+    // Coefficients that are already nonzero get one more bit each time they are passed over.
+    auto refine = [&](i16& coefficient) {
+        if (read_huffman_bits(hstream, 1) && (coefficient & positive_bit) == 0)
+            coefficient += coefficient >= 0 ? positive_bit : negative_bit;
+    };
 
-                // For DC coefficients, symbol encodes the length of the coefficient.
-                auto dc_length = symbol_or_error.release_value();
-                if (dc_length > 11) {
-                    dbgln_if(JPG_DEBUG, "DC coefficient too long: {}!", dc_length);
+    u8 j = scan.spectral_selection_start;
+    if (hstream.end_of_band_run == 0) {
+        for (; j <= scan.spectral_selection_end; j++) {
+            auto symbol_or_error = get_next_symbol(hstream, *component.ac_table);
+            if (!symbol_or_error.has_value())
+                return false;
+
+            auto ac_symbol = symbol_or_error.release_value();
+            u8 run_length = ac_symbol >> 4;
+            u8 coeff_length = ac_symbol & 0x0F;
+            i16 new_coefficient = 0;
+            if (coeff_length != 0) {
+                if (coeff_length != 1) {
+                    dbgln_if(JPG_DEBUG, "Refinement coefficient too long: {}!", coeff_length);
                     return false;
                 }
+                new_coefficient = read_huffman_bits(hstream, 1) ? positive_bit : negative_bit;
+            } else if (run_length != 15) {
+                hstream.end_of_band_run = (1u << run_length) + read_huffman_bits(hstream, run_length);
+                break;
+            }
 
-                auto coeff_or_error = read_huffman_bits(context.huffman_stream, dc_length);
-                if (!coeff_or_error.has_value())
+            // Skip run_length coefficients that are still zero, and place the new one after them.
+            for (; j <= scan.spectral_selection_end; j++) {
+                auto& coefficient = block[zigzag_map[j]];
+                if (coefficient != 0)
+                    refine(coefficient);
+                else if (run_length-- == 0)
+                    break;
+            }
+
+            if (new_coefficient != 0) {
+                if (j > scan.spectral_selection_end)
                     return false;
+                block[zigzag_map[j]] = new_coefficient;
+            }
+        }
+    }
 
-                // DC coefficients are encoded as the difference between previous and current DC values.
-                i32 dc_diff = coeff_or_error.release_value();
+    if (hstream.end_of_band_run > 0) {
+        for (; j <= scan.spectral_selection_end; j++) {
+            auto& coefficient = block[zigzag_map[j]];
+            if (coefficient != 0)
+                refine(coefficient);
+        }
+        hstream.end_of_band_run--;
+    }
 
-                // If MSB in diff is 0, the difference is -ve. Otherwise +ve.
-                if (dc_length != 0 && dc_diff < (1 << (dc_length - 1)))
-                    dc_diff -= (1 << dc_length) - 1;
+    return true;
+}
 
-                i32* select_component = component.serial_id == 0 ? block.y : (component.serial_id == 1 ? block.cb : block.cr);
-                auto& previous_dc = context.previous_dc_values[component.serial_id];
-                select_component[0] = previous_dc += dc_diff;
+ALWAYS_INLINE static bool decode_block(JPGLoadingContext& context, ComponentSpec& component, i16* block)
+{
+    auto& hstream = context.huffman_stream;
+    auto& scan = context.current_scan;
+    if (context.frame.type != StartOfFrame::FrameType::Progressive_DCT)
+        return decode_block_sequential(hstream, component, block);
+    if (scan.spectral_selection_start == 0) {
+        if (scan.successive_approximation_high == 0)
+            return decode_block_dc_first(hstream, component, scan, block);
+        decode_block_dc_refine(hstream, scan, block);
+        return true;
+    }
+    if (scan.successive_approximation_high == 0)
+        return decode_block_ac_first(hstream, component, scan, block);
+    return decode_block_ac_refine(hstream, component, scan, block);
+}
 
-                // Compute the AC coefficients.
-                for (int j = 1; j < 64;) {
-                    symbol_or_error = get_next_symbol(context.huffman_stream, ac_table);
-                    if (!symbol_or_error.has_value())
-                        return false;
+ALWAYS_INLINE static u8 clamp_sample(i32 value)
+{
+    return min(max(value, 0), 255);
+}
+
+// Dequantized coefficients are limited to what 8-bit samples can produce, which keeps the
+// fixed-point arithmetic below from overflowing on corrupt images.
+ALWAYS_INLINE static i32 dequantize(i16 coefficient, u16 quantizer)
+{
+    return min(max((i32)coefficient * quantizer, -4096), 4095);
+}
 
-                    // AC symbols encode 2 pieces of information, the high 4 bits represent
-                    // number of zeroes to be stuffed before reading the coefficient. Low 4
-                    // bits represent the magnitude of the coefficient.
-                    auto ac_symbol = symbol_or_error.release_value();
-                    if (ac_symbol == 0)
-                        break;
+static bool has_only_dc_coefficient(const i16* coefficients)
+{
+    i16 ac_bits = 0;
+    for (size_t i = 1; i < 64; i++)
+        ac_bits |= coefficients[i];
+    return ac_bits == 0;
+}
 
-                    // ac_symbol = 0xF0 means we need to skip 16 zeroes.
-                    u8 run_length = ac_symbol == 0xF0 ? 16 : ac_symbol >> 4;
-                    j += run_length;
+// The fixed-point layout of the AAN IDCT below is that of the IJG "ifast" IDCT: the inputs
+// have 2 fractional bits, and the constants have 8.
+static constexpr int idct_constant_bits = 8;
+static constexpr int idct_input_fraction_bits = 2;
 
-                    if (j >= 64) {
-                        dbgln_if(JPG_DEBUG, "Run-length exceeded boundaries. Cursor: {}, Skipping: {}!", j, run_length);
-                        return false;
-                    }
+// The AAN algorithm leaves a scale factor on every coefficient, which is applied while dequantizing.
+static const Array<i32, 64>& aan_scale_factors()
+{
+    static const Array<i32, 64> factors = [] {
+        auto factor = [](size_t k) { return k == 0 ? 1.0 : cos(k * M_PI / 16) * M_SQRT2; };
+        Array<i32, 64> factors;
+        for (size_t i = 0; i < 64; i++)
+            factors[i] = round(factor(i / 8) * factor(i % 8) * (1 << 14));
+        return factors;
+    }();
+    return factors;
+}
 
-                    u8 coeff_length = ac_symbol & 0x0F;
-                    if (coeff_length > 10) {
-                        dbgln_if(JPG_DEBUG, "AC coefficient too long: {}!", coeff_length);
-                        return false;
-                    }
+// One 8-point AAN IDCT, on either a single column or a vector of them.
+template<typename T>
+ALWAYS_INLINE static void aan_inverse_dct(T (&values)[8])
+{
+    auto multiply = [](T value, i32 constant) -> T { return (value * constant) >> idct_constant_bits; };
+    constexpr i32 fix_1_082392200 = 277;
+    constexpr i32 fix_1_414213562 = 362;
+    constexpr i32 fix_1_847759065 = 473;
+    constexpr i32 fix_2_613125930 = 669;
+
+    T even0 = values[0] + values[4];
+    T even1 = values[0] - values[4];
+    T even3 = values[2] + values[6];
+    T even2 = multiply(values[2] - values[6], fix_1_414213562) - even3;
+    T tmp0 = even0 + even3;
+    T tmp3 = even0 - even3;
+    T tmp1 = even1 + even2;
+    T tmp2 = even1 - even2;
+
+    T z13 = values[5] + values[3];
+    T z10 = values[5] - values[3];
+    T z11 = values[1] + values[7];
+    T z12 = values[1] - values[7];
+    T tmp7 = z11 + z13;
+    T odd1 = multiply(z11 - z13, fix_1_414213562);
+    T z5 = multiply(z10 + z12, fix_1_847759065);
+    T odd0 = multiply(z12, fix_1_082392200) - z5;
+    T odd2 = multiply(z10, -fix_2_613125930) + z5;
+    T tmp6 = odd2 - tmp7;
+    T tmp5 = odd1 - tmp6;
+    T tmp4 = odd0 + tmp5;
+
+    values[0] = tmp0 + tmp7;
+    values[7] = tmp0 - tmp7;
+    values[1] = tmp1 + tmp6;
+    values[6] = tmp1 - tmp6;
+    values[2] = tmp2 + tmp5;
+    values[5] = tmp2 - tmp5;
+    values[4] = tmp3 + tmp4;
+    values[3] = tmp3 - tmp4;
+}
 
-                    if (coeff_length != 0) {
-                        coeff_or_error = read_huffman_bits(context.huffman_stream, coeff_length);
-                        if (!coeff_or_error.has_value())
-                            return false;
-                        i32 ac_coefficient = coeff_or_error.release_value();
-                        if (ac_coefficient < (1 << (coeff_length - 1)))
-                            ac_coefficient -= (1 << coeff_length) - 1;
+#ifdef __SSE2__
+using IDCTColumns = AK::SIMD::i32x4;
+#else
+using IDCTColumns = i32;
+#endif
 
-                        select_component[zigzag_map[j++]] = ac_coefficient;
-                    }
+static void inverse_dct_columns(i32* workspace)
+{
+    constexpr size_t columns_at_once = sizeof(IDCTColumns) / sizeof(i32);
+    for (size_t column = 0; column < 8; column += columns_at_once) {
+        IDCTColumns values[8];
+        for (size_t row = 0; row < 8; row++)
+            __builtin_memcpy(&values[row], &workspace[row * 8 + column], sizeof(IDCTColumns));
+        aan_inverse_dct(values);
+        for (size_t row = 0; row < 8; row++)
+            __builtin_memcpy(&workspace[row * 8 + column], &values[row], sizeof(IDCTColumns));
+    }
+}
+
+static void inverse_dct_8x8(const i16* coefficients, const u16* quantization_table, u8* output, size_t pitch)
+{
+    if (has_only_dc_coefficient(coefficients)) {
+        u8 value = clamp_sample(((dequantize(coefficients[0], quantization_table[0]) + 4) >> 3) + 128);
+        for (size_t y = 0; y < 8; y++)
+            __builtin_memset(output + y * pitch, value, 8);
+        return;
+    }
+
+    auto& scale_factors = aan_scale_factors();
+    alignas(16) i32 workspace[64];
+    for (size_t i = 0; i < 64; i++) {
+        if (!coefficients[i]) {
+            workspace[i] = 0;
+            continue;
+        }
+        workspace[i] = (dequantize(coefficients[i], quantization_table[i]) * scale_factors[i]) >> (14 - idct_input_fraction_bits);
+    }
+
+    inverse_dct_columns(workspace);
+    for (size_t row = 0; row < 8; row++) {
+        for (size_t column = row + 1; column < 8; column++)
+            swap(workspace[row * 8 + column], workspace[column * 8 + row]);
+    }
+    inverse_dct_columns(workspace);
+
+    // The second pass leaves the block transposed, with 3 more fractional bits.
+    constexpr int output_shift = idct_input_fraction_bits + 3;
+    for (size_t y = 0; y < 8; y++) {
+        for (size_t x = 0; x < 8; x++)
+            output[y * pitch + x] = clamp_sample((workspace[x * 8 + y] + (128 << output_shift) + (1 << (output_shift - 1))) >> output_shift);
+    }
+}
+
+// Computes `size` samples from the `size` lowest frequencies of each row and column, which gives
+// the block at size/8 of its resolution without ever computing the full one.
+static void inverse_dct_reduced(const i16* coefficients, const u16* quantization_table, u8 size, u8* output, size_t pitch)
+{
+    VERIFY(size == 2 || size == 4);
+
+    // matrix[x * 4 + u] is C(u) / 2 * cos((2x + 1)uπ / 2size), in 13-bit fixed point.
+    static const auto matrices = [] {
+        Array<Array<i32, 16>, 2> matrices;
+        for (size_t i = 0; i < 2; i++) {
+            size_t matrix_size = i == 0 ? 2 : 4;
+            for (size_t x = 0; x < matrix_size; x++) {
+                for (size_t u = 0; u < matrix_size; u++) {
+                    double normalization = u == 0 ? M_SQRT1_2 : 1.0;
+                    matrices[i][x * 4 + u] = round(normalization / 2 * cos((2 * x + 1) * u * M_PI / (2 * matrix_size)) * (1 << 13));
                 }
             }
         }
+        return matrices;
+    }();
+    auto& matrix = matrices[size == 2 ? 0 : 1];
+
+    i32 dequantized[4][4];
+    for (size_t v = 0; v < size; v++) {
+        for (size_t u = 0; u < size; u++)
+            dequantized[v][u] = dequantize(coefficients[v * 8 + u], quantization_table[v * 8 + u]);
     }
 
-    return true;
+    // The intermediate values keep 3 fractional bits.
+    i32 columns[4][4];
+    for (size_t y = 0; y < size; y++) {
+        for (size_t u = 0; u < size; u++) {
+            i32 sum = 0;
+            for (size_t v = 0; v < size; v++)
+                sum += matrix[y * 4 + v] * dequantized[v][u];
+            columns[y][u] = (sum + (1 << 9)) >> 10;
+        }
+    }
+
+    for (size_t y = 0; y < size; y++) {
+        for (size_t x = 0; x < size; x++) {
+            i32 sum = 0;
+            for (size_t u = 0; u < size; u++)
+                sum += matrix[x * 4 + u] * columns[y][u];
+            output[y * pitch + x] = clamp_sample((sum + (128 << 16) + (1 << 15)) >> 16);
+        }
+    }
 }
 
-static Optional<Vector<Macroblock>> decode_huffman_stream(JPGLoadingContext& context)
+static void inverse_dct_block(const ComponentSpec& component, const i16* coefficients, u8* output)
 {
-    Vector<Macroblock> macroblocks;
-    macroblocks.resize(context.mblock_meta.padded_total);
+    switch (component.block_output_size) {
+    case 8:
+        inverse_dct_8x8(coefficients, component.quantization_table, output, component.samples_pitch);
+        break;
+    case 1:
+        // Only the DC coefficient, which is the average of the block, is needed.
+        *output = clamp_sample(((dequantize(coefficients[0], component.quantization_table[0]) + 4) >> 3) + 128);
+        break;
+    default:
+        inverse_dct_reduced(coefficients, component.quantization_table, component.block_output_size, output, component.samples_pitch);
+        break;
+    }
+}
 
-    if constexpr (JPG_DEBUG) {
-        dbgln("Image width: {}", context.frame.width);
-        dbgln("Image height: {}", context.frame.height);
-        dbgln("Macroblocks in a row: {}", context.mblock_meta.hpadded_count);
-        dbgln("Macroblocks in a column: {}", context.mblock_meta.vpadded_count);
-        dbgln("Macroblock meta padded total: {}", context.mblock_meta.padded_total);
+ALWAYS_INLINE static RGBA32 ycbcr_to_rgb(i32 y, i32 cb, i32 cr)
+{
+    // The conversion factors are in 16-bit fixed point.
+    cb -= 128;
+    cr -= 128;
+    i32 r = y + ((91881 * cr + 32768) >> 16);
+    i32 g = y + ((-22554 * cb - 46802 * cr + 32768) >> 16);
+    i32 b = y + ((116130 * cb + 32768) >> 16);
+    return 0xff000000 | (clamp_sample(r) << 16) | (clamp_sample(g) << 8) | clamp_sample(b);
+}
+
+static void convert_ycbcr_row(const u8* y, const u8* cb, const u8* cr, RGBA32* output, size_t width)
+{
+    size_t x = 0;
+#ifdef __SSE2__
+    using AK::SIMD::i32x4;
+    using AK::SIMD::u8x4;
+    constexpr i32x4 zero = { 0, 0, 0, 0 };
+    constexpr i32x4 max = { 255, 255, 255, 255 };
+    auto clamp_samples = [&](i32x4 values) {
+        values = values < zero ? zero : values;
+        return values > max ? max : values;
+    };
+    auto load = [](const u8* samples) {
+        u8x4 bytes;
+        __builtin_memcpy(&bytes, samples, sizeof(bytes));
+        return __builtin_convertvector(bytes, i32x4);
+    };
+    for (; x + 4 <= width; x += 4) {
+        i32x4 luma = load(y + x);
+        i32x4 blue_difference = load(cb + x) - 128;
+        i32x4 red_difference = load(cr + x) - 128;
+        i32x4 r = clamp_samples(luma + ((91881 * red_difference + 32768) >> 16));
+        i32x4 g = clamp_samples(luma + ((-22554 * blue_difference - 46802 * red_difference + 32768) >> 16));
+        i32x4 b = clamp_samples(luma + ((116130 * blue_difference + 32768) >> 16));
+        i32x4 pixels = (i32)0xff000000 | (r << 16) | (g << 8) | b;
+        __builtin_memcpy(output + x, &pixels, sizeof(pixels));
     }
+#endif
+    for (; x < width; x++)
+        output[x] = ycbcr_to_rgb(y[x], cb[x], cr[x]);
+}
 
-    // Compute huffman codes for DC and AC tables.
-    for (auto it = context.dc_tables.begin(); it != context.dc_tables.end(); ++it)
-        generate_huffman_codes(it->value);
+static void convert_grayscale_row(const u8* y, RGBA32* output, size_t width)
+{
+    for (size_t x = 0; x < width; x++)
+        output[x] = 0xff000000 | (y[x] * 0x010101);
+}
 
-    for (auto it = context.ac_tables.begin(); it != context.ac_tables.end(); ++it)
-        generate_huffman_codes(it->value);
+static void output_mcu_row(JPGLoadingContext& context, u32 mcu_row)
+{
+    if (context.buffers_whole_image) {
+        for (auto& component : context.components) {
+            u8 block_size = component.block_output_size;
+            for (u8 vfactor_i = 0; vfactor_i < component.vsample_factor; vfactor_i++) {
+                u32 block_row = mcu_row * component.vsample_factor + vfactor_i;
+                const i16* coefficients = component.coefficients.data() + block_row * component.blocks_per_line * 64;
+                u8* samples = component.samples.data() + vfactor_i * block_size * component.samples_pitch;
+                for (u32 block_column = 0; block_column < component.blocks_per_line; block_column++)
+                    inverse_dct_block(component, coefficients + block_column * 64, samples + block_column * block_size);
+            }
+        }
+    }
 
-    for (u32 vcursor = 0; vcursor < context.mblock_meta.vcount; vcursor += context.vsample_factor) {
-        for (u32 hcursor = 0; hcursor < context.mblock_meta.hcount; hcursor += context.hsample_factor) {
-            u32 i = vcursor * context.mblock_meta.hpadded_count + hcursor;
+    auto& bitmap = *context.bitmap;
+    u32 width = bitmap.width();
+    u32 rows_per_mcu = context.vsample_factor * context.block_output_size();
+    u32 first_row = mcu_row * rows_per_mcu;
+    for (u32 row = 0; row < rows_per_mcu && first_row + row < (u32)bitmap.height(); row++) {
+        const u8* rows[3];
+        for (size_t i = 0; i < context.components.size(); i++) {
+            auto& component = context.components[i];
+            const u8* samples = component.samples.data() + (row / component.vertical_upsampling) * component.samples_pitch;
+            if (component.horizontal_upsampling == 1) {
+                rows[i] = samples;
+                continue;
+            }
+
+            u8* upsampled = component.upsampled_row.data();
+            if (component.horizontal_upsampling == 2) {
+                for (u32 x = 0; x < width; x++)
+                    upsampled[x] = samples[x / 2];
+            } else {
+                for (u32 x = 0; x < width; x++)
+                    upsampled[x] = samples[x / component.horizontal_upsampling];
+            }
+            rows[i] = upsampled;
+        }
+
+        if (context.components.size() == 1)
+            convert_grayscale_row(rows[0], bitmap.scanline(first_row + row), width);
+        else
+            convert_ycbcr_row(rows[0], rows[1], rows[2], bitmap.scanline(first_row + row), width);
+    }
+}
+
+static bool restart_huffman_stream(JPGLoadingContext& context)
+{
+    auto& hstream = context.huffman_stream;
+
+    // Restart markers are stored in byte boundaries, so anything left in the bit buffer is padding.
+    hstream.bits = 0;
+    hstream.bit_count = 0;
+    hstream.padding_bit_count = 0;
+    hstream.reached_marker = false;
+    hstream.end_of_band_run = 0;
+
+    auto& data = hstream.data;
+    auto& offset = hstream.byte_offset;
+    while (offset + 1 < data.size() && data[offset] == 0xFF && data[offset + 1] == 0xFF)
+        offset++;
+    if (offset + 1 >= data.size() || data[offset] != 0xFF || data[offset + 1] < 0xD0 || data[offset + 1] > 0xD7) {
+        dbgln_if(JPG_DEBUG, "{}: Expected a restart marker!", offset);
+        return false;
+    }
+    // Skip the restart marker (RSTn).
+    offset += 2;
+
+    for (auto* component : context.current_scan.components)
+        component->previous_dc = 0;
+    return true;
+}
+
+static bool skip_to_marker_after_scan(InputMemoryStream& stream, const HuffmanStreamState& hstream)
+{
+    auto& data = hstream.data;
+    for (size_t offset = hstream.byte_offset; offset + 1 < data.size(); offset++) {
+        if (data[offset] != 0xFF)
+            continue;
+        u8 next_byte = data[offset + 1];
+        if (next_byte == 0x00 || next_byte == 0xFF || (next_byte >= 0xD0 && next_byte <= 0xD7))
+            continue;
+        stream.seek(offset);
+        return true;
+    }
+    dbgln_if(JPG_DEBUG, "No marker found after the scan!");
+    return false;
+}
+
+/**
+ * MCU means group of data units that are coded together. A data unit is an 8x8
+ * block of component data. In interleaved scans, number of non-interleaved data
+ * units of a component C is Ch * Cv, where Ch and Cv represent the horizontal &
+ * vertical subsampling factors of the component, respectively. Non-interleaved
+ * scans have one data unit per MCU.
+ *
+ * Sequential images are usually coded in a single interleaved scan, in which case
+ * every row of MCUs goes through the IDCT and color conversion as soon as it is
+ * decoded. Otherwise the coefficients are collected over all scans.
+ */
+static bool decode_scan(InputMemoryStream& stream, JPGLoadingContext& context)
+{
+    auto& scan = context.current_scan;
+    auto& hstream = context.huffman_stream;
+    hstream = {};
+    hstream.data = { context.data, context.data_size };
+    hstream.byte_offset = stream.offset();
+    for (auto* component : scan.components)
+        component->previous_dc = 0;
+
+    bool is_interleaved = scan.components.size() > 1;
+    u32 mcus_per_line = is_interleaved ? context.mcus_per_line : scan.components[0]->unpadded_blocks_per_line;
+    u32 mcu_rows = is_interleaved ? context.mcu_rows : scan.components[0]->unpadded_block_rows;
+    u32 mcus_until_restart = context.dc_reset_interval;
+    i16 block[64];
+
+    for (u32 mcu_row = 0; mcu_row < mcu_rows; mcu_row++) {
+        for (u32 mcu_column = 0; mcu_column < mcus_per_line; mcu_column++) {
             if (context.dc_reset_interval > 0) {
-                if (i % context.dc_reset_interval == 0) {
-                    context.previous_dc_values[0] = 0;
-                    context.previous_dc_values[1] = 0;
-                    context.previous_dc_values[2] = 0;
-
-                    // Restart markers are stored in byte boundaries. Advance the huffman stream cursor to
-                    //  the 0th bit of the next byte.
-                    if (context.huffman_stream.byte_offset < context.huffman_stream.stream.size()) {
-                        if (context.huffman_stream.bit_offset > 0) {
-                            context.huffman_stream.bit_offset = 0;
-                            context.huffman_stream.byte_offset++;
+                if (mcus_until_restart == 0) {
+                    if (!restart_huffman_stream(context))
+                        return false;
+                    mcus_until_restart = context.dc_reset_interval;
+                }
+                mcus_until_restart--;
+            }
+
+            for (auto* component : scan.components) {
+                u8 hcount = is_interleaved ? component->hsample_factor : 1;
+                u8 vcount = is_interleaved ? component->vsample_factor : 1;
+                for (u8 vfactor_i = 0; vfactor_i < vcount; vfactor_i++) {
+                    for (u8 hfactor_i = 0; hfactor_i < hcount; hfactor_i++) {
+                        u32 block_row = mcu_row * vcount + vfactor_i;
+                        u32 block_column = mcu_column * hcount + hfactor_i;
+                        if (context.buffers_whole_image) {
+                            if (!decode_block(context, *component, component->coefficients.data() + (block_row * component->blocks_per_line + block_column) * 64))
+                                return false;
+                            continue;
                         }
 
-                        // Skip the restart marker (RSTn).
-                        context.huffman_stream.byte_offset++;
+                        __builtin_memset(block, 0, sizeof(block));
+                        if (!decode_block(context, *component, block))
+                            return false;
+                        u8 block_size = component->block_output_size;
+                        u8* samples = component->samples.data() + vfactor_i * block_size * component->samples_pitch + block_column * block_size;
+                        inverse_dct_block(*component, block, samples);
                     }
                 }
             }
 
-            if (!build_macroblocks(context, macroblocks, hcursor, vcursor)) {
-                if constexpr (JPG_DEBUG) {
-                    dbgln("Failed to build Macroblock {}", i);
-                    dbgln("Huffman stream byte offset {}", context.huffman_stream.byte_offset);
-                    dbgln("Huffman stream bit offset {}", context.huffman_stream.bit_offset);
-                }
-                return {};
+            if (hstream.read_past_end) {
+                dbgln_if(JPG_DEBUG, "Huffman stream exhausted at MCU {}x{}!", mcu_column, mcu_row);
+                return false;
             }
         }
+
+        if (!context.buffers_whole_image)
+            output_mcu_row(context, mcu_row);
     }
 
-    return macroblocks;
+    return skip_to_marker_after_scan(stream, hstream);
 }
 
 static inline bool bounds_okay(const size_t cursor, const size_t delta, const size_t bound)
@@ -460,8 +991,11 @@ static inline bool is_valid_marker(const Marker marker)
     case JPG_DQT:
     case JPG_RST:
     case JPG_SOF0:
+    case JPG_SOF1:
+    case JPG_SOF2:
     case JPG_SOI:
     case JPG_SOS:
+    case JPG_EOI:
         return true;
     }
 
@@ -518,29 +1052,29 @@ static bool read_start_of_scan(InputMemoryStream& stream, JPGLoadingContext& con
     stream >> component_count;
     if (stream.handle_any_error())
         return false;
-    if (component_count != context.component_count) {
+    if (component_count == 0 || component_count > context.component_count) {
         dbgln_if(JPG_DEBUG, "{}: Unsupported number of components: {}!", stream.offset(), component_count);
         return false;
     }
 
+    Scan scan;
     for (int i = 0; i < component_count; i++) {
-        ComponentSpec* component = nullptr;
         u8 component_id = 0;
         stream >> component_id;
         if (stream.handle_any_error())
             return false;
 
-        auto it = context.components.find(component_id);
-        if (it != context.components.end()) {
-            component = &it->value;
-            if (i != component->serial_id) {
-                dbgln("JPEG decode failed (i != component->serial_id)");
-                return false;
-            }
-        } else {
+        auto it = context.components.find_if([&](auto& component) { return component.id == component_id; });
+        if (it.is_end()) {
             dbgln_if(JPG_DEBUG, "{}: Unsupported component id: {}!", stream.offset(), component_id);
             return false;
         }
+        ComponentSpec* component = &*it;
+        // Components have to appear in the same order as in the frame header.
+        if (!scan.components.is_empty() && component->serial_id <= scan.components.last()->serial_id) {
+            dbgln_if(JPG_DEBUG, "{}: Component {} is out of order!", stream.offset(), component_id);
+            return false;
+        }
 
         u8 table_ids = 0;
         stream >> table_ids;
@@ -549,44 +1083,74 @@ static bool read_start_of_scan(InputMemoryStream& stream, JPGLoadingContext& con
 
         component->dc_destination_id = table_ids >> 4;
         component->ac_destination_id = table_ids & 0x0F;
-
-        if (context.dc_tables.size() != context.ac_tables.size()) {
-            dbgln_if(JPG_DEBUG, "{}: DC & AC table count mismatch!", stream.offset());
-            return false;
-        }
-
-        if (!context.dc_tables.contains(component->dc_destination_id)) {
-            dbgln_if(JPG_DEBUG, "DC table (id: {}) does not exist!", component->dc_destination_id);
-            return false;
-        }
-
-        if (!context.ac_tables.contains(component->ac_destination_id)) {
-            dbgln_if(JPG_DEBUG, "AC table (id: {}) does not exist!", component->ac_destination_id);
-            return false;
-        }
+        scan.components.append(component);
     }
 
-    u8 spectral_selection_start = 0;
-    stream >> spectral_selection_start;
+    stream >> scan.spectral_selection_start;
     if (stream.handle_any_error())
         return false;
-    u8 spectral_selection_end = 0;
-    stream >> spectral_selection_end;
+    stream >> scan.spectral_selection_end;
     if (stream.handle_any_error())
         return false;
     u8 successive_approximation = 0;
     stream >> successive_approximation;
     if (stream.handle_any_error())
         return false;
-    // The three values should be fixed for baseline JPEGs utilizing sequential DCT.
-    if (spectral_selection_start != 0 || spectral_selection_end != 63 || successive_approximation != 0) {
+    scan.successive_approximation_high = successive_approximation >> 4;
+    scan.successive_approximation_low = successive_approximation & 0x0F;
+
+    bool is_progressive = context.frame.type == StartOfFrame::FrameType::Progressive_DCT;
+    bool is_valid;
+    if (is_progressive) {
+        // DC and AC coefficients are always in separate scans, and AC scans only have one component.
+        is_valid = scan.spectral_selection_start <= scan.spectral_selection_end
+            && scan.spectral_selection_end <= 63
+            && (scan.spectral_selection_start == 0) == (scan.spectral_selection_end == 0)
+            && (scan.spectral_selection_start == 0 || component_count == 1)
+            && scan.successive_approximation_high <= 13
+            && scan.successive_approximation_low <= 13;
+    } else {
+        // The three values should be fixed for baseline JPEGs utilizing sequential DCT.
+        is_valid = scan.spectral_selection_start == 0 && scan.spectral_selection_end == 63 && successive_approximation == 0;
+    }
+    if (!is_valid) {
         dbgln_if(JPG_DEBUG, "{}: ERROR! Start of Selection: {}, End of Selection: {}, Successive Approximation: {}!",
             stream.offset(),
-            spectral_selection_start,
-            spectral_selection_end,
+            scan.spectral_selection_start,
+            scan.spectral_selection_end,
             successive_approximation);
         return false;
     }
+
+    bool needs_dc_table = scan.spectral_selection_start == 0 && scan.successive_approximation_high == 0;
+    bool needs_ac_table = scan.spectral_selection_end > 0;
+    for (auto* component : scan.components) {
+        component->dc_table = nullptr;
+        component->ac_table = nullptr;
+        if (needs_dc_table) {
+            auto it = context.dc_tables.find(component->dc_destination_id);
+            if (it == context.dc_tables.end()) {
+                dbgln_if(JPG_DEBUG, "DC table (id: {}) does not exist!", component->dc_destination_id);
+                return false;
+            }
+            component->dc_table = &it->value;
+        }
+        if (needs_ac_table) {
+            auto it = context.ac_tables.find(component->ac_destination_id);
+            if (it == context.ac_tables.end()) {
+                dbgln_if(JPG_DEBUG, "AC table (id: {}) does not exist!", component->ac_destination_id);
+                return false;
+            }
+            component->ac_table = &it->value;
+        }
+
+        if (!component->has_quantization_table) {
+            __builtin_memcpy(component->quantization_table, context.quantization_tables[component->qtable_id], sizeof(component->quantization_table));
+            component->has_quantization_table = true;
+        }
+    }
+
+    context.current_scan = move(scan);
     return true;
 }
 
@@ -626,7 +1190,7 @@ static bool read_huffman_table(InputMemoryStream& stream, JPGLoadingContext& con
             dbgln_if(JPG_DEBUG, "{}: Unrecognized huffman table: {}!", stream.offset(), table_type);
             return false;
         }
-        if (table_destination_id > 1) {
+        if (table_destination_id > 3) {
             dbgln_if(JPG_DEBUG, "{}: Invalid huffman table destination id: {}!", stream.offset(), table_destination_id);
             return false;
         }
@@ -645,7 +1209,12 @@ static bool read_huffman_table(InputMemoryStream& stream, JPGLoadingContext& con
             table.code_counts[i] = count;
         }
 
-        table.codes.ensure_capacity(total_codes);
+        if (total_codes > 256) {
+            dbgln_if(JPG_DEBUG, "{}: Too many huffman codes: {}!", stream.offset(), total_codes);
+            return false;
+        }
+
+        table.symbols.ensure_capacity(total_codes);
 
         // Read symbols. Read X bytes, where X is the sum of the counts of codes read in the previous step.
         for (u32 i = 0; i < total_codes; i++) {
@@ -659,9 +1228,12 @@ static bool read_huffman_table(InputMemoryStream& stream, JPGLoadingContext& con
         if (stream.handle_any_error())
             return false;
 
+        if (!generate_huffman_codes(table))
+            return false;
+
         auto& huffman_table = table.type == 0 ? context.dc_tables : context.ac_tables;
-        huffman_table.set(table.destination_id, table);
-        VERIFY(huffman_table.size() <= 2);
+        huffman_table.set(table.destination_id, move(table));
+        VERIFY(huffman_table.size() <= 4);
 
         bytes_to_read -= 1 + 16 + total_codes;
     }
@@ -673,33 +1245,45 @@ static bool read_huffman_table(InputMemoryStream& stream, JPGLoadingContext& con
     return true;
 }
 
-static inline bool validate_luma_and_modify_context(const ComponentSpec& luma, JPGLoadingContext& context)
+static bool compute_component_sizes(JPGLoadingContext& context)
 {
-    if ((luma.hsample_factor == 1 || luma.hsample_factor == 2) && (luma.vsample_factor == 1 || luma.vsample_factor == 2)) {
-        context.mblock_meta.hpadded_count += luma.hsample_factor == 1 ? 0 : context.mblock_meta.hcount % 2;
-        context.mblock_meta.vpadded_count += luma.vsample_factor == 1 ? 0 : context.mblock_meta.vcount % 2;
-        context.mblock_meta.padded_total = context.mblock_meta.hpadded_count * context.mblock_meta.vpadded_count;
-        // For easy reference to relevant sample factors.
-        context.hsample_factor = luma.hsample_factor;
-        context.vsample_factor = luma.vsample_factor;
-
-        if constexpr (JPG_DEBUG) {
-            dbgln("Horizontal Subsampling Factor: {}", luma.hsample_factor);
-            dbgln("Vertical Subsampling Factor: {}", luma.vsample_factor);
+    // A single component is never interleaved, so its sampling factors don't matter.
+    if (context.component_count == 1) {
+        context.components[0].hsample_factor = 1;
+        context.components[0].vsample_factor = 1;
+    }
+
+    context.hsample_factor = 0;
+    context.vsample_factor = 0;
+    for (auto& component : context.components) {
+        context.hsample_factor = max(context.hsample_factor, component.hsample_factor);
+        context.vsample_factor = max(context.vsample_factor, component.vsample_factor);
+    }
+
+    for (auto& component : context.components) {
+        // Components are scaled back up by repeating their samples, which needs the sampling factors to divide evenly.
+        if (context.hsample_factor % component.hsample_factor != 0 || context.vsample_factor % component.vsample_factor != 0) {
+            dbgln_if(JPG_DEBUG, "Unsupported subsampling factors: horizontal: {}, vertical: {}", component.hsample_factor, component.vsample_factor);
+            return false;
         }
+    }
 
-        return true;
+    if constexpr (JPG_DEBUG) {
+        dbgln("Horizontal Subsampling Factor: {}", context.hsample_factor);
+        dbgln("Vertical Subsampling Factor: {}", context.vsample_factor);
     }
-    return false;
-}
 
-static inline void set_macroblock_metadata(JPGLoadingContext& context)
-{
-    context.mblock_meta.hcount = (context.frame.width + 7) / 8;
-    context.mblock_meta.vcount = (context.frame.height + 7) / 8;
-    context.mblock_meta.hpadded_count = context.mblock_meta.hcount;
-    context.mblock_meta.vpadded_count = context.mblock_meta.vcount;
-    context.mblock_meta.total = context.mblock_meta.hcount * context.mblock_meta.vcount;
+    context.mcus_per_line = ceil_div<u32>(context.frame.width, 8 * context.hsample_factor);
+    context.mcu_rows = ceil_div<u32>(context.frame.height, 8 * context.vsample_factor);
+    for (auto& component : context.components) {
+        component.blocks_per_line = context.mcus_per_line * component.hsample_factor;
+        component.block_rows = context.mcu_rows * component.vsample_factor;
+        u32 width = ceil_div<u32>(context.frame.width * component.hsample_factor, (u32)context.hsample_factor);
+        u32 height = ceil_div<u32>(context.frame.height * component.vsample_factor, (u32)context.vsample_factor);
+        component.unpadded_blocks_per_line = ceil_div<u32>(width, 8);
+        component.unpadded_block_rows = ceil_div<u32>(height, 8);
+    }
+    return true;
 }
 
 static bool read_start_of_frame(InputMemoryStream& stream, JPGLoadingContext& context)
@@ -741,8 +1325,6 @@ static bool read_start_of_frame(InputMemoryStream& stream, JPGLoadingContext& co
         return false;
     }
 
-    set_macroblock_metadata(context);
-
     stream >> context.component_count;
     if (stream.handle_any_error())
         return false;
@@ -765,39 +1347,26 @@ static bool read_start_of_frame(InputMemoryStream& stream, JPGLoadingContext& co
             return false;
         component.hsample_factor = subsample_factors >> 4;
         component.vsample_factor = subsample_factors & 0x0F;
-
-        if (component.serial_id == 0) {
-            // By convention, downsampling is applied only on chroma components. So we should
-            //  hope to see the maximum sampling factor in the luma component.
-            if (!validate_luma_and_modify_context(component, context)) {
-                dbgln_if(JPG_DEBUG, "{}: Unsupported luma subsampling factors: horizontal: {}, vertical: {}",
-                    stream.offset(),
-                    component.hsample_factor,
-                    component.vsample_factor);
-                return false;
-            }
-        } else {
-            if (component.hsample_factor != 1 || component.vsample_factor != 1) {
-                dbgln_if(JPG_DEBUG, "{}: Unsupported chroma subsampling factors: horizontal: {}, vertical: {}",
-                    stream.offset(),
-                    component.hsample_factor,
-                    component.vsample_factor);
-                return false;
-            }
+        if (component.hsample_factor < 1 || component.hsample_factor > 4 || component.vsample_factor < 1 || component.vsample_factor > 4) {
+            dbgln_if(JPG_DEBUG, "{}: Invalid subsampling factors: horizontal: {}, vertical: {}",
+                stream.offset(),
+                component.hsample_factor,
+                component.vsample_factor);
+            return false;
         }
 
         stream >> component.qtable_id;
         if (stream.handle_any_error())
             return false;
-        if (component.qtable_id > 1) {
+        if (component.qtable_id > 3) {
             dbgln_if(JPG_DEBUG, "{}: Unsupported quantization table id: {}!", stream.offset(), component.qtable_id);
             return false;
         }
 
-        context.components.set(component.id, component);
+        context.components.append(move(component));
     }
 
-    return true;
+    return compute_component_sizes(context);
 }
 
 static bool read_quantization_table(InputMemoryStream& stream, JPGLoadingContext& context)
@@ -819,11 +1388,11 @@ static bool read_quantization_table(InputMemoryStream& stream, JPGLoadingContext
             return false;
         }
         u8 table_id = info_byte & 0x0F;
-        if (table_id > 1) {
+        if (table_id > 3) {
             dbgln_if(JPG_DEBUG, "{}: Unsupported quantization table id: {}!", stream.offset(), table_id);
             return false;
         }
-        u32* table = table_id == 0 ? context.luma_table : context.chroma_table;
+        u16* table = context.quantization_tables[table_id];
         for (int i = 0; i < 64; i++) {
             if (element_unit_hint == 0) {
                 u8 tmp = 0;
@@ -860,260 +1429,11 @@ static bool skip_marker_with_length(InputMemoryStream& stream)
     return !stream.handle_any_error();
 }
 
-static void dequantize(JPGLoadingContext& context, Vector<Macroblock>& macroblocks)
+// Reads markers up to and including the header of the next scan, or up to the end of the image.
+static bool read_markers(InputMemoryStream& stream, JPGLoadingContext& context, bool& reached_end_of_image)
 {
-    for (u32 vcursor = 0; vcursor < context.mblock_meta.vcount; vcursor += context.vsample_factor) {
-        for (u32 hcursor = 0; hcursor < context.mblock_meta.hcount; hcursor += context.hsample_factor) {
-            for (auto it = context.components.begin(); it != context.components.end(); ++it) {
-                auto& component = it->value;
-                const u32* table = component.qtable_id == 0 ? context.luma_table : context.chroma_table;
-                for (u32 vfactor_i = 0; vfactor_i < component.vsample_factor; vfactor_i++) {
-                    for (u32 hfactor_i = 0; hfactor_i < component.hsample_factor; hfactor_i++) {
-                        u32 mb_index = (vcursor + vfactor_i) * context.mblock_meta.hpadded_count + (hfactor_i + hcursor);
-                        Macroblock& block = macroblocks[mb_index];
-                        int* block_component = component.serial_id == 0 ? block.y : (component.serial_id == 1 ? block.cb : block.cr);
-                        for (u32 k = 0; k < 64; k++)
-                            block_component[k] *= table[k];
-                    }
-                }
-            }
-        }
-    }
-}
-
-static void inverse_dct(const JPGLoadingContext& context, Vector<Macroblock>& macroblocks)
-{
-    static const float m0 = 2.0 * cos(1.0 / 16.0 * 2.0 * M_PI);
-    static const float m1 = 2.0 * cos(2.0 / 16.0 * 2.0 * M_PI);
-    static const float m3 = 2.0 * cos(2.0 / 16.0 * 2.0 * M_PI);
-    static const float m5 = 2.0 * cos(3.0 / 16.0 * 2.0 * M_PI);
-    static const float m2 = m0 - m5;
-    static const float m4 = m0 + m5;
-    static const float s0 = cos(0.0 / 16.0 * M_PI) / sqrt(8);
-    static const float s1 = cos(1.0 / 16.0 * M_PI) / 2.0;
-    static const float s2 = cos(2.0 / 16.0 * M_PI) / 2.0;
-    static const float s3 = cos(3.0 / 16.0 * M_PI) / 2.0;
-    static const float s4 = cos(4.0 / 16.0 * M_PI) / 2.0;
-    static const float s5 = cos(5.0 / 16.0 * M_PI) / 2.0;
-    static const float s6 = cos(6.0 / 16.0 * M_PI) / 2.0;
-    static const float s7 = cos(7.0 / 16.0 * M_PI) / 2.0;
-
-    for (u32 vcursor = 0; vcursor < context.mblock_meta.vcount; vcursor += context.vsample_factor) {
-        for (u32 hcursor = 0; hcursor < context.mblock_meta.hcount; hcursor += context.hsample_factor) {
-            for (auto it = context.components.begin(); it != context.components.end(); ++it) {
-                auto& component = it->value;
-                for (u8 vfactor_i = 0; vfactor_i < component.vsample_factor; vfactor_i++) {
-                    for (u8 hfactor_i = 0; hfactor_i < component.hsample_factor; hfactor_i++) {
-                        u32 mb_index = (vcursor + vfactor_i) * context.mblock_meta.hpadded_count + (hfactor_i + hcursor);
-                        Macroblock& block = macroblocks[mb_index];
-                        i32* block_component = component.serial_id == 0 ? block.y : (component.serial_id == 1 ? block.cb : block.cr);
-                        for (u32 k = 0; k < 8; ++k) {
-                            const float g0 = block_component[0 * 8 + k] * s0;
-                            const float g1 = block_component[4 * 8 + k] * s4;
-                            const float g2 = block_component[2 * 8 + k] * s2;
-                            const float g3 = block_component[6 * 8 + k] * s6;
-                            const float g4 = block_component[5 * 8 + k] * s5;
-                            const float g5 = block_component[1 * 8 + k] * s1;
-                            const float g6 = block_component[7 * 8 + k] * s7;
-                            const float g7 = block_component[3 * 8 + k] * s3;
-
-                            const float f0 = g0;
-                            const float f1 = g1;
-                            const float f2 = g2;
-                            const float f3 = g3;
-                            const float f4 = g4 - g7;
-                            const float f5 = g5 + g6;
-                            const float f6 = g5 - g6;
-                            const float f7 = g4 + g7;
-
-                            const float e0 = f0;
-                            const float e1 = f1;
-                            const float e2 = f2 - f3;
-                            const float e3 = f2 + f3;
-                            const float e4 = f4;
-                            const float e5 = f5 - f7;
-                            const float e6 = f6;
-                            const float e7 = f5 + f7;
-                            const float e8 = f4 + f6;
-
-                            const float d0 = e0;
-                            const float d1 = e1;
-                            const float d2 = e2 * m1;
-                            const float d3 = e3;
-                            const float d4 = e4 * m2;
-                            const float d5 = e5 * m3;
-                            const float d6 = e6 * m4;
-                            const float d7 = e7;
-                            const float d8 = e8 * m5;
-
-                            const float c0 = d0 + d1;
-                            const float c1 = d0 - d1;
-                            const float c2 = d2 - d3;
-                            const float c3 = d3;
-                            const float c4 = d4 + d8;
-                            const float c5 = d5 + d7;
-                            const float c6 = d6 - d8;
-                            const float c7 = d7;
-                            const float c8 = c5 - c6;
-
-                            const float b0 = c0 + c3;
-                            const float b1 = c1 + c2;
-                            const float b2 = c1 - c2;
-                            const float b3 = c0 - c3;
-                            const float b4 = c4 - c8;
-                            const float b5 = c8;
-                            const float b6 = c6 - c7;
-                            const float b7 = c7;
-
-                            block_component[0 * 8 + k] = b0 + b7;
-                            block_component[1 * 8 + k] = b1 + b6;
-                            block_component[2 * 8 + k] = b2 + b5;
-                            block_component[3 * 8 + k] = b3 + b4;
-                            block_component[4 * 8 + k] = b3 - b4;
-                            block_component[5 * 8 + k] = b2 - b5;
-                            block_component[6 * 8 + k] = b1 - b6;
-                            block_component[7 * 8 + k] = b0 - b7;
-                        }
-                        for (u32 l = 0; l < 8; ++l) {
-                            const float g0 = block_component[l * 8 + 0] * s0;
-                            const float g1 = block_component[l * 8 + 4] * s4;
-                            const float g2 = block_component[l * 8 + 2] * s2;
-                            const float g3 = block_component[l * 8 + 6] * s6;
-                            const float g4 = block_component[l * 8 + 5] * s5;
-                            const float g5 = block_component[l * 8 + 1] * s1;
-                            const float g6 = block_component[l * 8 + 7] * s7;
-                            const float g7 = block_component[l * 8 + 3] * s3;
-
-                            const float f0 = g0;
-                            const float f1 = g1;
-                            const float f2 = g2;
-                            const float f3 = g3;
-                            const float f4 = g4 - g7;
-                            const float f5 = g5 + g6;
-                            const float f6 = g5 - g6;
-                            const float f7 = g4 + g7;
-
-                            const float e0 = f0;
-                            const float e1 = f1;
-                            const float e2 = f2 - f3;
-                            const float e3 = f2 + f3;
-                            const float e4 = f4;
-                            const float e5 = f5 - f7;
-                            const float e6 = f6;
-                            const float e7 = f5 + f7;
-                            const float e8 = f4 + f6;
-
-                            const float d0 = e0;
-                            const float d1 = e1;
-                            const float d2 = e2 * m1;
-                            const float d3 = e3;
-                            const float d4 = e4 * m2;
-                            const float d5 = e5 * m3;
-                            const float d6 = e6 * m4;
-                            const float d7 = e7;
-                            const float d8 = e8 * m5;
-
-                            const float c0 = d0 + d1;
-                            const float c1 = d0 - d1;
-                            const float c2 = d2 - d3;
-                            const float c3 = d3;
-                            const float c4 = d4 + d8;
-                            const float c5 = d5 + d7;
-                            const float c6 = d6 - d8;
-                            const float c7 = d7;
-                            const float c8 = c5 - c6;
-
-                            const float b0 = c0 + c3;
-                            const float b1 = c1 + c2;
-                            const float b2 = c1 - c2;
-                            const float b3 = c0 - c3;
-                            const float b4 = c4 - c8;
-                            const float b5 = c8;
-                            const float b6 = c6 - c7;
-                            const float b7 = c7;
-
-                            block_component[l * 8 + 0] = b0 + b7;
-                            block_component[l * 8 + 1] = b1 + b6;
-                            block_component[l * 8 + 2] = b2 + b5;
-                            block_component[l * 8 + 3] = b3 + b4;
-                            block_component[l * 8 + 4] = b3 - b4;
-                            block_component[l * 8 + 5] = b2 - b5;
-                            block_component[l * 8 + 6] = b1 - b6;
-                            block_component[l * 8 + 7] = b0 - b7;
-                        }
-                    }
-                }
-            }
-        }
-    }
-}
-
-static void ycbcr_to_rgb(const JPGLoadingContext& context, Vector<Macroblock>& macroblocks)
-{
-    for (u32 vcursor = 0; vcursor < context.mblock_meta.vcount; vcursor += context.vsample_factor) {
-        for (u32 hcursor = 0; hcursor < context.mblock_meta.hcount; hcursor += context.hsample_factor) {
-            const u32 chroma_block_index = vcursor * context.mblock_meta.hpadded_count + hcursor;
-            const Macroblock& chroma = macroblocks[chroma_block_index];
-            // Overflows are intentional.
-            for (u8 vfactor_i = context.vsample_factor - 1; vfactor_i < context.vsample_factor; --vfactor_i) {
-                for (u8 hfactor_i = context.hsample_factor - 1; hfactor_i < context.hsample_factor; --hfactor_i) {
-                    u32 mb_index = (vcursor + vfactor_i) * context.mblock_meta.hpadded_count + (hcursor + hfactor_i);
-                    i32* y = macroblocks[mb_index].y;
-                    i32* cb = macroblocks[mb_index].cb;
-                    i32* cr = macroblocks[mb_index].cr;
-                    for (u8 i = 7; i < 8; --i) {
-                        for (u8 j = 7; j < 8; --j) {
-                            const u8 pixel = i * 8 + j;
-                            const u32 chroma_pxrow = (i / context.vsample_factor) + 4 * vfactor_i;
-                            const u32 chroma_pxcol = (j / context.hsample_factor) + 4 * hfactor_i;
-                            const u32 chroma_pixel = chroma_pxrow * 8 + chroma_pxcol;
-                            int r = y[pixel] + 1.402f * chroma.cr[chroma_pixel] + 128;
-                            int g = y[pixel] - 0.344f * chroma.cb[chroma_pixel] - 0.714f * chroma.cr[chroma_pixel] + 128;
-                            int b = y[pixel] + 1.772f * chroma.cb[chroma_pixel] + 128;
-                            y[pixel] = r < 0 ? 0 : (r > 255 ? 255 : r);
-                            cb[pixel] = g < 0 ? 0 : (g > 255 ? 255 : g);
-                            cr[pixel] = b < 0 ? 0 : (b > 255 ? 255 : b);
-                        }
-                    }
-                }
-            }
-        }
-    }
-}
-
-static bool compose_bitmap(JPGLoadingContext& context, const Vector<Macroblock>& macroblocks)
-{
-    context.bitmap = Bitmap::create_purgeable(BitmapFormat::RGB32, { context.frame.width, context.frame.height });
-    if (!context.bitmap)
-        return false;
-
-    for (u32 y = context.frame.height - 1; y < context.frame.height; y--) {
-        const u32 block_row = y / 8;
-        const u32 pixel_row = y % 8;
-        for (u32 x = 0; x < context.frame.width; x++) {
-            const u32 block_column = x / 8;
-            auto& block = macroblocks[block_row * context.mblock_meta.hpadded_count + block_column];
-            const u32 pixel_column = x % 8;
-            const u32 pixel_index = pixel_row * 8 + pixel_column;
-            const Color color { (u8)block.y[pixel_index], (u8)block.cb[pixel_index], (u8)block.cr[pixel_index] };
-            context.bitmap->set_pixel(x, y, color);
-        }
-    }
-
-    return true;
-}
-
-static bool parse_header(InputMemoryStream& stream, JPGLoadingContext& context)
-{
-    auto marker = read_marker_at_cursor(stream);
-    if (stream.handle_any_error())
-        return false;
-    if (marker != JPG_SOI) {
-        dbgln_if(JPG_DEBUG, "{}: SOI not found: {:x}!", stream.offset(), marker);
-        return false;
-    }
     for (;;) {
-        marker = read_marker_at_cursor(stream);
+        auto marker = read_marker_at_cursor(stream);
         if (stream.handle_any_error())
             return false;
 
@@ -1136,10 +1456,14 @@ static bool parse_header(InputMemoryStream& stream, JPGLoadingContext& context)
         case JPG_RST6:
         case JPG_RST7:
         case JPG_SOI:
-        case JPG_EOI:
             dbgln_if(JPG_DEBUG, "{}: Unexpected marker {:x}!", stream.offset(), marker);
             return false;
+        case JPG_EOI:
+            reached_end_of_image = true;
+            return true;
         case JPG_SOF0:
+        case JPG_SOF1:
+        case JPG_SOF2:
             if (!read_start_of_frame(stream, context))
                 return false;
             context.state = JPGLoadingContext::FrameDecoded;
@@ -1170,50 +1494,79 @@ static bool parse_header(InputMemoryStream& stream, JPGLoadingContext& context)
     VERIFY_NOT_REACHED();
 }
 
-static bool scan_huffman_stream(InputMemoryStream& stream, JPGLoadingContext& context)
+static bool parse_header(InputMemoryStream& stream, JPGLoadingContext& context)
 {
-    u8 last_byte;
-    u8 current_byte = 0;
-    stream >> current_byte;
+    auto marker = read_marker_at_cursor(stream);
     if (stream.handle_any_error())
         return false;
+    if (marker != JPG_SOI) {
+        dbgln_if(JPG_DEBUG, "{}: SOI not found: {:x}!", stream.offset(), marker);
+        return false;
+    }
 
-    for (;;) {
-        last_byte = current_byte;
-        stream >> current_byte;
-        if (stream.handle_any_error()) {
-            dbgln_if(JPG_DEBUG, "{}: EOI not found!", stream.offset());
-            return false;
-        }
+    bool reached_end_of_image = false;
+    if (!read_markers(stream, context, reached_end_of_image))
+        return false;
+    if (reached_end_of_image) {
+        dbgln_if(JPG_DEBUG, "{}: EOI found before the first scan!", stream.offset());
+        return false;
+    }
+    return true;
+}
 
-        if (last_byte == 0xFF) {
-            if (current_byte == 0xFF)
-                continue;
-            if (current_byte == 0x00) {
-                stream >> current_byte;
-                if (stream.handle_any_error())
-                    return false;
-                context.huffman_stream.stream.append(last_byte);
-                continue;
-            }
-            Marker marker = 0xFF00 | current_byte;
-            if (marker == JPG_EOI)
-                return true;
-            if (marker >= JPG_RST0 && marker <= JPG_RST7) {
-                context.huffman_stream.stream.append(marker);
-                stream >> current_byte;
-                if (stream.handle_any_error())
-                    return false;
-                continue;
+static bool prepare_for_decoding(JPGLoadingContext& context)
+{
+    if (context.minimum_size.has_value()) {
+        for (u8 denominator : { 8, 4, 2 }) {
+            if (ceil_div<int>(context.frame.width, (int)denominator) >= context.minimum_size->width()
+                && ceil_div<int>(context.frame.height, (int)denominator) >= context.minimum_size->height()) {
+                context.scale_denominator = denominator;
+                break;
             }
-            dbgln_if(JPG_DEBUG, "{}: Invalid marker: {:x}!", stream.offset(), marker);
-            return false;
-        } else {
-            context.huffman_stream.stream.append(last_byte);
         }
     }
 
-    VERIFY_NOT_REACHED();
+    IntSize size { ceil_div<int>(context.frame.width, (int)context.scale_denominator), ceil_div<int>(context.frame.height, (int)context.scale_denominator) };
+    context.bitmap = Bitmap::create_purgeable(BitmapFormat::RGB32, size);
+    if (!context.bitmap)
+        return false;
+
+    context.buffers_whole_image = context.frame.type == StartOfFrame::FrameType::Progressive_DCT
+        || context.current_scan.components.size() != context.components.size();
+
+    for (auto& component : context.components) {
+        u8 horizontal_ratio = context.hsample_factor / component.hsample_factor;
+        u8 vertical_ratio = context.vsample_factor / component.vsample_factor;
+        component.block_output_size = context.block_output_size();
+        component.horizontal_upsampling = horizontal_ratio;
+        component.vertical_upsampling = vertical_ratio;
+        // When the image is scaled down, components that are subsampled the same way in both
+        // directions are decoded at a larger size instead of being scaled back up.
+        if (horizontal_ratio == vertical_ratio && component.block_output_size * horizontal_ratio <= 8) {
+            component.block_output_size *= horizontal_ratio;
+            component.horizontal_upsampling = 1;
+            component.vertical_upsampling = 1;
+        }
+
+        component.samples_pitch = component.blocks_per_line * component.block_output_size;
+        component.samples.resize(component.samples_pitch * component.vsample_factor * component.block_output_size);
+        if (component.horizontal_upsampling != 1)
+            component.upsampled_row.resize(size.width());
+        if (context.buffers_whole_image) {
+            component.coefficients.resize(component.blocks_per_line * component.block_rows * 64);
+            component.coefficients.span().fill(0);
+        }
+    }
+
+    if constexpr (JPG_DEBUG) {
+        dbgln("Image width: {}", context.frame.width);
+        dbgln("Image height: {}", context.frame.height);
+        dbgln("MCUs in a row: {}", context.mcus_per_line);
+        dbgln("MCUs in a column: {}", context.mcu_rows);
+        dbgln("Scale: 1/{}", context.scale_denominator);
+    }
+
+    return true;
 }
 
 static bool decode_jpg(JPGLoadingContext& context)
@@ -1222,29 +1575,40 @@ static bool decode_jpg(JPGLoadingContext& context)
 
     if (!parse_header(stream, context))
         return false;
-    if (!scan_huffman_stream(stream, context))
+    if (!prepare_for_decoding(context))
         return false;
 
-    auto result = decode_huffman_stream(context);
-    if (!result.has_value()) {
-        dbgln_if(JPG_DEBUG, "{}: Failed to decode Macroblocks!", stream.offset());
-        return false;
+    for (;;) {
+        if (!decode_scan(stream, context)) {
+            dbgln_if(JPG_DEBUG, "{}: Failed to decode scan!", stream.offset());
+            return false;
+        }
+
+        bool reached_end_of_image = false;
+        if (!read_markers(stream, context, reached_end_of_image))
+            return false;
+        if (reached_end_of_image)
+            break;
+        if (!context.buffers_whole_image) {
+            dbgln_if(JPG_DEBUG, "{}: Unexpected scan after a complete interleaved scan!", stream.offset());
+            return false;
+        }
+    }
+
+    if (context.buffers_whole_image) {
+        for (u32 mcu_row = 0; mcu_row < context.mcu_rows; mcu_row++)
+            output_mcu_row(context, mcu_row);
     }
 
-    auto macroblocks = result.release_value();
-    dequantize(context, macroblocks);
-    inverse_dct(context, macroblocks);
-    ycbcr_to_rgb(context, macroblocks);
-    if (!compose_bitmap(context, macroblocks))
-        return false;
     return true;
 }
 
-static RefPtr<Gfx::Bitmap> load_jpg_impl(const u8* data, size_t data_size)
+static RefPtr<Gfx::Bitmap> load_jpg_impl(const u8* data, size_t data_size, Optional<IntSize> minimum_size = {})
 {
     JPGLoadingContext context;
     context.data = data;
     context.data_size = data_size;
+    context.minimum_size = minimum_size;
 
     if (!decode_jpg(context))
         return nullptr;
@@ -1271,12 +1635,22 @@ RefPtr<Gfx::Bitmap> load_jpg_from_memory(const u8* data, size_t length)
     return bitmap;
 }
 
+RefPtr<Gfx::Bitmap> load_jpg_downscaled(const StringView& path, const IntSize& minimum_size)
+{
+    auto file_or_error = MappedFile::map(path);
+    if (file_or_error.is_error())
+        return nullptr;
+    auto bitmap = load_jpg_impl((const u8*)file_or_error.value()->data(), file_or_error.value()->size(), minimum_size);
+    if (bitmap)
+        bitmap->set_mmap_name(String::formatted("Gfx::Bitmap [{}] - Decoded downscaled JPG: {}", bitmap->size(), LexicalPath::canonicalized_path(path)));
+    return bitmap;
+}
+
 JPGImageDecoderPlugin::JPGImageDecoderPlugin(const u8* data, size_t size)
 {
     m_context = make<JPGLoadingContext>();
     m_context->data = data;
     m_context->data_size = size;
-    m_context->huffman_stream.stream.ensure_capacity(50 * KiB);
 }
 
 JPGImageDecoderPlugin::~JPGImageDecoderPlugin()
@@ -35,6 +35,9 @@ namespace Gfx {
 
 RefPtr<Gfx::Bitmap> load_jpg(const StringView& path);
 RefPtr<Gfx::Bitmap> load_jpg_from_memory(const u8* data, size_t length);
+// Decodes the image at 1/2, 1/4 or 1/8 of its size, picking the smallest of those that is at least `minimum_size`.
+// The reduced image is computed directly from the DCT coefficients, which is much cheaper than decoding it whole.
+RefPtr<Gfx::Bitmap> load_jpg_downscaled(const StringView& path, const IntSize& minimum_size);
 
 struct JPGLoadingContext;
 
@@ -28,7 +28,9 @@
 #include <AK/Endian.h>
 #include <AK/LexicalPath.h>
 #include <AK/MappedFile.h>
-#include <LibCompress/Gzip.h>
+#include <AK/MemoryStream.h>
+#include <AK/SIMD.h>
+#include <LibCompress/Deflate.h>
 #include <LibGfx/PNGLoader.h>
 #include <fcntl.h>
 #include <math.h>
@@ -39,7 +41,6 @@
 #include <unistd.h>
 
 #ifdef __serenity__
-#    include <LibCompress/Deflate.h>
 #    include <serenity.h>
 #endif
 
@@ -59,11 +60,6 @@ struct PNG_IHDR {
 
 static_assert(sizeof(PNG_IHDR) == 13);
 
-struct Scanline {
-    u8 filter { 0 };
-    ReadonlyBytes data {};
-};
-
 struct [[gnu::packed]] PaletteEntry {
     u8 r;
     u8 g;
@@ -71,27 +67,6 @@ struct [[gnu::packed]] PaletteEntry {
     //u8 a;
 };
 
-template<typename T>
-struct [[gnu::packed]] Tuple {
-    T gray;
-    T a;
-};
-
-template<typename T>
-struct [[gnu::packed]] Triplet {
-    T r;
-    T g;
-    T b;
-};
-
-template<typename T>
-struct [[gnu::packed]] Quad {
-    T r;
-    T g;
-    T b;
-    T a;
-};
-
 enum PngInterlaceMethod {
     Null = 0,
     Adam7 = 1
@@ -119,12 +94,12 @@ struct PNGLoadingContext {
     u8 channels { 0 };
     bool has_seen_zlib_header { false };
     bool has_alpha() const { return color_type & 4 || palette_transparency_data.size() > 0; }
-    Vector<Scanline> scanlines;
     RefPtr<Gfx::Bitmap> bitmap;
     ByteBuffer decompression_buffer;
     Vector<u8> compressed_data;
     Vector<PaletteEntry> palette_data;
     Vector<u8> palette_transparency_data;
+    Vector<RGBA32> palette;
 
     Checked<int> compute_row_size_for_width(int width)
     {
@@ -222,302 +197,256 @@ ALWAYS_INLINE static u8 paeth_predictor(int a, int b, int c)
     return c;
 }
 
-union [[gnu::packed]] Pixel {
-    RGBA32 rgba { 0 };
-    u8 v[4];
-    struct {
-        u8 r;
-        u8 g;
-        u8 b;
-        u8 a;
-    };
-};
-static_assert(sizeof(Pixel) == 4);
-
-template<bool has_alpha, u8 filter_type>
-ALWAYS_INLINE static void unfilter_impl(Gfx::Bitmap& bitmap, int y, const void* dummy_scanline_data)
+// Reverses the filter of a scanline in place. Filters work on bytes, predicting each one from the
+// corresponding bytes of the pixel to the left, the pixel above and the pixel above and to the left.
+static void unfilter_scanline_generic(u8 filter, size_t bytes_per_pixel, Bytes scanline, ReadonlyBytes previous_scanline)
 {
-    auto* dummy_scanline = (const Pixel*)dummy_scanline_data;
-    if constexpr (filter_type == 0) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-        }
+    auto* x = scanline.data();
+    auto* b = previous_scanline.data();
+    size_t size = scanline.size();
+
+    switch (filter) {
+    case 0:
+        break;
+    case 1:
+        for (size_t i = bytes_per_pixel; i < size; ++i)
+            x[i] += x[i - bytes_per_pixel];
+        break;
+    case 2:
+        for (size_t i = 0; i < size; ++i)
+            x[i] += b[i];
+        break;
+    case 3:
+        for (size_t i = 0; i < min(bytes_per_pixel, size); ++i)
+            x[i] += b[i] / 2;
+        for (size_t i = bytes_per_pixel; i < size; ++i)
+            x[i] += (x[i - bytes_per_pixel] + b[i]) / 2;
+        break;
+    case 4:
+        for (size_t i = 0; i < min(bytes_per_pixel, size); ++i)
+            x[i] += b[i];
+        for (size_t i = bytes_per_pixel; i < size; ++i)
+            x[i] += paeth_predictor(x[i - bytes_per_pixel], b[i], b[i - bytes_per_pixel]);
+        break;
+    default:
+        VERIFY_NOT_REACHED();
     }
+}
+
+#ifdef __SSE2__
+
+using AK::SIMD::i16x4;
+using AK::SIMD::u8x16;
+using AK::SIMD::u8x4;
+
+template<size_t bytes_per_pixel>
+ALWAYS_INLINE static u8x4 load_pixel(const u8* data)
+{
+    u8x4 pixel {};
+    __builtin_memcpy(&pixel, data, bytes_per_pixel);
+    return pixel;
+}
+
+template<size_t bytes_per_pixel>
+ALWAYS_INLINE static void store_pixel(u8* data, u8x4 pixel)
+{
+    __builtin_memcpy(data, &pixel, bytes_per_pixel);
+}
+
+ALWAYS_INLINE static u8x4 paeth_predictor(u8x4 a_bytes, u8x4 b_bytes, u8x4 c_bytes)
+{
+    auto a = __builtin_convertvector(a_bytes, i16x4);
+    auto b = __builtin_convertvector(b_bytes, i16x4);
+    auto c = __builtin_convertvector(c_bytes, i16x4);
+
+    // With p = a + b - c: |p - a| = |b - c|, |p - b| = |a - c| and |p - c| = |(b - c) + (a - c)|.
+    i16x4 pa = b - c;
+    i16x4 pb = a - c;
+    i16x4 pc = pa + pb;
+    pa = pa < 0 ? -pa : pa;
+    pb = pb < 0 ? -pb : pb;
+    pc = pc < 0 ? -pc : pc;
+
+    i16x4 predictor = ((pa <= pb) & (pa <= pc)) ? a : (pb <= pc ? b : c);
+    return __builtin_convertvector(predictor, u8x4);
+}
 
-    if constexpr (filter_type == 1) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        swap(pixels[0].r, pixels[0].b);
-        for (int i = 1; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            auto& a = (const Pixel&)pixels[i - 1];
-            x.v[0] += a.v[0];
-            x.v[1] += a.v[1];
-            x.v[2] += a.v[2];
-            if constexpr (has_alpha)
-                x.v[3] += a.v[3];
+// Sub, Average and Paeth depend on the previous pixel, so these go one pixel (of three or four
+// bytes) at a time, with all of its bytes in one vector. Up has no such dependency.
+template<size_t bytes_per_pixel>
+static void unfilter_scanline_simd(u8 filter, Bytes scanline, ReadonlyBytes previous_scanline)
+{
+    auto* x = scanline.data();
+    auto* b = previous_scanline.data();
+    size_t pixel_count = scanline.size() / bytes_per_pixel;
+
+    switch (filter) {
+    case 0:
+        break;
+    case 1: {
+        u8x4 a {};
+        for (size_t i = 0; i < pixel_count; ++i, x += bytes_per_pixel) {
+            a += load_pixel<bytes_per_pixel>(x);
+            store_pixel<bytes_per_pixel>(x, a);
         }
-        return;
+        break;
     }
-    if constexpr (filter_type == 2) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        auto* pixels_y_minus_1 = y == 0 ? dummy_scanline : (const Pixel*)bitmap.scanline(y - 1);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            const Pixel& b = pixels_y_minus_1[i];
-            x.v[0] += b.v[0];
-            x.v[1] += b.v[1];
-            x.v[2] += b.v[2];
-            if constexpr (has_alpha)
-                x.v[3] += b.v[3];
+    case 2: {
+        size_t i = 0;
+        for (; i + sizeof(u8x16) <= scanline.size(); i += sizeof(u8x16)) {
+            u8x16 above, current;
+            __builtin_memcpy(&above, b + i, sizeof(u8x16));
+            __builtin_memcpy(&current, x + i, sizeof(u8x16));
+            current += above;
+            __builtin_memcpy(x + i, &current, sizeof(u8x16));
         }
-        return;
+        for (; i < scanline.size(); ++i)
+            x[i] += b[i];
+        break;
     }
-    if constexpr (filter_type == 3) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        auto* pixels_y_minus_1 = y == 0 ? dummy_scanline : (const Pixel*)bitmap.scanline(y - 1);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            Pixel a;
-            if (i != 0)
-                a = pixels[i - 1];
-            const Pixel& b = pixels_y_minus_1[i];
-            x.v[0] = x.v[0] + ((a.v[0] + b.v[0]) / 2);
-            x.v[1] = x.v[1] + ((a.v[1] + b.v[1]) / 2);
-            x.v[2] = x.v[2] + ((a.v[2] + b.v[2]) / 2);
-            if constexpr (has_alpha)
-                x.v[3] = x.v[3] + ((a.v[3] + b.v[3]) / 2);
+    case 3: {
+        u8x4 a {};
+        for (size_t i = 0; i < pixel_count; ++i, x += bytes_per_pixel, b += bytes_per_pixel) {
+            auto above = load_pixel<bytes_per_pixel>(b);
+            // The average of a and b, rounded down without overflowing a byte.
+            a = load_pixel<bytes_per_pixel>(x) + (a & above) + ((a ^ above) >> 1);
+            store_pixel<bytes_per_pixel>(x, a);
         }
-        return;
+        break;
     }
-    if constexpr (filter_type == 4) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        auto* pixels_y_minus_1 = y == 0 ? dummy_scanline : (Pixel*)bitmap.scanline(y - 1);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            Pixel a;
-            const Pixel& b = pixels_y_minus_1[i];
-            Pixel c;
-            if (i != 0) {
-                a = pixels[i - 1];
-                c = pixels_y_minus_1[i - 1];
-            }
-            x.v[0] += paeth_predictor(a.v[0], b.v[0], c.v[0]);
-            x.v[1] += paeth_predictor(a.v[1], b.v[1], c.v[1]);
-            x.v[2] += paeth_predictor(a.v[2], b.v[2], c.v[2]);
-            if constexpr (has_alpha)
-                x.v[3] += paeth_predictor(a.v[3], b.v[3], c.v[3]);
+    case 4: {
+        u8x4 a {};
+        u8x4 c {};
+        for (size_t i = 0; i < pixel_count; ++i, x += bytes_per_pixel, b += bytes_per_pixel) {
+            auto above = load_pixel<bytes_per_pixel>(b);
+            a = load_pixel<bytes_per_pixel>(x) + paeth_predictor(a, above, c);
+            store_pixel<bytes_per_pixel>(x, a);
+            c = above;
         }
+        break;
     }
-}
-
-template<typename T>
-ALWAYS_INLINE static void unpack_grayscale_without_alpha(PNGLoadingContext& context)
-{
-    for (int y = 0; y < context.height; ++y) {
-        auto* gray_values = reinterpret_cast<const T*>(context.scanlines[y].data.data());
-        for (int i = 0; i < context.width; ++i) {
-            auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-            pixel.r = gray_values[i];
-            pixel.g = gray_values[i];
-            pixel.b = gray_values[i];
-            pixel.a = 0xff;
-        }
+    default:
+        VERIFY_NOT_REACHED();
     }
 }
 
-template<typename T>
-ALWAYS_INLINE static void unpack_grayscale_with_alpha(PNGLoadingContext& context)
+#endif
+
+static void unfilter_scanline(u8 filter, size_t bytes_per_pixel, Bytes scanline, ReadonlyBytes previous_scanline)
 {
-    for (int y = 0; y < context.height; ++y) {
-        auto* tuples = reinterpret_cast<const Tuple<T>*>(context.scanlines[y].data.data());
-        for (int i = 0; i < context.width; ++i) {
-            auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-            pixel.r = tuples[i].gray;
-            pixel.g = tuples[i].gray;
-            pixel.b = tuples[i].gray;
-            pixel.a = tuples[i].a;
-        }
-    }
+#ifdef __SSE2__
+    if (bytes_per_pixel == 4)
+        return unfilter_scanline_simd<4>(filter, scanline, previous_scanline);
+    if (bytes_per_pixel == 3)
+        return unfilter_scanline_simd<3>(filter, scanline, previous_scanline);
+#endif
+    unfilter_scanline_generic(filter, bytes_per_pixel, scanline, previous_scanline);
 }
 
-template<typename T>
-ALWAYS_INLINE static void unpack_triplets_without_alpha(PNGLoadingContext& context)
+ALWAYS_INLINE static RGBA32 make_pixel(u8 r, u8 g, u8 b, u8 a)
 {
-    for (int y = 0; y < context.height; ++y) {
-        auto* triplets = reinterpret_cast<const Triplet<T>*>(context.scanlines[y].data.data());
-        for (int i = 0; i < context.width; ++i) {
-            auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-            pixel.r = triplets[i].r;
-            pixel.g = triplets[i].g;
-            pixel.b = triplets[i].b;
-            pixel.a = 0xff;
-        }
-    }
+    return (a << 24) | (r << 16) | (g << 8) | b;
 }
 
-NEVER_INLINE FLATTEN static bool unfilter(PNGLoadingContext& context)
+// Converts an unfiltered scanline to the bitmap's BGRA layout. Only the most significant byte of
+// 16-bit samples is used.
+static bool unpack_scanline(const PNGLoadingContext& context, ReadonlyBytes scanline, RGBA32* pixels, int width)
 {
-    // First unpack the scanlines to RGBA:
+    auto* data = scanline.data();
+
     switch (context.color_type) {
     case 0:
         if (context.bit_depth == 8) {
-            unpack_grayscale_without_alpha<u8>(context);
+            for (int i = 0; i < width; ++i)
+                pixels[i] = make_pixel(data[i], data[i], data[i], 0xff);
         } else if (context.bit_depth == 16) {
-            unpack_grayscale_without_alpha<u16>(context);
-        } else if (context.bit_depth == 1 || context.bit_depth == 2 || context.bit_depth == 4) {
-            auto bit_depth_squared = context.bit_depth * context.bit_depth;
+            for (int i = 0; i < width; ++i)
+                pixels[i] = make_pixel(data[2 * i], data[2 * i], data[2 * i], 0xff);
+        } else {
             auto pixels_per_byte = 8 / context.bit_depth;
             auto mask = (1 << context.bit_depth) - 1;
-            for (int y = 0; y < context.height; ++y) {
-                auto* gray_values = context.scanlines[y].data.data();
-                for (int x = 0; x < context.width; ++x) {
-                    auto bit_offset = (8 - context.bit_depth) - (context.bit_depth * (x % pixels_per_byte));
-                    auto value = (gray_values[x / pixels_per_byte] >> bit_offset) & mask;
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[x];
-                    pixel.r = value * (0xff / bit_depth_squared);
-                    pixel.g = value * (0xff / bit_depth_squared);
-                    pixel.b = value * (0xff / bit_depth_squared);
-                    pixel.a = 0xff;
-                }
+            for (int i = 0; i < width; ++i) {
+                auto bit_offset = (8 - context.bit_depth) - (context.bit_depth * (i % pixels_per_byte));
+                u8 value = ((data[i / pixels_per_byte] >> bit_offset) & mask) * 0xff / mask;
+                pixels[i] = make_pixel(value, value, value, 0xff);
             }
-        } else {
-            VERIFY_NOT_REACHED();
         }
-        break;
+        return true;
     case 4:
         if (context.bit_depth == 8) {
-            unpack_grayscale_with_alpha<u8>(context);
-        } else if (context.bit_depth == 16) {
-            unpack_grayscale_with_alpha<u16>(context);
+            for (int i = 0; i < width; ++i)
+                pixels[i] = make_pixel(data[2 * i], data[2 * i], data[2 * i], data[2 * i + 1]);
         } else {
-            VERIFY_NOT_REACHED();
+            for (int i = 0; i < width; ++i)
+                pixels[i] = make_pixel(data[4 * i], data[4 * i], data[4 * i], data[4 * i + 2]);
         }
-        break;
+        return true;
     case 2:
         if (context.bit_depth == 8) {
-            unpack_triplets_without_alpha<u8>(context);
-        } else if (context.bit_depth == 16) {
-            unpack_triplets_without_alpha<u16>(context);
+            for (int i = 0; i < width; ++i)
+                pixels[i] = make_pixel(data[3 * i], data[3 * i + 1], data[3 * i + 2], 0xff);
         } else {
-            VERIFY_NOT_REACHED();
+            for (int i = 0; i < width; ++i)
+                pixels[i] = make_pixel(data[6 * i], data[6 * i + 2], data[6 * i + 4], 0xff);
         }
-        break;
+        return true;
     case 6:
         if (context.bit_depth == 8) {
-            for (int y = 0; y < context.height; ++y) {
-                memcpy(context.bitmap->scanline(y), context.scanlines[y].data.data(), context.scanlines[y].data.size());
-            }
-        } else if (context.bit_depth == 16) {
-            for (int y = 0; y < context.height; ++y) {
-                auto* triplets = reinterpret_cast<const Quad<u16>*>(context.scanlines[y].data.data());
-                for (int i = 0; i < context.width; ++i) {
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                    pixel.r = triplets[i].r & 0xFF;
-                    pixel.g = triplets[i].g & 0xFF;
-                    pixel.b = triplets[i].b & 0xFF;
-                    pixel.a = triplets[i].a & 0xFF;
-                }
+            for (int i = 0; i < width; ++i) {
+                u32 rgba;
+                __builtin_memcpy(&rgba, data + 4 * i, sizeof(rgba));
+                // Swap the red and blue bytes.
+                pixels[i] = (rgba & 0xff00ff00) | ((rgba >> 16) & 0xff) | ((rgba & 0xff) << 16);
             }
         } else {
-            VERIFY_NOT_REACHED();
+            for (int i = 0; i < width; ++i)
+                pixels[i] = make_pixel(data[8 * i], data[8 * i + 2], data[8 * i + 4], data[8 * i + 6]);
         }
-        break;
-    case 3:
+        return true;
+    case 3: {
+        auto& palette = context.palette;
         if (context.bit_depth == 8) {
-            for (int y = 0; y < context.height; ++y) {
-                auto* palette_index = context.scanlines[y].data.data();
-                for (int i = 0; i < context.width; ++i) {
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                    if (palette_index[i] >= context.palette_data.size())
-                        return false;
-                    auto& color = context.palette_data.at((int)palette_index[i]);
-                    auto transparency = context.palette_transparency_data.size() >= palette_index[i] + 1u
-                        ? context.palette_transparency_data.data()[palette_index[i]]
-                        : 0xff;
-                    pixel.r = color.r;
-                    pixel.g = color.g;
-                    pixel.b = color.b;
-                    pixel.a = transparency;
-                }
+            for (int i = 0; i < width; ++i) {
+                if (data[i] >= palette.size())
+                    return false;
+                pixels[i] = palette[data[i]];
             }
-        } else if (context.bit_depth == 1 || context.bit_depth == 2 || context.bit_depth == 4) {
+        } else {
             auto pixels_per_byte = 8 / context.bit_depth;
             auto mask = (1 << context.bit_depth) - 1;
-            for (int y = 0; y < context.height; ++y) {
-                auto* palette_indexes = context.scanlines[y].data.data();
-                for (int i = 0; i < context.width; ++i) {
-                    auto bit_offset = (8 - context.bit_depth) - (context.bit_depth * (i % pixels_per_byte));
-                    auto palette_index = (palette_indexes[i / pixels_per_byte] >> bit_offset) & mask;
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                    if ((size_t)palette_index >= context.palette_data.size())
-                        return false;
-                    auto& color = context.palette_data.at(palette_index);
-                    auto transparency = context.palette_transparency_data.size() >= palette_index + 1u
-                        ? context.palette_transparency_data.data()[palette_index]
-                        : 0xff;
-                    pixel.r = color.r;
-                    pixel.g = color.g;
-                    pixel.b = color.b;
-                    pixel.a = transparency;
-                }
+            for (int i = 0; i < width; ++i) {
+                auto bit_offset = (8 - context.bit_depth) - (context.bit_depth * (i % pixels_per_byte));
+                size_t palette_index = (data[i / pixels_per_byte] >> bit_offset) & mask;
+                if (palette_index >= palette.size())
+                    return false;
+                pixels[i] = palette[palette_index];
             }
-        } else {
-            VERIFY_NOT_REACHED();
         }
-        break;
+        return true;
+    }
     default:
         VERIFY_NOT_REACHED();
-        break;
     }
+}
 
-    u8 dummy_scanline[context.width * sizeof(RGBA32)];
+// Inflates the image data into the buffer, which has room for exactly the expected amount.
+// Returns how much of it was filled; a truncated or corrupt stream leaves the rest unfilled.
+static size_t inflate_image_data(ReadonlyBytes compressed_data, Bytes output)
+{
+    InputMemoryStream memory_stream { compressed_data };
+    Compress::DeflateDecompressor deflate_stream { memory_stream };
 
-    for (int y = 0; y < context.height; ++y) {
-        auto filter = context.scanlines[y].filter;
-        if (filter == 0) {
-            if (context.has_alpha())
-                unfilter_impl<true, 0>(*context.bitmap, y, dummy_scanline);
-            else
-                unfilter_impl<false, 0>(*context.bitmap, y, dummy_scanline);
-            continue;
-        }
-        if (filter == 1) {
-            if (context.has_alpha())
-                unfilter_impl<true, 1>(*context.bitmap, y, dummy_scanline);
-            else
-                unfilter_impl<false, 1>(*context.bitmap, y, dummy_scanline);
-            continue;
-        }
-        if (filter == 2) {
-            if (context.has_alpha())
-                unfilter_impl<true, 2>(*context.bitmap, y, dummy_scanline);
-            else
-                unfilter_impl<false, 2>(*context.bitmap, y, dummy_scanline);
-            continue;
-        }
-        if (filter == 3) {
-            if (context.has_alpha())
-                unfilter_impl<true, 3>(*context.bitmap, y, dummy_scanline);
-            else
-                unfilter_impl<false, 3>(*context.bitmap, y, dummy_scanline);
-            continue;
-        }
-        if (filter == 4) {
-            if (context.has_alpha())
-                unfilter_impl<true, 4>(*context.bitmap, y, dummy_scanline);
-            else
-                unfilter_impl<false, 4>(*context.bitmap, y, dummy_scanline);
-            continue;
-        }
+    size_t total_read = 0;
+    while (total_read < output.size()) {
+        auto nread = deflate_stream.read(output.slice(total_read));
+        if (nread == 0)
+            break;
+        total_read += nread;
     }
 
-    return true;
+    if (deflate_stream.handle_any_error())
+        dbgln_if(PNG_DEBUG, "PNG image data is invalid after {} bytes", total_read);
+    return total_read;
 }
 
 static bool decode_png_header(PNGLoadingContext& context)
@@ -601,43 +530,55 @@ static bool decode_png_chunks(PNGLoadingContext& context)
     return true;
 }
 
-static bool decode_png_bitmap_simple(PNGLoadingContext& context)
+// Unfilters and unpacks the scanlines of an image, or of one pass of an interlaced image, starting
+// at `offset` into the image data. Each scanline is handed to `callback` once unpacked.
+template<typename Callback>
+static bool decode_scanlines(PNGLoadingContext& context, size_t& offset, int width, int height, Callback callback)
 {
-    Streamer streamer(context.decompression_buffer.data(), context.decompression_buffer.size());
+    auto row_size = context.compute_row_size_for_width(width);
+    if (row_size.has_overflow())
+        return false;
+
+    size_t bytes_per_pixel = max(1, context.channels * context.bit_depth / 8);
+    auto zero_scanline = ByteBuffer::create_zeroed(row_size.value());
+    Vector<RGBA32> pixels;
+    pixels.resize(width);
 
-    for (int y = 0; y < context.height; ++y) {
-        u8 filter;
-        if (!streamer.read(filter)) {
+    ReadonlyBytes previous_scanline = zero_scanline.bytes();
+    for (int y = 0; y < height; ++y) {
+        if (offset + 1 + row_size.value() > context.decompression_buffer.size()) {
             context.state = PNGLoadingContext::State::Error;
             return false;
         }
 
+        u8 filter = context.decompression_buffer[offset];
         if (filter > 4) {
             dbgln_if(PNG_DEBUG, "Invalid PNG filter: {}", filter);
             context.state = PNGLoadingContext::State::Error;
             return false;
         }
 
-        context.scanlines.append({ filter });
-        auto& scanline_buffer = context.scanlines.last().data;
-        auto row_size = context.compute_row_size_for_width(context.width);
-        if (row_size.has_overflow())
-            return false;
-
-        if (!streamer.wrap_bytes(scanline_buffer, row_size.value())) {
+        auto scanline = context.decompression_buffer.bytes().slice(offset + 1, row_size.value());
+        unfilter_scanline(filter, bytes_per_pixel, scanline, previous_scanline);
+        if (!unpack_scanline(context, scanline, pixels.data(), width)) {
             context.state = PNGLoadingContext::State::Error;
             return false;
         }
-    }
+        callback(y, pixels.data());
 
-    context.bitmap = Bitmap::create_purgeable(context.has_alpha() ? BitmapFormat::RGBA32 : BitmapFormat::RGB32, { context.width, context.height });
-
-    if (!context.bitmap) {
-        context.state = PNGLoadingContext::State::Error;
-        return false;
+        previous_scanline = scanline;
+        offset += 1 + row_size.value();
     }
 
-    return unfilter(context);
+    return true;
+}
+
+static bool decode_png_bitmap_simple(PNGLoadingContext& context)
+{
+    size_t offset = 0;
+    return decode_scanlines(context, offset, context.width, context.height, [&](int y, const RGBA32* pixels) {
+        __builtin_memcpy(context.bitmap->scanline(y), pixels, context.width * sizeof(RGBA32));
+    });
 }
 
 static int adam7_height(PNGLoadingContext& context, int pass)
@@ -690,75 +631,57 @@ static int adam7_startx[8] = { 0, 0, 4, 0, 2, 0, 1, 0 };
 static int adam7_stepy[8] = { 1, 8, 8, 8, 4, 4, 2, 2 };
 static int adam7_stepx[8] = { 1, 8, 8, 4, 4, 2, 2, 1 };
 
-static bool decode_adam7_pass(PNGLoadingContext& context, Streamer& streamer, int pass)
+static bool decode_png_adam7(PNGLoadingContext& context)
 {
-    PNGLoadingContext subimage_context;
-    subimage_context.width = adam7_width(context, pass);
-    subimage_context.height = adam7_height(context, pass);
-    subimage_context.channels = context.channels;
-    subimage_context.color_type = context.color_type;
-    subimage_context.palette_data = context.palette_data;
-    subimage_context.palette_transparency_data = context.palette_transparency_data;
-    subimage_context.bit_depth = context.bit_depth;
-    subimage_context.filter_method = context.filter_method;
-
-    // For small images, some passes might be empty
-    if (!subimage_context.width || !subimage_context.height)
-        return true;
+    size_t offset = 0;
+    for (int pass = 1; pass <= 7; ++pass) {
+        auto width = adam7_width(context, pass);
+        auto height = adam7_height(context, pass);
 
-    subimage_context.scanlines.clear_with_capacity();
-    for (int y = 0; y < subimage_context.height; ++y) {
-        u8 filter;
-        if (!streamer.read(filter)) {
-            context.state = PNGLoadingContext::State::Error;
-            return false;
-        }
+        // For small images, some passes might be empty
+        if (!width || !height)
+            continue;
 
-        if (filter > 4) {
-            dbgln_if(PNG_DEBUG, "Invalid PNG filter: {}", filter);
-            context.state = PNGLoadingContext::State::Error;
+        // Scatter the pixels of the pass into the image according to the pass pattern
+        auto result = decode_scanlines(context, offset, width, height, [&](int y, const RGBA32* pixels) {
+            auto* destination = context.bitmap->scanline(adam7_starty[pass] + y * adam7_stepy[pass]);
+            for (int x = 0, dx = adam7_startx[pass]; x < width; ++x, dx += adam7_stepx[pass])
+                destination[dx] = pixels[x];
+        });
+        if (!result)
             return false;
-        }
-
-        subimage_context.scanlines.append({ filter });
-        auto& scanline_buffer = subimage_context.scanlines.last().data;
+    }
+    return true;
+}
 
-        auto row_size = context.compute_row_size_for_width(subimage_context.width);
+// The size of the image data once inflated: each scanline (of each pass) starts with its filter type.
+static Optional<size_t> compute_image_data_size(PNGLoadingContext& context)
+{
+    Checked<size_t> size = 0;
+    auto add_scanlines = [&](int width, int height) {
+        if (!width || !height)
+            return true;
+        auto row_size = context.compute_row_size_for_width(width);
         if (row_size.has_overflow())
             return false;
-        if (!streamer.wrap_bytes(scanline_buffer, row_size.value())) {
-            context.state = PNGLoadingContext::State::Error;
+        Checked<size_t> scanlines_size = row_size.value() + 1;
+        scanlines_size *= static_cast<size_t>(height);
+        if (scanlines_size.has_overflow())
             return false;
-        }
-    }
-
-    subimage_context.bitmap = Bitmap::create(context.bitmap->format(), { subimage_context.width, subimage_context.height });
-    if (!unfilter(subimage_context)) {
-        subimage_context.bitmap = nullptr;
-        return false;
-    }
+        size += scanlines_size.value();
+        return !size.has_overflow();
+    };
 
-    // Copy the subimage data into the main image according to the pass pattern
-    for (int y = 0, dy = adam7_starty[pass]; y < subimage_context.height && dy < context.height; ++y, dy += adam7_stepy[pass]) {
-        for (int x = 0, dx = adam7_startx[pass]; x < subimage_context.width && dy < context.width; ++x, dx += adam7_stepx[pass]) {
-            context.bitmap->set_pixel(dx, dy, subimage_context.bitmap->get_pixel(x, y));
+    if (context.interlace_method == PngInterlaceMethod::Adam7) {
+        for (int pass = 1; pass <= 7; ++pass) {
+            if (!add_scanlines(adam7_width(context, pass), adam7_height(context, pass)))
+                return {};
         }
+    } else if (!add_scanlines(context.width, context.height)) {
+        return {};
     }
-    return true;
-}
 
-static bool decode_png_adam7(PNGLoadingContext& context)
-{
-    Streamer streamer(context.decompression_buffer.data(), context.decompression_buffer.size());
-    context.bitmap = Bitmap::create_purgeable(context.has_alpha() ? BitmapFormat::RGBA32 : BitmapFormat::RGB32, { context.width, context.height });
-    if (!context.bitmap)
-        return false;
-
-    for (int pass = 1; pass <= 7; ++pass) {
-        if (!decode_adam7_pass(context, streamer, pass))
-            return false;
-    }
-    return true;
+    return size.value();
 }
 
 static bool decode_png_bitmap(PNGLoadingContext& context)
@@ -777,29 +700,46 @@ static bool decode_png_bitmap(PNGLoadingContext& context)
     if (context.color_type == 3 && context.palette_data.is_empty())
         return false; // Didn't see a PLTE chunk for a palettized image, or it was empty.
 
-    auto result = Compress::DeflateDecompressor::decompress_all(context.compressed_data.span().slice(2));
-    if (!result.has_value()) {
+    if (context.compressed_data.size() < 2)
+        return false; // Didn't see the zlib header.
+
+    for (size_t i = 0; i < context.palette_data.size(); ++i) {
+        auto& color = context.palette_data[i];
+        auto alpha = i < context.palette_transparency_data.size() ? context.palette_transparency_data[i] : 0xff;
+        context.palette.append(make_pixel(color.r, color.g, color.b, alpha));
+    }
+
+    auto image_data_size = compute_image_data_size(context);
+    if (!image_data_size.has_value()) {
         context.state = PNGLoadingContext::State::Error;
         return false;
     }
-    context.decompression_buffer = result.value();
-    context.compressed_data.clear();
 
-    context.scanlines.ensure_capacity(context.height);
-    switch (context.interlace_method) {
-    case PngInterlaceMethod::Null:
-        if (!decode_png_bitmap_simple(context))
-            return false;
-        break;
-    case PngInterlaceMethod::Adam7:
-        if (!decode_png_adam7(context))
-            return false;
-        break;
-    default:
-        VERIFY_NOT_REACHED();
+    context.bitmap = Bitmap::create_purgeable(context.has_alpha() ? BitmapFormat::RGBA32 : BitmapFormat::RGB32, { context.width, context.height });
+    if (!context.bitmap) {
+        context.state = PNGLoadingContext::State::Error;
+        return false;
     }
 
+    context.decompression_buffer = ByteBuffer::create_uninitialized(image_data_size.value());
+
+    auto inflated_size = inflate_image_data(context.compressed_data.span().slice(2), context.decompression_buffer);
+    context.decompression_buffer.trim(inflated_size);
+
+    bool success;
+    if (context.interlace_method == PngInterlaceMethod::Adam7)
+        success = decode_png_adam7(context);
+    else
+        success = decode_png_bitmap_simple(context);
+
     context.decompression_buffer.clear();
+    context.compressed_data.clear();
+
+    if (!success) {
+        context.bitmap = nullptr;
+        context.state = PNGLoadingContext::State::Error;
+        return false;
+    }
 
     context.state = PNGLoadingContext::State::BitmapDecoded;
     return true;
@@ -974,6 +914,7 @@ static bool process_chunk(Streamer& streamer, PNGLoadingContext& context)
     return true;
 }
 
+
 PNGImageDecoderPlugin::PNGImageDecoderPlugin(const u8* data, size_t size)
 {
     m_context = make<PNGLoadingContext>();
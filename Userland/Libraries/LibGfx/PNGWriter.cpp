@@ -26,7 +26,9 @@
 
 #include "PNGWriter.h"
 #include <AK/String.h>
+#include <LibCompress/Zlib.h>
 #include <LibCrypto/Checksum/CRC32.h>
+#include <stdlib.h>
 
 namespace Gfx {
 
@@ -40,29 +42,13 @@ public:
     void add_u32_big(u32);
     void add_u16_little(u16);
     void add_u32_little(u32);
+    void add(ReadonlyBytes);
 
 private:
     Vector<u8> m_data;
     String m_type;
 };
 
-class NonCompressibleBlock {
-public:
-    void finalize(PNGChunk&);
-    void add_byte_to_block(u8 data, PNGChunk&);
-
-    u32 adler_s1() { return m_adler_s1; }
-    u32 adler_s2() { return m_adler_s2; }
-
-private:
-    void add_block_to_chunk(PNGChunk&, bool);
-    void update_adler(u8);
-    bool full() { return m_non_compressible_data.size() == 65535; }
-    Vector<u8> m_non_compressible_data;
-    u32 m_adler_s1 { 1 };
-    u32 m_adler_s2 { 0 };
-};
-
 PNGChunk::PNGChunk(const String& type)
     : m_type(move(type))
 {
@@ -101,63 +87,22 @@ void PNGChunk::add_u16_big(u16 data)
     m_data.append(data & 0xff);
 }
 
-void NonCompressibleBlock::add_byte_to_block(u8 data, PNGChunk& chunk)
+void PNGChunk::add(ReadonlyBytes bytes)
 {
-    m_non_compressible_data.append(data);
-    update_adler(data);
-    if (full()) {
-        add_block_to_chunk(chunk, false);
-        m_non_compressible_data.clear();
-    }
-}
-
-void NonCompressibleBlock::add_block_to_chunk(PNGChunk& png_chunk, bool last)
-{
-    if (last) {
-        png_chunk.add_u8(1);
-    } else {
-        png_chunk.add_u8(0);
-    }
-
-    auto len = m_non_compressible_data.size();
-    auto nlen = ~len;
-
-    png_chunk.add_u16_little(len);
-    png_chunk.add_u16_little(nlen);
-
-    for (auto non_compressed_byte : m_non_compressible_data) {
-        png_chunk.add_u8(non_compressed_byte);
-    }
-}
-
-void NonCompressibleBlock::finalize(PNGChunk& chunk)
-{
-    add_block_to_chunk(chunk, true);
-}
-
-void NonCompressibleBlock::update_adler(u8 data)
-{
-    m_adler_s1 = (m_adler_s1 + data) % 65521;
-    m_adler_s2 = (m_adler_s2 + m_adler_s1) % 65521;
+    m_data.append(bytes.data(), bytes.size());
 }
 
 void PNGWriter::add_chunk(const PNGChunk& png_chunk)
 {
-    Vector<u8> combined;
-    for (auto character : png_chunk.type()) {
-        combined.append(character);
-    }
-    combined.append(png_chunk.data());
-
-    auto crc = BigEndian(Crypto::Checksum::CRC32({ (const u8*)combined.data(), combined.size() }).digest());
-    auto data_len = BigEndian(png_chunk.data().size());
-
-    ByteBuffer buf;
-    buf.append(&data_len, sizeof(u32));
-    buf.append(combined.data(), combined.size());
-    buf.append(&crc, sizeof(u32));
+    Crypto::Checksum::CRC32 crc32 { png_chunk.type().bytes() };
+    crc32.update(png_chunk.data().span());
+    auto crc = BigEndian(crc32.digest());
+    auto data_len = BigEndian<u32>(png_chunk.data().size());
 
-    m_data.append(buf.data(), buf.size());
+    m_data.append((const u8*)&data_len, sizeof(u32));
+    m_data.append((const u8*)png_chunk.type().characters(), png_chunk.type().length());
+    m_data.append(png_chunk.data().data(), png_chunk.data().size());
+    m_data.append((const u8*)&crc, sizeof(u32));
 }
 
 void PNGWriter::add_png_header()
@@ -185,30 +130,95 @@ void PNGWriter::add_IEND_chunk()
     add_chunk(png_chunk);
 }
 
+static u8 paeth_predictor(int a, int b, int c)
+{
+    int p = a + b - c;
+    int pa = abs(p - a);
+    int pb = abs(p - b);
+    int pc = abs(p - c);
+    if (pa <= pb && pa <= pc)
+        return a;
+    if (pb <= pc)
+        return b;
+    return c;
+}
+
+// Filters `row` with the given filter type (0 to 4, None, Sub, Up, Average and Paeth), and
+// returns the sum of the filtered bytes taken as signed values, a guess at how well it compresses.
+static size_t filter_row(u8 filter_type, ReadonlyBytes row, ReadonlyBytes previous_row, Bytes filtered_row, size_t bytes_per_pixel)
+{
+    size_t sum = 0;
+    for (size_t i = 0; i < row.size(); ++i) {
+        u8 a = i >= bytes_per_pixel ? row[i - bytes_per_pixel] : 0;
+        u8 b = previous_row[i];
+        u8 c = i >= bytes_per_pixel ? previous_row[i - bytes_per_pixel] : 0;
+        u8 predictor = 0;
+        switch (filter_type) {
+        case 0:
+            break;
+        case 1:
+            predictor = a;
+            break;
+        case 2:
+            predictor = b;
+            break;
+        case 3:
+            predictor = (a + b) / 2;
+            break;
+        case 4:
+            predictor = paeth_predictor(a, b, c);
+            break;
+        default:
+            VERIFY_NOT_REACHED();
+        }
+        u8 filtered = row[i] - predictor;
+        filtered_row[i] = filtered;
+        sum += abs(static_cast<i8>(filtered));
+    }
+    return sum;
+}
+
 void PNGWriter::add_IDAT_chunk(const RefPtr<Bitmap> bitmap)
 {
     PNGChunk png_chunk { "IDAT" };
 
-    u16 CMF_FLG = 0x81d;
-    png_chunk.add_u16_big(CMF_FLG);
+    constexpr size_t bytes_per_pixel = 4;
+    size_t row_size = bitmap->width() * bytes_per_pixel;
 
-    NonCompressibleBlock non_compressible_block;
+    // Each row is stored with the filter that makes its bytes the smallest, which is the usual
+    // heuristic for which one compresses best.
+    auto uncompressed_data = ByteBuffer::create_uninitialized((row_size + 1) * bitmap->height());
+    auto row = ByteBuffer::create_uninitialized(row_size);
+    auto previous_row = ByteBuffer::create_zeroed(row_size);
+    auto candidate_row = ByteBuffer::create_uninitialized(row_size);
 
     for (int y = 0; y < bitmap->height(); ++y) {
-        non_compressible_block.add_byte_to_block(0, png_chunk);
-
         for (int x = 0; x < bitmap->width(); ++x) {
             auto pixel = bitmap->get_pixel(x, y);
-            non_compressible_block.add_byte_to_block(pixel.red(), png_chunk);
-            non_compressible_block.add_byte_to_block(pixel.green(), png_chunk);
-            non_compressible_block.add_byte_to_block(pixel.blue(), png_chunk);
-            non_compressible_block.add_byte_to_block(pixel.alpha(), png_chunk);
+            row[x * bytes_per_pixel + 0] = pixel.red();
+            row[x * bytes_per_pixel + 1] = pixel.green();
+            row[x * bytes_per_pixel + 2] = pixel.blue();
+            row[x * bytes_per_pixel + 3] = pixel.alpha();
+        }
+
+        auto output = uncompressed_data.bytes().slice(y * (row_size + 1), row_size + 1);
+        size_t best_sum = filter_row(0, row, previous_row, output.slice(1), bytes_per_pixel);
+        output[0] = 0;
+        for (u8 filter_type = 1; filter_type <= 4; ++filter_type) {
+            auto sum = filter_row(filter_type, row, previous_row, candidate_row, bytes_per_pixel);
+            if (sum < best_sum) {
+                best_sum = sum;
+                output[0] = filter_type;
+                candidate_row.bytes().copy_to(output.slice(1));
+            }
         }
+
+        swap(row, previous_row);
     }
-    non_compressible_block.finalize(png_chunk);
 
-    png_chunk.add_u16_big(non_compressible_block.adler_s2());
-    png_chunk.add_u16_big(non_compressible_block.adler_s1());
+    auto compressed_data = Compress::Zlib::compress_all(uncompressed_data);
+    VERIFY(compressed_data.has_value());
+    png_chunk.add(compressed_data.value());
 
     add_chunk(png_chunk);
 }
@@ -34,7 +34,7 @@
 #include <AK/Debug.h>
 #include <AK/Function.h>
 #include <AK/Memory.h>
-#include <AK/QuickSort.h>
+#include <AK/SIMD.h>
 #include <AK/StdLibExtras.h>
 #include <AK/StringBuilder.h>
 #include <AK/Utf32View.h>
@@ -42,6 +42,7 @@
 #include <LibGfx/CharacterBitmap.h>
 #include <LibGfx/Palette.h>
 #include <LibGfx/Path.h>
+#include <LibGfx/PathRasterizer.h>
 #include <math.h>
 #include <stdio.h>
 
@@ -69,6 +70,106 @@ ALWAYS_INLINE Color get_pixel(const Gfx::Bitmap& bitmap, int x, int y)
     return bitmap.get_pixel(x, y);
 }
 
+using AK::SIMD::u16x8;
+using AK::SIMD::u32x4;
+using AK::SIMD::u64x2;
+
+// This is exactly value / 255 for anything up to 255 * 255.
+ALWAYS_INLINE static u16x8 divide_by_255(u16x8 value)
+{
+    return (value + 1 + (value >> 8)) >> 8;
+}
+
+ALWAYS_INLINE static bool is_all_zero(u32x4 value)
+{
+    auto halves = (u64x2)value;
+    return !(halves[0] | halves[1]);
+}
+
+// Blends four source pixels onto four opaque destination pixels. With an opaque destination,
+// Color::blend() reduces to (destination * (255 - alpha) + source * alpha) / 255 per channel.
+ALWAYS_INLINE static u32x4 blend_onto_opaque(u32x4 destination, u32x4 source)
+{
+#ifdef __SSE2__
+    // Red and blue, and green on its own, sit in separate 16-bit lanes, so that the products don't overflow.
+    auto alpha = source >> 24;
+    auto alpha_pairs = (u16x8)(alpha | (alpha << 16));
+    auto inverse_alpha_pairs = 255 - alpha_pairs;
+    auto red_blue = (u16x8)(source & 0x00ff00ff) * alpha_pairs + (u16x8)(destination & 0x00ff00ff) * inverse_alpha_pairs;
+    auto green = (u16x8)((source >> 8) & 0xff) * alpha_pairs + (u16x8)((destination >> 8) & 0xff) * inverse_alpha_pairs;
+    return (u32x4)divide_by_255(red_blue) | ((u32x4)divide_by_255(green) << 8) | 0xff000000;
+#else
+    u32x4 result;
+    for (int i = 0; i < 4; ++i)
+        result[i] = Color::from_rgb(destination[i]).blend(Color::from_rgba(source[i])).value();
+    return result;
+#endif
+}
+
+ALWAYS_INLINE static u32x4 apply_opacity(u32x4 source, u8 opacity_alpha, bool source_has_alpha)
+{
+    if (!source_has_alpha)
+        return (source & 0x00ffffff) | ((u32)opacity_alpha << 24);
+    if (opacity_alpha == 255)
+        return source;
+    auto alpha = (u32x4)divide_by_255((u16x8)(source >> 24) * opacity_alpha);
+    return (source & 0x00ffffff) | (alpha << 24);
+}
+
+// Source-over blends a span of pixels onto dst, four at a time. load_source(index, count) returns
+// the (up to four) source pixels starting at index, with the alpha they should be blended with.
+// If destination_is_opaque is set, the destination's alpha channel is ignored.
+template<typename LoadSource>
+ALWAYS_INLINE static void blend_span(RGBA32* dst, size_t count, bool destination_is_opaque, LoadSource load_source)
+{
+    auto blend_pixels = [&](u32x4 destination, u32x4 source) {
+        if (is_all_zero(~source & 0xff000000))
+            return source;
+        auto result = blend_onto_opaque(destination, source);
+        if (!destination_is_opaque && !is_all_zero(~destination & 0xff000000)) {
+            for (int i = 0; i < 4; ++i) {
+                if ((destination[i] >> 24) != 255)
+                    result[i] = Color::from_rgba(destination[i]).blend(Color::from_rgba(source[i])).value();
+            }
+        }
+        return result;
+    };
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        auto source = load_source(i, 4);
+        u32x4 destination;
+        __builtin_memcpy(&destination, dst + i, sizeof(destination));
+        // Transparent source pixels leave the destination alone, unless it's transparent too: then Color::blend() takes the source.
+        if (is_all_zero(source & 0xff000000) && (destination_is_opaque || is_all_zero((u32x4)((destination & 0xff000000) == 0))))
+            continue;
+        auto result = blend_pixels(destination, source);
+        __builtin_memcpy(dst + i, &result, sizeof(result));
+    }
+    if (i == count)
+        return;
+    size_t remaining = count - i;
+    u32x4 destination {};
+    __builtin_memcpy(&destination, dst + i, remaining * sizeof(RGBA32));
+    auto result = blend_pixels(destination, load_source(i, remaining));
+    __builtin_memcpy(dst + i, &result, remaining * sizeof(RGBA32));
+}
+
+static void blend_span(RGBA32* dst, const RGBA32* src, size_t count, u8 opacity_alpha, bool source_has_alpha, bool destination_is_opaque)
+{
+    blend_span(dst, count, destination_is_opaque, [&](size_t index, size_t pixel_count) {
+        u32x4 source {};
+        __builtin_memcpy(&source, src + index, pixel_count * sizeof(RGBA32));
+        return apply_opacity(source, opacity_alpha, source_has_alpha);
+    });
+}
+
+static void blend_span_with_color(RGBA32* dst, size_t count, Color color)
+{
+    u32x4 source { color.value(), color.value(), color.value(), color.value() };
+    blend_span(dst, count, false, [&](size_t, size_t) { return source; });
+}
+
 Painter::Painter(Gfx::Bitmap& bitmap)
     : m_target(bitmap)
 {
@@ -77,7 +178,6 @@ Painter::Painter(Gfx::Bitmap& bitmap)
     VERIFY(bitmap.physical_width() % scale == 0);
     VERIFY(bitmap.physical_height() % scale == 0);
     m_state_stack.append(State());
-    state().font = &FontDatabase::default_font();
     state().clip_rect = { { 0, 0 }, bitmap.size() };
     state().scale = scale;
     m_clip_origin = state().clip_rect;
@@ -87,6 +187,14 @@ Painter::~Painter()
 {
 }
 
+const Font& Painter::font() const
+{
+    // The default font is looked up lazily, so that painting that doesn't involve text works without the font database.
+    if (!state().font)
+        return FontDatabase::default_font();
+    return *state().font;
+}
+
 void Painter::fill_rect_with_draw_op(const IntRect& a_rect, Color color)
 {
     VERIFY(scale() == 1); // FIXME: Add scaling support.
@@ -98,10 +206,28 @@ void Painter::fill_rect_with_draw_op(const IntRect& a_rect, Color color)
     RGBA32* dst = m_target->scanline(rect.top()) + rect.left();
     const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
 
-    for (int i = rect.height() - 1; i >= 0; --i) {
-        for (int j = 0; j < rect.width(); ++j)
-            set_physical_pixel_with_draw_op(dst[j], color);
-        dst += dst_skip;
+    // Same as set_physical_pixel_with_draw_op() on every pixel, but with the switch hoisted out of the loops.
+    switch (draw_op()) {
+    case DrawOp::Copy:
+        for (int i = rect.height() - 1; i >= 0; --i) {
+            fast_u32_fill(dst, color.value(), rect.width());
+            dst += dst_skip;
+        }
+        break;
+    case DrawOp::Xor:
+        for (int i = rect.height() - 1; i >= 0; --i) {
+            for (int j = 0; j < rect.width(); ++j)
+                dst[j] = (dst[j] & 0x00ffffff) ^ color.value();
+            dst += dst_skip;
+        }
+        break;
+    case DrawOp::Invert:
+        for (int i = rect.height() - 1; i >= 0; --i) {
+            for (int j = 0; j < rect.width(); ++j)
+                dst[j] ^= 0x00ffffff;
+            dst += dst_skip;
+        }
+        break;
     }
 }
 
@@ -130,8 +256,7 @@ void Painter::fill_physical_rect(const IntRect& physical_rect, Color color)
     const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
 
     for (int i = physical_rect.height() - 1; i >= 0; --i) {
-        for (int j = 0; j < physical_rect.width(); ++j)
-            dst[j] = Color::from_rgba(dst[j]).blend(color).value();
+        blend_span_with_color(dst, physical_rect.width(), color);
         dst += dst_skip;
     }
 }
@@ -555,28 +680,13 @@ void Painter::blit_with_opacity(const IntPoint& position, const Gfx::Bitmap& sou
     const RGBA32* src = source.scanline(src_rect.top() + first_row) + src_rect.left() + first_column;
     const unsigned src_skip = source.pitch() / sizeof(RGBA32);
 
-    auto do_blit = [&]<bool with_src_alpha>() {
-        for (int row = first_row; row <= last_row; ++row) {
-            for (int x = 0; x <= (last_column - first_column); ++x) {
-                if constexpr (with_src_alpha) {
-                    Color src_color_with_alpha = Color::from_rgba(src[x]);
-                    float pixel_opacity = src_color_with_alpha.alpha() / 255.0;
-                    src_color_with_alpha.set_alpha(255 * (opacity * pixel_opacity));
-                    dst[x] = Color::from_rgba(dst[x]).blend(src_color_with_alpha).value();
-                } else {
-                    Color src_color_with_alpha = Color::from_rgb(src[x]);
-                    src_color_with_alpha.set_alpha(alpha);
-                    dst[x] = Color::from_rgb(dst[x]).blend(src_color_with_alpha).value();
-                }
-            }
-            dst += dst_skip;
-            src += src_skip;
-        }
-    };
-    if (source.has_alpha_channel() && apply_alpha)
-        do_blit.template operator()<true>();
-    else
-        do_blit.template operator()<false>();
+    // Without a source alpha channel, the destination is treated as opaque, as Color::from_rgb() would.
+    bool source_has_alpha = source.has_alpha_channel() && apply_alpha;
+    for (int row = first_row; row <= last_row; ++row) {
+        blend_span(dst, src, last_column - first_column + 1, alpha, source_has_alpha, !source_has_alpha);
+        dst += dst_skip;
+        src += src_skip;
+    }
 }
 
 void Painter::blit_filtered(const IntPoint& position, const Gfx::Bitmap& source, const IntRect& src_rect, Function<Color(Color)> filter)
@@ -799,11 +909,216 @@ ALWAYS_INLINE static void do_draw_integer_scaled_bitmap(Gfx::Bitmap& target, con
     }
 }
 
+// Interpolates between two colors, with weight (0-256) going to b. The channels are processed in pairs.
+// This works on single pixels as well as on four at a time, with one weight or one for each of them.
+template<typename T, typename Weight>
+ALWAYS_INLINE static T interpolate(T a, T b, Weight weight)
+{
+    T red_blue = (((a & 0x00ff00ff) * (256 - weight) + (b & 0x00ff00ff) * weight) >> 8) & 0x00ff00ff;
+    T alpha_green = (((a >> 8) & 0x00ff00ff) * (256 - weight) + ((b >> 8) & 0x00ff00ff) * weight) & 0xff00ff00;
+    return alpha_green | red_blue;
+}
+
+// Where a destination pixel samples the source along one axis: the nearest source pixel, the two pixels to interpolate
+// between (with the weight of the second one), or the range of pixels to average.
+struct SourceSample {
+    int first { 0 };
+    int second { 0 };
+    u32 weight { 0 };
+};
+
+// Takes the fixed-point position of a destination pixel's center.
+ALWAYS_INLINE static SourceSample bilinear_sample(int position, int low, int high)
+{
+    int first = position >> 16;
+    if (first < low)
+        return { low, low, 0 };
+    if (first >= high)
+        return { high, high, 0 };
+    return { first, first + 1, (u32)(position >> 8) & 0xff };
+}
+
+// Takes the fixed-point position of a destination pixel's leading edge, and returns a half-open range.
+ALWAYS_INLINE static SourceSample box_sample(int position, int step, int low, int high)
+{
+    int begin = min(max(position >> 16, low), high);
+    int end = max(min((position + step) >> 16, high + 1), begin + 1);
+    return { begin, end, 0 };
+}
+
+template<typename GetPixel>
+ALWAYS_INLINE static void scale_row_nearest_neighbor(RGBA32* row, const Vector<SourceSample>& columns, const Gfx::Bitmap& source, GetPixel get_pixel, int y)
+{
+    for (size_t i = 0; i < columns.size(); ++i)
+        row[i] = get_pixel(source, columns[i].first, y).value();
+}
+
+static bool is_32bit_format(BitmapFormat format)
+{
+    return format == BitmapFormat::RGB32 || format == BitmapFormat::RGBA32;
+}
+
+// Returns the pixels of source row y from first_column to last_column. 32-bit bitmaps are read in place, other formats
+// are converted into buffer. RGB32 pixels come with whatever is in their alpha byte; since the channels never mix,
+// the scalers simply make their results opaque at the end.
+template<typename GetPixel>
+ALWAYS_INLINE static const RGBA32* load_source_row(RGBA32* buffer, const Gfx::Bitmap& source, GetPixel get_pixel, int y, int first_column, int last_column)
+{
+    if (is_32bit_format(source.format()))
+        return source.scanline(y) + first_column;
+    for (int x = first_column; x <= last_column; ++x)
+        buffer[x - first_column] = get_pixel(source, x, y).value();
+    return buffer;
+}
+
+ALWAYS_INLINE static void make_opaque(RGBA32* row, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        row[i] |= 0xff000000;
+}
+
+struct ScalingBuffers {
+    Vector<RGBA32> first_row;
+    Vector<RGBA32> second_row;
+    Vector<RGBA32> interpolated_row;
+    Vector<u32> red_blue_sums;
+    Vector<u32> alpha_green_sums;
+    Vector<u32> reciprocals;
+};
+
+// Interpolates between the two source rows first, four pixels at a time, so that each destination pixel only needs one
+// more interpolation. That one is done for four destination pixels at a time as well.
+template<typename GetPixel>
+ALWAYS_INLINE static void scale_row_bilinear(RGBA32* row, ScalingBuffers& buffers, const Vector<SourceSample>& column_samples, const Gfx::Bitmap& source, GetPixel get_pixel, const SourceSample& rows)
+{
+    // Vector's bounds checks are too much for these loops.
+    auto* columns = column_samples.data();
+    size_t column_count = column_samples.size();
+    int first_column = column_samples.first().first;
+    int last_column = column_samples.last().second;
+    size_t width = last_column - first_column + 1;
+    auto* top = load_source_row(buffers.first_row.data(), source, get_pixel, rows.first, first_column, last_column);
+    auto* bottom = load_source_row(buffers.second_row.data(), source, get_pixel, rows.second, first_column, last_column);
+    auto* interpolated = buffers.interpolated_row.data();
+
+    size_t x = 0;
+    for (; x + 4 <= width; x += 4) {
+        u32x4 top_pixels;
+        u32x4 bottom_pixels;
+        __builtin_memcpy(&top_pixels, top + x, sizeof(top_pixels));
+        __builtin_memcpy(&bottom_pixels, bottom + x, sizeof(bottom_pixels));
+        auto result = interpolate(top_pixels, bottom_pixels, rows.weight);
+        __builtin_memcpy(interpolated + x, &result, sizeof(result));
+    }
+    for (; x < width; ++x)
+        interpolated[x] = interpolate(top[x], bottom[x], rows.weight);
+
+    size_t i = 0;
+    for (; i + 4 <= column_count; i += 4) {
+        auto* c = columns + i;
+        u32x4 left { interpolated[c[0].first - first_column], interpolated[c[1].first - first_column], interpolated[c[2].first - first_column], interpolated[c[3].first - first_column] };
+        u32x4 right { interpolated[c[0].second - first_column], interpolated[c[1].second - first_column], interpolated[c[2].second - first_column], interpolated[c[3].second - first_column] };
+        u32x4 weights { c[0].weight, c[1].weight, c[2].weight, c[3].weight };
+        auto result = interpolate(left, right, weights);
+        __builtin_memcpy(row + i, &result, sizeof(result));
+    }
+    for (; i < column_count; ++i)
+        row[i] = interpolate(interpolated[columns[i].first - first_column], interpolated[columns[i].second - first_column], columns[i].weight);
+
+    if (source.format() == BitmapFormat::RGB32)
+        make_opaque(row, column_count);
+}
+
+// Sums up the source rows first, four pixels at a time with two channels to each 32-bit lane, and then averages
+// the column sums that fall into each destination pixel.
+template<typename GetPixel>
+ALWAYS_INLINE static void scale_row_box_filter(RGBA32* row, ScalingBuffers& buffers, const Vector<SourceSample>& column_samples, const Gfx::Bitmap& source, GetPixel get_pixel, const SourceSample& rows)
+{
+    // Vector's bounds checks are too much for these loops.
+    auto* columns = column_samples.data();
+    size_t column_count = column_samples.size();
+    int first_column = column_samples.first().first;
+    int last_column = column_samples.last().second - 1;
+    size_t width = last_column - first_column + 1;
+    u32 row_count = rows.second - rows.first;
+    size_t max_column_span = buffers.reciprocals.size();
+
+    // A 16-bit half of a lane holds the sum of up to 257 pixels. Shrinking by more than that is rare enough to not bother.
+    if (row_count * max_column_span > 256) {
+        for (size_t i = 0; i < column_count; ++i) {
+            u32 red = 0, green = 0, blue = 0, alpha = 0;
+            for (int y = rows.first; y < rows.second; ++y) {
+                for (int x = columns[i].first; x < columns[i].second; ++x) {
+                    auto color = get_pixel(source, x, y);
+                    red += color.red();
+                    green += color.green();
+                    blue += color.blue();
+                    alpha += color.alpha();
+                }
+            }
+            u32 count = (columns[i].second - columns[i].first) * row_count;
+            row[i] = Color(red / count, green / count, blue / count, alpha / count).value();
+        }
+        return;
+    }
+
+    auto* red_blue_sums = buffers.red_blue_sums.data();
+    auto* alpha_green_sums = buffers.alpha_green_sums.data();
+    __builtin_memset(red_blue_sums, 0, width * sizeof(u32));
+    __builtin_memset(alpha_green_sums, 0, width * sizeof(u32));
+    for (int y = rows.first; y < rows.second; ++y) {
+        auto* pixels = load_source_row(buffers.first_row.data(), source, get_pixel, y, first_column, last_column);
+        size_t x = 0;
+        for (; x + 4 <= width; x += 4) {
+            u32x4 source_pixels;
+            u32x4 red_blue;
+            u32x4 alpha_green;
+            __builtin_memcpy(&source_pixels, pixels + x, sizeof(source_pixels));
+            __builtin_memcpy(&red_blue, red_blue_sums + x, sizeof(red_blue));
+            __builtin_memcpy(&alpha_green, alpha_green_sums + x, sizeof(alpha_green));
+            red_blue += source_pixels & 0x00ff00ff;
+            alpha_green += (source_pixels >> 8) & 0x00ff00ff;
+            __builtin_memcpy(red_blue_sums + x, &red_blue, sizeof(red_blue));
+            __builtin_memcpy(alpha_green_sums + x, &alpha_green, sizeof(alpha_green));
+        }
+        for (; x < width; ++x) {
+            red_blue_sums[x] += pixels[x] & 0x00ff00ff;
+            alpha_green_sums[x] += (pixels[x] >> 8) & 0x00ff00ff;
+        }
+    }
+
+    // For count <= 256, dividing a sum s <= 255 * count by count is the same as (s * ceil(2^24 / count)) >> 24.
+    // That saves four divisions per pixel, and there are only a few different counts in a row.
+    auto* reciprocals = buffers.reciprocals.data();
+    for (size_t span = 1; span <= max_column_span; ++span) {
+        u32 count = span * row_count;
+        reciprocals[span - 1] = ((1 << 24) + count - 1) / count;
+    }
+
+    for (size_t i = 0; i < column_count; ++i) {
+        u32 red_blue = 0;
+        u32 alpha_green = 0;
+        for (int x = columns[i].first - first_column; x < columns[i].second - first_column; ++x) {
+            red_blue += red_blue_sums[x];
+            alpha_green += alpha_green_sums[x];
+        }
+        u32 reciprocal = reciprocals[columns[i].second - columns[i].first - 1];
+        u32 alpha = ((alpha_green >> 16) * reciprocal) >> 24;
+        u32 red = ((red_blue >> 16) * reciprocal) >> 24;
+        u32 green = ((alpha_green & 0xffff) * reciprocal) >> 24;
+        u32 blue = ((red_blue & 0xffff) * reciprocal) >> 24;
+        row[i] = (alpha << 24) | (red << 16) | (green << 8) | blue;
+    }
+
+    if (source.format() == BitmapFormat::RGB32)
+        make_opaque(row, column_count);
+}
+
 template<bool has_alpha_channel, typename GetPixel>
-ALWAYS_INLINE static void do_draw_scaled_bitmap(Gfx::Bitmap& target, const IntRect& dst_rect, const IntRect& clipped_rect, const Gfx::Bitmap& source, const FloatRect& src_rect, GetPixel get_pixel, float opacity)
+ALWAYS_INLINE static void do_draw_scaled_bitmap(Gfx::Bitmap& target, const IntRect& dst_rect, const IntRect& clipped_rect, const Gfx::Bitmap& source, const FloatRect& src_rect, GetPixel get_pixel, float opacity, Painter::ScalingMode scaling_mode)
 {
     IntRect int_src_rect = enclosing_int_rect(src_rect);
-    if (dst_rect == clipped_rect && int_src_rect == src_rect && !(dst_rect.width() % int_src_rect.width()) && !(dst_rect.height() % int_src_rect.height())) {
+    if (scaling_mode == Painter::ScalingMode::NearestNeighbor && dst_rect == clipped_rect && int_src_rect == src_rect && !(dst_rect.width() % int_src_rect.width()) && !(dst_rect.height() % int_src_rect.height())) {
         int hfactor = dst_rect.width() / int_src_rect.width();
         int vfactor = dst_rect.height() / int_src_rect.height();
         if (hfactor == 2 && vfactor == 2)
@@ -815,34 +1130,83 @@ ALWAYS_INLINE static void do_draw_scaled_bitmap(Gfx::Bitmap& target, const IntRe
         return do_draw_integer_scaled_bitmap<has_alpha_channel>(target, dst_rect, int_src_rect, source, hfactor, vfactor, get_pixel, opacity);
     }
 
-    bool has_opacity = opacity != 1.0f;
+    u8 opacity_alpha = 255 * opacity;
     int hscale = (src_rect.width() * (1 << 16)) / dst_rect.width();
     int vscale = (src_rect.height() * (1 << 16)) / dst_rect.height();
     int src_left = src_rect.left() * (1 << 16);
     int src_top = src_rect.top() * (1 << 16);
+    auto bounds = int_src_rect.intersected(source.physical_rect());
+    if (bounds.is_empty())
+        return;
 
-    for (int y = clipped_rect.top(); y <= clipped_rect.bottom(); ++y) {
-        auto* scanline = (Color*)target.scanline(y);
-        for (int x = clipped_rect.left(); x <= clipped_rect.right(); ++x) {
-            auto scaled_x = ((x - dst_rect.x()) * hscale + src_left) >> 16;
-            auto scaled_y = ((y - dst_rect.y()) * vscale + src_top) >> 16;
-            auto src_pixel = get_pixel(source, scaled_x, scaled_y);
-            if (has_opacity)
-                src_pixel.set_alpha(src_pixel.alpha() * opacity);
-            if constexpr (has_alpha_channel) {
-                scanline[x] = scanline[x].blend(src_pixel);
-            } else
-                scanline[x] = src_pixel;
+    bool use_bilinear = scaling_mode == Painter::ScalingMode::BilinearBlend && hscale < 2 << 16 && vscale < 2 << 16;
+    bool use_box_filter = scaling_mode == Painter::ScalingMode::BilinearBlend && !use_bilinear;
+    if (use_bilinear) {
+        src_left += hscale / 2 - (1 << 15);
+        src_top += vscale / 2 - (1 << 15);
+    }
+
+    auto sample = [&](int position, int step, int low, int high) -> SourceSample {
+        if (use_bilinear)
+            return bilinear_sample(position, low, high);
+        if (use_box_filter)
+            return box_sample(position, step, low, high);
+        return { position >> 16 };
+    };
+
+    Vector<SourceSample> columns;
+    columns.ensure_capacity(clipped_rect.width());
+    int src_x = (clipped_rect.left() - dst_rect.x()) * hscale + src_left;
+    for (int x = clipped_rect.left(); x <= clipped_rect.right(); ++x) {
+        columns.unchecked_append(sample(src_x, hscale, bounds.left(), bounds.right()));
+        src_x += hscale;
+    }
+
+    // Each destination row is resampled into a buffer first, so that it can be blended (or copied) as a whole span.
+    Vector<RGBA32> row;
+    row.resize(columns.size());
+    ScalingBuffers buffers;
+    if (use_bilinear || use_box_filter) {
+        size_t source_width = columns.last().second - columns.first().first + 1;
+        if (!is_32bit_format(source.format())) {
+            buffers.first_row.resize(source_width);
+            buffers.second_row.resize(source_width);
+        }
+        if (use_bilinear) {
+            buffers.interpolated_row.resize(source_width);
+        } else {
+            buffers.red_blue_sums.resize(source_width);
+            buffers.alpha_green_sums.resize(source_width);
+            size_t max_column_span = 0;
+            for (auto& column : columns)
+                max_column_span = max(max_column_span, (size_t)(column.second - column.first));
+            buffers.reciprocals.resize(max_column_span);
         }
     }
+
+    for (int y = clipped_rect.top(); y <= clipped_rect.bottom(); ++y) {
+        auto rows = sample((y - dst_rect.y()) * vscale + src_top, vscale, bounds.top(), bounds.bottom());
+        if (use_bilinear)
+            scale_row_bilinear(row.data(), buffers, columns, source, get_pixel, rows);
+        else if (use_box_filter)
+            scale_row_box_filter(row.data(), buffers, columns, source, get_pixel, rows);
+        else
+            scale_row_nearest_neighbor(row.data(), columns, source, get_pixel, rows.first);
+
+        auto* scanline = target.scanline(y) + clipped_rect.left();
+        if constexpr (has_alpha_channel)
+            blend_span(scanline, row.data(), row.size(), opacity_alpha, true, false);
+        else
+            fast_u32_copy(scanline, row.data(), row.size());
+    }
 }
 
-void Painter::draw_scaled_bitmap(const IntRect& a_dst_rect, const Gfx::Bitmap& source, const IntRect& a_src_rect, float opacity)
+void Painter::draw_scaled_bitmap(const IntRect& a_dst_rect, const Gfx::Bitmap& source, const IntRect& a_src_rect, float opacity, ScalingMode scaling_mode)
 {
-    draw_scaled_bitmap(a_dst_rect, source, FloatRect { a_src_rect }, opacity);
+    draw_scaled_bitmap(a_dst_rect, source, FloatRect { a_src_rect }, opacity, scaling_mode);
 }
 
-void Painter::draw_scaled_bitmap(const IntRect& a_dst_rect, const Gfx::Bitmap& source, const FloatRect& a_src_rect, float opacity)
+void Painter::draw_scaled_bitmap(const IntRect& a_dst_rect, const Gfx::Bitmap& source, const FloatRect& a_src_rect, float opacity, ScalingMode scaling_mode)
 {
     IntRect int_src_rect = enclosing_int_rect(a_src_rect);
     if (scale() == source.scale() && a_src_rect == int_src_rect && a_dst_rect.size() == int_src_rect.size())
@@ -857,37 +1221,37 @@ void Painter::draw_scaled_bitmap(const IntRect& a_dst_rect, const Gfx::Bitmap& s
     if (source.has_alpha_channel() || opacity != 1.0f) {
         switch (source.format()) {
         case BitmapFormat::RGB32:
-            do_draw_scaled_bitmap<true>(*m_target, dst_rect, clipped_rect, source, src_rect, get_pixel<BitmapFormat::RGB32>, opacity);
+            do_draw_scaled_bitmap<true>(*m_target, dst_rect, clipped_rect, source, src_rect, get_pixel<BitmapFormat::RGB32>, opacity, scaling_mode);
             break;
         case BitmapFormat::RGBA32:
-            do_draw_scaled_bitmap<true>(*m_target, dst_rect, clipped_rect, source, src_rect, get_pixel<BitmapFormat::RGBA32>, opacity);
+            do_draw_scaled_bitmap<true>(*m_target, dst_rect, clipped_rect, source, src_rect, get_pixel<BitmapFormat::RGBA32>, opacity, scaling_mode);
             break;
         case BitmapFormat::Indexed8:
-            do_draw_scaled_bitmap<true>(*m_target, dst_rect, clipped_rect, source, src_rect, get_pixel<BitmapFormat::Indexed8>, opacity);
+            do_draw_scaled_bitmap<true>(*m_target, dst_rect, clipped_rect, source, src_rect, get_pixel<BitmapFormat::Indexed8>, opacity, scaling_mode);
             break;
         case BitmapFormat::Indexed4:
-            do_draw_scaled_bitmap<true>(*m_target, dst_rect, clipped_rect, source, src_rect, get_pixel<BitmapFormat::Indexed4>, opacity);
+            do_draw_scaled_bitmap<true>(*m_target, dst_rect, clipped_rect, source, src_rect, get_pixel<BitmapFormat::Indexed4>, opacity, scaling_mode);
             break;
         case BitmapFormat::Indexed2:
-            do_draw_scaled_bitmap<true>(*m_target, dst_rect, clipped_rect, source, src_rect, get_pixel<BitmapFormat::Indexed2>, opacity);
+            do_draw_scaled_bitmap<true>(*m_target, dst_rect, clipped_rect, source, src_rect, get_pixel<BitmapFormat::Indexed2>, opacity, scaling_mode);
             break;
         case BitmapFormat::Indexed1:
-            do_draw_scaled_bitmap<true>(*m_target, dst_rect, clipped_rect, source, src_rect, get_pixel<BitmapFormat::Indexed1>, opacity);
+            do_draw_scaled_bitmap<true>(*m_target, dst_rect, clipped_rect, source, src_rect, get_pixel<BitmapFormat::Indexed1>, opacity, scaling_mode);
             break;
         default:
-            do_draw_scaled_bitmap<true>(*m_target, dst_rect, clipped_rect, source, src_rect, get_pixel<BitmapFormat::Invalid>, opacity);
+            do_draw_scaled_bitmap<true>(*m_target, dst_rect, clipped_rect, source, src_rect, get_pixel<BitmapFormat::Invalid>, opacity, scaling_mode);
             break;
         }
     } else {
         switch (source.format()) {
         case BitmapFormat::RGB32:
-            do_draw_scaled_bitmap<false>(*m_target, dst_rect, clipped_rect, source, src_rect, get_pixel<BitmapFormat::RGB32>, opacity);
+            do_draw_scaled_bitmap<false>(*m_target, dst_rect, clipped_rect, source, src_rect, get_pixel<BitmapFormat::RGB32>, opacity, scaling_mode);
             break;
         case BitmapFormat::Indexed8:
-            do_draw_scaled_bitmap<false>(*m_target, dst_rect, clipped_rect, source, src_rect, get_pixel<BitmapFormat::Indexed8>, opacity);
+            do_draw_scaled_bitmap<false>(*m_target, dst_rect, clipped_rect, source, src_rect, get_pixel<BitmapFormat::Indexed8>, opacity, scaling_mode);
             break;
         default:
-            do_draw_scaled_bitmap<false>(*m_target, dst_rect, clipped_rect, source, src_rect, get_pixel<BitmapFormat::Invalid>, opacity);
+            do_draw_scaled_bitmap<false>(*m_target, dst_rect, clipped_rect, source, src_rect, get_pixel<BitmapFormat::Invalid>, opacity, scaling_mode);
             break;
         }
     }
@@ -1549,166 +1913,32 @@ void Painter::stroke_path(const Path& path, Color color, int thickness)
     }
 }
 
-[[maybe_unused]] static void approximately_place_on_int_grid(FloatPoint ffrom, FloatPoint fto, IntPoint& from, IntPoint& to, Optional<IntPoint> previous_to)
-{
-    auto diffs = fto - ffrom;
-    // Truncate all first (round down).
-    from = ffrom.to_type<int>();
-    to = fto.to_type<int>();
-    // There are 16 possible configurations, by deciding to round each
-    // coord up or down (and there are four coords, from.x from.y to.x to.y)
-    // we will simply choose one which most closely matches the correct slope
-    // with the following heuristic:
-    // - if the x diff is positive or zero (that is, a right-to-left slant), round 'from.x' up and 'to.x' down.
-    // - if the x diff is negative         (that is, a left-to-right slant), round 'from.x' down and 'to.x' up.
-    // Note that we do not need to touch the 'y' attribute, as that is our scanline.
-    if (diffs.x() >= 0) {
-        from.set_x(from.x() + 1);
-    } else {
-        to.set_x(to.x() + 1);
-    }
-    if (previous_to.has_value() && from.x() != previous_to.value().x()) // The points have to line up, since we're using these lines to fill a shape.
-        from.set_x(previous_to.value().x());
-}
-
 void Painter::fill_path(Path& path, Color color, WindingRule winding_rule)
 {
     VERIFY(scale() == 1); // FIXME: Add scaling support.
 
-    const auto& segments = path.split_lines();
-
-    if (segments.size() == 0)
+    // All pixels that the path touches, even partially.
+    auto& bounding_box = path.bounding_box();
+    int left = floorf(bounding_box.x());
+    int top = floorf(bounding_box.y());
+    int right = ceilf(bounding_box.x() + bounding_box.width());
+    int bottom = ceilf(bounding_box.y() + bounding_box.height());
+    auto rect = IntRect(left, top, right - left, bottom - top).translated(translation()).intersected(clip_rect());
+    if (rect.is_empty())
         return;
 
-    Vector<Path::SplitLineSegment> active_list;
-    active_list.ensure_capacity(segments.size());
-
-    // first, grab the segments for the very first scanline
-    int first_y = path.bounding_box().bottom_right().y() + 1;
-    int last_y = path.bounding_box().top_left().y() - 1;
-    float scanline = first_y;
-
-    size_t last_active_segment { 0 };
-
-    for (auto& segment : segments) {
-        if (segment.maximum_y != scanline)
-            break;
-        active_list.append(segment);
-        ++last_active_segment;
-    }
-
-    auto is_inside_shape = [winding_rule](int winding_number) {
-        if (winding_rule == WindingRule::Nonzero)
-            return winding_number != 0;
-
-        if (winding_rule == WindingRule::EvenOdd)
-            return winding_number % 2 == 0;
-
-        VERIFY_NOT_REACHED();
-    };
-
-    auto increment_winding = [winding_rule](int& winding_number, const IntPoint& from, const IntPoint& to) {
-        if (winding_rule == WindingRule::EvenOdd) {
-            ++winding_number;
-            return;
-        }
-
-        if (winding_rule == WindingRule::Nonzero) {
-            if (from.dy_relative_to(to) < 0)
-                ++winding_number;
-            else
-                --winding_number;
-            return;
-        }
-
-        VERIFY_NOT_REACHED();
-    };
-
-    while (scanline >= last_y) {
-        Optional<IntPoint> previous_to;
-        if (active_list.size()) {
-            // sort the active list by 'x' from right to left
-            quick_sort(active_list, [](const auto& line0, const auto& line1) {
-                return line1.x < line0.x;
-            });
-#if FILL_PATH_DEBUG
-            if ((int)scanline % 10 == 0) {
-                draw_text(IntRect(active_list.last().x - 20, scanline, 20, 10), String::number((int)scanline));
-            }
-#endif
-
-            if (active_list.size() > 1) {
-                auto winding_number { 0 };
-                for (size_t i = 1; i < active_list.size(); ++i) {
-                    auto& previous = active_list[i - 1];
-                    auto& current = active_list[i];
-
-                    IntPoint from, to;
-                    IntPoint truncated_from { previous.x, scanline };
-                    IntPoint truncated_to { current.x, scanline };
-                    approximately_place_on_int_grid({ previous.x, scanline }, { current.x, scanline }, from, to, previous_to);
-
-                    if (is_inside_shape(winding_number)) {
-                        // The points between this segment and the previous are
-                        // inside the shape
-
-                        dbgln_if(FILL_PATH_DEBUG, "y={}: {} at {}: {} -- {}", scanline, winding_number, i, from, to);
-                        draw_line(from, to, color, 1);
-                    }
-
-                    auto is_passing_through_maxima = scanline == previous.maximum_y
-                        || scanline == previous.minimum_y
-                        || scanline == current.maximum_y
-                        || scanline == current.minimum_y;
-
-                    auto is_passing_through_vertex = false;
-
-                    if (is_passing_through_maxima) {
-                        is_passing_through_vertex = previous.x == current.x;
-                    }
-
-                    if (!is_passing_through_vertex || previous.inverse_slope * current.inverse_slope < 0)
-                        increment_winding(winding_number, truncated_from, truncated_to);
-
-                    // update the x coord
-                    active_list[i - 1].x -= active_list[i - 1].inverse_slope;
-                }
-                active_list.last().x -= active_list.last().inverse_slope;
-            } else {
-                auto point = IntPoint(active_list[0].x, scanline);
-                draw_line(point, point, color);
-
-                // update the x coord
-                active_list.first().x -= active_list.first().inverse_slope;
-            }
-        }
-
-        --scanline;
-        // remove any edge that goes out of bound from the active list
-        for (size_t i = 0, count = active_list.size(); i < count; ++i) {
-            if (scanline <= active_list[i].minimum_y) {
-                active_list.remove(i);
-                --count;
-                --i;
-            }
-        }
-        for (size_t j = last_active_segment; j < segments.size(); ++j, ++last_active_segment) {
-            auto& segment = segments[j];
-            if (segment.maximum_y < scanline)
-                break;
-            if (segment.minimum_y >= scanline)
-                continue;
-
-            active_list.append(segment);
-        }
-    }
-
-#if FILL_PATH_DEBUG
-    size_t i { 0 };
-    for (auto& segment : segments) {
-        draw_line(Point<int>(segment.from), Point<int>(segment.to), Color::from_hsv(i++ * 360.0 / segments.size(), 1.0, 1.0), 1);
-    }
-#endif
+    PathRasterizer rasterizer(rect.size());
+    rasterizer.draw_path(path, (translation() - rect.location()).to_type<float>());
+    rasterizer.for_each_row(winding_rule, [&](int y, int x, ReadonlyBytes coverage) {
+        auto* dst = m_target->scanline(rect.y() + y) + rect.x() + x;
+        blend_span(dst, coverage.size(), false, [&](size_t index, size_t count) {
+            u32x4 alpha {};
+            for (size_t i = 0; i < count; ++i)
+                alpha[i] = coverage[index + i];
+            alpha = (u32x4)divide_by_255((u16x8)alpha * color.alpha());
+            return (color.value() & 0x00ffffff) | (alpha << 24);
+        });
+    });
 }
 
 void Painter::blit_disabled(const IntPoint& location, const Gfx::Bitmap& bitmap, const IntRect& rect, const Palette& palette)
@@ -50,6 +50,11 @@ public:
         Dashed,
     };
 
+    enum class ScalingMode {
+        NearestNeighbor,
+        BilinearBlend,
+    };
+
     void clear_rect(const IntRect&, Color);
     void fill_rect(const IntRect&, Color);
     void fill_rect_with_dither_pattern(const IntRect&, Color, Color);
@@ -61,8 +66,8 @@ public:
     void draw_focus_rect(const IntRect&, Color);
     void draw_bitmap(const IntPoint&, const CharacterBitmap&, Color = Color());
     void draw_bitmap(const IntPoint&, const GlyphBitmap&, Color = Color());
-    void draw_scaled_bitmap(const IntRect& dst_rect, const Gfx::Bitmap&, const IntRect& src_rect, float opacity = 1.0f);
-    void draw_scaled_bitmap(const IntRect& dst_rect, const Gfx::Bitmap&, const FloatRect& src_rect, float opacity = 1.0f);
+    void draw_scaled_bitmap(const IntRect& dst_rect, const Gfx::Bitmap&, const IntRect& src_rect, float opacity = 1.0f, ScalingMode = ScalingMode::NearestNeighbor);
+    void draw_scaled_bitmap(const IntRect& dst_rect, const Gfx::Bitmap&, const FloatRect& src_rect, float opacity = 1.0f, ScalingMode = ScalingMode::NearestNeighbor);
     void draw_triangle(const IntPoint&, const IntPoint&, const IntPoint&, Color);
     void draw_ellipse_intersecting(const IntRect&, Color, int thickness = 1);
     void set_pixel(const IntPoint&, Color);
@@ -103,7 +108,7 @@ public:
     };
     void fill_path(Path&, Color, WindingRule rule = WindingRule::Nonzero);
 
-    const Font& font() const { return *state().font; }
+    const Font& font() const;
     void set_font(const Font& font) { state().font = &font; }
 
     enum class DrawOp {
@@ -143,7 +148,7 @@ protected:
     void draw_physical_pixel(const IntPoint&, Color, int thickness = 1);
 
     struct State {
-        const Font* font;
+        const Font* font { nullptr };
         IntPoint translation;
         int scale = 1;
         IntRect clip_rect;
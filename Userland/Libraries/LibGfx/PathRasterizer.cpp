@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/StdLibExtras.h>
+#include <LibGfx/Bitmap.h>
+#include <LibGfx/Path.h>
+#include <LibGfx/PathRasterizer.h>
+#include <math.h>
+
+#ifdef __SSE2__
+#    include <AK/SIMD.h>
+#    include <emmintrin.h>
+#endif
+
+namespace Gfx {
+
+PathRasterizer::PathRasterizer(const IntSize& size)
+    : m_size(size)
+    , m_row_stride(size.width() + 2)
+{
+    // Lines on the right edge add to the two cells past the last pixel.
+    m_cells.resize(m_row_stride * m_size.height());
+    __builtin_memset(m_cells.data(), 0, m_cells.size() * sizeof(float));
+    m_row_extents.resize(m_size.height());
+}
+
+void PathRasterizer::draw_path(const Path& path, const FloatPoint& offset)
+{
+    FloatPoint cursor;
+    FloatPoint subpath_start;
+
+    auto add_line = [&](const FloatPoint& from, const FloatPoint& to) {
+        draw_line(from + offset, to + offset);
+    };
+
+    for (auto& segment : path.segments()) {
+        switch (segment.type()) {
+        case Segment::Type::Invalid:
+            VERIFY_NOT_REACHED();
+        case Segment::Type::MoveTo:
+            add_line(cursor, subpath_start);
+            subpath_start = segment.point();
+            break;
+        case Segment::Type::LineTo:
+            add_line(cursor, segment.point());
+            break;
+        case Segment::Type::QuadraticBezierCurveTo: {
+            auto& through = static_cast<const QuadraticBezierCurveSegment&>(segment).through();
+            Painter::for_each_line_segment_on_bezier_curve(through, cursor, segment.point(), [&](auto& from, auto& to) { add_line(from, to); });
+            break;
+        }
+        case Segment::Type::EllipticalArcTo: {
+            auto& arc = static_cast<const EllipticalArcSegment&>(segment);
+            Painter::for_each_line_segment_on_elliptical_arc(cursor, segment.point(), arc.center(), arc.radii(), arc.x_axis_rotation(), arc.theta_1(), arc.theta_delta(), [&](auto& from, auto& to) { add_line(from, to); });
+            break;
+        }
+        }
+        cursor = segment.point();
+    }
+    add_line(cursor, subpath_start);
+}
+
+void PathRasterizer::draw_line(FloatPoint p0, FloatPoint p1)
+{
+    if (p0.y() == p1.y())
+        return;
+
+    // Lines are accumulated from top to bottom, the direction says which way they actually went.
+    float direction = 1.0f;
+    if (p0.y() > p1.y()) {
+        swap(p0, p1);
+        direction = -1.0f;
+    }
+
+    float width = m_size.width();
+    float height = m_size.height();
+    float top = max(p0.y(), 0.0f);
+    float bottom = min(p1.y(), height);
+    if (top >= bottom)
+        return;
+
+    // How much a line covers only depends on where it crosses each row: the parts of it left of the first pixel
+    // might as well be on the left edge, and the parts right of the last pixel don't cover anything. So the line
+    // is split where it crosses the left and right edges, and the pieces are moved inside (or dropped).
+    float dxdy = (p1.x() - p0.x()) / (p1.y() - p0.y());
+    auto x_at = [&](float y) { return p0.x() + (y - p0.y()) * dxdy; };
+
+    float splits[4] = { top };
+    size_t split_count = 1;
+    if (p0.x() != p1.x()) {
+        for (float edge : { 0.0f, width }) {
+            float y = p0.y() + (edge - p0.x()) / dxdy;
+            if (y > top && y < bottom)
+                splits[split_count++] = y;
+        }
+        if (split_count == 3 && splits[1] > splits[2])
+            swap(splits[1], splits[2]);
+    }
+    splits[split_count++] = bottom;
+
+    for (size_t i = 0; i + 1 < split_count; ++i) {
+        float y0 = splits[i];
+        float y1 = splits[i + 1];
+        float x0 = x_at(y0);
+        float x1 = x_at(y1);
+        if (x0 + x1 >= 2 * width)
+            continue;
+        x0 = min(max(x0, 0.0f), width);
+        x1 = min(max(x1, 0.0f), width);
+        accumulate_line({ x0, y0 }, { x1, y1 }, direction);
+    }
+}
+
+// The line is within the rasterizer, and goes downwards.
+void PathRasterizer::accumulate_line(FloatPoint top, FloatPoint bottom, float direction)
+{
+    float dxdy = (bottom.x() - top.x()) / (bottom.y() - top.y());
+    int first_row = top.y();
+    int end_row = min((int)ceilf(bottom.y()), m_size.height());
+    float x = top.x();
+
+    for (int y = first_row; y < end_row; ++y) {
+        float dy = min(y + 1.0f, bottom.y()) - max((float)y, top.y());
+        float next_x = min(max(x + dxdy * dy, 0.0f), (float)m_size.width());
+        float d = dy * direction;
+        float x0 = min(x, next_x);
+        float x1 = max(x, next_x);
+        int x0_floor = x0;
+        int x1_ceil = ceilf(x1);
+        auto* cells = row(y);
+
+        auto& extent = m_row_extents[y];
+        extent.left = min(extent.left, x0_floor);
+        extent.right = max(extent.right, max(x1_ceil, x0_floor + 1));
+
+        if (x1_ceil <= x0_floor + 1) {
+            // Within a single pixel, the part of it right of the line's midpoint is covered.
+            float covered = 0.5f * (x + next_x) - x0_floor;
+            cells[x0_floor] += d - d * covered;
+            cells[x0_floor + 1] += d * covered;
+        } else {
+            // The line spans several pixels: the first and last get a triangle's worth each, and the ones in
+            // between get the rest, with the running sum along the row ramping up from one to the other.
+            float inverse_width = 1.0f / (x1 - x0);
+            float x0_fraction = x0 - x0_floor;
+            float first_area = 0.5f * inverse_width * (1.0f - x0_fraction) * (1.0f - x0_fraction);
+            float x1_fraction = x1 - x1_ceil + 1.0f;
+            float last_area = 0.5f * inverse_width * x1_fraction * x1_fraction;
+            cells[x0_floor] += d * first_area;
+            if (x1_ceil == x0_floor + 2) {
+                cells[x0_floor + 1] += d * (1.0f - first_area - last_area);
+            } else {
+                float second_area = inverse_width * (1.5f - x0_fraction);
+                cells[x0_floor + 1] += d * (second_area - first_area);
+                for (int i = x0_floor + 2; i < x1_ceil - 1; ++i)
+                    cells[i] += d * inverse_width;
+                float area_before_last = second_area + (x1_ceil - x0_floor - 3) * inverse_width;
+                cells[x1_ceil - 1] += d * (1.0f - area_before_last - last_area);
+            }
+            cells[x1_ceil] += d * last_area;
+        }
+
+        x = next_x;
+    }
+}
+
+ALWAYS_INLINE static u8 coverage_for(float accumulator, Painter::WindingRule winding_rule)
+{
+    float value = fabsf(accumulator);
+    if (winding_rule == Painter::WindingRule::EvenOdd) {
+        // Windings of one, three, ... are inside and even ones outside, with partial coverage in between.
+        value -= 2.0f * (int)(value * 0.5f);
+        value = 1.0f - fabsf(1.0f - value);
+    } else {
+        value = min(value, 1.0f);
+    }
+    return value * 255.0f + 0.5f;
+}
+
+// Computes the running sum of the cells into coverage, and returns the final sum.
+static float accumulate_cells(const float* cells, u8* coverage, size_t count, Painter::WindingRule winding_rule)
+{
+    float accumulator = 0.0f;
+    size_t i = 0;
+#ifdef __SSE2__
+    using AK::SIMD::f32x4;
+    using AK::SIMD::i32x4;
+
+    auto absolute = [](f32x4 value) { return (f32x4)((i32x4)value & 0x7fffffff); };
+    f32x4 carry = {};
+    for (; i + 4 <= count; i += 4) {
+        f32x4 sums;
+        __builtin_memcpy(&sums, cells + i, sizeof(sums));
+        sums += (f32x4)_mm_slli_si128((__m128i)sums, 4);
+        sums += (f32x4)_mm_slli_si128((__m128i)sums, 8);
+        sums += carry;
+        carry = (f32x4)_mm_shuffle_epi32((__m128i)sums, 0xff);
+
+        auto value = absolute(sums);
+        if (winding_rule == Painter::WindingRule::EvenOdd) {
+            value -= 2.0f * __builtin_convertvector(__builtin_convertvector(value * 0.5f, i32x4), f32x4);
+            value = 1.0f - absolute(1.0f - value);
+        } else {
+            value = (f32x4)_mm_min_ps((__m128)value, _mm_set1_ps(1.0f));
+        }
+        auto bytes = (__m128i)__builtin_convertvector(value * 255.0f + 0.5f, i32x4);
+        bytes = _mm_packus_epi16(_mm_packs_epi32(bytes, bytes), bytes);
+        u32 packed = _mm_cvtsi128_si32(bytes);
+        __builtin_memcpy(coverage + i, &packed, sizeof(packed));
+    }
+    accumulator = carry[0];
+#endif
+    for (; i < count; ++i) {
+        accumulator += cells[i];
+        coverage[i] = coverage_for(accumulator, winding_rule);
+    }
+    return accumulator;
+}
+
+void PathRasterizer::for_each_row(Painter::WindingRule winding_rule, Function<void(int y, int x, ReadonlyBytes coverage)> callback)
+{
+    Vector<u8> coverage;
+    coverage.resize(m_size.width());
+
+    for (int y = 0; y < m_size.height(); ++y) {
+        auto& extent = m_row_extents[y];
+        if (extent.left >= m_size.width())
+            continue;
+
+        // Left of the leftmost cell the sum is zero, and right of the rightmost one it doesn't change anymore.
+        size_t left = extent.left;
+        size_t end = min(extent.right + 1, m_size.width());
+        float accumulator = accumulate_cells(row(y) + left, coverage.data() + left, end - left, winding_rule);
+        if (u8 trailing_coverage = coverage_for(accumulator, winding_rule); trailing_coverage && end < (size_t)m_size.width()) {
+            __builtin_memset(coverage.data() + end, trailing_coverage, m_size.width() - end);
+            end = m_size.width();
+        }
+        callback(y, left, { coverage.data() + left, end - left });
+    }
+}
+
+RefPtr<Bitmap> PathRasterizer::accumulate(Painter::WindingRule winding_rule)
+{
+    auto bitmap = Bitmap::create(BitmapFormat::RGBA32, m_size);
+    if (!bitmap)
+        return nullptr;
+    bitmap->fill(Color(Color::White).with_alpha(0));
+    for_each_row(winding_rule, [&](int y, int x, ReadonlyBytes coverage) {
+        auto* scanline = bitmap->scanline(y) + x;
+        for (size_t i = 0; i < coverage.size(); ++i)
+            scanline[i] = Color(Color::White).with_alpha(coverage[i]).value();
+    });
+    return bitmap;
+}
+
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Function.h>
+#include <AK/NumericLimits.h>
+#include <AK/Span.h>
+#include <AK/Vector.h>
+#include <LibGfx/Forward.h>
+#include <LibGfx/Painter.h>
+#include <LibGfx/Point.h>
+#include <LibGfx/Size.h>
+
+namespace Gfx {
+
+// An antialiasing path rasterizer. Every line adds the (signed) area it covers to the cells of an accumulation
+// buffer, and a running sum along each row then gives the exact coverage of every pixel. Only the cells between
+// the leftmost and rightmost lines in a row are visited.
+class PathRasterizer {
+public:
+    explicit PathRasterizer(const IntSize&);
+
+    // Adds all subpaths of the path, each of them implicitly closed, moved by the given offset.
+    void draw_path(const Path&, const FloatPoint& offset = {});
+    void draw_line(FloatPoint, FloatPoint);
+
+    // Calls the callback for every row that the path covers, with the coverage (0-255) of the pixels from x onwards.
+    void for_each_row(Painter::WindingRule, Function<void(int y, int x, ReadonlyBytes coverage)>);
+
+    // Returns a white bitmap, with the coverage in its alpha channel.
+    RefPtr<Bitmap> accumulate(Painter::WindingRule = Painter::WindingRule::Nonzero);
+
+    const IntSize& size() const { return m_size; }
+
+private:
+    void accumulate_line(FloatPoint top, FloatPoint bottom, float direction);
+    float* row(int y) { return m_cells.data() + y * m_row_stride; }
+
+    struct RowExtent {
+        int left { NumericLimits<int>::max() };
+        int right { -1 };
+    };
+
+    IntSize m_size;
+    size_t m_row_stride { 0 };
+    Vector<float> m_cells;
+    Vector<RowExtent> m_row_extents;
+};
+
+}
@@ -67,6 +67,16 @@ void HttpsJob::start()
         if (on_certificate_requested)
             on_certificate_requested(*this);
     };
+    m_socket->on_tls_session_established = [this](auto& session) {
+        if (on_tls_session_established)
+            on_tls_session_established(session);
+    };
+    m_socket->on_tls_session_resumption_failed = [this] {
+        if (on_tls_session_resumption_failed)
+            on_tls_session_resumption_failed();
+    };
+    if (m_session_to_resume.has_value())
+        m_socket->set_session_to_resume(m_session_to_resume.release_value());
     bool success = ((TLS::TLSv12&)*m_socket).connect(m_request.url().host(), m_request.url().port());
     if (!success) {
         deferred_invoke([this](auto&) {
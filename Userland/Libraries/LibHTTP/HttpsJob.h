@@ -51,8 +51,11 @@ public:
     virtual void start() override;
     virtual void shutdown() override;
     void set_certificate(String certificate, String key);
+    void set_tls_session_to_resume(TLS::Session session) { m_session_to_resume = move(session); }
 
     Function<void(HttpsJob&)> on_certificate_requested;
+    Function<void(const TLS::Session&)> on_tls_session_established;
+    Function<void()> on_tls_session_resumption_failed;
 
 protected:
     virtual void register_on_ready_to_read(Function<void()>) override;
@@ -70,6 +73,7 @@ protected:
 private:
     RefPtr<TLS::TLSv12> m_socket;
     const Vector<Certificate>* m_override_ca_certificates { nullptr };
+    Optional<TLS::Session> m_session_to_resume;
 };
 
 }
@@ -29,6 +29,7 @@
 #include <LibCore/TCPSocket.h>
 #include <LibHTTP/HttpResponse.h>
 #include <LibHTTP/Job.h>
+#include <LibThread/ThreadPool.h>
 #include <stdio.h>
 #include <unistd.h>
 
@@ -342,6 +343,8 @@ void Job::on_socket_connected()
 void Job::finish_up()
 {
     m_state = State::Finished;
+    if (m_is_decoding_content)
+        return;
     if (!m_can_stream_response) {
         auto flattened_buffer = ByteBuffer::create_uninitialized(m_received_size);
         u8* flat_ptr = flattened_buffer.data();
@@ -355,7 +358,21 @@ void Job::finish_up()
         // FIXME: LibCompress exposes a streaming interface, so this can be resolved
         auto content_encoding = m_headers.get("Content-Encoding");
         if (content_encoding.has_value()) {
-            flattened_buffer = handle_content_encoding(flattened_buffer, content_encoding.value());
+            // Decompressing can take a while, so it's done on the thread pool to keep the other jobs going.
+            m_is_decoding_content = true;
+            auto future = LibThread::ThreadPool::the().run([buffer = move(flattened_buffer), content_encoding = content_encoding.release_value()] {
+                return handle_content_encoding(buffer, content_encoding);
+            });
+            future->on_complete([this, weak_this = make_weak_ptr()](ByteBuffer decoded_buffer) {
+                if (!weak_this)
+                    return;
+                m_is_decoding_content = false;
+                m_buffered_size = decoded_buffer.size();
+                m_received_buffers.append(move(decoded_buffer));
+                m_can_stream_response = true;
+                finish_up();
+            });
+            return;
         }
 
         m_buffered_size = flattened_buffer.size();
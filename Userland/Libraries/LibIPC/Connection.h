@@ -27,6 +27,7 @@
 #pragma once
 
 #include <AK/ByteBuffer.h>
+#include <AK/Optional.h>
 #include <AK/NonnullOwnPtrVector.h>
 #include <LibCore/Event.h>
 #include <LibCore/EventLoop.h>
@@ -35,6 +36,7 @@
 #include <LibCore/SyscallUtils.h>
 #include <LibCore/Timer.h>
 #include <LibIPC/Message.h>
+#include <LibIPC/MessageRing.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -45,6 +47,11 @@
 
 namespace IPC {
 
+// Sent as the size of a message to switch a connection over to a pair of MessageRings.
+// The connecting side follows it with the size of the rings (and passes their file descriptors
+// along), the other side answers with a size of 0 once it has mapped them.
+static constexpr u32 shared_memory_transport_marker = 0xffffffff;
+
 template<typename LocalEndpoint, typename PeerEndpoint>
 class Connection : public Core::Object {
 public:
@@ -75,8 +82,14 @@ public:
             return;
 
         auto buffer = message.encode();
+        // With the shared memory transport, messages may take either the ring or the socket,
+        // so they are numbered for the peer to put them back in order.
+        if (m_outgoing_ring.has_value()) {
+            u32 sequence = m_next_outgoing_sequence++;
+            buffer.data.prepend(reinterpret_cast<const u8*>(&sequence), sizeof(sequence));
+        }
         // Prepend the message size.
-        uint32_t message_size = buffer.data.size();
+        uint32_t message_size = buffer.data.size() - (m_outgoing_ring.has_value() ? sizeof(u32) : 0);
         buffer.data.prepend(reinterpret_cast<const u8*>(&message_size), sizeof(message_size));
 
 #ifdef __serenity__
@@ -92,26 +105,14 @@ public:
             warnln("fd passing is not supported on this platform, sorry :(");
 #endif
 
-        size_t total_nwritten = 0;
-        while (total_nwritten < buffer.data.size()) {
-            auto nwritten = write(m_socket->fd(), buffer.data.data() + total_nwritten, buffer.data.size() - total_nwritten);
-            if (nwritten < 0) {
-                switch (errno) {
-                case EPIPE:
-                    dbgln("{}::post_message: Disconnected from peer", *this);
-                    shutdown();
-                    return;
-                case EAGAIN:
-                    dbgln("{}::post_message: Peer buffer overflowed", *this);
-                    shutdown();
-                    return;
-                default:
-                    perror("Connection::post_message write");
-                    shutdown();
-                    return;
-                }
-            }
-            total_nwritten += nwritten;
+        // File descriptors are passed over the socket, so a message that carries some has to take the socket too.
+        // The messages after it may go back to the ring, the peer puts them in order by their sequence numbers.
+        if (m_outgoing_ring.has_value() && buffer.fds.is_empty() && m_outgoing_ring->try_write(buffer.data.span())) {
+            ++m_messages_sent_through_ring;
+            if (m_outgoing_ring->take_reader_waiting())
+                wake_up_peer();
+        } else if (!write_to_socket(buffer.data.span())) {
+            return;
         }
 
         m_responsiveness_timer->start();
@@ -121,6 +122,7 @@ public:
     OwnPtr<typename RequestType::ResponseType> send_sync(Args&&... args)
     {
         post_message(RequestType(forward<Args>(args)...));
+        flush_wakeup();
         auto response = wait_for_specific_endpoint_message<typename RequestType::ResponseType, PeerEndpoint>();
         VERIFY(response);
         return response;
@@ -130,9 +132,51 @@ public:
     OwnPtr<typename RequestType::ResponseType> send_sync_but_allow_failure(Args&&... args)
     {
         post_message(RequestType(forward<Args>(args)...));
+        flush_wakeup();
         return wait_for_specific_endpoint_message<typename RequestType::ResponseType, PeerEndpoint>();
     }
 
+    // Moves the messages going in both directions into shared memory, leaving only wakeups and file
+    // descriptors to the socket. Has to be called by the connecting side, before sending any messages.
+    bool enable_shared_memory_transport([[maybe_unused]] size_t capacity = MessageRing::default_capacity)
+    {
+#ifdef __serenity__
+        VERIFY(!m_outgoing_ring.has_value() && !m_pending_incoming_ring.has_value());
+        auto outgoing_ring = MessageRing::create(capacity);
+        auto incoming_ring = MessageRing::create(capacity);
+        if (!outgoing_ring.has_value() || !incoming_ring.has_value())
+            return false;
+
+        if (sendfd(m_socket->fd(), outgoing_ring->fd()) < 0 || sendfd(m_socket->fd(), incoming_ring->fd()) < 0) {
+            perror("sendfd");
+            shutdown();
+            return false;
+        }
+        u32 request[] = { shared_memory_transport_marker, (u32)outgoing_ring->size() };
+        if (!write_to_socket({ request, sizeof(request) }))
+            return false;
+
+        // Our messages go into the ring right away, the peer reads them once it has mapped it.
+        // Its messages are only sequenced from its answer onwards though.
+        m_outgoing_ring = move(outgoing_ring);
+        m_pending_incoming_ring = move(incoming_ring);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // When batching, the peer is woken up for new messages in the shared memory rings at most once
+    // per event loop iteration, instead of once for each message it hasn't picked up yet.
+    void set_batching(bool batching)
+    {
+        m_batching = batching;
+        if (!batching)
+            flush_wakeup();
+    }
+
+    size_t messages_sent_through_ring() const { return m_messages_sent_through_ring; }
+
     virtual void may_have_become_unresponsive() { }
     virtual void did_become_responsive() { }
 
@@ -179,18 +223,159 @@ protected:
         return {};
     }
 
-    bool drain_messages_from_peer()
+    bool write_to_socket(ReadonlyBytes bytes)
     {
-        Vector<u8> bytes;
+        size_t total_nwritten = 0;
+        while (total_nwritten < bytes.size()) {
+            auto nwritten = write(m_socket->fd(), bytes.data() + total_nwritten, bytes.size() - total_nwritten);
+            if (nwritten < 0) {
+                switch (errno) {
+                case EPIPE:
+                    dbgln("{}::post_message: Disconnected from peer", *this);
+                    shutdown();
+                    return false;
+                case EAGAIN:
+                    dbgln("{}::post_message: Peer buffer overflowed", *this);
+                    shutdown();
+                    return false;
+                default:
+                    perror("Connection::post_message write");
+                    shutdown();
+                    return false;
+                }
+            }
+            total_nwritten += nwritten;
+        }
+        return true;
+    }
 
-        if (!m_unprocessed_bytes.is_empty()) {
-            bytes.append(m_unprocessed_bytes.data(), m_unprocessed_bytes.size());
-            m_unprocessed_bytes.clear();
+    void wake_up_peer()
+    {
+        if (m_batching) {
+            if (m_wakeup_pending)
+                return;
+            m_wakeup_pending = true;
+            deferred_invoke([this](auto&) { flush_wakeup(); });
+            return;
         }
+        // A message size of 0 only tells the peer to look at the ring.
+        u32 wakeup = 0;
+        write_to_socket({ &wakeup, sizeof(wakeup) });
+    }
+
+    void flush_wakeup()
+    {
+        if (!m_wakeup_pending || !m_socket->is_open())
+            return;
+        m_wakeup_pending = false;
+        u32 wakeup = 0;
+        write_to_socket({ &wakeup, sizeof(wakeup) });
+    }
+
+    // Messages may keep a reference to the receive buffer for the parameters they decode as views.
+    bool decode_message(const ByteBuffer& buffer, ReadonlyBytes bytes)
+    {
+        if (auto message = LocalEndpoint::decode_message(buffer, bytes, m_socket->fd())) {
+            m_unprocessed_messages.append(message.release_nonnull());
+        } else if (auto message = PeerEndpoint::decode_message(buffer, bytes, m_socket->fd())) {
+            m_unprocessed_messages.append(message.release_nonnull());
+        } else {
+            dbgln("Failed to parse a message");
+            return false;
+        }
+        return true;
+    }
+
+    bool handle_shared_memory_transport_marker(ReadonlyBytes bytes, size_t& index)
+    {
+        if (bytes.size() - index < 2 * sizeof(u32))
+            return true;
+        auto ring_size = *reinterpret_cast<const u32*>(bytes.data() + index + sizeof(u32));
+        index += 2 * sizeof(u32);
+
+        if (m_pending_incoming_ring.has_value()) {
+            // The peer has mapped the rings we sent it.
+            m_incoming_ring = move(m_pending_incoming_ring);
+            m_pending_incoming_ring.clear();
+            return true;
+        }
+
+#ifdef __serenity__
+        int incoming_fd = recvfd(m_socket->fd(), O_CLOEXEC);
+        int outgoing_fd = incoming_fd >= 0 ? recvfd(m_socket->fd(), O_CLOEXEC) : -1;
+        if (incoming_fd < 0 || outgoing_fd < 0) {
+            perror("recvfd");
+            shutdown();
+            return false;
+        }
+        m_incoming_ring = MessageRing::create_from_anon_fd(incoming_fd, ring_size);
+        m_outgoing_ring = MessageRing::create_from_anon_fd(outgoing_fd, ring_size);
+        if (!m_incoming_ring.has_value() || !m_outgoing_ring.has_value()) {
+            dbgln("{}: Failed to map the shared memory transport", *this);
+            shutdown();
+            return false;
+        }
+
+        u32 answer[] = { shared_memory_transport_marker, 0 };
+        return write_to_socket({ answer, sizeof(answer) });
+#else
+        dbgln("{}: Peer asked for the shared memory transport (size {}), which is not supported on this platform", *this, ring_size);
+        shutdown();
+        return false;
+#endif
+    }
+
+    // With the shared memory transport, each message is prefixed with its size and sequence number,
+    // and may come from either the ring or the socket. The socket also carries wakeups (of size 0).
+    bool decode_sequenced_messages(const ByteBuffer& socket_bytes, size_t& socket_index, const ByteBuffer& ring_bytes, size_t& ring_index)
+    {
+        struct Frame {
+            u32 sequence;
+            ReadonlyBytes message;
+            const ByteBuffer* buffer;
+        };
+        auto frame_at = [](const ByteBuffer& bytes, size_t index) -> Optional<Frame> {
+            if (bytes.size() - index < 2 * sizeof(u32))
+                return {};
+            auto message_size = *reinterpret_cast<const u32*>(bytes.data() + index);
+            auto sequence = *reinterpret_cast<const u32*>(bytes.data() + index + sizeof(u32));
+            if (bytes.size() - index - 2 * sizeof(u32) < message_size)
+                return {};
+            return Frame { sequence, bytes.bytes().slice(index + 2 * sizeof(u32), message_size), &bytes };
+        };
+
+        for (;;) {
+            while (socket_bytes.size() - socket_index >= sizeof(u32) && *reinterpret_cast<const u32*>(socket_bytes.data() + socket_index) == 0)
+                socket_index += sizeof(u32);
+
+            Optional<Frame> frame;
+            if (auto socket_frame = frame_at(socket_bytes, socket_index); socket_frame.has_value() && socket_frame->sequence == m_next_incoming_sequence) {
+                frame = socket_frame;
+                socket_index += 2 * sizeof(u32) + frame->message.size();
+            } else if (auto ring_frame = frame_at(ring_bytes, ring_index); ring_frame.has_value() && ring_frame->sequence == m_next_incoming_sequence) {
+                frame = ring_frame;
+                ring_index += 2 * sizeof(u32) + frame->message.size();
+            } else {
+                // The next message is still on its way.
+                return true;
+            }
+
+            if (!decode_message(*frame->buffer, frame->message))
+                return false;
+            ++m_next_incoming_sequence;
+        }
+    }
+
+    bool drain_messages_from_peer()
+    {
+        // Received straight into a ByteBuffer, so that the messages decoded from it can share it.
+        auto bytes = move(m_unprocessed_bytes);
+        size_t received_size = bytes.size();
 
         while (m_socket->is_open()) {
-            u8 buffer[4096];
-            ssize_t nread = recv(m_socket->fd(), buffer, sizeof(buffer), MSG_DONTWAIT);
+            if (bytes.size() - received_size < 4096)
+                bytes.grow(max(bytes.size() * 2, received_size + 4096));
+            ssize_t nread = recv(m_socket->fd(), bytes.data() + received_size, bytes.size() - received_size, MSG_DONTWAIT);
             if (nread < 0) {
                 if (errno == EAGAIN)
                     break;
@@ -199,35 +384,57 @@ protected:
                 return false;
             }
             if (nread == 0) {
-                if (bytes.is_empty()) {
+                if (received_size == 0) {
                     deferred_invoke([this](auto&) { die(); });
                 }
                 return false;
             }
-            bytes.append(buffer, nread);
+            received_size += nread;
         }
+        bytes.trim(received_size);
 
-        if (!bytes.is_empty()) {
-            m_responsiveness_timer->stop();
-            did_become_responsive();
-        }
+        bool received_anything = !bytes.is_empty();
 
         size_t index = 0;
         uint32_t message_size = 0;
-        for (; index + sizeof(message_size) < bytes.size(); index += message_size) {
+        for (; !m_incoming_ring.has_value() && index + sizeof(message_size) < bytes.size(); index += message_size) {
             message_size = *reinterpret_cast<uint32_t*>(bytes.data() + index);
+            if (message_size == shared_memory_transport_marker) {
+                if (!handle_shared_memory_transport_marker(bytes, index))
+                    return false;
+                break;
+            }
             if (message_size == 0 || bytes.size() - index - sizeof(uint32_t) < message_size)
                 break;
             index += sizeof(message_size);
-            auto remaining_bytes = ReadonlyBytes { bytes.data() + index, bytes.size() - index };
-            if (auto message = LocalEndpoint::decode_message(remaining_bytes, m_socket->fd())) {
-                m_unprocessed_messages.append(message.release_nonnull());
-            } else if (auto message = PeerEndpoint::decode_message(remaining_bytes, m_socket->fd())) {
-                m_unprocessed_messages.append(message.release_nonnull());
-            } else {
-                dbgln("Failed to parse a message");
+            if (!decode_message(bytes, bytes.bytes().slice(index, message_size)))
                 break;
+        }
+
+        if (m_incoming_ring.has_value()) {
+            auto ring_bytes = move(m_unprocessed_ring_bytes);
+
+            // Anything written to the ring after this point comes with a wakeup.
+            m_incoming_ring->set_reader_waiting();
+            auto unprocessed_ring_size = ring_bytes.size();
+            if (!m_incoming_ring->read_all(ring_bytes)) {
+                shutdown();
+                return false;
             }
+            received_anything |= ring_bytes.size() > unprocessed_ring_size;
+
+            size_t ring_index = 0;
+            if (!decode_sequenced_messages(bytes, index, ring_bytes, ring_index)) {
+                shutdown();
+                return false;
+            }
+            if (ring_index < ring_bytes.size())
+                m_unprocessed_ring_bytes = ByteBuffer::copy(ring_bytes.data() + ring_index, ring_bytes.size() - ring_index);
+        }
+
+        if (received_anything) {
+            m_responsiveness_timer->stop();
+            did_become_responsive();
         }
 
         if (index < bytes.size()) {
@@ -269,6 +476,17 @@ protected:
     RefPtr<Core::Notifier> m_notifier;
     NonnullOwnPtrVector<Message> m_unprocessed_messages;
     ByteBuffer m_unprocessed_bytes;
+
+    // Present once the shared memory transport has been negotiated.
+    Optional<MessageRing> m_outgoing_ring;
+    Optional<MessageRing> m_incoming_ring;
+    Optional<MessageRing> m_pending_incoming_ring;
+    ByteBuffer m_unprocessed_ring_bytes;
+    u32 m_next_outgoing_sequence { 0 };
+    size_t m_messages_sent_through_ring { 0 };
+    u32 m_next_incoming_sequence { 0 };
+    bool m_batching { false };
+    bool m_wakeup_pending { false };
 };
 
 }
@@ -102,6 +102,14 @@ bool Decoder::decode(String& value)
     m_stream >> length;
     if (m_stream.handle_any_error())
         return false;
+    if (length == anonymous_payload_marker) {
+        ReadonlyBytes bytes;
+        if (!decode_anonymous_payload(bytes))
+            return false;
+        value = String { bytes };
+        m_anonymous_buffers.take_last();
+        return true;
+    }
     if (length < 0) {
         value = {};
         return true;
@@ -117,12 +125,67 @@ bool Decoder::decode(String& value)
     return !m_stream.handle_any_error();
 }
 
+bool Decoder::decode(StringView& value)
+{
+    i32 length = 0;
+    m_stream >> length;
+    if (m_stream.handle_any_error())
+        return false;
+    if (length == anonymous_payload_marker) {
+        ReadonlyBytes bytes;
+        if (!decode_anonymous_payload(bytes))
+            return false;
+        value = StringView { bytes.data(), bytes.size() };
+        return true;
+    }
+    if (length < 0) {
+        value = {};
+        return true;
+    }
+    if (m_stream.remaining() < static_cast<size_t>(length))
+        return false;
+    value = StringView { m_stream.bytes().offset(m_stream.offset()), static_cast<size_t>(length) };
+    return m_stream.discard_or_error(length);
+}
+
+bool Decoder::decode_anonymous_payload(ReadonlyBytes& value)
+{
+    Core::AnonymousBuffer buffer;
+    if (!IPC::decode(*this, buffer) || !buffer.is_valid())
+        return false;
+    value = { buffer.data<u8>(), buffer.size() };
+    m_anonymous_buffers.append(move(buffer));
+    return true;
+}
+
+bool Decoder::decode(ReadonlyBytes& value)
+{
+    i32 length = 0;
+    m_stream >> length;
+    if (m_stream.handle_any_error())
+        return false;
+    if (length == anonymous_payload_marker)
+        return decode_anonymous_payload(value);
+    if (length < 0 || m_stream.remaining() < static_cast<size_t>(length))
+        return false;
+    value = m_stream.bytes().slice(m_stream.offset(), length);
+    return m_stream.discard_or_error(length);
+}
+
 bool Decoder::decode(ByteBuffer& value)
 {
     i32 length = 0;
     m_stream >> length;
     if (m_stream.handle_any_error())
         return false;
+    if (length == anonymous_payload_marker) {
+        ReadonlyBytes bytes;
+        if (!decode_anonymous_payload(bytes))
+            return false;
+        value = ByteBuffer::copy(bytes.data(), bytes.size());
+        m_anonymous_buffers.take_last();
+        return true;
+    }
     if (length < 0) {
         value = {};
         return true;
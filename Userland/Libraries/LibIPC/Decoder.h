@@ -62,6 +62,10 @@ public:
     bool decode(float&);
     bool decode(String&);
     bool decode(ByteBuffer&);
+    // The views point into the decoded message (or one of the anonymous buffers
+    // taken from this decoder), and are only valid as long as that is kept alive.
+    bool decode(StringView&);
+    bool decode(ReadonlyBytes&);
     bool decode(URL&);
     bool decode(Dictionary&);
     bool decode(File&);
@@ -124,9 +128,14 @@ public:
         return true;
     }
 
+    Vector<Core::AnonymousBuffer> take_anonymous_buffers() { return move(m_anonymous_buffers); }
+
 private:
+    bool decode_anonymous_payload(ReadonlyBytes&);
+
     InputMemoryStream& m_stream;
     int m_sockfd { -1 };
+    Vector<Core::AnonymousBuffer> m_anonymous_buffers;
 };
 
 }
@@ -31,6 +31,7 @@
 #include <LibIPC/Dictionary.h>
 #include <LibIPC/Encoder.h>
 #include <LibIPC/File.h>
+#include <string.h>
 
 namespace IPC {
 
@@ -132,20 +133,35 @@ Encoder& Encoder::operator<<(const char* value)
 
 Encoder& Encoder::operator<<(const StringView& value)
 {
-    m_buffer.data.append((const u8*)value.characters_without_null_termination(), value.length());
-    return *this;
+    if (value.is_null())
+        return *this << (i32)-1;
+    return *this << ReadonlyBytes { (const u8*)value.characters_without_null_termination(), value.length() };
 }
 
 Encoder& Encoder::operator<<(const String& value)
 {
-    if (value.is_null())
-        return *this << (i32)-1;
-    *this << static_cast<i32>(value.length());
     return *this << value.view();
 }
 
 Encoder& Encoder::operator<<(const ByteBuffer& value)
 {
+    return *this << value.bytes();
+}
+
+Encoder& Encoder::operator<<(ReadonlyBytes value)
+{
+#ifdef __serenity__
+    if (value.size() >= anonymous_payload_threshold) {
+        auto buffer = Core::AnonymousBuffer::create_with_size(value.size());
+        if (buffer.is_valid()) {
+            memcpy(buffer.data<void>(), value.data(), value.size());
+            *this << anonymous_payload_marker;
+            *this << buffer;
+            m_buffer.anonymous_buffers.append(move(buffer));
+            return *this;
+        }
+    }
+#endif
     *this << static_cast<i32>(value.size());
     m_buffer.data.append(value.data(), value.size());
     return *this;
@@ -28,12 +28,20 @@
 
 #include <AK/Function.h>
 #include <AK/Vector.h>
+#include <LibCore/AnonymousBuffer.h>
 
 namespace IPC {
 
+// Byte buffers at least this large are passed to the peer in an anonymous buffer instead of
+// being copied through the socket. They are marked on the wire with a length of -2.
+static constexpr size_t anonymous_payload_threshold = 64 * KiB;
+static constexpr i32 anonymous_payload_marker = -2;
+
 struct MessageBuffer {
     Vector<u8, 1024> data;
     Vector<int> fds;
+    // Keeps the anonymous buffers behind some of the fds alive until they have been sent.
+    Vector<Core::AnonymousBuffer> anonymous_buffers;
 };
 
 class Message {
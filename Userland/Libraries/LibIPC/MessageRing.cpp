@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Debug.h>
+#include <LibIPC/MessageRing.h>
+#include <string.h>
+
+namespace IPC {
+
+Optional<MessageRing> MessageRing::create(size_t capacity)
+{
+    VERIFY(capacity && (capacity & (capacity - 1)) == 0);
+    auto buffer = Core::AnonymousBuffer::create_with_size(sizeof(Header) + capacity);
+    if (!buffer.is_valid())
+        return {};
+
+    // Anonymous memory starts out zeroed, so both offsets are already in place.
+    MessageRing ring(move(buffer));
+    ring.header().reader_waiting.store(1);
+    return ring;
+}
+
+Optional<MessageRing> MessageRing::create_from_anon_fd(int fd, size_t size)
+{
+    if (size <= sizeof(Header))
+        return {};
+    auto capacity = size - sizeof(Header);
+    if ((capacity & (capacity - 1)) != 0 || capacity > NumericLimits<u32>::max())
+        return {};
+
+    auto buffer = Core::AnonymousBuffer::create_from_anon_fd(fd, size);
+    if (!buffer.is_valid())
+        return {};
+    return MessageRing(move(buffer));
+}
+
+MessageRing::MessageRing(Core::AnonymousBuffer buffer)
+    : m_buffer(move(buffer))
+    , m_capacity(m_buffer.size() - sizeof(Header))
+{
+}
+
+bool MessageRing::try_write(ReadonlyBytes bytes)
+{
+    auto& header = this->header();
+    auto write_offset = header.write_offset.load(AK::MemoryOrder::memory_order_relaxed);
+    auto read_offset = header.read_offset.load(AK::MemoryOrder::memory_order_acquire);
+    auto used = write_offset - read_offset;
+    if (used > m_capacity || bytes.size() > m_capacity - used)
+        return false;
+
+    auto start = write_offset & (m_capacity - 1);
+    auto first_chunk_size = min<size_t>(bytes.size(), m_capacity - start);
+    memcpy(ring_data() + start, bytes.data(), first_chunk_size);
+    memcpy(ring_data(), bytes.data() + first_chunk_size, bytes.size() - first_chunk_size);
+
+    header.write_offset.store(write_offset + bytes.size(), AK::MemoryOrder::memory_order_seq_cst);
+    return true;
+}
+
+bool MessageRing::read_all(ByteBuffer& bytes)
+{
+    auto& header = this->header();
+    auto read_offset = header.read_offset.load(AK::MemoryOrder::memory_order_relaxed);
+    auto write_offset = header.write_offset.load(AK::MemoryOrder::memory_order_seq_cst);
+    auto available = write_offset - read_offset;
+    if (available > m_capacity) {
+        dbgln("MessageRing: Write offset {} is out of bounds (read offset {})", write_offset, read_offset);
+        return false;
+    }
+    if (!available)
+        return true;
+
+    auto start = read_offset & (m_capacity - 1);
+    auto first_chunk_size = min<size_t>(available, m_capacity - start);
+    auto old_size = bytes.size();
+    bytes.grow(old_size + available);
+    memcpy(bytes.data() + old_size, ring_data() + start, first_chunk_size);
+    memcpy(bytes.data() + old_size + first_chunk_size, ring_data(), available - first_chunk_size);
+
+    header.read_offset.store(write_offset, AK::MemoryOrder::memory_order_release);
+    return true;
+}
+
+void MessageRing::set_reader_waiting()
+{
+    header().reader_waiting.store(1, AK::MemoryOrder::memory_order_seq_cst);
+}
+
+bool MessageRing::take_reader_waiting()
+{
+    return header().reader_waiting.exchange(0, AK::MemoryOrder::memory_order_seq_cst);
+}
+
+}
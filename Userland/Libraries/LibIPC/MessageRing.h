@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/ByteBuffer.h>
+#include <AK/Optional.h>
+#include <AK/Span.h>
+#include <LibCore/AnonymousBuffer.h>
+
+namespace IPC {
+
+// A single-producer, single-consumer ring of bytes in memory that is shared
+// between the two ends of a connection, one per direction.
+//
+// The writer appends whole messages (or nothing, if they don't fit), the reader
+// takes everything that has been written so far. Neither side makes a syscall;
+// the writer only needs to wake up the reader (through the socket) if the reader
+// has announced that it is about to go to sleep, see take_reader_waiting().
+class MessageRing {
+public:
+    static constexpr size_t default_capacity = 64 * KiB;
+
+    static Optional<MessageRing> create(size_t capacity = default_capacity);
+    static Optional<MessageRing> create_from_anon_fd(int fd, size_t size);
+
+    int fd() const { return m_buffer.fd(); }
+    size_t size() const { return m_buffer.size(); }
+
+    bool try_write(ReadonlyBytes);
+
+    // Appends all bytes written so far to `bytes`. Returns false if the ring is corrupted.
+    bool read_all(ByteBuffer& bytes);
+
+    // The reader marks itself as waiting before it takes what is in the ring. The writer clears
+    // the mark after each write, and has to wake up the reader if it was set.
+    void set_reader_waiting();
+    bool take_reader_waiting();
+
+private:
+    struct Header {
+        // Both offsets only ever grow (and wrap around), so that a full ring can be told apart from an empty one.
+        alignas(64) Atomic<u32> write_offset;
+        alignas(64) Atomic<u32> read_offset;
+        alignas(64) Atomic<u32> reader_waiting;
+    };
+
+    explicit MessageRing(Core::AnonymousBuffer);
+
+    Header& header() { return *reinterpret_cast<Header*>(m_buffer.data<u8>()); }
+    u8* ring_data() { return m_buffer.data<u8>() + sizeof(Header); }
+
+    Core::AnonymousBuffer m_buffer;
+    u32 m_capacity { 0 };
+};
+
+}
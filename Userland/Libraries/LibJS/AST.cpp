@@ -31,9 +31,11 @@
 #include <AK/ScopeGuard.h>
 #include <AK/StringBuilder.h>
 #include <AK/TemporaryChange.h>
+#include <LibCore/ElapsedTimer.h>
 #include <LibCrypto/BigInt/SignedBigInteger.h>
 #include <LibJS/AST.h>
 #include <LibJS/Interpreter.h>
+#include <LibJS/Parser.h>
 #include <LibJS/Runtime/Accessor.h>
 #include <LibJS/Runtime/Array.h>
 #include <LibJS/Runtime/BigInt.h>
@@ -109,6 +111,35 @@ Value Program::execute(Interpreter& interpreter, GlobalObject& global_object) co
     return interpreter.execute_statement(global_object, *this, ScopeType::Block);
 }
 
+Value LazyFunctionBody::execute(Interpreter&, GlobalObject&) const
+{
+    // ScriptFunction parses the body before executing it.
+    VERIFY_NOT_REACHED();
+}
+
+Lexer LazyFunctionBody::lexer() const
+{
+    auto& start = source_range().start;
+    return Lexer(m_source->source().substring_view(m_offset), m_source->filename(), start.line, start.column - 1);
+}
+
+RefPtr<BlockStatement> LazyFunctionBody::parsed_body()
+{
+    if (m_parsed_body || !m_parse_error.is_null())
+        return m_parsed_body;
+
+    Core::ElapsedTimer timer(true);
+    timer.start();
+    Parser parser(lexer());
+    auto body = parser.parse_lazy_function_body(*this);
+    if (parser.has_errors())
+        m_parse_error = parser.errors()[0].to_string();
+    else
+        m_parsed_body = move(body);
+    m_source->did_compile_function(timer.elapsed_microseconds(), parser.ast_node_bytes());
+    return m_parsed_body;
+}
+
 Value FunctionDeclaration::execute(Interpreter& interpreter, GlobalObject&) const
 {
     interpreter.enter_node(*this);
@@ -928,6 +959,13 @@ void ScopeNode::dump(int indent) const
     }
 }
 
+void LazyFunctionBody::dump(int indent) const
+{
+    ASTNode::dump(indent);
+    print_indent(indent + 1);
+    outln("(Not parsed yet, {} bytes into the source)", m_offset);
+}
+
 void BinaryExpression::dump(int indent) const
 {
     const char* op_string = nullptr;
@@ -179,6 +179,90 @@ public:
     }
 };
 
+// The source of a program parsed with lazy function compilation. Lazily compiled function bodies are parsed from here.
+class PreparsedSource : public RefCounted<PreparsedSource> {
+public:
+    static NonnullRefPtr<PreparsedSource> create(StringView source, StringView filename)
+    {
+        return adopt(*new PreparsedSource(source, filename));
+    }
+
+    const String& source() const { return m_source; }
+    const String& filename() const { return m_filename; }
+
+    void did_preparse_function() { ++m_preparsed_function_count; }
+    void did_compile_function(u64 parse_time_us, size_t ast_node_bytes)
+    {
+        ++m_compiled_function_count;
+        m_compile_time_us += parse_time_us;
+        m_compile_ast_node_bytes += ast_node_bytes;
+    }
+
+    size_t preparsed_function_count() const { return m_preparsed_function_count; }
+    size_t compiled_function_count() const { return m_compiled_function_count; }
+    u64 compile_time_us() const { return m_compile_time_us; }
+    size_t compile_ast_node_bytes() const { return m_compile_ast_node_bytes; }
+
+private:
+    PreparsedSource(StringView source, StringView filename)
+        : m_source(source)
+        , m_filename(filename)
+    {
+    }
+
+    String m_source;
+    String m_filename;
+    size_t m_preparsed_function_count { 0 };
+    size_t m_compiled_function_count { 0 };
+    u64 m_compile_time_us { 0 };
+    size_t m_compile_ast_node_bytes { 0 };
+};
+
+// The body of a function that has only been skipped over so far. The source range starts at the
+// body's opening curly brace; ScriptFunction asks for the parsed body the first time it's called.
+class LazyFunctionBody final : public Statement {
+public:
+    // The parser state at the start of the body that parsing it depends on.
+    struct Context {
+        bool strict_mode { false };
+        bool allow_super_property_lookup { false };
+        bool allow_super_constructor_call { false };
+        bool in_arrow_function_context { false };
+        bool in_break_context { false };
+        bool in_continue_context { false };
+    };
+
+    LazyFunctionBody(SourceRange source_range, NonnullRefPtr<PreparsedSource> source, size_t offset, Context context)
+        : Statement(move(source_range))
+        , m_source(move(source))
+        , m_offset(offset)
+        , m_context(context)
+    {
+    }
+
+    virtual Value execute(Interpreter&, GlobalObject&) const override;
+    virtual void dump(int indent) const override;
+
+    const PreparsedSource& source() const { return m_source; }
+    PreparsedSource& source() { return m_source; }
+    size_t offset() const { return m_offset; }
+    const Context& context() const { return m_context; }
+
+    // A lexer positioned at the start of the body, for Parser::parse_lazy_function_body().
+    Lexer lexer() const;
+
+    // Parses the body the first time it's called. Returns null if that failed, see parse_error().
+    RefPtr<BlockStatement> parsed_body();
+    const String& parse_error() const { return m_parse_error; }
+
+private:
+    NonnullRefPtr<PreparsedSource> m_source;
+    size_t m_offset { 0 };
+    Context m_context;
+    RefPtr<BlockStatement> m_parsed_body;
+    String m_parse_error;
+};
+
 class Expression : public ASTNode {
 public:
     Expression(SourceRange source_range)
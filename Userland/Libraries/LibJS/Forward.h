@@ -134,6 +134,7 @@ class HandleImpl;
 class Heap;
 class HeapBlock;
 class Interpreter;
+class Lexer;
 class LexicalEnvironment;
 class MarkedValueList;
 class NativeFunction;
@@ -143,6 +144,7 @@ class PropertyName;
 class Reference;
 class ScopeNode;
 class ScopeObject;
+class ScriptFunction;
 class Shape;
 class Statement;
 class Symbol;
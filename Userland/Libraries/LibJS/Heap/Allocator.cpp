@@ -26,6 +26,7 @@
 
 #include <AK/Badge.h>
 #include <LibJS/Heap/Allocator.h>
+#include <LibJS/Heap/Heap.h>
 #include <LibJS/Heap/HeapBlock.h>
 
 namespace JS {
@@ -41,14 +42,22 @@ Allocator::~Allocator()
 
 Cell* Allocator::allocate_cell(Heap& heap)
 {
+    while (m_usable_blocks.is_empty() && !m_unswept_blocks.is_empty())
+        sweep_block(heap, *m_unswept_blocks.first());
+
     if (m_usable_blocks.is_empty()) {
         auto block = HeapBlock::create_with_cell_size(heap, m_cell_size);
+        heap.did_create_block({}, *block);
         m_usable_blocks.append(*block.leak_ptr());
     }
 
     auto& block = *m_usable_blocks.last();
     auto* cell = block.allocate();
     VERIFY(cell);
+    if (!block.has_young_cells()) {
+        block.set_has_young_cells(true);
+        m_nursery_blocks.append(&block);
+    }
     if (block.is_full())
         m_full_blocks.append(*m_usable_blocks.last());
     return cell;
@@ -60,10 +69,45 @@ void Allocator::block_did_become_empty(Badge<Heap>, HeapBlock& block)
     delete &block;
 }
 
+void Allocator::did_collect_garbage(Badge<Heap>)
+{
+    for (auto* block : m_nursery_blocks)
+        block->set_has_young_cells(false);
+    m_nursery_blocks.clear_with_capacity();
+}
+
 void Allocator::block_did_become_usable(Badge<Heap>, HeapBlock& block)
 {
     VERIFY(!block.is_full());
     m_usable_blocks.append(block);
 }
 
+void Allocator::begin_lazy_sweep(Badge<Heap>)
+{
+    // Nothing may be allocated from a block until it has been swept, since its unmarked cells are garbage.
+    while (!m_full_blocks.is_empty())
+        m_unswept_blocks.append(*m_full_blocks.first());
+    while (!m_usable_blocks.is_empty())
+        m_unswept_blocks.append(*m_usable_blocks.first());
+}
+
+void Allocator::finish_sweeping(Heap& heap)
+{
+    while (!m_unswept_blocks.is_empty())
+        sweep_block(heap, *m_unswept_blocks.first());
+}
+
+void Allocator::sweep_block(Heap& heap, HeapBlock& block)
+{
+    if (!heap.sweep_block({}, block)) {
+        heap.will_destroy_block({}, block);
+        block.m_list_node.remove();
+        delete &block;
+    } else if (block.is_full()) {
+        m_full_blocks.append(block);
+    } else {
+        m_usable_blocks.append(block);
+    }
+}
+
 }
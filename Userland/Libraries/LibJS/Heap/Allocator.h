@@ -54,18 +54,42 @@ public:
             if (callback(block) == IterationDecision::Break)
                 return IterationDecision::Break;
         }
+        for (auto& block : m_unswept_blocks) {
+            if (callback(block) == IterationDecision::Break)
+                return IterationDecision::Break;
+        }
         return IterationDecision::Continue;
     }
 
+    // Blocks that have handed out cells since the last collection. Only these can contain young cells.
+    template<typename Callback>
+    void for_each_nursery_block(Callback callback)
+    {
+        for (auto* block : m_nursery_blocks)
+            callback(*block);
+    }
+
     void block_did_become_empty(Badge<Heap>, HeapBlock&);
     void block_did_become_usable(Badge<Heap>, HeapBlock&);
+    void did_collect_garbage(Badge<Heap>);
+
+    // Lazy sweeping: after marking, every block is put aside and swept only when
+    // this allocator runs out of usable blocks, or when the heap needs it to be done.
+    void begin_lazy_sweep(Badge<Heap>);
+    bool has_unswept_blocks() const { return !m_unswept_blocks.is_empty(); }
+    void finish_sweeping(Heap&);
 
 private:
+    void sweep_block(Heap&, HeapBlock&);
+
     const size_t m_cell_size;
 
+    Vector<HeapBlock*> m_nursery_blocks;
+
     typedef IntrusiveList<HeapBlock, &HeapBlock::m_list_node> BlockList;
     BlockList m_full_blocks;
     BlockList m_usable_blocks;
+    BlockList m_unswept_blocks;
 };
 
 }
@@ -69,17 +69,76 @@ ALWAYS_INLINE Allocator& Heap::allocator_for_size(size_t cell_size)
 
 Cell* Heap::allocate_cell(size_t size)
 {
-    if (should_collect_on_every_allocation()) {
-        collect_garbage();
+    if (m_incremental_marking_in_progress) {
+        ++m_allocations_since_marking_started;
+        if (should_collect_on_every_allocation() || ++m_allocations_since_last_marking_step >= 256)
+            perform_incremental_marking_step();
+    } else if (should_collect_on_every_allocation()) {
+        collect_garbage_for_allocation();
     } else if (m_allocations_since_last_gc > m_max_allocations_between_gc) {
         m_allocations_since_last_gc = 0;
-        collect_garbage();
+        collect_garbage_for_allocation();
     } else {
         ++m_allocations_since_last_gc;
     }
 
     auto& allocator = allocator_for_size(size);
-    return allocator.allocate_cell(*this);
+    if (!allocator.has_unswept_blocks())
+        return allocator.allocate_cell(*this);
+
+    Core::ElapsedTimer sweep_timer(true);
+    sweep_timer.start();
+    auto* cell = allocator.allocate_cell(*this);
+    auto time_spent = sweep_timer.elapsed_microseconds();
+    ++m_statistics.lazy_sweeps;
+    m_statistics.lazy_sweep_time_us += time_spent;
+    return cell;
+}
+
+void Heap::collect_garbage_for_allocation()
+{
+    // Whether a minor collection is possible depends on the previous collection having been swept completely.
+    finish_sweeping();
+
+    auto collection_type = collection_type_for_allocation();
+    if (collection_type == CollectionType::CollectGarbage && m_incremental && !m_gc_deferrals)
+        start_incremental_marking();
+    else
+        collect_garbage(collection_type);
+}
+
+Heap::CollectionType Heap::collection_type_for_allocation() const
+{
+    if (!m_generational || !m_can_collect_young_generation)
+        return CollectionType::CollectGarbage;
+
+    // Promoted cells are only reclaimed by full collections, so do one whenever
+    // the old generation has grown by as much as it contained after the last one.
+    if (m_cells_promoted_since_last_major_gc > max(m_old_cells_after_last_major_gc, m_max_allocations_between_gc))
+        return CollectionType::CollectGarbage;
+    return CollectionType::CollectYoungGarbage;
+}
+
+void Heap::set_generational(bool generational)
+{
+    VERIFY(!m_collecting_garbage);
+    if (m_generational == generational)
+        return;
+    m_generational = generational;
+
+    // Cells that survived collections in the other mode are neither young nor properly remembered,
+    // so the next collection has to be a full one.
+    m_can_collect_young_generation = false;
+}
+
+void Heap::set_incremental(bool incremental)
+{
+    VERIFY(!m_collecting_garbage);
+    if (m_incremental == incremental)
+        return;
+    if (!incremental && m_incremental_marking_in_progress)
+        collect_garbage();
+    m_incremental = incremental;
 }
 
 void Heap::collect_garbage(CollectionType collection_type, bool print_report)
@@ -87,18 +146,77 @@ void Heap::collect_garbage(CollectionType collection_type, bool print_report)
     VERIFY(!m_collecting_garbage);
     TemporaryChange change(m_collecting_garbage, true);
 
-    Core::ElapsedTimer collection_measurement_timer;
+    Core::ElapsedTimer collection_measurement_timer(true);
     collection_measurement_timer.start();
-    if (collection_type == CollectionType::CollectGarbage) {
-        if (m_gc_deferrals) {
-            m_should_gc_when_deferral_ends = true;
-            return;
-        }
-        HashTable<Cell*> roots;
-        gather_roots(roots);
+    if (collection_type == CollectionType::CollectEverything) {
+        finish_sweeping();
+        m_incremental_marking_in_progress = false;
+        m_marking_work_list.clear();
+        m_marked_cells_without_write_barriers.clear();
+        for_each_block([&](auto& block) {
+            block.for_each_cell([](Cell* cell) {
+                cell->set_marked(false);
+            });
+            return IterationDecision::Continue;
+        });
+        sweep_dead_cells(print_report, collection_measurement_timer);
+        return;
+    }
+
+    if (m_gc_deferrals) {
+        if (!m_should_gc_when_deferral_ends || collection_type == CollectionType::CollectGarbage)
+            m_deferred_collection_type = collection_type;
+        m_should_gc_when_deferral_ends = true;
+        return;
+    }
+
+    if (m_incremental_marking_in_progress) {
+        // Whatever was asked for, the marking that is already underway has to be finished first.
+        finish_incremental_marking(collection_measurement_timer);
+        finish_sweeping();
+        auto time_spent = collection_measurement_timer.elapsed_microseconds();
+        ++m_statistics.major_collections;
+        m_statistics.major_collection_time_us += time_spent;
+        m_statistics.max_major_collection_time_us = max(m_statistics.max_major_collection_time_us, time_spent);
+        record_pause(time_spent);
+        return;
+    }
+
+    finish_sweeping();
+    if (collection_type == CollectionType::CollectYoungGarbage && (!m_generational || !m_can_collect_young_generation))
+        collection_type = CollectionType::CollectGarbage;
+
+    HashTable<Cell*> roots;
+    gather_roots(roots);
+
+    if (collection_type == CollectionType::CollectYoungGarbage) {
+        mark_young_cells(roots);
+        sweep_young_cells(print_report, collection_measurement_timer);
+    } else {
         mark_live_cells(roots);
+        sweep_dead_cells(print_report, collection_measurement_timer);
     }
-    sweep_dead_cells(print_report, collection_measurement_timer);
+    rebuild_remembered_set(roots);
+
+    auto time_spent = collection_measurement_timer.elapsed_microseconds();
+    if (collection_type == CollectionType::CollectYoungGarbage) {
+        ++m_statistics.minor_collections;
+        m_statistics.minor_collection_time_us += time_spent;
+        m_statistics.max_minor_collection_time_us = max(m_statistics.max_minor_collection_time_us, time_spent);
+    } else {
+        ++m_statistics.major_collections;
+        m_statistics.major_collection_time_us += time_spent;
+        m_statistics.max_major_collection_time_us = max(m_statistics.max_major_collection_time_us, time_spent);
+    }
+    record_pause(time_spent);
+}
+
+void Heap::record_pause(u64 time_spent_us)
+{
+    size_t bucket = 0;
+    while (bucket < pause_histogram_bucket_count - 1 && time_spent_us >= pause_histogram_bucket_limit_us(bucket))
+        ++bucket;
+    ++m_statistics.pause_histogram[bucket];
 }
 
 void Heap::gather_roots(HashTable<Cell*>& roots)
@@ -149,12 +267,6 @@ __attribute__((no_sanitize("address"))) void Heap::gather_conservative_roots(Has
         possible_pointers.set(data);
     }
 
-    HashTable<HeapBlock*> all_live_heap_blocks;
-    for_each_block([&](auto& block) {
-        all_live_heap_blocks.set(&block);
-        return IterationDecision::Continue;
-    });
-
     for (auto possible_pointer : possible_pointers) {
         if (!possible_pointer)
             continue;
@@ -162,7 +274,7 @@ __attribute__((no_sanitize("address"))) void Heap::gather_conservative_roots(Has
         dbgln("  ? {}", (const void*)possible_pointer);
 #endif
         auto* possible_heap_block = HeapBlock::from_cell(reinterpret_cast<const Cell*>(possible_pointer));
-        if (all_live_heap_blocks.contains(possible_heap_block)) {
+        if (m_blocks.contains(possible_heap_block)) {
             if (auto* cell = possible_heap_block->cell_from_possible_pointer(possible_pointer)) {
                 if (cell->is_live()) {
 #if HEAP_DEBUG
@@ -181,7 +293,10 @@ __attribute__((no_sanitize("address"))) void Heap::gather_conservative_roots(Has
 
 class MarkingVisitor final : public Cell::Visitor {
 public:
-    MarkingVisitor() { }
+    explicit MarkingVisitor(Vector<Cell*>& work_list)
+        : m_work_list(work_list)
+    {
+    }
 
     virtual void visit_impl(Cell* cell)
     {
@@ -191,8 +306,11 @@ public:
         dbgln("  ! {}", cell);
 #endif
         cell->set_marked(true);
-        cell->visit_edges(*this);
+        m_work_list.append(cell);
     }
+
+private:
+    Vector<Cell*>& m_work_list;
 };
 
 void Heap::mark_live_cells(const HashTable<Cell*>& roots)
@@ -200,65 +318,201 @@ void Heap::mark_live_cells(const HashTable<Cell*>& roots)
 #if HEAP_DEBUG
     dbgln("mark_live_cells:");
 #endif
-    MarkingVisitor visitor;
+    MarkingVisitor visitor(m_marking_work_list);
     for (auto* root : roots)
         visitor.visit(root);
+
+    Core::ElapsedTimer timer;
+    drain_marking_work_list(timer, {});
 }
 
-void Heap::sweep_dead_cells(bool print_report, const Core::ElapsedTimer& measurement_timer)
+bool Heap::drain_marking_work_list(const Core::ElapsedTimer& timer, Optional<u64> deadline_us)
 {
+    MarkingVisitor visitor(m_marking_work_list);
+    size_t visited_cells = 0;
+    while (!m_marking_work_list.is_empty()) {
+        // Checking the clock is comparatively expensive, so only do it every so often.
+        if (deadline_us.has_value() && (++visited_cells % 128) == 0 && timer.elapsed_microseconds() >= deadline_us.value())
+            return false;
+        auto* cell = m_marking_work_list.take_last();
+        if (m_incremental_marking_in_progress && !cell->has_write_barriers())
+            m_marked_cells_without_write_barriers.append(cell);
+        cell->visit_edges(visitor);
+    }
+    return true;
+}
+
+void Heap::start_incremental_marking()
+{
+    VERIFY(!m_collecting_garbage);
+    VERIFY(!m_incremental_marking_in_progress);
+    TemporaryChange change(m_collecting_garbage, true);
+
+    Core::ElapsedTimer timer(true);
+    timer.start();
+
+    finish_sweeping();
+
 #if HEAP_DEBUG
-    dbgln("sweep_dead_cells:");
+    dbgln("start_incremental_marking:");
 #endif
-    Vector<HeapBlock*, 32> empty_blocks;
-    Vector<HeapBlock*, 32> full_blocks_that_became_usable;
+    m_incremental_marking_in_progress = true;
+    m_allocations_since_last_marking_step = 0;
+    m_allocations_since_marking_started = 0;
 
-    size_t collected_cells = 0;
-    size_t live_cells = 0;
-    size_t collected_cell_bytes = 0;
-    size_t live_cell_bytes = 0;
+    HashTable<Cell*> roots;
+    gather_roots(roots);
+    MarkingVisitor visitor(m_marking_work_list);
+    for (auto* root : roots)
+        visitor.visit(root);
 
-    for_each_block([&](auto& block) {
-        bool block_has_live_cells = false;
-        bool block_was_full = block.is_full();
-        block.for_each_cell([&](Cell* cell) {
-            if (cell->is_live()) {
-                if (!cell->is_marked()) {
+    auto time_spent = timer.elapsed_microseconds();
+    ++m_statistics.incremental_marking_steps;
+    m_statistics.incremental_marking_time_us += time_spent;
+    m_statistics.max_incremental_marking_step_time_us = max(m_statistics.max_incremental_marking_step_time_us, time_spent);
+    record_pause(time_spent);
+}
+
+void Heap::perform_incremental_marking_step()
+{
+    VERIFY(m_incremental_marking_in_progress);
+    if (m_collecting_garbage)
+        return;
+    if (m_gc_deferrals) {
+        m_should_gc_when_deferral_ends = true;
+        return;
+    }
+    TemporaryChange change(m_collecting_garbage, true);
+    m_allocations_since_last_marking_step = 0;
+
+    Core::ElapsedTimer timer(true);
+    timer.start();
+
+    // Native code further up the stack may have passed a write barrier on a cell while it was still white,
+    // and store a reference into it once this step has turned it black. Those cells are scanned again at the end.
+    HashTable<Cell*> stack_roots;
+    gather_conservative_roots(stack_roots);
+    MarkingVisitor visitor(m_marking_work_list);
+    for (auto* cell : stack_roots) {
+        visitor.visit(cell);
+        if (!cell->is_remembered())
+            remember_cell(*cell);
+    }
+
+    // If the program allocates faster than we can mark, give up on bounding the pause.
+    bool out_of_time = m_allocations_since_marking_started > m_max_allocations_between_gc * 4;
+    if (!out_of_time && !drain_marking_work_list(timer, m_max_pause_time_us)) {
+        auto time_spent = timer.elapsed_microseconds();
+        ++m_statistics.incremental_marking_steps;
+        m_statistics.incremental_marking_time_us += time_spent;
+        m_statistics.max_incremental_marking_step_time_us = max(m_statistics.max_incremental_marking_step_time_us, time_spent);
+        record_pause(time_spent);
+        return;
+    }
+
+    finish_incremental_marking(timer);
+
+    auto time_spent = timer.elapsed_microseconds();
+    ++m_statistics.major_collections;
+    m_statistics.major_collection_time_us += time_spent;
+    m_statistics.max_major_collection_time_us = max(m_statistics.max_major_collection_time_us, time_spent);
+    record_pause(time_spent);
+}
+
+void Heap::finish_incremental_marking(const Core::ElapsedTimer& timer)
+{
 #if HEAP_DEBUG
-                    dbgln("  ~ {}", cell);
+    dbgln("finish_incremental_marking:");
 #endif
-                    block.deallocate(cell);
-                    ++collected_cells;
-                    collected_cell_bytes += block.cell_size();
-                } else {
-                    cell->set_marked(false);
-                    block_has_live_cells = true;
-                    ++live_cells;
-                    live_cell_bytes += block.cell_size();
-                }
-            }
-        });
-        if (!block_has_live_cells)
-            empty_blocks.append(&block);
-        else if (block_was_full != block.is_full())
-            full_blocks_that_became_usable.append(&block);
-        return IterationDecision::Continue;
-    });
+    VERIFY(m_incremental_marking_in_progress);
 
-    for (auto* block : empty_blocks) {
+    // Every root, remembered cell and marked cell without write barriers may have had references
+    // stored into it after it was scanned, so all of them are scanned once more.
+    HashTable<Cell*> roots;
+    gather_roots(roots);
+
+    MarkingVisitor visitor(m_marking_work_list);
+    for (auto* root : roots) {
+        if (!root)
+            continue;
+        if (root->is_marked())
+            m_marking_work_list.append(root);
+        else
+            visitor.visit(root);
+    }
+    drain_marking_work_list(timer, {});
+
+    for (auto* cell : m_remembered_cells) {
+        if (cell->is_marked())
+            m_marking_work_list.append(cell);
+    }
+    drain_marking_work_list(timer, {});
+
+    // Scanning a cell without write barriers appends it to the list again, so take it first.
+    auto cells_without_write_barriers = move(m_marked_cells_without_write_barriers);
+    m_marking_work_list.append(cells_without_write_barriers.data(), cells_without_write_barriers.size());
+    drain_marking_work_list(timer, {});
+
+    m_incremental_marking_in_progress = false;
+    m_marked_cells_without_write_barriers.clear();
+
+    begin_sweep();
+    rebuild_remembered_set(roots);
+}
+
+class YoungMarkingVisitor final : public Cell::Visitor {
+public:
+    explicit YoungMarkingVisitor(Vector<Cell*>& work_list)
+        : m_work_list(work_list)
+    {
+    }
+
+    virtual void visit_impl(Cell* cell)
+    {
+        if (cell->is_old() || cell->is_marked())
+            return;
 #if HEAP_DEBUG
-        dbgln(" - HeapBlock empty @ {}: cell_size={}", block, block->cell_size());
+        dbgln("  ! {}", cell);
 #endif
-        allocator_for_size(block->cell_size()).block_did_become_empty({}, *block);
+        cell->set_marked(true);
+        m_work_list.append(cell);
     }
 
-    for (auto* block : full_blocks_that_became_usable) {
+private:
+    Vector<Cell*>& m_work_list;
+};
+
+void Heap::mark_young_cells(const HashTable<Cell*>& roots)
+{
 #if HEAP_DEBUG
-        dbgln(" - HeapBlock usable again @ {}: cell_size={}", block, block->cell_size());
+    dbgln("mark_young_cells:");
 #endif
-        allocator_for_size(block->cell_size()).block_did_become_usable({}, *block);
+    YoungMarkingVisitor visitor(m_marking_work_list);
+    for (auto* root : roots) {
+        if (root && root->is_old())
+            root->visit_edges(visitor);
+        else
+            visitor.visit(root);
     }
 
+    for (auto* cell : m_remembered_cells)
+        cell->visit_edges(visitor);
+
+    for (auto* cell : m_old_cells_without_write_barriers)
+        cell->visit_edges(visitor);
+
+    while (!m_marking_work_list.is_empty())
+        m_marking_work_list.take_last()->visit_edges(visitor);
+}
+
+void Heap::sweep_dead_cells(bool print_report, const Core::ElapsedTimer& measurement_timer)
+{
+#if HEAP_DEBUG
+    dbgln("sweep_dead_cells:");
+#endif
+    begin_sweep();
+    finish_sweeping();
+
 #if HEAP_DEBUG
     for_each_block([&](auto& block) {
         dbgln(" > Live HeapBlock @ {}: cell_size={}", &block, block.cell_size());
@@ -278,14 +532,236 @@ void Heap::sweep_dead_cells(bool print_report, const Core::ElapsedTimer& measure
         dbgln("Garbage collection report");
         dbgln("=============================================");
         dbgln("     Time spent: {} ms", time_spent);
-        dbgln("     Live cells: {} ({} bytes)", live_cells, live_cell_bytes);
-        dbgln("Collected cells: {} ({} bytes)", collected_cells, collected_cell_bytes);
+        dbgln("     Live cells: {} ({} bytes)", m_sweep_counts.live_cells, m_sweep_counts.live_cell_bytes);
+        dbgln("Collected cells: {} ({} bytes)", m_sweep_counts.collected_cells, m_sweep_counts.collected_cell_bytes);
         dbgln("    Live blocks: {} ({} bytes)", live_block_count, live_block_count * HeapBlock::block_size);
+        dbgln("   Freed blocks: {} ({} bytes)", m_sweep_counts.freed_blocks, m_sweep_counts.freed_blocks * HeapBlock::block_size);
+        dbgln("=============================================");
+    }
+}
+
+void Heap::begin_sweep()
+{
+    VERIFY(!m_sweep_pending);
+    revoke_weak_references(false);
+
+    // The remembered sets are rebuilt from the survivors while sweeping, and from the roots afterwards.
+    for (auto* cell : m_remembered_cells)
+        cell->set_remembered(false);
+    m_remembered_cells.clear_with_capacity();
+    m_old_cells_without_write_barriers.clear_with_capacity();
+
+    for (auto& allocator : m_allocators) {
+        allocator->did_collect_garbage({});
+        allocator->begin_lazy_sweep({});
+    }
+
+    m_sweep_counts = {};
+    m_sweep_pending = true;
+    m_can_collect_young_generation = false;
+}
+
+void Heap::finish_sweeping()
+{
+    if (!m_sweep_pending)
+        return;
+#if HEAP_DEBUG
+    dbgln("finish_sweeping:");
+#endif
+    for (auto& allocator : m_allocators)
+        allocator->finish_sweeping(*this);
+
+    m_sweep_pending = false;
+    m_can_collect_young_generation = m_generational;
+    m_old_cells_after_last_major_gc = m_generational ? m_sweep_counts.live_cells : 0;
+    m_cells_promoted_since_last_major_gc = 0;
+}
+
+void Heap::revoke_weak_references(bool only_young_cells)
+{
+    // A dead cell may stay in its block until long after this collection, but nothing may find it again.
+    size_t surviving_cell_count = 0;
+    for (auto* cell : m_weakly_referenced_cells) {
+        if (cell->is_marked() || (only_young_cells && cell->is_old())) {
+            m_weakly_referenced_cells[surviving_cell_count++] = cell;
+            continue;
+        }
+        cell->revoke_weak_references();
+    }
+    m_weakly_referenced_cells.shrink(surviving_cell_count, true);
+}
+
+bool Heap::sweep_block(Badge<Allocator>, HeapBlock& block)
+{
+    VERIFY(m_sweep_pending);
+    bool block_has_live_cells = false;
+    block.for_each_cell([&](Cell* cell) {
+        if (!cell->is_live())
+            return;
+        if (!cell->is_marked()) {
+#if HEAP_DEBUG
+            dbgln("  ~ {}", cell);
+#endif
+            block.deallocate(cell);
+            ++m_sweep_counts.collected_cells;
+            m_sweep_counts.collected_cell_bytes += block.cell_size();
+            ++m_statistics.collected_cells;
+            return;
+        }
+        cell->set_marked(false);
+        if (m_generational) {
+            if (!cell->is_old())
+                did_promote_cell(*cell);
+            else if (!cell->has_write_barriers())
+                m_old_cells_without_write_barriers.append(cell);
+        } else {
+            cell->set_old(false);
+            cell->set_remembered(false);
+        }
+        block_has_live_cells = true;
+        ++m_sweep_counts.live_cells;
+        m_sweep_counts.live_cell_bytes += block.cell_size();
+    });
+
+    if (!block_has_live_cells) {
+#if HEAP_DEBUG
+        dbgln(" - HeapBlock empty @ {}: cell_size={}", &block, block.cell_size());
+#endif
+        ++m_sweep_counts.freed_blocks;
+    }
+    return block_has_live_cells;
+}
+
+void Heap::sweep_young_cells(bool print_report, const Core::ElapsedTimer& measurement_timer)
+{
+#if HEAP_DEBUG
+    dbgln("sweep_young_cells:");
+#endif
+    revoke_weak_references(true);
+
+    Vector<HeapBlock*, 32> empty_blocks;
+    Vector<HeapBlock*, 32> full_blocks_that_became_usable;
+
+    size_t collected_cells = 0;
+    size_t promoted_cells = 0;
+    size_t nursery_block_count = 0;
+
+    for (auto& allocator : m_allocators) {
+        allocator->for_each_nursery_block([&](auto& block) {
+            ++nursery_block_count;
+            bool block_has_live_cells = false;
+            bool block_was_full = block.is_full();
+            block.for_each_cell([&](Cell* cell) {
+                if (!cell->is_live())
+                    return;
+                if (cell->is_old()) {
+                    block_has_live_cells = true;
+                    return;
+                }
+                if (!cell->is_marked()) {
+#if HEAP_DEBUG
+                    dbgln("  ~ {}", cell);
+#endif
+                    block.deallocate(cell);
+                    ++collected_cells;
+                    return;
+                }
+                cell->set_marked(false);
+                did_promote_cell(*cell);
+                block_has_live_cells = true;
+                ++promoted_cells;
+            });
+            if (!block_has_live_cells)
+                empty_blocks.append(&block);
+            else if (block_was_full != block.is_full())
+                full_blocks_that_became_usable.append(&block);
+        });
+        allocator->did_collect_garbage({});
+    }
+
+    m_statistics.collected_cells += collected_cells;
+
+    for (auto* block : empty_blocks) {
+        m_blocks.remove(block);
+        allocator_for_size(block->cell_size()).block_did_become_empty({}, *block);
+    }
+
+    for (auto* block : full_blocks_that_became_usable)
+        allocator_for_size(block->cell_size()).block_did_become_usable({}, *block);
+
+    if (print_report) {
+        dbgln("Minor garbage collection report");
+        dbgln("=============================================");
+        dbgln("     Time spent: {} us", measurement_timer.elapsed_microseconds());
+        dbgln("  Nursery blocks: {}", nursery_block_count);
+        dbgln(" Promoted cells: {}", promoted_cells);
+        dbgln("Collected cells: {}", collected_cells);
+        dbgln("Remembered cells: {} (+{} without write barriers)", m_remembered_cells.size(), m_old_cells_without_write_barriers.size());
         dbgln("   Freed blocks: {} ({} bytes)", empty_blocks.size(), empty_blocks.size() * HeapBlock::block_size);
         dbgln("=============================================");
     }
 }
 
+void Heap::did_promote_cell(Cell& cell)
+{
+    cell.set_old(true);
+    ++m_cells_promoted_since_last_major_gc;
+    ++m_statistics.promoted_cells;
+    if (!cell.has_write_barriers()) {
+        cell.set_remembered(true);
+        m_old_cells_without_write_barriers.append(&cell);
+    }
+}
+
+void Heap::rebuild_remembered_set(const HashTable<Cell*>& roots)
+{
+    // After a collection, no old cell points to a young one, except for writes that are still in flight:
+    // native code may have passed a write barrier while the cell was young, and it's still holding on to it.
+    for (auto* cell : m_remembered_cells)
+        cell->set_remembered(false);
+    m_remembered_cells.clear_with_capacity();
+
+    if (!m_generational)
+        return;
+
+    for (auto* root : roots) {
+        if (!root || root->is_remembered())
+            continue;
+        remember_cell(*root);
+    }
+}
+
+void Heap::remember_cell(Cell& cell)
+{
+    VERIFY(!cell.is_remembered());
+    cell.set_remembered(true);
+    m_remembered_cells.append(&cell);
+}
+
+void Heap::did_write_to_cell(Badge<Cell>, Cell& cell)
+{
+    // Marked cells that haven't been swept yet will become old once they are.
+    bool may_point_to_young_cell = m_generational && (cell.is_old() || cell.is_marked());
+    bool may_point_to_white_cell = m_incremental_marking_in_progress && cell.is_marked();
+    if (may_point_to_young_cell || may_point_to_white_cell)
+        remember_cell(cell);
+}
+
+void Heap::did_create_block(Badge<Allocator>, HeapBlock& block)
+{
+    m_blocks.set(&block);
+}
+
+void Heap::will_destroy_block(Badge<Allocator>, HeapBlock& block)
+{
+    m_blocks.remove(&block);
+}
+
+void Heap::did_create_weakly_referenced_cell(Badge<Cell>, Cell& cell)
+{
+    m_weakly_referenced_cells.append(&cell);
+}
+
 void Heap::did_create_handle(Badge<HandleImpl>, HandleImpl& impl)
 {
     VERIFY(!m_handles.contains(&impl));
@@ -321,8 +797,12 @@ void Heap::undefer_gc(Badge<DeferGC>)
     --m_gc_deferrals;
 
     if (!m_gc_deferrals) {
-        if (m_should_gc_when_deferral_ends)
-            collect_garbage();
+        if (m_should_gc_when_deferral_ends) {
+            if (m_incremental_marking_in_progress)
+                perform_incremental_marking_step();
+            else
+                collect_garbage(m_deferred_collection_type);
+        }
         m_should_gc_when_deferral_ends = false;
     }
 }
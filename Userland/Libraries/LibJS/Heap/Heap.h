@@ -26,9 +26,13 @@
 
 #pragma once
 
+#include <AK/Array.h>
+#include <AK/Badge.h>
 #include <AK/HashTable.h>
 #include <AK/Noncopyable.h>
 #include <AK/NonnullOwnPtr.h>
+#include <AK/Optional.h>
+#include <AK/StdLibExtras.h>
 #include <AK/Types.h>
 #include <AK/Vector.h>
 #include <LibCore/Forward.h>
@@ -40,6 +44,22 @@
 
 namespace JS {
 
+// Cell types whose every post-construction edge mutation goes through Cell::write_barrier().
+// Old cells of any other type are traced conservatively on every minor collection.
+template<typename T>
+struct HasWriteBarriers {
+    static constexpr bool value = IsSame<T, Object>::value
+        || IsSame<T, Array>::value
+        || IsSame<T, ScriptFunction>::value
+        || IsSame<T, NativeFunction>::value
+        || IsSame<T, LexicalEnvironment>::value
+        || IsSame<T, Shape>::value
+        || IsSame<T, Accessor>::value
+        || IsSame<T, PrimitiveString>::value
+        || IsSame<T, Symbol>::value
+        || IsSame<T, BigInt>::value;
+};
+
 class Heap {
     AK_MAKE_NONCOPYABLE(Heap);
     AK_MAKE_NONMOVABLE(Heap);
@@ -53,7 +73,9 @@ public:
     {
         auto* memory = allocate_cell(sizeof(T));
         new (memory) T(forward<Args>(args)...);
-        return static_cast<T*>(memory);
+        auto* cell = static_cast<T*>(memory);
+        cell->set_has_write_barriers(HasWriteBarriers<T>::value);
+        return cell;
     }
 
     template<typename T, typename... Args>
@@ -62,6 +84,7 @@ public:
         auto* memory = allocate_cell(sizeof(T));
         new (memory) T(forward<Args>(args)...);
         auto* cell = static_cast<T*>(memory);
+        cell->set_has_write_barriers(HasWriteBarriers<T>::value);
         constexpr bool is_object = IsBaseOf<Object, T>::value;
         if constexpr (is_object)
             static_cast<Object*>(cell)->disable_transitions();
@@ -73,6 +96,7 @@ public:
 
     enum class CollectionType {
         CollectGarbage,
+        CollectYoungGarbage,
         CollectEverything,
     };
 
@@ -83,6 +107,52 @@ public:
     bool should_collect_on_every_allocation() const { return m_should_collect_on_every_allocation; }
     void set_should_collect_on_every_allocation(bool b) { m_should_collect_on_every_allocation = b; }
 
+    bool is_generational() const { return m_generational; }
+    void set_generational(bool);
+
+    // In incremental mode, full collections triggered by allocation mark the heap in steps of
+    // at most max_pause_time_us, interleaved with the program. Once marking is done, each allocator
+    // sweeps its blocks lazily, when it runs out of usable ones, so the destructors of dead cells may
+    // run long after the collection. WeakPtrs to them are revoked as soon as marking ends, though;
+    // see Cell::revoke_weak_references().
+    bool is_incremental() const { return m_incremental; }
+    void set_incremental(bool);
+
+    u64 max_pause_time_us() const { return m_max_pause_time_us; }
+    void set_max_pause_time_us(u64 max_pause_time_us) { m_max_pause_time_us = max_pause_time_us; }
+
+    static constexpr size_t pause_histogram_bucket_count = 16;
+
+    // Bucket N counts pauses shorter than 32 << N microseconds, the last bucket counts all longer ones.
+    static constexpr u64 pause_histogram_bucket_limit_us(size_t bucket) { return 32llu << bucket; }
+
+    struct Statistics {
+        size_t minor_collections { 0 };
+        size_t major_collections { 0 };
+        u64 minor_collection_time_us { 0 };
+        u64 major_collection_time_us { 0 };
+        u64 max_minor_collection_time_us { 0 };
+        u64 max_major_collection_time_us { 0 };
+        size_t incremental_marking_steps { 0 };
+        u64 incremental_marking_time_us { 0 };
+        u64 max_incremental_marking_step_time_us { 0 };
+        size_t lazy_sweeps { 0 };
+        u64 lazy_sweep_time_us { 0 };
+        size_t promoted_cells { 0 };
+        size_t collected_cells { 0 };
+        AK::Array<size_t, pause_histogram_bucket_count> pause_histogram {};
+    };
+
+    const Statistics& statistics() const { return m_statistics; }
+
+    void did_write_to_cell(Badge<Cell>, Cell&);
+
+    void did_create_block(Badge<Allocator>, HeapBlock&);
+    void will_destroy_block(Badge<Allocator>, HeapBlock&);
+    bool sweep_block(Badge<Allocator>, HeapBlock&);
+
+    void did_create_weakly_referenced_cell(Badge<Cell>, Cell&);
+
     void did_create_handle(Badge<HandleImpl>, HandleImpl&);
     void did_destroy_handle(Badge<HandleImpl>, HandleImpl&);
 
@@ -98,7 +168,23 @@ private:
     void gather_roots(HashTable<Cell*>&);
     void gather_conservative_roots(HashTable<Cell*>&);
     void mark_live_cells(const HashTable<Cell*>& live_cells);
+    void mark_young_cells(const HashTable<Cell*>& live_cells);
+    bool drain_marking_work_list(const Core::ElapsedTimer&, Optional<u64> deadline_us);
     void sweep_dead_cells(bool print_report, const Core::ElapsedTimer&);
+    void sweep_young_cells(bool print_report, const Core::ElapsedTimer&);
+    void begin_sweep();
+    void finish_sweeping();
+    void revoke_weak_references(bool only_young_cells);
+    void rebuild_remembered_set(const HashTable<Cell*>& roots);
+    void remember_cell(Cell&);
+    void did_promote_cell(Cell&);
+    void collect_garbage_for_allocation();
+    CollectionType collection_type_for_allocation() const;
+
+    void start_incremental_marking();
+    void perform_incremental_marking_step();
+    void finish_incremental_marking(const Core::ElapsedTimer&);
+    void record_pause(u64 time_spent_us);
 
     Allocator& allocator_for_size(size_t);
 
@@ -116,15 +202,57 @@ private:
 
     bool m_should_collect_on_every_allocation { false };
 
+    // Generational mode does not move cells. Instead, cells are promoted in place when they
+    // survive a collection, and minor collections only trace and sweep cells that are still young.
+    bool m_generational { false };
+    bool m_can_collect_young_generation { false };
+    size_t m_old_cells_after_last_major_gc { 0 };
+    size_t m_cells_promoted_since_last_major_gc { 0 };
+
+    // Old cells that may point to young ones: everything written to since the last collection,
+    // plus the roots of the last collection, since native code may be holding them mid-mutation.
+    Vector<Cell*> m_remembered_cells;
+
+    // Old cells without write barriers, which always have to be treated as remembered.
+    Vector<Cell*> m_old_cells_without_write_barriers;
+
+    // Incremental marking is tri-color: marked cells on the work list are gray, other marked cells are black.
+    // Cells that are written to while marked are remembered and scanned again when marking finishes,
+    // as are marked cells without write barriers.
+    bool m_incremental { false };
+    bool m_incremental_marking_in_progress { false };
+    u64 m_max_pause_time_us { 1000 };
+    size_t m_allocations_since_last_marking_step { 0 };
+    size_t m_allocations_since_marking_started { 0 };
+    Vector<Cell*> m_marking_work_list;
+    Vector<Cell*> m_marked_cells_without_write_barriers;
+
+    struct SweepCounts {
+        size_t collected_cells { 0 };
+        size_t collected_cell_bytes { 0 };
+        size_t live_cells { 0 };
+        size_t live_cell_bytes { 0 };
+        size_t freed_blocks { 0 };
+    };
+    SweepCounts m_sweep_counts;
+    bool m_sweep_pending { false };
+
+    Statistics m_statistics;
+
     VM& m_vm;
 
     Vector<NonnullOwnPtr<Allocator>> m_allocators;
+    HashTable<HeapBlock*> m_blocks;
     HashTable<HandleImpl*> m_handles;
 
+    // Cells that can be reached through a WeakPtr. Each one leaves this list when it is found dead.
+    Vector<Cell*> m_weakly_referenced_cells;
+
     HashTable<MarkedValueList*> m_marked_value_lists;
 
     size_t m_gc_deferrals { 0 };
     bool m_should_gc_when_deferral_ends { false };
+    CollectionType m_deferred_collection_type { CollectionType::CollectYoungGarbage };
 
     bool m_collecting_garbage { false };
 };
@@ -26,17 +26,120 @@
  */
 
 #include "Lexer.h"
+#include <AK/Array.h>
 #include <AK/Debug.h>
-#include <AK/HashMap.h>
 #include <ctype.h>
 #include <stdio.h>
 
 namespace JS {
 
-HashMap<String, TokenType> Lexer::s_keywords;
-HashMap<String, TokenType> Lexer::s_three_char_tokens;
-HashMap<String, TokenType> Lexer::s_two_char_tokens;
-HashMap<char, TokenType> Lexer::s_single_char_tokens;
+struct Keyword {
+    template<size_t N>
+    constexpr Keyword(const char (&name)[N], TokenType type)
+        : name(name)
+        , length(N - 1)
+        , type(type)
+    {
+    }
+
+    const char* name;
+    size_t length;
+    TokenType type;
+};
+
+static constexpr Keyword s_keywords[] = {
+    { "await", TokenType::Await },
+    { "break", TokenType::Break },
+    { "case", TokenType::Case },
+    { "catch", TokenType::Catch },
+    { "class", TokenType::Class },
+    { "const", TokenType::Const },
+    { "continue", TokenType::Continue },
+    { "debugger", TokenType::Debugger },
+    { "default", TokenType::Default },
+    { "delete", TokenType::Delete },
+    { "do", TokenType::Do },
+    { "else", TokenType::Else },
+    { "enum", TokenType::Enum },
+    { "export", TokenType::Export },
+    { "extends", TokenType::Extends },
+    { "false", TokenType::BoolLiteral },
+    { "finally", TokenType::Finally },
+    { "for", TokenType::For },
+    { "function", TokenType::Function },
+    { "if", TokenType::If },
+    { "import", TokenType::Import },
+    { "in", TokenType::In },
+    { "instanceof", TokenType::Instanceof },
+    { "let", TokenType::Let },
+    { "new", TokenType::New },
+    { "null", TokenType::NullLiteral },
+    { "return", TokenType::Return },
+    { "super", TokenType::Super },
+    { "switch", TokenType::Switch },
+    { "this", TokenType::This },
+    { "throw", TokenType::Throw },
+    { "true", TokenType::BoolLiteral },
+    { "try", TokenType::Try },
+    { "typeof", TokenType::Typeof },
+    { "var", TokenType::Var },
+    { "void", TokenType::Void },
+    { "while", TokenType::While },
+    { "with", TokenType::With },
+    { "yield", TokenType::Yield },
+};
+
+// A perfect hash of the keywords, looking at their length and their first, second and last characters.
+// The multipliers were picked so that no two keywords end up in the same slot of the table.
+static constexpr size_t keyword_table_size = 128;
+
+static constexpr size_t keyword_hash(const char* characters, size_t length)
+{
+    return (length * 3 + static_cast<u8>(characters[0]) * 15 + static_cast<u8>(characters[1]) * 12 + static_cast<u8>(characters[length - 1])) % keyword_table_size;
+}
+
+static constexpr bool keyword_hash_is_perfect()
+{
+    for (size_t i = 0; i < array_size(s_keywords); ++i) {
+        if (s_keywords[i].length < 2)
+            return false;
+        for (size_t j = i + 1; j < array_size(s_keywords); ++j) {
+            if (keyword_hash(s_keywords[i].name, s_keywords[i].length) == keyword_hash(s_keywords[j].name, s_keywords[j].length))
+                return false;
+        }
+    }
+    return true;
+}
+
+static_assert(keyword_hash_is_perfect());
+
+// Maps each slot to the index of its keyword plus one, or zero if there is none.
+static constexpr auto s_keyword_table = [] {
+    Array<u8, keyword_table_size> table {};
+    for (size_t i = 0; i < array_size(s_keywords); ++i)
+        table[keyword_hash(s_keywords[i].name, s_keywords[i].length)] = i + 1;
+    return table;
+}();
+
+static constexpr size_t longest_keyword_length = [] {
+    size_t length = 0;
+    for (auto& keyword : s_keywords)
+        length = max(length, keyword.length);
+    return length;
+}();
+
+static TokenType keyword_or_identifier_type(const StringView& value)
+{
+    if (value.length() < 2 || value.length() > longest_keyword_length)
+        return TokenType::Identifier;
+    auto index = s_keyword_table[keyword_hash(value.characters_without_null_termination(), value.length())];
+    if (index == 0)
+        return TokenType::Identifier;
+    auto& keyword = s_keywords[index - 1];
+    if (value != StringView(keyword.name, keyword.length))
+        return TokenType::Identifier;
+    return keyword.type;
+}
 
 Lexer::Lexer(StringView source, StringView filename, size_t line_number, size_t line_column)
     : m_source(source)
@@ -45,112 +148,6 @@ Lexer::Lexer(StringView source, StringView filename, size_t line_number, size_t
     , m_line_number(line_number)
     , m_line_column(line_column)
 {
-    if (s_keywords.is_empty()) {
-        s_keywords.set("await", TokenType::Await);
-        s_keywords.set("break", TokenType::Break);
-        s_keywords.set("case", TokenType::Case);
-        s_keywords.set("catch", TokenType::Catch);
-        s_keywords.set("class", TokenType::Class);
-        s_keywords.set("const", TokenType::Const);
-        s_keywords.set("continue", TokenType::Continue);
-        s_keywords.set("debugger", TokenType::Debugger);
-        s_keywords.set("default", TokenType::Default);
-        s_keywords.set("delete", TokenType::Delete);
-        s_keywords.set("do", TokenType::Do);
-        s_keywords.set("else", TokenType::Else);
-        s_keywords.set("enum", TokenType::Enum);
-        s_keywords.set("export", TokenType::Export);
-        s_keywords.set("extends", TokenType::Extends);
-        s_keywords.set("false", TokenType::BoolLiteral);
-        s_keywords.set("finally", TokenType::Finally);
-        s_keywords.set("for", TokenType::For);
-        s_keywords.set("function", TokenType::Function);
-        s_keywords.set("if", TokenType::If);
-        s_keywords.set("import", TokenType::Import);
-        s_keywords.set("in", TokenType::In);
-        s_keywords.set("instanceof", TokenType::Instanceof);
-        s_keywords.set("let", TokenType::Let);
-        s_keywords.set("new", TokenType::New);
-        s_keywords.set("null", TokenType::NullLiteral);
-        s_keywords.set("return", TokenType::Return);
-        s_keywords.set("super", TokenType::Super);
-        s_keywords.set("switch", TokenType::Switch);
-        s_keywords.set("this", TokenType::This);
-        s_keywords.set("throw", TokenType::Throw);
-        s_keywords.set("true", TokenType::BoolLiteral);
-        s_keywords.set("try", TokenType::Try);
-        s_keywords.set("typeof", TokenType::Typeof);
-        s_keywords.set("var", TokenType::Var);
-        s_keywords.set("void", TokenType::Void);
-        s_keywords.set("while", TokenType::While);
-        s_keywords.set("with", TokenType::With);
-        s_keywords.set("yield", TokenType::Yield);
-    }
-
-    if (s_three_char_tokens.is_empty()) {
-        s_three_char_tokens.set("===", TokenType::EqualsEqualsEquals);
-        s_three_char_tokens.set("!==", TokenType::ExclamationMarkEqualsEquals);
-        s_three_char_tokens.set("**=", TokenType::DoubleAsteriskEquals);
-        s_three_char_tokens.set("<<=", TokenType::ShiftLeftEquals);
-        s_three_char_tokens.set(">>=", TokenType::ShiftRightEquals);
-        s_three_char_tokens.set("&&=", TokenType::DoubleAmpersandEquals);
-        s_three_char_tokens.set("||=", TokenType::DoublePipeEquals);
-        s_three_char_tokens.set("\?\?=", TokenType::DoubleQuestionMarkEquals);
-        s_three_char_tokens.set(">>>", TokenType::UnsignedShiftRight);
-        s_three_char_tokens.set("...", TokenType::TripleDot);
-    }
-
-    if (s_two_char_tokens.is_empty()) {
-        s_two_char_tokens.set("=>", TokenType::Arrow);
-        s_two_char_tokens.set("+=", TokenType::PlusEquals);
-        s_two_char_tokens.set("-=", TokenType::MinusEquals);
-        s_two_char_tokens.set("*=", TokenType::AsteriskEquals);
-        s_two_char_tokens.set("/=", TokenType::SlashEquals);
-        s_two_char_tokens.set("%=", TokenType::PercentEquals);
-        s_two_char_tokens.set("&=", TokenType::AmpersandEquals);
-        s_two_char_tokens.set("|=", TokenType::PipeEquals);
-        s_two_char_tokens.set("^=", TokenType::CaretEquals);
-        s_two_char_tokens.set("&&", TokenType::DoubleAmpersand);
-        s_two_char_tokens.set("||", TokenType::DoublePipe);
-        s_two_char_tokens.set("??", TokenType::DoubleQuestionMark);
-        s_two_char_tokens.set("**", TokenType::DoubleAsterisk);
-        s_two_char_tokens.set("==", TokenType::EqualsEquals);
-        s_two_char_tokens.set("<=", TokenType::LessThanEquals);
-        s_two_char_tokens.set(">=", TokenType::GreaterThanEquals);
-        s_two_char_tokens.set("!=", TokenType::ExclamationMarkEquals);
-        s_two_char_tokens.set("--", TokenType::MinusMinus);
-        s_two_char_tokens.set("++", TokenType::PlusPlus);
-        s_two_char_tokens.set("<<", TokenType::ShiftLeft);
-        s_two_char_tokens.set(">>", TokenType::ShiftRight);
-        s_two_char_tokens.set("?.", TokenType::QuestionMarkPeriod);
-    }
-
-    if (s_single_char_tokens.is_empty()) {
-        s_single_char_tokens.set('&', TokenType::Ampersand);
-        s_single_char_tokens.set('*', TokenType::Asterisk);
-        s_single_char_tokens.set('[', TokenType::BracketOpen);
-        s_single_char_tokens.set(']', TokenType::BracketClose);
-        s_single_char_tokens.set('^', TokenType::Caret);
-        s_single_char_tokens.set(':', TokenType::Colon);
-        s_single_char_tokens.set(',', TokenType::Comma);
-        s_single_char_tokens.set('{', TokenType::CurlyOpen);
-        s_single_char_tokens.set('}', TokenType::CurlyClose);
-        s_single_char_tokens.set('=', TokenType::Equals);
-        s_single_char_tokens.set('!', TokenType::ExclamationMark);
-        s_single_char_tokens.set('-', TokenType::Minus);
-        s_single_char_tokens.set('(', TokenType::ParenOpen);
-        s_single_char_tokens.set(')', TokenType::ParenClose);
-        s_single_char_tokens.set('%', TokenType::Percent);
-        s_single_char_tokens.set('.', TokenType::Period);
-        s_single_char_tokens.set('|', TokenType::Pipe);
-        s_single_char_tokens.set('+', TokenType::Plus);
-        s_single_char_tokens.set('?', TokenType::QuestionMark);
-        s_single_char_tokens.set(';', TokenType::Semicolon);
-        s_single_char_tokens.set('/', TokenType::Slash);
-        s_single_char_tokens.set('~', TokenType::Tilde);
-        s_single_char_tokens.set('<', TokenType::LessThan);
-        s_single_char_tokens.set('>', TokenType::GreaterThan);
-    }
     consume();
 }
 
@@ -364,6 +361,102 @@ bool Lexer::slash_means_division() const
         || type == TokenType::This;
 }
 
+TokenType Lexer::consume_punctuator()
+{
+    auto peek = [&](size_t offset) -> char {
+        auto index = m_position + offset;
+        return index < m_source.length() ? m_source[index] : 0;
+    };
+    auto consume_token = [&](size_t length, TokenType type) {
+        for (size_t i = 0; i < length; ++i)
+            consume();
+        return type;
+    };
+
+    auto second_char = peek(0);
+    auto third_char = peek(1);
+    switch (m_current_char) {
+    case '&':
+        if (second_char == '&')
+            return third_char == '=' ? consume_token(3, TokenType::DoubleAmpersandEquals) : consume_token(2, TokenType::DoubleAmpersand);
+        return second_char == '=' ? consume_token(2, TokenType::AmpersandEquals) : consume_token(1, TokenType::Ampersand);
+    case '|':
+        if (second_char == '|')
+            return third_char == '=' ? consume_token(3, TokenType::DoublePipeEquals) : consume_token(2, TokenType::DoublePipe);
+        return second_char == '=' ? consume_token(2, TokenType::PipeEquals) : consume_token(1, TokenType::Pipe);
+    case '?':
+        if (second_char == '?')
+            return third_char == '=' ? consume_token(3, TokenType::DoubleQuestionMarkEquals) : consume_token(2, TokenType::DoubleQuestionMark);
+        // OptionalChainingPunctuator :: ?. [lookahead ∉ DecimalDigit]
+        if (second_char == '.' && !isdigit(third_char))
+            return consume_token(2, TokenType::QuestionMarkPeriod);
+        return consume_token(1, TokenType::QuestionMark);
+    case '*':
+        if (second_char == '*')
+            return third_char == '=' ? consume_token(3, TokenType::DoubleAsteriskEquals) : consume_token(2, TokenType::DoubleAsterisk);
+        return second_char == '=' ? consume_token(2, TokenType::AsteriskEquals) : consume_token(1, TokenType::Asterisk);
+    case '<':
+        if (second_char == '<')
+            return third_char == '=' ? consume_token(3, TokenType::ShiftLeftEquals) : consume_token(2, TokenType::ShiftLeft);
+        return second_char == '=' ? consume_token(2, TokenType::LessThanEquals) : consume_token(1, TokenType::LessThan);
+    case '>':
+        if (second_char == '>') {
+            if (third_char == '>')
+                return peek(2) == '=' ? consume_token(4, TokenType::UnsignedShiftRightEquals) : consume_token(3, TokenType::UnsignedShiftRight);
+            return third_char == '=' ? consume_token(3, TokenType::ShiftRightEquals) : consume_token(2, TokenType::ShiftRight);
+        }
+        return second_char == '=' ? consume_token(2, TokenType::GreaterThanEquals) : consume_token(1, TokenType::GreaterThan);
+    case '=':
+        if (second_char == '=')
+            return third_char == '=' ? consume_token(3, TokenType::EqualsEqualsEquals) : consume_token(2, TokenType::EqualsEquals);
+        return second_char == '>' ? consume_token(2, TokenType::Arrow) : consume_token(1, TokenType::Equals);
+    case '!':
+        if (second_char == '=')
+            return third_char == '=' ? consume_token(3, TokenType::ExclamationMarkEqualsEquals) : consume_token(2, TokenType::ExclamationMarkEquals);
+        return consume_token(1, TokenType::ExclamationMark);
+    case '.':
+        if (second_char == '.' && third_char == '.')
+            return consume_token(3, TokenType::TripleDot);
+        return consume_token(1, TokenType::Period);
+    case '+':
+        if (second_char == '+')
+            return consume_token(2, TokenType::PlusPlus);
+        return second_char == '=' ? consume_token(2, TokenType::PlusEquals) : consume_token(1, TokenType::Plus);
+    case '-':
+        if (second_char == '-')
+            return consume_token(2, TokenType::MinusMinus);
+        return second_char == '=' ? consume_token(2, TokenType::MinusEquals) : consume_token(1, TokenType::Minus);
+    case '/':
+        return second_char == '=' ? consume_token(2, TokenType::SlashEquals) : consume_token(1, TokenType::Slash);
+    case '%':
+        return second_char == '=' ? consume_token(2, TokenType::PercentEquals) : consume_token(1, TokenType::Percent);
+    case '^':
+        return second_char == '=' ? consume_token(2, TokenType::CaretEquals) : consume_token(1, TokenType::Caret);
+    case '[':
+        return consume_token(1, TokenType::BracketOpen);
+    case ']':
+        return consume_token(1, TokenType::BracketClose);
+    case '{':
+        return consume_token(1, TokenType::CurlyOpen);
+    case '}':
+        return consume_token(1, TokenType::CurlyClose);
+    case '(':
+        return consume_token(1, TokenType::ParenOpen);
+    case ')':
+        return consume_token(1, TokenType::ParenClose);
+    case ':':
+        return consume_token(1, TokenType::Colon);
+    case ',':
+        return consume_token(1, TokenType::Comma);
+    case ';':
+        return consume_token(1, TokenType::Semicolon);
+    case '~':
+        return consume_token(1, TokenType::Tilde);
+    default:
+        return consume_token(1, TokenType::Invalid);
+    }
+}
+
 Token Lexer::next()
 {
     size_t trivia_start = m_position;
@@ -463,13 +556,7 @@ Token Lexer::next()
             consume();
         } while (is_identifier_middle());
 
-        StringView value = m_source.substring_view(value_start - 1, m_position - value_start);
-        auto it = s_keywords.find(value.hash(), [&](auto& entry) { return entry.key == value; });
-        if (it == s_keywords.end()) {
-            token_type = TokenType::Identifier;
-        } else {
-            token_type = it->value;
-        }
+        token_type = keyword_or_identifier_type(m_source.substring_view(value_start - 1, m_position - value_start));
     } else if (is_numeric_literal_start()) {
         token_type = TokenType::NumericLiteral;
         bool is_invalid_numeric_literal = false;
@@ -570,59 +657,7 @@ Token Lexer::next()
             token_type = TokenType::Eof;
         }
     } else {
-        // There is only one four-char operator: >>>=
-        bool found_four_char_token = false;
-        if (match('>', '>', '>', '=')) {
-            found_four_char_token = true;
-            consume();
-            consume();
-            consume();
-            consume();
-            token_type = TokenType::UnsignedShiftRightEquals;
-        }
-
-        bool found_three_char_token = false;
-        if (!found_four_char_token && m_position + 1 < m_source.length()) {
-            auto three_chars_view = m_source.substring_view(m_position - 1, 3);
-            auto it = s_three_char_tokens.find(three_chars_view.hash(), [&](auto& entry) { return entry.key == three_chars_view; });
-            if (it != s_three_char_tokens.end()) {
-                found_three_char_token = true;
-                consume();
-                consume();
-                consume();
-                token_type = it->value;
-            }
-        }
-
-        bool found_two_char_token = false;
-        if (!found_four_char_token && !found_three_char_token && m_position < m_source.length()) {
-            auto two_chars_view = m_source.substring_view(m_position - 1, 2);
-            auto it = s_two_char_tokens.find(two_chars_view.hash(), [&](auto& entry) { return entry.key == two_chars_view; });
-            if (it != s_two_char_tokens.end()) {
-                // OptionalChainingPunctuator :: ?. [lookahead ∉ DecimalDigit]
-                if (!(it->value == TokenType::QuestionMarkPeriod && m_position + 1 < m_source.length() && isdigit(m_source[m_position + 1]))) {
-                    found_two_char_token = true;
-                    consume();
-                    consume();
-                    token_type = it->value;
-                }
-            }
-        }
-
-        bool found_one_char_token = false;
-        if (!found_four_char_token && !found_three_char_token && !found_two_char_token) {
-            auto it = s_single_char_tokens.find(m_current_char);
-            if (it != s_single_char_tokens.end()) {
-                found_one_char_token = true;
-                consume();
-                token_type = it->value;
-            }
-        }
-
-        if (!found_four_char_token && !found_three_char_token && !found_two_char_token && !found_one_char_token) {
-            consume();
-            token_type = TokenType::Invalid;
-        }
+        token_type = consume_punctuator();
     }
 
     if (!m_template_states.is_empty() && m_template_states.last().in_expr) {
@@ -28,9 +28,9 @@
 
 #include "Token.h"
 
-#include <AK/HashMap.h>
 #include <AK/String.h>
 #include <AK/StringView.h>
+#include <AK/Vector.h>
 
 namespace JS {
 
@@ -61,6 +61,7 @@ private:
     bool match(char, char, char) const;
     bool match(char, char, char, char) const;
     bool slash_means_division() const;
+    TokenType consume_punctuator();
 
     StringView m_source;
     size_t m_position { 0 };
@@ -78,11 +79,6 @@ private:
         u8 open_bracket_count;
     };
     Vector<TemplateState> m_template_states;
-
-    static HashMap<String, TokenType> s_keywords;
-    static HashMap<String, TokenType> s_three_char_tokens;
-    static HashMap<String, TokenType> s_two_char_tokens;
-    static HashMap<char, TokenType> s_single_char_tokens;
 };
 
 }
@@ -33,6 +33,11 @@
 
 namespace JS {
 
+static bool is_unprefixed_octal_number(const StringView& value)
+{
+    return value.length() > 1 && value[0] == '0' && isdigit(value[1]);
+}
+
 static bool statement_is_use_strict_directive(NonnullRefPtr<Statement> statement)
 {
     if (!is<ExpressionStatement>(*statement))
@@ -57,21 +62,21 @@ public:
         , m_mask(mask)
     {
         if (m_mask & Var)
-            m_parser.m_parser_state.m_var_scopes.append(NonnullRefPtrVector<VariableDeclaration>());
+            m_parser.m_var_scopes.append(NonnullRefPtrVector<VariableDeclaration>());
         if (m_mask & Let)
-            m_parser.m_parser_state.m_let_scopes.append(NonnullRefPtrVector<VariableDeclaration>());
+            m_parser.m_let_scopes.append(NonnullRefPtrVector<VariableDeclaration>());
         if (m_mask & Function)
-            m_parser.m_parser_state.m_function_scopes.append(NonnullRefPtrVector<FunctionDeclaration>());
+            m_parser.m_function_scopes.append(NonnullRefPtrVector<FunctionDeclaration>());
     }
 
     ~ScopePusher()
     {
         if (m_mask & Var)
-            m_parser.m_parser_state.m_var_scopes.take_last();
+            m_parser.m_var_scopes.take_last();
         if (m_mask & Let)
-            m_parser.m_parser_state.m_let_scopes.take_last();
+            m_parser.m_let_scopes.take_last();
         if (m_mask & Function)
-            m_parser.m_parser_state.m_function_scopes.take_last();
+            m_parser.m_function_scopes.take_last();
     }
 
     Parser& m_parser;
@@ -203,6 +208,34 @@ Parser::Parser(Lexer lexer)
 {
 }
 
+void Parser::enable_lazy_function_compilation()
+{
+    if (!m_preparsed_source)
+        m_preparsed_source = PreparsedSource::create(m_parser_state.m_lexer.source(), m_parser_state.m_lexer.filename());
+}
+
+NonnullRefPtr<BlockStatement> Parser::parse_lazy_function_body(LazyFunctionBody& lazy_body)
+{
+    m_preparsed_source = lazy_body.source();
+    m_source_offset = lazy_body.offset();
+
+    auto& context = lazy_body.context();
+    m_parser_state.m_strict_mode = context.strict_mode;
+    m_parser_state.m_allow_super_property_lookup = context.allow_super_property_lookup;
+    m_parser_state.m_allow_super_constructor_call = context.allow_super_constructor_call;
+    m_parser_state.m_in_arrow_function_context = context.in_arrow_function_context;
+    m_parser_state.m_in_break_context = context.in_break_context;
+    m_parser_state.m_in_continue_context = context.in_continue_context;
+    m_parser_state.m_in_function_context = true;
+
+    ScopePusher scope(*this, ScopePusher::Var | ScopePusher::Function);
+    bool is_strict = false;
+    auto body = parse_block_statement(is_strict);
+    body->add_variables(m_var_scopes.last());
+    body->add_functions(m_function_scopes.last());
+    return body;
+}
+
 Associativity Parser::operator_associativity(TokenType type) const
 {
     switch (type) {
@@ -271,10 +304,10 @@ NonnullRefPtr<Program> Parser::parse_program()
         }
         first = false;
     }
-    if (m_parser_state.m_var_scopes.size() == 1) {
-        program->add_variables(m_parser_state.m_var_scopes.last());
-        program->add_variables(m_parser_state.m_let_scopes.last());
-        program->add_functions(m_parser_state.m_function_scopes.last());
+    if (m_var_scopes.size() == 1) {
+        program->add_variables(m_var_scopes.last());
+        program->add_variables(m_let_scopes.last());
+        program->add_functions(m_function_scopes.last());
     } else {
         syntax_error("Unclosed scope");
     }
@@ -290,7 +323,7 @@ NonnullRefPtr<Declaration> Parser::parse_declaration()
         return parse_class_declaration();
     case TokenType::Function: {
         auto declaration = parse_function_node<FunctionDeclaration>();
-        m_parser_state.m_function_scopes.last().append(declaration);
+        m_function_scopes.last().append(declaration);
         return declaration;
     }
     case TokenType::Let:
@@ -362,11 +395,11 @@ NonnullRefPtr<Statement> Parser::parse_statement()
 RefPtr<FunctionExpression> Parser::try_parse_arrow_function_expression(bool expect_parens)
 {
     save_state();
-    m_parser_state.m_var_scopes.append(NonnullRefPtrVector<VariableDeclaration>());
+    m_var_scopes.append(NonnullRefPtrVector<VariableDeclaration>());
     auto rule_start = push_start();
 
     ArmedScopeGuard state_rollback_guard = [&] {
-        m_parser_state.m_var_scopes.take_last();
+        m_var_scopes.take_last();
         load_state();
     };
 
@@ -424,7 +457,7 @@ RefPtr<FunctionExpression> Parser::try_parse_arrow_function_expression(bool expe
             // with a "body" property.
             auto return_expression = parse_expression(2);
             auto return_block = create_ast_node<BlockStatement>({ m_parser_state.m_current_token.filename(), rule_start.position(), position() });
-            return_block->append<ReturnStatement>({ m_filename, rule_start.position(), position() }, move(return_expression));
+            return_block->append(create_ast_node<ReturnStatement>({ m_filename, rule_start.position(), position() }, move(return_expression)));
             return return_block;
         }
         // Invalid arrow function body
@@ -435,7 +468,7 @@ RefPtr<FunctionExpression> Parser::try_parse_arrow_function_expression(bool expe
         state_rollback_guard.disarm();
         discard_saved_state();
         auto body = function_body_result.release_nonnull();
-        return create_ast_node<FunctionExpression>({ m_parser_state.m_current_token.filename(), rule_start.position(), position() }, "", move(body), move(parameters), function_length, m_parser_state.m_var_scopes.take_last(), is_strict, true);
+        return create_ast_node<FunctionExpression>({ m_parser_state.m_current_token.filename(), rule_start.position(), position() }, "", move(body), move(parameters), function_length, m_var_scopes.take_last(), is_strict, true);
     }
 
     return nullptr;
@@ -608,7 +641,7 @@ NonnullRefPtr<ClassExpression> Parser::parse_class_expression(bool expect_class_
             // constructor(... args){ super (...args);}
             auto super_call = create_ast_node<CallExpression>({ m_parser_state.m_current_token.filename(), rule_start.position(), position() }, create_ast_node<SuperExpression>({ m_parser_state.m_current_token.filename(), rule_start.position(), position() }), Vector { CallExpression::Argument { create_ast_node<Identifier>({ m_parser_state.m_current_token.filename(), rule_start.position(), position() }, "args"), true } });
             constructor_body->append(create_ast_node<ExpressionStatement>({ m_parser_state.m_current_token.filename(), rule_start.position(), position() }, move(super_call)));
-            constructor_body->add_variables(m_parser_state.m_var_scopes.last());
+            constructor_body->add_variables(m_var_scopes.last());
 
             constructor = create_ast_node<FunctionExpression>({ m_parser_state.m_current_token.filename(), rule_start.position(), position() }, class_name, move(constructor_body), Vector { FunctionNode::Parameter { "args", nullptr, true } }, 0, NonnullRefPtrVector<VariableDeclaration>(), true);
         } else {
@@ -1306,8 +1339,8 @@ NonnullRefPtr<BlockStatement> Parser::parse_block_statement(bool& is_strict)
     m_parser_state.m_strict_mode = initial_strict_mode_state;
     m_parser_state.m_string_legacy_octal_escape_sequence_in_scope = false;
     consume(TokenType::CurlyClose);
-    block->add_variables(m_parser_state.m_let_scopes.last());
-    block->add_functions(m_parser_state.m_function_scopes.last());
+    block->add_variables(m_let_scopes.last());
+    block->add_functions(m_function_scopes.last());
     return block;
 }
 
@@ -1343,12 +1376,116 @@ NonnullRefPtr<FunctionNodeType> Parser::parse_function_node(u8 parse_options)
     });
 
     bool is_strict = false;
+    if (m_preparsed_source && match(TokenType::CurlyOpen)) {
+        auto body = preparse_function_body(is_strict);
+        return create_ast_node<FunctionNodeType>({ m_parser_state.m_current_token.filename(), rule_start.position(), position() }, name, move(body), move(parameters), function_length, NonnullRefPtrVector<VariableDeclaration>(), is_strict);
+    }
+
     auto body = parse_block_statement(is_strict);
-    body->add_variables(m_parser_state.m_var_scopes.last());
-    body->add_functions(m_parser_state.m_function_scopes.last());
+    body->add_variables(m_var_scopes.last());
+    body->add_functions(m_function_scopes.last());
     return create_ast_node<FunctionNodeType>({ m_parser_state.m_current_token.filename(), rule_start.position(), position() }, name, move(body), move(parameters), function_length, NonnullRefPtrVector<VariableDeclaration>(), is_strict);
 }
 
+NonnullRefPtr<Statement> Parser::preparse_function_body(bool& is_strict)
+{
+    auto rule_start = push_start();
+    auto body_start = m_parser_state.m_current_token.value().characters_without_null_termination();
+    size_t offset = m_source_offset + (body_start - m_parser_state.m_lexer.source().characters_without_null_termination());
+
+    LazyFunctionBody::Context context;
+    context.strict_mode = m_parser_state.m_strict_mode;
+    context.allow_super_property_lookup = m_parser_state.m_allow_super_property_lookup;
+    context.allow_super_constructor_call = m_parser_state.m_allow_super_constructor_call;
+    context.in_arrow_function_context = m_parser_state.m_in_arrow_function_context;
+    context.in_break_context = m_parser_state.m_in_break_context;
+    context.in_continue_context = m_parser_state.m_in_continue_context;
+
+    skip_function_body(is_strict);
+    m_preparsed_source->did_preparse_function();
+
+    auto body = create_ast_node<LazyFunctionBody>({ m_parser_state.m_current_token.filename(), rule_start.position(), position() }, *m_preparsed_source, offset, context);
+    m_lazy_function_bodies.append(body);
+    return body;
+}
+
+// Finds the end of a function body by matching brackets, without building a tree for it. Only the syntax errors
+// that single tokens give away are reported here, the others are reported when the body is compiled.
+void Parser::skip_function_body(bool& is_strict)
+{
+    consume(TokenType::CurlyOpen);
+
+    // Like parse_block_statement(), only a "use strict" directive at the very start of the body counts.
+    is_strict = m_parser_state.m_strict_mode;
+    if (!is_strict && match(TokenType::StringLiteral)) {
+        auto value = m_parser_state.m_current_token.value();
+        if (value == "'use strict'" || value == "\"use strict\"") {
+            save_state();
+            consume();
+            is_strict = match(TokenType::Semicolon) || match(TokenType::CurlyClose) || m_parser_state.m_current_token.trivia_contains_line_terminator();
+            load_state();
+        }
+    }
+
+    Vector<TokenType, 16> closing_brackets;
+    closing_brackets.append(TokenType::CurlyClose);
+    while (!closing_brackets.is_empty()) {
+        auto& token = m_parser_state.m_current_token;
+        switch (token.type()) {
+        case TokenType::CurlyOpen:
+            closing_brackets.append(TokenType::CurlyClose);
+            break;
+        case TokenType::ParenOpen:
+            closing_brackets.append(TokenType::ParenClose);
+            break;
+        case TokenType::BracketOpen:
+            closing_brackets.append(TokenType::BracketClose);
+            break;
+        case TokenType::TemplateLiteralExprStart:
+            closing_brackets.append(TokenType::TemplateLiteralExprEnd);
+            break;
+        case TokenType::CurlyClose:
+        case TokenType::ParenClose:
+        case TokenType::BracketClose:
+        case TokenType::TemplateLiteralExprEnd:
+            if (token.type() != closing_brackets.last()) {
+                expected(Token::name(closing_brackets.last()));
+                return;
+            }
+            closing_brackets.take_last();
+            break;
+        case TokenType::Eof:
+            expected(Token::name(closing_brackets.last()));
+            return;
+        case TokenType::Invalid:
+        case TokenType::UnterminatedRegexLiteral:
+        case TokenType::UnterminatedStringLiteral:
+        case TokenType::UnterminatedTemplateLiteral:
+            syntax_error(token.message().is_empty() ? String::formatted("Unexpected token {}", token.name()) : token.message());
+            return;
+        case TokenType::With:
+            if (is_strict)
+                syntax_error("'with' statement not allowed in strict mode");
+            break;
+        case TokenType::NumericLiteral:
+            if (is_strict && is_unprefixed_octal_number(token.value()))
+                syntax_error("Unprefixed octal number not allowed in strict mode");
+            break;
+        case TokenType::StringLiteral:
+            if (is_strict && token.value().contains('\\')) {
+                auto status = Token::StringValueStatus::Ok;
+                token.string_value(status);
+                if (status == Token::StringValueStatus::LegacyOctalEscapeSequence)
+                    syntax_error("Octal escape sequence in string literal not allowed in strict mode");
+            }
+            break;
+        default:
+            break;
+        }
+        consume();
+    }
+}
+
 Vector<FunctionNode::Parameter> Parser::parse_function_parameters(int& function_length, u8 parse_options)
 {
     auto rule_start = push_start();
@@ -1453,9 +1590,9 @@ NonnullRefPtr<VariableDeclaration> Parser::parse_variable_declaration(bool for_l
 
     auto declaration = create_ast_node<VariableDeclaration>({ m_parser_state.m_current_token.filename(), rule_start.position(), position() }, declaration_kind, move(declarations));
     if (declaration_kind == DeclarationKind::Var)
-        m_parser_state.m_var_scopes.last().append(declaration);
+        m_var_scopes.last().append(declaration);
     else
-        m_parser_state.m_let_scopes.last().append(declaration);
+        m_let_scopes.last().append(declaration);
     return declaration;
 }
 
@@ -1687,7 +1824,7 @@ NonnullRefPtr<IfStatement> Parser::parse_if_statement()
         ScopePusher scope(*this, ScopePusher::Let);
         auto block = create_ast_node<BlockStatement>({ m_parser_state.m_current_token.filename(), rule_start.position(), position() });
         block->append(parse_declaration());
-        block->add_functions(m_parser_state.m_function_scopes.last());
+        block->add_functions(m_function_scopes.last());
         return block;
     };
 
@@ -1733,7 +1870,7 @@ NonnullRefPtr<Statement> Parser::parse_for_statement()
                 return parse_for_in_of_statement(*init);
         } else if (match_variable_declaration()) {
             if (!match(TokenType::Var)) {
-                m_parser_state.m_let_scopes.append(NonnullRefPtrVector<VariableDeclaration>());
+                m_let_scopes.append(NonnullRefPtrVector<VariableDeclaration>());
                 in_scope = true;
             }
             init = parse_variable_declaration(true);
@@ -1768,7 +1905,7 @@ NonnullRefPtr<Statement> Parser::parse_for_statement()
     auto body = parse_statement();
 
     if (in_scope) {
-        m_parser_state.m_let_scopes.take_last();
+        m_let_scopes.take_last();
     }
 
     return create_ast_node<ForStatement>({ m_parser_state.m_current_token.filename(), rule_start.position(), position() }, move(init), move(test), move(update), move(body));
@@ -1995,9 +2132,6 @@ Token Parser::consume(TokenType expected_type)
 
 Token Parser::consume_and_validate_numeric_literal()
 {
-    auto is_unprefixed_octal_number = [](const StringView& value) {
-        return value.length() > 1 && value[0] == '0' && isdigit(value[1]);
-    };
     auto literal_start = position();
     auto token = consume(TokenType::NumericLiteral);
     if (m_parser_state.m_strict_mode && is_unprefixed_octal_number(token.value()))
@@ -2030,15 +2164,33 @@ void Parser::syntax_error(const String& message, Optional<Position> position)
     m_parser_state.m_errors.append({ message, position });
 }
 
+template<typename ScopeType>
+static size_t innermost_scope_size(const Vector<ScopeType>& scopes)
+{
+    return scopes.is_empty() ? 0 : scopes.last().size();
+}
+
+template<typename ScopeType>
+static void shrink_innermost_scope(Vector<ScopeType>& scopes, size_t size)
+{
+    if (!scopes.is_empty())
+        scopes.last().shrink(size);
+}
+
 void Parser::save_state()
 {
-    m_saved_state.append(m_parser_state);
+    m_saved_state.append({ m_parser_state, innermost_scope_size(m_var_scopes), innermost_scope_size(m_let_scopes), innermost_scope_size(m_function_scopes), m_lazy_function_bodies.size() });
 }
 
 void Parser::load_state()
 {
     VERIFY(!m_saved_state.is_empty());
-    m_parser_state = m_saved_state.take_last();
+    auto saved_state = m_saved_state.take_last();
+    m_parser_state = move(saved_state.parser_state);
+    shrink_innermost_scope(m_var_scopes, saved_state.var_scope_size);
+    shrink_innermost_scope(m_let_scopes, saved_state.let_scope_size);
+    shrink_innermost_scope(m_function_scopes, saved_state.function_scope_size);
+    m_lazy_function_bodies.shrink(saved_state.lazy_function_body_count);
 }
 
 void Parser::discard_saved_state()
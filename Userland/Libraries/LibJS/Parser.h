@@ -58,6 +58,17 @@ public:
 
     NonnullRefPtr<Program> parse_program();
 
+    // Skip over function bodies, and only parse them when the function is first called. Most syntax errors
+    // in a body are reported then, rather than by parse_program(); see skip_function_body().
+    void enable_lazy_function_compilation();
+    const PreparsedSource* preparsed_source() const { return m_preparsed_source; }
+    NonnullRefPtr<BlockStatement> parse_lazy_function_body(LazyFunctionBody&);
+    // The bodies skipped over by this parser, not counting the ones nested in those.
+    NonnullRefPtrVector<LazyFunctionBody>& lazy_function_bodies() { return m_lazy_function_bodies; }
+
+    // The size of the AST nodes this parser has created, not counting the strings and vectors they own.
+    size_t ast_node_bytes() const { return m_ast_node_bytes; }
+
     template<typename FunctionNodeType>
     NonnullRefPtr<FunctionNodeType> parse_function_node(u8 parse_options = FunctionNodeParseOptions::CheckForFunctionAndName);
     Vector<FunctionNode::Parameter> parse_function_parameters(int& function_length, u8 parse_options = 0);
@@ -150,6 +161,13 @@ public:
 private:
     friend class ScopePusher;
 
+    template<typename T, typename... Args>
+    NonnullRefPtr<T> create_ast_node(SourceRange range, Args&&... args)
+    {
+        m_ast_node_bytes += sizeof(T);
+        return JS::create_ast_node<T>(move(range), forward<Args>(args)...);
+    }
+
     Associativity operator_associativity(TokenType) const;
     bool match_expression() const;
     bool match_unary_prefixed_expression() const;
@@ -166,6 +184,8 @@ private:
     Token consume();
     Token consume(TokenType type);
     Token consume_and_validate_numeric_literal();
+    NonnullRefPtr<Statement> preparse_function_body(bool& is_strict);
+    void skip_function_body(bool& is_strict);
     void consume_or_insert_semicolon();
     void save_state();
     void load_state();
@@ -204,9 +224,6 @@ private:
         Lexer m_lexer;
         Token m_current_token;
         Vector<Error> m_errors;
-        Vector<NonnullRefPtrVector<VariableDeclaration>> m_var_scopes;
-        Vector<NonnullRefPtrVector<VariableDeclaration>> m_let_scopes;
-        Vector<NonnullRefPtrVector<FunctionDeclaration>> m_function_scopes;
         HashTable<StringView> m_labels_in_scope;
         bool m_strict_mode { false };
         bool m_allow_super_property_lookup { false };
@@ -220,9 +237,26 @@ private:
         explicit ParserState(Lexer);
     };
 
+    // The scopes are kept out of the parser state so that saving it doesn't copy every declaration
+    // parsed so far. Backtracking only ever has to drop declarations appended to the innermost scopes.
+    struct SavedState {
+        ParserState parser_state;
+        size_t var_scope_size { 0 };
+        size_t let_scope_size { 0 };
+        size_t function_scope_size { 0 };
+        size_t lazy_function_body_count { 0 };
+    };
+
     Vector<Position> m_rule_starts;
     ParserState m_parser_state;
+    Vector<NonnullRefPtrVector<VariableDeclaration>> m_var_scopes;
+    Vector<NonnullRefPtrVector<VariableDeclaration>> m_let_scopes;
+    Vector<NonnullRefPtrVector<FunctionDeclaration>> m_function_scopes;
     FlyString m_filename;
-    Vector<ParserState> m_saved_state;
+    Vector<SavedState> m_saved_state;
+    RefPtr<PreparsedSource> m_preparsed_source;
+    NonnullRefPtrVector<LazyFunctionBody> m_lazy_function_bodies;
+    size_t m_source_offset { 0 };
+    size_t m_ast_node_bytes { 0 };
 };
 }
@@ -46,10 +46,18 @@ public:
     }
 
     Function* getter() const { return m_getter; }
-    void set_getter(Function* getter) { m_getter = getter; }
+    void set_getter(Function* getter)
+    {
+        write_barrier();
+        m_getter = getter;
+    }
 
     Function* setter() const { return m_setter; }
-    void set_setter(Function* setter) { m_setter = setter; }
+    void set_setter(Function* setter)
+    {
+        write_barrier();
+        m_setter = setter;
+    }
 
     Value call_getter(Value this_value)
     {
@@ -28,6 +28,8 @@
 
 #include <AK/Function.h>
 #include <AK/HashTable.h>
+#include <AK/NumericLimits.h>
+#include <AK/QuickSort.h>
 #include <AK/ScopeGuard.h>
 #include <AK/StringBuilder.h>
 #include <LibJS/Runtime/Array.h>
@@ -107,6 +109,18 @@ static Function* callback_from_args(GlobalObject& global_object, const String& n
     return &callback.as_function();
 }
 
+// Elements of arrays with packed number storage have no holes and no accessors,
+// so they can be read directly instead of going through Object::get().
+static Value get_element(Object& object, size_t index)
+{
+    if (object.is_array() && index <= NumericLimits<u32>::max()) {
+        auto value = static_cast<const Object&>(object).indexed_properties().packed_number_at(index);
+        if (!value.is_empty())
+            return value;
+    }
+    return object.get(index);
+}
+
 static void for_each_item(VM& vm, GlobalObject& global_object, const String& name, AK::Function<IterationDecision(size_t index, Value value, Value callback_result)> callback, bool skip_empty = true)
 {
     auto* this_object = vm.this_value(global_object).to_object(global_object);
@@ -124,7 +138,7 @@ static void for_each_item(VM& vm, GlobalObject& global_object, const String& nam
     auto this_value = vm.argument(1);
 
     for (size_t i = 0; i < initial_length; ++i) {
-        auto value = this_object->get(i);
+        auto value = get_element(*this_object, i);
         if (vm.exception())
             return;
         if (value.is_empty()) {
@@ -170,13 +184,20 @@ JS_DEFINE_NATIVE_FUNCTION(ArrayPrototype::map)
     if (vm.exception())
         return {};
     auto* new_array = Array::create(global_object);
-    new_array->indexed_properties().set_array_like_size(initial_length);
     for_each_item(vm, global_object, "map", [&](auto index, auto, auto callback_result) {
         if (vm.exception())
             return IterationDecision::Break;
-        new_array->define_property(index, callback_result);
+        // Appending keeps the storage packed, which setting the length upfront would not.
+        if (index == new_array->indexed_properties().array_like_size())
+            new_array->indexed_properties().append(callback_result);
+        else
+            new_array->define_property(index, callback_result);
         return IterationDecision::Continue;
     });
+    if (vm.exception())
+        return {};
+    if (new_array->indexed_properties().array_like_size() < initial_length)
+        new_array->indexed_properties().set_array_like_size(initial_length);
     return Value(new_array);
 }
 
@@ -455,7 +476,29 @@ JS_DEFINE_NATIVE_FUNCTION(ArrayPrototype::index_of)
             from_index = max(length + from_index, 0);
     }
     auto search_element = vm.argument(0);
-    for (i32 i = from_index; i < length; ++i) {
+    i32 i = from_index;
+    if (this_object->is_array()) {
+        // All packed number elements are numbers, so strict equality comes down to comparing doubles.
+        auto search_packed_elements = [&](auto& elements) {
+            i32 packed_length = min(length, static_cast<i32>(elements.size()));
+            if (!search_element.is_number()) {
+                i = max(i, packed_length);
+                return false;
+            }
+            auto search_number = search_element.as_double();
+            for (; i < packed_length; ++i) {
+                if (elements[i] == search_number)
+                    return true;
+            }
+            return false;
+        };
+        auto& indexed_properties = static_cast<const Object*>(this_object)->indexed_properties();
+        if (indexed_properties.is_packed_int32() && search_packed_elements(indexed_properties.packed_int32_elements()))
+            return Value(i);
+        if (indexed_properties.is_packed_double() && search_packed_elements(indexed_properties.packed_double_elements()))
+            return Value(i);
+    }
+    for (; i < length; ++i) {
         auto element = this_object->get(i);
         if (vm.exception())
             return {};
@@ -702,6 +745,33 @@ static void array_merge_sort(VM& vm, GlobalObject& global_object, Function* comp
     }
 }
 
+// Without a comparison function, elements are sorted by their string representations.
+// Packed number elements can't run any code while being converted, so each one is converted
+// just once, and the elements are then sorted in place.
+template<typename T>
+static void sort_packed_number_elements(GlobalObject& global_object, Vector<T>& elements)
+{
+    struct Entry {
+        String key;
+        T element;
+        size_t index;
+    };
+    Vector<Entry> entries;
+    entries.ensure_capacity(elements.size());
+    for (size_t i = 0; i < elements.size(); ++i)
+        entries.unchecked_append({ Value(elements[i]).to_string(global_object), elements[i], i });
+
+    // Comparing the original indices of equal keys keeps the sort stable, which matters for 0 and -0.
+    quick_sort(entries, [](auto& a, auto& b) {
+        if (a.key == b.key)
+            return a.index < b.index;
+        return a.key < b.key;
+    });
+
+    for (size_t i = 0; i < entries.size(); ++i)
+        elements[i] = entries[i].element;
+}
+
 JS_DEFINE_NATIVE_FUNCTION(ArrayPrototype::sort)
 {
     auto* array = vm.this_value(global_object).to_object(global_object);
@@ -718,6 +788,18 @@ JS_DEFINE_NATIVE_FUNCTION(ArrayPrototype::sort)
     if (vm.exception())
         return {};
 
+    if (callback.is_undefined() && array->is_array() && static_cast<const Object*>(array)->indexed_properties().array_like_size() == original_length) {
+        auto& indexed_properties = array->indexed_properties();
+        if (indexed_properties.is_packed_int32()) {
+            sort_packed_number_elements(global_object, indexed_properties.packed_int32_elements());
+            return array;
+        }
+        if (indexed_properties.is_packed_double()) {
+            sort_packed_number_elements(global_object, indexed_properties.packed_double_elements());
+            return array;
+        }
+    }
+
     MarkedValueList values_to_sort(vm.heap());
 
     for (size_t i = 0; i < original_length; ++i) {
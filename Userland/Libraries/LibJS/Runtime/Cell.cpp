@@ -48,6 +48,16 @@ Heap& Cell::heap() const
     return HeapBlock::from_cell(this)->heap();
 }
 
+void Cell::track_weak_references()
+{
+    heap().did_create_weakly_referenced_cell({}, *this);
+}
+
+void Cell::did_write_to_cell()
+{
+    heap().did_write_to_cell({}, *this);
+}
+
 VM& Cell::vm() const
 {
     return heap().vm();
@@ -49,6 +49,24 @@ public:
     bool is_live() const { return m_live; }
     void set_live(bool b) { m_live = b; }
 
+    // A cell becomes old once it has survived a collection in generational mode.
+    bool is_old() const { return m_old; }
+    void set_old(bool b) { m_old = b; }
+
+    bool is_remembered() const { return m_remembered; }
+    void set_remembered(bool b) { m_remembered = b; }
+
+    bool has_write_barriers() const { return m_has_write_barriers; }
+    void set_has_write_barriers(bool b) { m_has_write_barriers = b; }
+
+    // Must be called before storing a reference to another cell into this one, so that minor
+    // collections can find old-to-young edges, and incremental marking can rescan marked cells.
+    ALWAYS_INLINE void write_barrier()
+    {
+        if ((m_old || m_mark) && !m_remembered)
+            did_write_to_cell();
+    }
+
     virtual const char* class_name() const = 0;
 
     class Visitor {
@@ -62,15 +80,26 @@ public:
 
     virtual void visit_edges(Visitor&) { }
 
+    // Called once a collection has found this cell dead, which may be long before it is swept.
+    // Cells that call track_weak_references() must revoke every WeakPtr to themselves here.
+    virtual void revoke_weak_references() { }
+
     Heap& heap() const;
     VM& vm() const;
 
 protected:
     Cell() { }
 
+    void track_weak_references();
+
 private:
-    bool m_mark { false };
-    bool m_live { true };
+    void did_write_to_cell();
+
+    bool m_mark : 1 { false };
+    bool m_live : 1 { true };
+    bool m_old : 1 { false };
+    bool m_remembered : 1 { false };
+    bool m_has_write_barriers : 1 { false };
 };
 
 }
@@ -97,6 +97,71 @@ void SimpleIndexedPropertyStorage::set_array_like_size(size_t new_size)
     m_packed_elements.resize(new_size);
 }
 
+template<typename T>
+Optional<ValueAndAttributes> PackedNumberIndexedPropertyStorage<T>::get(u32 index) const
+{
+    if (index >= m_elements.size())
+        return {};
+    return ValueAndAttributes { Value(m_elements[index]), default_attributes };
+}
+
+template<typename T>
+void PackedNumberIndexedPropertyStorage<T>::put(u32 index, Value value, PropertyAttributes attributes)
+{
+    VERIFY(can_put(index, value, attributes));
+    auto element = static_cast<T>(value.as_double());
+    if (index == m_elements.size())
+        m_elements.append(element);
+    else
+        m_elements[index] = element;
+}
+
+template<typename T>
+void PackedNumberIndexedPropertyStorage<T>::remove(u32 index)
+{
+    // Removing an existing element would leave a hole, IndexedProperties switches to another storage before that.
+    VERIFY(index >= m_elements.size());
+}
+
+template<typename T>
+void PackedNumberIndexedPropertyStorage<T>::insert(u32 index, Value value, PropertyAttributes attributes)
+{
+    VERIFY(can_put(index, value, attributes));
+    m_elements.insert(index, static_cast<T>(value.as_double()));
+}
+
+template<typename T>
+ValueAndAttributes PackedNumberIndexedPropertyStorage<T>::take_first()
+{
+    return { Value(m_elements.take_first()), default_attributes };
+}
+
+template<typename T>
+ValueAndAttributes PackedNumberIndexedPropertyStorage<T>::take_last()
+{
+    return { Value(m_elements.take_last()), default_attributes };
+}
+
+template<typename T>
+void PackedNumberIndexedPropertyStorage<T>::set_array_like_size(size_t new_size)
+{
+    VERIFY(new_size <= m_elements.size());
+    m_elements.shrink(new_size);
+}
+
+template<typename T>
+Vector<Value> PackedNumberIndexedPropertyStorage<T>::values() const
+{
+    Vector<Value> values;
+    values.ensure_capacity(m_elements.size());
+    for (auto element : m_elements)
+        values.unchecked_append(Value(element));
+    return values;
+}
+
+template class PackedNumberIndexedPropertyStorage<i32>;
+template class PackedNumberIndexedPropertyStorage<double>;
+
 GenericIndexedPropertyStorage::GenericIndexedPropertyStorage(SimpleIndexedPropertyStorage&& storage)
 {
     m_array_size = storage.array_like_size();
@@ -104,6 +169,17 @@ GenericIndexedPropertyStorage::GenericIndexedPropertyStorage(SimpleIndexedProper
         m_packed_elements.append({ element, default_attributes });
 }
 
+GenericIndexedPropertyStorage::GenericIndexedPropertyStorage(Vector<Value>&& initial_values)
+{
+    m_array_size = initial_values.size();
+    for (size_t i = 0; i < initial_values.size(); ++i) {
+        if (i < SPARSE_ARRAY_THRESHOLD)
+            m_packed_elements.append({ initial_values[i], default_attributes });
+        else
+            m_sparse_elements.set(i, { initial_values[i], default_attributes });
+    }
+}
+
 bool GenericIndexedPropertyStorage::has_index(u32 index) const
 {
     if (index < SPARSE_ARRAY_THRESHOLD)
@@ -273,6 +349,36 @@ void IndexedPropertyIterator::skip_empty_indices()
     m_index = m_indexed_properties.array_like_size();
 }
 
+static NonnullOwnPtr<IndexedPropertyStorage> create_storage_for_values(Vector<Value>&& values)
+{
+    bool all_values_are_int32 = true;
+    for (auto& value : values) {
+        if (!PackedDoubleIndexedPropertyStorage::can_hold(value))
+            return make<SimpleIndexedPropertyStorage>(move(values));
+        if (!PackedInt32IndexedPropertyStorage::can_hold(value))
+            all_values_are_int32 = false;
+    }
+
+    if (all_values_are_int32) {
+        Vector<i32> elements;
+        elements.ensure_capacity(values.size());
+        for (auto& value : values)
+            elements.unchecked_append(static_cast<i32>(value.as_double()));
+        return make<PackedInt32IndexedPropertyStorage>(move(elements));
+    }
+
+    Vector<double> elements;
+    elements.ensure_capacity(values.size());
+    for (auto& value : values)
+        elements.unchecked_append(value.as_double());
+    return make<PackedDoubleIndexedPropertyStorage>(move(elements));
+}
+
+IndexedProperties::IndexedProperties(Vector<Value>&& values)
+    : m_storage(create_storage_for_values(move(values)))
+{
+}
+
 Optional<ValueAndAttributes> IndexedProperties::get(Object* this_object, u32 index, bool evaluate_accessors) const
 {
     auto result = m_storage->get(index);
@@ -291,9 +397,8 @@ Optional<ValueAndAttributes> IndexedProperties::get(Object* this_object, u32 ind
 
 void IndexedProperties::put(Object* this_object, u32 index, Value value, PropertyAttributes attributes, bool evaluate_accessors)
 {
-    if (m_storage->is_simple_storage() && (index >= SPARSE_ARRAY_THRESHOLD || attributes != default_attributes))
-        switch_to_generic_storage();
-    if (m_storage->is_simple_storage() || !evaluate_accessors) {
+    ensure_storage_can_put(index, value, attributes);
+    if (m_storage->is_simple_storage() || m_storage->is_packed_number_storage() || !evaluate_accessors) {
         m_storage->put(index, value, attributes);
         return;
     }
@@ -314,13 +419,16 @@ bool IndexedProperties::remove(u32 index)
         return true;
     if (!result.value().attributes.is_configurable())
         return false;
+    if (m_storage->is_packed_number_storage())
+        switch_to_value_storage(array_like_size());
     m_storage->remove(index);
     return true;
 }
 
 void IndexedProperties::insert(u32 index, Value value, PropertyAttributes attributes)
 {
-    if (m_storage->is_simple_storage() && (index >= SPARSE_ARRAY_THRESHOLD || attributes != default_attributes || array_like_size() == SPARSE_ARRAY_THRESHOLD))
+    ensure_storage_can_put(index, value, attributes);
+    if (m_storage->is_simple_storage() && array_like_size() == SPARSE_ARRAY_THRESHOLD)
         switch_to_generic_storage();
     m_storage->insert(index, move(value), attributes);
 }
@@ -341,21 +449,38 @@ ValueAndAttributes IndexedProperties::take_last(Object* this_object)
     return last;
 }
 
+void IndexedProperties::append(Value value, PropertyAttributes attributes)
+{
+    if (attributes == default_attributes) {
+        if (is_packed_int32() && PackedInt32IndexedPropertyStorage::can_hold(value)) {
+            packed_int32_elements().append(static_cast<i32>(value.as_double()));
+            return;
+        }
+        if (is_packed_double() && PackedDoubleIndexedPropertyStorage::can_hold(value)) {
+            packed_double_elements().append(value.as_double());
+            return;
+        }
+    }
+    put(nullptr, array_like_size(), value, attributes, false);
+}
+
 void IndexedProperties::append_all(Object* this_object, const IndexedProperties& properties, bool evaluate_accessors)
 {
-    if (m_storage->is_simple_storage() && !properties.m_storage->is_simple_storage())
+    if (m_storage->is_simple_storage() && !properties.m_storage->is_simple_storage() && !properties.m_storage->is_packed_number_storage())
         switch_to_generic_storage();
 
     for (auto it = properties.begin(false); it != properties.end(); ++it) {
         const auto& element = it.value_and_attributes(this_object, evaluate_accessors);
         if (this_object && this_object->vm().exception())
             return;
-        m_storage->put(m_storage->array_like_size(), element.value, element.attributes);
+        put(this_object, array_like_size(), element.value, element.attributes, false);
     }
 }
 
 void IndexedProperties::set_array_like_size(size_t new_size)
 {
+    if (m_storage->is_packed_number_storage() && new_size > array_like_size())
+        switch_to_value_storage(new_size);
     if (m_storage->is_simple_storage() && new_size > SPARSE_ARRAY_THRESHOLD)
         switch_to_generic_storage();
     m_storage->set_array_like_size(new_size);
@@ -364,7 +489,11 @@ void IndexedProperties::set_array_like_size(size_t new_size)
 Vector<u32> IndexedProperties::indices() const
 {
     Vector<u32> indices;
-    if (m_storage->is_simple_storage()) {
+    if (m_storage->is_packed_number_storage()) {
+        indices.ensure_capacity(array_like_size());
+        for (size_t i = 0; i < array_like_size(); ++i)
+            indices.unchecked_append(i);
+    } else if (m_storage->is_simple_storage()) {
         const auto& storage = static_cast<const SimpleIndexedPropertyStorage&>(*m_storage);
         const auto& elements = storage.elements();
         indices.ensure_capacity(storage.array_like_size());
@@ -387,8 +516,58 @@ Vector<u32> IndexedProperties::indices() const
     return indices;
 }
 
+void IndexedProperties::ensure_storage_can_put(u32 index, Value value, PropertyAttributes attributes)
+{
+    if (is_packed_int32()) {
+        auto& storage = static_cast<PackedInt32IndexedPropertyStorage&>(*m_storage);
+        if (storage.can_put(index, value, attributes))
+            return;
+        if (index <= storage.size() && attributes == default_attributes && PackedDoubleIndexedPropertyStorage::can_hold(value)) {
+            switch_to_packed_double_storage();
+            return;
+        }
+    } else if (is_packed_double()) {
+        if (static_cast<PackedDoubleIndexedPropertyStorage&>(*m_storage).can_put(index, value, attributes))
+            return;
+    }
+
+    if (m_storage->is_packed_number_storage())
+        switch_to_value_storage(max(array_like_size(), static_cast<size_t>(index) + 1));
+    if (m_storage->is_simple_storage() && (index >= SPARSE_ARRAY_THRESHOLD || attributes != default_attributes))
+        switch_to_generic_storage();
+}
+
+void IndexedProperties::switch_to_packed_double_storage()
+{
+    auto& int32_elements = packed_int32_elements();
+    Vector<double> elements;
+    elements.ensure_capacity(int32_elements.size());
+    for (auto element : int32_elements)
+        elements.unchecked_append(element);
+    m_storage = make<PackedDoubleIndexedPropertyStorage>(move(elements));
+}
+
+Vector<Value> IndexedProperties::packed_number_values() const
+{
+    if (is_packed_int32())
+        return static_cast<const PackedInt32IndexedPropertyStorage&>(*m_storage).values();
+    return static_cast<const PackedDoubleIndexedPropertyStorage&>(*m_storage).values();
+}
+
+void IndexedProperties::switch_to_value_storage(size_t new_array_like_size)
+{
+    if (new_array_like_size <= SPARSE_ARRAY_THRESHOLD)
+        m_storage = make<SimpleIndexedPropertyStorage>(packed_number_values());
+    else
+        m_storage = make<GenericIndexedPropertyStorage>(packed_number_values());
+}
+
 void IndexedProperties::switch_to_generic_storage()
 {
+    if (m_storage->is_packed_number_storage()) {
+        m_storage = make<GenericIndexedPropertyStorage>(packed_number_values());
+        return;
+    }
     auto& storage = static_cast<SimpleIndexedPropertyStorage&>(*m_storage);
     m_storage = make<GenericIndexedPropertyStorage>(move(storage));
 }
@@ -27,6 +27,7 @@
 #pragma once
 
 #include <AK/NonnullOwnPtr.h>
+#include <AK/NumericLimits.h>
 #include <LibJS/Runtime/Shape.h>
 #include <LibJS/Runtime/Value.h>
 
@@ -62,8 +63,61 @@ public:
     virtual void set_array_like_size(size_t new_size) = 0;
 
     virtual bool is_simple_storage() const { return false; }
+    virtual bool is_packed_int32_storage() const { return false; }
+    virtual bool is_packed_double_storage() const { return false; }
+    bool is_packed_number_storage() const { return is_packed_int32_storage() || is_packed_double_storage(); }
 };
 
+// Storage for elements that are all numbers of the same kind, without holes and with default attributes.
+// As there is nothing else to remember, elements are stored as plain i32s or doubles instead of Values.
+template<typename T>
+class PackedNumberIndexedPropertyStorage final : public IndexedPropertyStorage {
+public:
+    PackedNumberIndexedPropertyStorage() = default;
+    explicit PackedNumberIndexedPropertyStorage(Vector<T>&& initial_elements)
+        : m_elements(move(initial_elements))
+    {
+    }
+
+    static bool can_hold(Value value)
+    {
+        if (!value.is_number())
+            return false;
+        if constexpr (IsSame<T, double>::value)
+            return true;
+        auto number = value.as_double();
+        return number >= NumericLimits<i32>::min() && number <= NumericLimits<i32>::max() && static_cast<i32>(number) == number && !value.is_negative_zero();
+    }
+
+    bool can_put(u32 index, Value value, PropertyAttributes attributes) const { return index <= m_elements.size() && attributes == default_attributes && can_hold(value); }
+
+    virtual bool has_index(u32 index) const override { return index < m_elements.size(); }
+    virtual Optional<ValueAndAttributes> get(u32 index) const override;
+    virtual void put(u32 index, Value value, PropertyAttributes attributes = default_attributes) override;
+    virtual void remove(u32 index) override;
+
+    virtual void insert(u32 index, Value value, PropertyAttributes attributes = default_attributes) override;
+    virtual ValueAndAttributes take_first() override;
+    virtual ValueAndAttributes take_last() override;
+
+    virtual size_t size() const override { return m_elements.size(); }
+    virtual size_t array_like_size() const override { return m_elements.size(); }
+    virtual void set_array_like_size(size_t new_size) override;
+
+    virtual bool is_packed_int32_storage() const override { return IsSame<T, i32>::value; }
+    virtual bool is_packed_double_storage() const override { return IsSame<T, double>::value; }
+
+    Vector<T>& elements() { return m_elements; }
+    const Vector<T>& elements() const { return m_elements; }
+    Vector<Value> values() const;
+
+private:
+    Vector<T> m_elements;
+};
+
+using PackedInt32IndexedPropertyStorage = PackedNumberIndexedPropertyStorage<i32>;
+using PackedDoubleIndexedPropertyStorage = PackedNumberIndexedPropertyStorage<double>;
+
 class SimpleIndexedPropertyStorage final : public IndexedPropertyStorage {
 public:
     SimpleIndexedPropertyStorage() = default;
@@ -95,6 +149,7 @@ private:
 class GenericIndexedPropertyStorage final : public IndexedPropertyStorage {
 public:
     explicit GenericIndexedPropertyStorage(SimpleIndexedPropertyStorage&&);
+    explicit GenericIndexedPropertyStorage(Vector<Value>&& initial_values);
 
     virtual bool has_index(u32 index) const override;
     virtual Optional<ValueAndAttributes> get(u32 index) const override;
@@ -140,11 +195,7 @@ private:
 class IndexedProperties {
 public:
     IndexedProperties() = default;
-
-    IndexedProperties(Vector<Value>&& values)
-        : m_storage(make<SimpleIndexedPropertyStorage>(move(values)))
-    {
-    }
+    IndexedProperties(Vector<Value>&& values);
 
     bool has_index(u32 index) const { return m_storage->has_index(index); }
     Optional<ValueAndAttributes> get(Object* this_object, u32 index, bool evaluate_accessors = true) const;
@@ -155,7 +206,7 @@ public:
     ValueAndAttributes take_first(Object* this_object);
     ValueAndAttributes take_last(Object* this_object);
 
-    void append(Value value, PropertyAttributes attributes = default_attributes) { put(nullptr, array_like_size(), value, attributes, false); }
+    void append(Value value, PropertyAttributes attributes = default_attributes);
     void append_all(Object* this_object, const IndexedProperties& properties, bool evaluate_accessors = true);
 
     IndexedPropertyIterator begin(bool skip_empty = true) const { return IndexedPropertyIterator(*this, 0, skip_empty); };
@@ -167,10 +218,44 @@ public:
 
     Vector<u32> indices() const;
 
+    bool is_packed_int32() const { return m_storage->is_packed_int32_storage(); }
+    bool is_packed_double() const { return m_storage->is_packed_double_storage(); }
+    bool is_packed_number() const { return m_storage->is_packed_number_storage(); }
+
+    Vector<i32>& packed_int32_elements() { return static_cast<PackedInt32IndexedPropertyStorage&>(*m_storage).elements(); }
+    const Vector<i32>& packed_int32_elements() const { return static_cast<const PackedInt32IndexedPropertyStorage&>(*m_storage).elements(); }
+    Vector<double>& packed_double_elements() { return static_cast<PackedDoubleIndexedPropertyStorage&>(*m_storage).elements(); }
+    const Vector<double>& packed_double_elements() const { return static_cast<const PackedDoubleIndexedPropertyStorage&>(*m_storage).elements(); }
+
+    // Packed number elements have no holes and no accessors, so they can be read without
+    // going through Object::get(). Returns an empty value for any other storage.
+    Value packed_number_at(u32 index) const
+    {
+        if (is_packed_int32()) {
+            auto& elements = packed_int32_elements();
+            return index < elements.size() ? Value(elements[index]) : Value();
+        }
+        if (is_packed_double()) {
+            auto& elements = packed_double_elements();
+            return index < elements.size() ? Value(elements[index]) : Value();
+        }
+        return {};
+    }
+
     template<typename Callback>
     void for_each_value(Callback callback)
     {
-        if (m_storage->is_simple_storage()) {
+        if (is_packed_int32()) {
+            for (auto element : packed_int32_elements()) {
+                Value value(element);
+                callback(value);
+            }
+        } else if (is_packed_double()) {
+            for (auto element : packed_double_elements()) {
+                Value value(element);
+                callback(value);
+            }
+        } else if (m_storage->is_simple_storage()) {
             for (auto& value : static_cast<SimpleIndexedPropertyStorage&>(*m_storage).elements())
                 callback(value);
         } else {
@@ -182,9 +267,13 @@ public:
     }
 
 private:
+    void ensure_storage_can_put(u32 index, Value, PropertyAttributes);
+    void switch_to_packed_double_storage();
+    Vector<Value> packed_number_values() const;
+    void switch_to_value_storage(size_t new_array_like_size);
     void switch_to_generic_storage();
 
-    NonnullOwnPtr<IndexedPropertyStorage> m_storage { make<SimpleIndexedPropertyStorage>() };
+    NonnullOwnPtr<IndexedPropertyStorage> m_storage { make<PackedInt32IndexedPropertyStorage>() };
 };
 
 }
@@ -24,11 +24,11 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/AllOf.h>
 #include <AK/Function.h>
-#include <AK/JsonArray.h>
-#include <AK/JsonObject.h>
-#include <AK/JsonParser.h>
+#include <AK/GenericLexer.h>
 #include <AK/StringBuilder.h>
+#include <AK/StringUtils.h>
 #include <LibJS/Runtime/Array.h>
 #include <LibJS/Runtime/BigIntObject.h>
 #include <LibJS/Runtime/BooleanObject.h>
@@ -38,6 +38,8 @@
 #include <LibJS/Runtime/NumberObject.h>
 #include <LibJS/Runtime/Object.h>
 #include <LibJS/Runtime/StringObject.h>
+#include <ctype.h>
+#include <stdlib.h>
 
 namespace JS {
 
@@ -390,6 +392,11 @@ String JSONObject::quote_json_string(String string)
     return builder.to_string();
 }
 
+static void ignore_json_whitespace(GenericLexer& lexer)
+{
+    lexer.ignore_while([](char ch) { return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r'; });
+}
+
 JS_DEFINE_NATIVE_FUNCTION(JSONObject::parse)
 {
     if (!vm.argument_count())
@@ -399,12 +406,15 @@ JS_DEFINE_NATIVE_FUNCTION(JSONObject::parse)
         return {};
     auto reviver = vm.argument(1);
 
-    auto json = JsonValue::from_string(string);
-    if (!json.has_value()) {
+    GenericLexer lexer(string);
+    Value result = parse_json_value(global_object, lexer);
+    ignore_json_whitespace(lexer);
+    if (result.is_empty() || !lexer.is_eof()) {
         vm.throw_exception<SyntaxError>(global_object, ErrorType::JsonMalformed);
         return {};
     }
-    Value result = parse_json_value(global_object, json.value());
+    // NOTE: The reviver walks the parsed value afterwards, as it's allowed to observe and modify
+    //       whole holder objects, including properties that come later in the text.
     if (reviver.is_function()) {
         auto* holder_object = Object::create_empty(global_object);
         holder_object->define_property(String::empty(), result);
@@ -415,44 +425,210 @@ JS_DEFINE_NATIVE_FUNCTION(JSONObject::parse)
     return result;
 }
 
-Value JSONObject::parse_json_value(GlobalObject& global_object, const JsonValue& value)
+// The values are created while parsing, without building an intermediate JsonValue tree first. Objects
+// with the same keys in the same order end up sharing a shape through the shape's put transitions.
+// An empty value (or a null pointer) means the text isn't valid JSON.
+Value JSONObject::parse_json_value(GlobalObject& global_object, GenericLexer& lexer)
 {
-    if (value.is_object())
-        return Value(parse_json_object(global_object, value.as_object()));
-    if (value.is_array())
-        return Value(parse_json_array(global_object, value.as_array()));
-    if (value.is_null())
-        return js_null();
-#if !defined(KERNEL)
-    if (value.is_double())
-        return Value(value.as_double());
-#endif
-    if (value.is_number())
-        return Value(value.to_i32(0));
-    if (value.is_string())
-        return js_string(global_object.heap(), value.to_string());
-    if (value.is_bool())
-        return Value(static_cast<bool>(value.as_bool()));
-    VERIFY_NOT_REACHED();
+    ignore_json_whitespace(lexer);
+    switch (lexer.peek()) {
+    case '{': {
+        auto* object = parse_json_object(global_object, lexer);
+        return object ? Value(object) : Value();
+    }
+    case '[': {
+        auto* array = parse_json_array(global_object, lexer);
+        return array ? Value(array) : Value();
+    }
+    case '"': {
+        auto string = parse_json_string(lexer);
+        return string.is_null() ? Value() : js_string(global_object.heap(), move(string));
+    }
+    case 't':
+        return lexer.consume_specific("true") ? Value(true) : Value();
+    case 'f':
+        return lexer.consume_specific("false") ? Value(false) : Value();
+    case 'n':
+        return lexer.consume_specific("null") ? js_null() : Value();
+    default:
+        return parse_json_number(lexer);
+    }
 }
 
-Object* JSONObject::parse_json_object(GlobalObject& global_object, const JsonObject& json_object)
+Object* JSONObject::parse_json_object(GlobalObject& global_object, GenericLexer& lexer)
 {
+    VERIFY(lexer.next_is('{'));
+    lexer.ignore();
     auto* object = Object::create_empty(global_object);
-    json_object.for_each_member([&](auto& key, auto& value) {
-        object->define_property(key, parse_json_value(global_object, value));
-    });
-    return object;
+    ignore_json_whitespace(lexer);
+    if (lexer.consume_specific('}'))
+        return object;
+    for (;;) {
+        ignore_json_whitespace(lexer);
+        if (!lexer.next_is('"'))
+            return nullptr;
+        auto key = parse_json_string(lexer);
+        if (key.is_null())
+            return nullptr;
+        ignore_json_whitespace(lexer);
+        if (!lexer.consume_specific(':'))
+            return nullptr;
+        auto value = parse_json_value(global_object, lexer);
+        if (value.is_empty())
+            return nullptr;
+        object->define_property(key, value);
+        ignore_json_whitespace(lexer);
+        if (lexer.consume_specific('}'))
+            return object;
+        if (!lexer.consume_specific(','))
+            return nullptr;
+    }
 }
 
-Array* JSONObject::parse_json_array(GlobalObject& global_object, const JsonArray& json_array)
+Array* JSONObject::parse_json_array(GlobalObject& global_object, GenericLexer& lexer)
 {
+    VERIFY(lexer.next_is('['));
+    lexer.ignore();
     auto* array = Array::create(global_object);
-    size_t index = 0;
-    json_array.for_each([&](auto& value) {
-        array->define_property(index++, parse_json_value(global_object, value));
-    });
-    return array;
+    ignore_json_whitespace(lexer);
+    if (lexer.consume_specific(']'))
+        return array;
+    for (;;) {
+        auto value = parse_json_value(global_object, lexer);
+        if (value.is_empty())
+            return nullptr;
+        array->indexed_properties().append(value);
+        ignore_json_whitespace(lexer);
+        if (lexer.consume_specific(']'))
+            return array;
+        if (!lexer.consume_specific(','))
+            return nullptr;
+    }
+}
+
+// Returns a null string if the string literal is malformed.
+String JSONObject::parse_json_string(GenericLexer& lexer)
+{
+    VERIFY(lexer.next_is('"'));
+    lexer.ignore();
+
+    auto is_unescaped_character = [](char ch) { return ch != '"' && ch != '\\' && static_cast<u8>(ch) >= 0x20; };
+    auto consume_code_unit = [&]() -> Optional<u32> {
+        if (lexer.tell_remaining() < 4)
+            return {};
+        auto hex_digits = lexer.consume(4);
+        if (!all_of(hex_digits.begin(), hex_digits.end(), isxdigit))
+            return {};
+        return AK::StringUtils::convert_to_uint_from_hex(hex_digits);
+    };
+
+    // Most strings have no escape sequences and can be copied out of the source in one go.
+    auto characters = lexer.consume_while(is_unescaped_character);
+    if (lexer.consume_specific('"'))
+        return characters.is_empty() ? String::empty() : String(characters);
+
+    StringBuilder builder;
+    builder.append(characters);
+    for (;;) {
+        if (lexer.is_eof() || !lexer.consume_specific('\\'))
+            return {};
+        switch (lexer.consume()) {
+        case '"':
+            builder.append('"');
+            break;
+        case '\\':
+            builder.append('\\');
+            break;
+        case '/':
+            builder.append('/');
+            break;
+        case 'b':
+            builder.append('\b');
+            break;
+        case 'f':
+            builder.append('\f');
+            break;
+        case 'n':
+            builder.append('\n');
+            break;
+        case 'r':
+            builder.append('\r');
+            break;
+        case 't':
+            builder.append('\t');
+            break;
+        case 'u': {
+            auto code_unit = consume_code_unit();
+            if (!code_unit.has_value())
+                return {};
+            u32 code_point = code_unit.value();
+            // A high surrogate followed by an escaped low surrogate encodes a single code point.
+            if (code_point >= 0xd800 && code_point <= 0xdbff && lexer.next_is("\\u")) {
+                lexer.ignore(2);
+                auto low_surrogate = consume_code_unit();
+                if (!low_surrogate.has_value())
+                    return {};
+                if (low_surrogate.value() >= 0xdc00 && low_surrogate.value() <= 0xdfff) {
+                    code_point = 0x10000 + ((code_point - 0xd800) << 10) + (low_surrogate.value() - 0xdc00);
+                } else {
+                    builder.append_code_point(code_point);
+                    code_point = low_surrogate.value();
+                }
+            }
+            builder.append_code_point(code_point);
+            break;
+        }
+        default:
+            return {};
+        }
+        builder.append(lexer.consume_while(is_unescaped_character));
+        if (lexer.consume_specific('"'))
+            return builder.to_string();
+    }
+}
+
+Value JSONObject::parse_json_number(GenericLexer& lexer)
+{
+    auto remaining = lexer.remaining();
+    auto start = lexer.tell();
+
+    bool is_negative = lexer.consume_specific('-');
+    if (!lexer.next_is(isdigit))
+        return {};
+    if (!lexer.consume_specific('0'))
+        lexer.ignore_while(isdigit);
+    auto integer_length = lexer.tell() - start;
+
+    bool is_integer = true;
+    if (lexer.consume_specific('.')) {
+        is_integer = false;
+        if (!lexer.next_is(isdigit))
+            return {};
+        lexer.ignore_while(isdigit);
+    }
+    if (lexer.next_is('e') || lexer.next_is('E')) {
+        is_integer = false;
+        lexer.ignore();
+        if (!lexer.consume_specific('+'))
+            lexer.consume_specific('-');
+        if (!lexer.next_is(isdigit))
+            return {};
+        lexer.ignore_while(isdigit);
+    }
+
+    // Integers with up to nine digits fit into an i32.
+    auto digit_count = integer_length - is_negative;
+    if (is_integer && digit_count <= 9) {
+        i32 value = 0;
+        for (size_t i = is_negative; i < integer_length; ++i)
+            value = value * 10 + (remaining[i] - '0');
+        if (is_negative)
+            return value == 0 ? Value(-0.0) : Value(-value);
+        return Value(value);
+    }
+
+    auto number_string = String(remaining.substring_view(0, lexer.tell() - start));
+    return Value(strtod(number_string.characters(), nullptr));
 }
 
 Value JSONObject::internalize_json_property(GlobalObject& global_object, Object* holder, const PropertyName& name, Function& reviver)
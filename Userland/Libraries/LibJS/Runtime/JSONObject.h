@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <AK/GenericLexer.h>
 #include <LibJS/Runtime/Object.h>
 
 namespace JS {
@@ -58,9 +59,11 @@ private:
     static String quote_json_string(String);
 
     // Parse helpers
-    static Object* parse_json_object(GlobalObject&, const JsonObject&);
-    static Array* parse_json_array(GlobalObject&, const JsonArray&);
-    static Value parse_json_value(GlobalObject&, const JsonValue&);
+    static Value parse_json_value(GlobalObject&, GenericLexer&);
+    static Object* parse_json_object(GlobalObject&, GenericLexer&);
+    static Array* parse_json_array(GlobalObject&, GenericLexer&);
+    static String parse_json_string(GenericLexer&);
+    static Value parse_json_number(GenericLexer&);
     static Value internalize_json_property(GlobalObject&, Object* holder, const PropertyName& name, Function& reviver);
 
     JS_DECLARE_NATIVE_FUNCTION(stringify);
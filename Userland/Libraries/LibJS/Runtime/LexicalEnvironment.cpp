@@ -79,6 +79,7 @@ Optional<Variable> LexicalEnvironment::get_from_scope(const FlyString& name) con
 
 void LexicalEnvironment::put_to_scope(const FlyString& name, Variable variable)
 {
+    write_barrier();
     m_variables.set(name, variable);
 }
 
@@ -127,6 +128,7 @@ void LexicalEnvironment::bind_this_value(GlobalObject& global_object, Value this
         vm().throw_exception<ReferenceError>(global_object, ErrorType::ThisIsAlreadyInitialized);
         return;
     }
+    write_barrier();
     m_this_value = this_value;
     m_this_binding_status = ThisBindingStatus::Initialized;
 }
@@ -133,6 +133,7 @@ bool Object::set_prototype(Object* new_prototype)
         return true;
     if (!m_is_extensible)
         return false;
+    write_barrier();
     if (shape().is_unique()) {
         shape().set_prototype_without_transition(new_prototype);
         return true;
@@ -343,6 +344,7 @@ Value Object::get_own_property_descriptor_object(const PropertyName& property_na
 
 void Object::set_shape(Shape& new_shape)
 {
+    write_barrier();
     m_storage.resize(new_shape.property_count());
     m_shape = &new_shape;
 }
@@ -477,6 +479,8 @@ bool Object::put_own_property(Object& this_object, const StringOrSymbol& propert
 {
     VERIFY(!(mode == PutOwnPropertyMode::Put && value.is_accessor()));
 
+    write_barrier();
+
     if (value.is_accessor()) {
         auto& accessor = value.as_accessor();
         if (accessor.getter())
@@ -571,6 +575,8 @@ bool Object::put_own_property_by_index(Object& this_object, u32 property_index,
 {
     VERIFY(!(mode == PutOwnPropertyMode::Put && value.is_accessor()));
 
+    write_barrier();
+
     auto existing_property = m_indexed_properties.get(nullptr, property_index, false);
     auto new_property = !existing_property.has_value();
 
@@ -654,6 +660,7 @@ void Object::ensure_shape_is_unique()
     if (shape().is_unique())
         return;
 
+    write_barrier();
     m_shape = m_shape->create_unique_clone();
 }
 
@@ -817,9 +824,12 @@ void Object::visit_edges(Cell::Visitor& visitor)
     for (auto& value : m_storage)
         visitor.visit(value);
 
-    m_indexed_properties.for_each_value([&visitor](auto& value) {
-        visitor.visit(value);
-    });
+    // Packed number elements never refer to cells.
+    if (!m_indexed_properties.is_packed_number()) {
+        m_indexed_properties.for_each_value([&visitor](auto& value) {
+            visitor.visit(value);
+        });
+    }
 }
 
 bool Object::has_property(const PropertyName& property_name) const
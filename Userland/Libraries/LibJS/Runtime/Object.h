@@ -130,8 +130,16 @@ public:
     Value get_direct(size_t index) const { return m_storage[index]; }
 
     const IndexedProperties& indexed_properties() const { return m_indexed_properties; }
-    IndexedProperties& indexed_properties() { return m_indexed_properties; }
-    void set_indexed_property_elements(Vector<Value>&& values) { m_indexed_properties = IndexedProperties(move(values)); }
+    IndexedProperties& indexed_properties()
+    {
+        write_barrier();
+        return m_indexed_properties;
+    }
+    void set_indexed_property_elements(Vector<Value>&& values)
+    {
+        write_barrier();
+        m_indexed_properties = IndexedProperties(move(values));
+    }
 
     Value invoke(const StringOrSymbol& property_name, Optional<MarkedValueList> arguments = {});
 
@@ -87,8 +87,18 @@ void ScriptFunction::visit_edges(Visitor& visitor)
     visitor.visit(m_parent_scope);
 }
 
+void ScriptFunction::parse_lazy_body()
+{
+    if (!is<LazyFunctionBody>(*m_body))
+        return;
+    if (auto parsed_body = static_cast<LazyFunctionBody&>(*m_body).parsed_body())
+        m_body = parsed_body.release_nonnull();
+}
+
 LexicalEnvironment* ScriptFunction::create_environment()
 {
+    parse_lazy_body();
+
     HashMap<FlyString, Variable> variables;
     for (auto& parameter : m_parameters) {
         variables.set(parameter.name, { js_undefined(), DeclarationKind::Var });
@@ -126,6 +136,11 @@ Value ScriptFunction::execute_function_body()
 
     VM::InterpreterExecutionScope scope(*interpreter);
 
+    if (is<LazyFunctionBody>(*m_body)) {
+        vm.throw_exception<SyntaxError>(global_object(), static_cast<const LazyFunctionBody&>(*m_body).parse_error());
+        return {};
+    }
+
     auto& call_frame_args = vm.call_frame().arguments;
     for (size_t i = 0; i < m_parameters.size(); ++i) {
         auto parameter = m_parameters[i];
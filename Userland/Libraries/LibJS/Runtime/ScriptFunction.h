@@ -59,6 +59,7 @@ private:
     virtual LexicalEnvironment* create_environment() override;
     virtual void visit_edges(Visitor&) override;
 
+    void parse_lazy_body();
     Value execute_function_body();
 
     JS_DECLARE_NATIVE_GETTER(length_getter);
@@ -49,6 +49,7 @@ Shape* Shape::create_put_transition(const StringOrSymbol& property_name, Propert
     if (auto* existing_shape = m_forward_transitions.get(key).value_or(nullptr))
         return existing_shape;
     auto* new_shape = heap().allocate_without_global_object<Shape>(*this, property_name, attributes, TransitionType::Put);
+    write_barrier();
     m_forward_transitions.set(key, new_shape);
     return new_shape;
 }
@@ -59,6 +60,7 @@ Shape* Shape::create_configure_transition(const StringOrSymbol& property_name, P
     if (auto* existing_shape = m_forward_transitions.get(key).value_or(nullptr))
         return existing_shape;
     auto* new_shape = heap().allocate_without_global_object<Shape>(*this, property_name, attributes, TransitionType::Configure);
+    write_barrier();
     m_forward_transitions.set(key, new_shape);
     return new_shape;
 }
@@ -190,6 +192,7 @@ void Shape::add_property_to_unique_shape(const StringOrSymbol& property_name, Pr
     VERIFY(is_unique());
     VERIFY(m_property_table);
     VERIFY(!m_property_table->contains(property_name));
+    write_barrier();
     m_property_table->set(property_name, { m_property_table->size(), attributes });
     ++m_property_count;
 }
@@ -219,6 +222,7 @@ void Shape::remove_property_from_unique_shape(const StringOrSymbol& property_nam
 
 void Shape::add_property_without_transition(const StringOrSymbol& property_name, PropertyAttributes attributes)
 {
+    write_barrier();
     ensure_property_table();
     if (m_property_table->set(property_name, { m_property_count, attributes }) == AK::HashSetResult::InsertedNewEntry)
         ++m_property_count;
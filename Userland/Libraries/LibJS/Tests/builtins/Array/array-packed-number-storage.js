@@ -0,0 +1,86 @@
+describe("arrays of numbers", () => {
+    test("switching from int32 to double elements", () => {
+        var a = [1, 2, 3];
+        a.push(1.5);
+        a.push(-0);
+        expect(a).toEqual([1, 2, 3, 1.5, -0]);
+        expect(Object.is(a[4], -0)).toBeTrue();
+    });
+
+    test("switching to other values", () => {
+        var a = [1, 2.5];
+        a.push("foo");
+        a.push({});
+        expect(a).toHaveLength(4);
+        expect(a[0]).toBe(1);
+        expect(a[1]).toBe(2.5);
+        expect(a[2]).toBe("foo");
+    });
+
+    test("holes", () => {
+        var a = [1, 2, 3];
+        delete a[1];
+        expect(a).toHaveLength(3);
+        expect(1 in a).toBeFalse();
+
+        var b = [1, 2, 3];
+        b[5] = 6;
+        expect(b).toHaveLength(6);
+        expect(4 in b).toBeFalse();
+
+        var c = [1, 2, 3];
+        c.length = 5;
+        expect(3 in c).toBeFalse();
+        c.length = 2;
+        expect(c).toEqual([1, 2]);
+    });
+
+    test("more than 200 elements", () => {
+        var a = [];
+        for (var i = 0; i < 1000; ++i) a.push(i);
+        expect(a).toHaveLength(1000);
+        expect(a[999]).toBe(999);
+        a[1500] = 0.5;
+        expect(a).toHaveLength(1501);
+        expect(a[999]).toBe(999);
+        expect(1200 in a).toBeFalse();
+    });
+
+    test("holes are filled from the prototype chain after shrinking during forEach", () => {
+        Array.prototype[2] = 42;
+        var a = [1, 2, 3];
+        var seen = [];
+        a.forEach((value, index) => {
+            if (index === 0) a.length = 1;
+            seen.push(value);
+        });
+        delete Array.prototype[2];
+        expect(seen).toEqual([1, 42]);
+    });
+
+    test("sort without comparison function compares strings", () => {
+        expect([10, 9, 1, 100, 2].sort()).toEqual([1, 10, 100, 2, 9]);
+        var a = [0.5, -0, 0, -1, NaN].sort();
+        expect(a).toHaveLength(5);
+        expect(a[0]).toBe(-1);
+        expect(Object.is(a[1], -0)).toBeTrue();
+        expect(Object.is(a[2], 0)).toBeTrue();
+        expect(a[3]).toBe(0.5);
+        expect(a[4]).toBeNaN();
+    });
+
+    test("indexOf compares strictly", () => {
+        expect([1, 2, 3].indexOf(2)).toBe(1);
+        expect([1, 2, 3].indexOf("2")).toBe(-1);
+        expect([1.5, NaN].indexOf(NaN)).toBe(-1);
+        expect([0, 1].indexOf(-0)).toBe(0);
+        expect([1, 2, 3].indexOf(1, 1)).toBe(-1);
+    });
+
+    test("map keeps holes and length", () => {
+        var a = [1, , 3].map(x => x * 2);
+        expect(a).toHaveLength(3);
+        expect(1 in a).toBeFalse();
+        expect(a[2]).toBe(6);
+    });
+});
@@ -26,6 +26,16 @@ test("syntax errors", () => {
         '{ "foo" }',
         '{ foo: "bar" }',
         "[1,2,3,]",
+        "01",
+        "1.",
+        ".5",
+        "1e",
+        "-",
+        '"\t"',
+        '"\\x41"',
+        '"\\u12"',
+        "[1 2]",
+        "tru",
         "[1,2,3, ]",
         '{ "foo": "bar",}',
         '{ "foo": "bar", }',
@@ -35,3 +45,22 @@ test("syntax errors", () => {
         }).toThrow(SyntaxError);
     });
 });
+
+test("numbers", () => {
+    expect(JSON.parse("1e3")).toBe(1000);
+    expect(JSON.parse("-12.5e-1")).toBe(-1.25);
+    expect(JSON.parse("1234567890123")).toBe(1234567890123);
+    expect(Object.is(JSON.parse("-0"), -0)).toBeTrue();
+});
+
+test("strings", () => {
+    expect(JSON.parse('""')).toBe("");
+    expect(JSON.parse('"\\"\\\\\\/\\b\\f\\n\\r\\t"')).toBe('"\\/\b\f\n\r\t');
+    expect(JSON.parse('"\\u00e9\\ud83d\\ude00"')).toBe("é😀");
+});
+
+test("objects", () => {
+    expect(JSON.parse('{"a":1,"a":2}')).toEqual({ a: 2 });
+    expect(Object.getOwnPropertyNames(JSON.parse('{"__proto__":1}'))).toEqual(["__proto__"]);
+    expect(JSON.parse(' \t\n{ "a" : [ 1 , { } ] } ')).toEqual({ a: [1, {}] });
+});
@@ -0,0 +1,101 @@
+describe("bodies of nested functions", () => {
+    test("inherit strict mode", () => {
+        function outer() {
+            "use strict";
+            function inner() {
+                return function () {
+                    return isStrictMode();
+                };
+            }
+            return inner()();
+        }
+        expect(outer()).toBeTrue();
+    });
+
+    test("see hoisted declarations", () => {
+        function outer() {
+            return inner() + value;
+            function inner() {
+                return 1;
+            }
+            var value = 2;
+        }
+        expect(outer()).toBeNaN();
+    });
+
+    test("are only run when called", () => {
+        var calls = 0;
+        function outer() {
+            function neverCalled() {
+                calls++;
+            }
+            return function () {
+                calls++;
+                return calls;
+            };
+        }
+        var f = outer();
+        expect(calls).toBe(0);
+        expect(f()).toBe(1);
+        expect(f()).toBe(2);
+    });
+
+    test("contain template literals and object literals", () => {
+        function outer(x) {
+            function inner() {
+                return `${{ value: x }.value}${`${x}`}`;
+            }
+            return inner();
+        }
+        expect(outer(4)).toBe("44");
+    });
+
+    test("contain brackets in strings, regular expressions and comments", () => {
+        function outer() {
+            // }
+            const string = "}{";
+            const regex = /[}{]\}/;
+            return string + regex.source + `${"}"}`;
+        }
+        expect(outer()).toBe("}{[}{]\\}}");
+    });
+
+    test("detect a use strict directive without semicolon", () => {
+        function outer() {
+            "use strict"
+            return isStrictMode();
+        }
+        function notADirective() {
+            "use strict" + "";
+            return isStrictMode();
+        }
+        expect(outer()).toBeTrue();
+        expect(notADirective()).toBeFalse();
+    });
+
+    test("in class methods", () => {
+        class A {
+            constructor() {
+                this.value = 1;
+            }
+            double() {
+                return this.value * 2;
+            }
+        }
+        class B extends A {
+            constructor() {
+                super();
+                this.value = 2;
+            }
+            method() {
+                return super.double() + 1;
+            }
+        }
+        expect(new B().method()).toBe(5);
+    });
+
+    test("syntax errors are reported when parsing", () => {
+        expect("function f() { function g() { let let = 1; } }").not.toEval();
+        expect("function f() { 'use strict'; function g() { with (x) {} } }").not.toEval();
+    });
+});
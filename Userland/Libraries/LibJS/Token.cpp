@@ -106,7 +106,13 @@ String Token::string_value(StringValueStatus& status) const
     VERIFY(type() == TokenType::StringLiteral || type() == TokenType::TemplateLiteralString);
 
     auto is_template = type() == TokenType::TemplateLiteralString;
-    GenericLexer lexer(is_template ? m_value : m_value.substring_view(1, m_value.length() - 2));
+    auto characters = is_template ? m_value : m_value.substring_view(1, m_value.length() - 2);
+
+    // Only strings with escape sequences need to be built character by character.
+    if (!characters.contains('\\'))
+        return characters;
+
+    GenericLexer lexer(characters);
 
     auto encoding_failure = [&status](StringValueStatus parse_status) -> String {
         status = parse_status;
@@ -115,9 +121,9 @@ String Token::string_value(StringValueStatus& status) const
 
     StringBuilder builder;
     while (!lexer.is_eof()) {
-        // No escape, consume one char and continue
+        // No escape, consume everything up to the next one and continue
         if (!lexer.next_is('\\')) {
-            builder.append(lexer.consume());
+            builder.append(lexer.consume_while([](char c) { return c != '\\'; }));
             continue;
         }
 
@@ -38,6 +38,7 @@
 #include <signal.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/internals.h>
 #include <sys/mman.h>
 #include <syscall.h>
 #include <time.h>
@@ -106,6 +107,7 @@ static int create_thread(pthread_t* thread, void* (*entry)(void*), void* argumen
 [[noreturn]] static void exit_thread(void* code)
 {
     KeyDestroyer::destroy_for_current_thread();
+    __malloc_release_thread_cache();
     syscall(SC_exit_thread, code);
     VERIFY_NOT_REACHED();
 }
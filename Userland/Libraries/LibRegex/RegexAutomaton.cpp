@@ -0,0 +1,616 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "RegexAutomaton.h"
+#include "RegexOptimizer.h"
+#include <AK/Debug.h>
+#include <AK/QuickSort.h>
+
+#include <ctype.h>
+
+namespace regex {
+
+static constexpr size_t c_max_dfa_states = 2048;
+static constexpr size_t c_unset_slot = NumericLimits<size_t>::max();
+
+struct Automaton::ThreadList {
+    Vector<u32> nodes;
+    Vector<size_t> slots;
+    Vector<u32> visited;
+    u32 generation { 1 };
+
+    explicit ThreadList(size_t node_count)
+    {
+        visited.ensure_capacity(node_count);
+        for (size_t i = 0; i < node_count; ++i)
+            visited.unchecked_append(0);
+    }
+
+    void clear()
+    {
+        nodes.clear_with_capacity();
+        slots.clear_with_capacity();
+        ++generation;
+    }
+};
+
+static bool compare_is_supported(const ByteCode& bytecode, size_t position, Optional<size_t>& string_offset)
+{
+    auto arguments_count = bytecode.at(position + 1);
+    size_t offset = position + 3;
+    for (size_t i = 0; i < arguments_count; ++i) {
+        switch ((CharacterCompareType)bytecode.at(offset++)) {
+        case CharacterCompareType::Inverse:
+        case CharacterCompareType::TemporaryInverse:
+        case CharacterCompareType::AnyChar:
+            break;
+        case CharacterCompareType::Char:
+        case CharacterCompareType::CharClass:
+        case CharacterCompareType::CharRange:
+            ++offset;
+            break;
+        case CharacterCompareType::String: {
+            // Strings consume more than one character, so they become a chain of nodes.
+            // That only works if nothing else is part of the same comparison.
+            auto length = bytecode.at(offset);
+            if (arguments_count != 1 || length == 0)
+                return false;
+            string_offset = offset;
+            offset += length + 1;
+            break;
+        }
+        case CharacterCompareType::Reference:
+        case CharacterCompareType::NamedReference:
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+OwnPtr<Automaton> Automaton::compile(const ByteCode& bytecode, AllOptions options, size_t capture_groups_count)
+{
+    auto automaton = make<Automaton>();
+    automaton->m_bytecode = &bytecode;
+    automaton->m_insensitive = options.has_flag_set(AllFlags::Insensitive);
+    automaton->m_capture_group_count = capture_groups_count;
+
+    auto& nodes = automaton->m_nodes;
+    HashMap<size_t, u32> node_for_position;
+
+    // Jump targets are resolved once every opcode has been turned into a node.
+    struct PendingTarget {
+        u32 node;
+        bool is_argument;
+        ssize_t position;
+    };
+    Vector<PendingTarget> pending_targets;
+
+    MatchState state;
+    while (state.instruction_position < bytecode.size()) {
+        auto* opcode = bytecode.get_opcode(state);
+        if (!opcode)
+            return {};
+
+        auto position = state.instruction_position;
+        auto next_position = (ssize_t)(position + opcode->size());
+        auto index = (u32)nodes.size();
+        node_for_position.set(position, index);
+
+        switch (opcode->opcode_id()) {
+        case OpCodeId::Compare: {
+            Optional<size_t> string_offset;
+            if (!compare_is_supported(bytecode, position, string_offset))
+                return {};
+
+            if (string_offset.has_value()) {
+                // Strings are stored as their length followed by one bytecode value per character.
+                auto length = bytecode.at(string_offset.value());
+                for (size_t i = 0; i < length; ++i) {
+                    nodes.append({ NodeType::CharacterSet, index + (u32)i + 1, (u32)automaton->m_character_sets.size() });
+                    automaton->m_character_sets.append(automaton->character_set_for_char(bytecode.at(string_offset.value() + 1 + i)));
+                }
+                pending_targets.append({ (u32)nodes.size() - 1, false, next_position });
+                break;
+            }
+
+            if (bytecode.at(position + 1) == 1 && (CharacterCompareType)bytecode.at(position + 3) == CharacterCompareType::Char) {
+                nodes.append({ NodeType::CharacterSet, 0, (u32)automaton->m_character_sets.size() });
+                automaton->m_character_sets.append(automaton->character_set_for_char(bytecode.at(position + 4)));
+                pending_targets.append({ index, false, next_position });
+                break;
+            }
+
+            auto set = Optimizer::bytes_accepted_by_compare(bytecode, position, options);
+            if (!set.has_value())
+                return {};
+            nodes.append({ NodeType::CharacterSet, 0, (u32)automaton->m_character_sets.size() });
+            automaton->m_character_sets.append(set.value());
+            pending_targets.append({ index, false, next_position });
+            break;
+        }
+        case OpCodeId::Jump:
+            nodes.append({ NodeType::Jump });
+            pending_targets.append({ index, false, next_position + static_cast<OpCode_Jump*>(opcode)->offset() });
+            break;
+        case OpCodeId::ForkJump:
+            nodes.append({ NodeType::Split });
+            pending_targets.append({ index, false, next_position + static_cast<OpCode_ForkJump*>(opcode)->offset() });
+            pending_targets.append({ index, true, next_position });
+            break;
+        case OpCodeId::ForkStay:
+            nodes.append({ NodeType::Split });
+            pending_targets.append({ index, false, next_position });
+            pending_targets.append({ index, true, next_position + static_cast<OpCode_ForkStay*>(opcode)->offset() });
+            break;
+        case OpCodeId::CheckBegin:
+            nodes.append({ NodeType::CheckBegin });
+            pending_targets.append({ index, false, next_position });
+            break;
+        case OpCodeId::CheckEnd:
+            nodes.append({ NodeType::CheckEnd });
+            pending_targets.append({ index, false, next_position });
+            break;
+        case OpCodeId::CheckBoundary:
+            nodes.append({ NodeType::CheckBoundary, 0, (u32)position });
+            pending_targets.append({ index, false, next_position });
+            automaton->m_has_boundary_checks = true;
+            break;
+        case OpCodeId::SaveLeftCaptureGroup:
+        case OpCodeId::SaveRightCaptureGroup: {
+            auto id = opcode->opcode_id() == OpCodeId::SaveLeftCaptureGroup
+                ? static_cast<OpCode_SaveLeftCaptureGroup*>(opcode)->id()
+                : static_cast<OpCode_SaveRightCaptureGroup*>(opcode)->id();
+            automaton->m_capture_group_count = max(automaton->m_capture_group_count, id + 1);
+            auto type = opcode->opcode_id() == OpCodeId::SaveLeftCaptureGroup ? NodeType::SaveLeftCaptureGroup : NodeType::SaveRightCaptureGroup;
+            nodes.append({ type, 0, (u32)id });
+            pending_targets.append({ index, false, next_position });
+            break;
+        }
+        case OpCodeId::SaveLeftNamedCaptureGroup:
+        case OpCodeId::SaveRightNamedCaptureGroup: {
+            auto name = opcode->opcode_id() == OpCodeId::SaveLeftNamedCaptureGroup
+                ? static_cast<OpCode_SaveLeftNamedCaptureGroup*>(opcode)->name()
+                : static_cast<OpCode_SaveRightNamedCaptureGroup*>(opcode)->name();
+            auto name_index = automaton->m_capture_group_names.find_first_index(name);
+            if (!name_index.has_value()) {
+                name_index = automaton->m_capture_group_names.size();
+                automaton->m_capture_group_names.append(name);
+            }
+            auto type = opcode->opcode_id() == OpCodeId::SaveLeftNamedCaptureGroup ? NodeType::SaveLeftNamedCaptureGroup : NodeType::SaveRightNamedCaptureGroup;
+            nodes.append({ type, 0, (u32)name_index.value() });
+            pending_targets.append({ index, false, next_position });
+            break;
+        }
+        default:
+            // Lookarounds (Save/Restore/GoBack/FailForks) need the backtracker.
+            return {};
+        }
+
+        state.instruction_position = next_position;
+    }
+
+    auto accept_node = (u32)nodes.size();
+    nodes.append({ NodeType::Accept });
+
+    for (auto& pending : pending_targets) {
+        u32 target;
+        if (pending.position >= (ssize_t)bytecode.size()) {
+            target = accept_node;
+        } else {
+            auto node = pending.position >= 0 ? node_for_position.get(pending.position) : Optional<u32> {};
+            if (!node.has_value())
+                return {};
+            target = node.value();
+        }
+        if (pending.is_argument)
+            nodes[pending.node].argument = target;
+        else
+            nodes[pending.node].next = target;
+    }
+
+    // The backtracker retries a loop body that matched nothing along its other paths, which
+    // the lockstep simulation has no equivalent of; leave such patterns to the backtracker.
+    if (automaton->has_empty_loop())
+        return {};
+
+    automaton->m_slot_count = 1 + 3 * automaton->m_capture_group_count + 3 * automaton->m_capture_group_names.size();
+
+    dbgln_if(REGEX_DEBUG, "[automaton] Compiled {} bytecode entries into {} nodes", bytecode.size(), nodes.size());
+    return automaton;
+}
+
+bool Automaton::has_empty_loop() const
+{
+    Vector<bool> visited;
+    Vector<u32> stack;
+    auto can_reach_without_input = [&](u32 from, u32 to) {
+        visited.resize(m_nodes.size());
+        for (auto& entry : visited)
+            entry = false;
+        stack.clear_with_capacity();
+        stack.append(from);
+        while (!stack.is_empty()) {
+            auto index = stack.take_last();
+            if (index == to)
+                return true;
+            if (visited[index])
+                continue;
+            visited[index] = true;
+            auto& node = m_nodes[index];
+            if (node.type == NodeType::CharacterSet || node.type == NodeType::Accept)
+                continue;
+            stack.append(node.next);
+            if (node.type == NodeType::Split)
+                stack.append(node.argument);
+        }
+        return false;
+    };
+
+    // Every loop in the bytecode closes with a backwards jump or fork.
+    for (u32 index = 0; index < m_nodes.size(); ++index) {
+        auto& node = m_nodes[index];
+        if (node.type == NodeType::CharacterSet || node.type == NodeType::Accept)
+            continue;
+        if (node.next <= index && can_reach_without_input(node.next, index))
+            return true;
+        if (node.type == NodeType::Split && node.argument <= index && can_reach_without_input(node.argument, index))
+            return true;
+    }
+    return false;
+}
+
+Automaton::CharacterSet Automaton::character_set_for_char(u32 ch) const
+{
+    CharacterSet set {};
+    if (ch > 0xff)
+        return set;
+    for (u32 byte = 0; byte < 256; ++byte) {
+        if (m_insensitive ? tolower(byte) == tolower(ch) : byte == ch)
+            set[byte >> 6] |= 1ull << (byte & 63);
+    }
+    return set;
+}
+
+bool Automaton::can_handle(AllOptions options, const RegexStringView& view) const
+{
+    return view.is_u8_view()
+        && options.has_flag_set(AllFlags::Insensitive) == m_insensitive
+        && !options.has_flag_set(AllFlags::MatchNotBeginOfLine)
+        && !options.has_flag_set(AllFlags::MatchNotEndOfLine);
+}
+
+void Automaton::add_thread(ThreadList& list, u32 node_index, const MatchInput& input, size_t position, Vector<size_t>& slots) const
+{
+    // Follows all epsilon edges from `node_index` in priority order, recording the
+    // consuming nodes that are reached. Capture slots are changed in place and
+    // restored on the way back, so `slots` is unchanged when this returns.
+    struct Frame {
+        u32 node;
+        bool is_restore;
+        size_t slot;
+        size_t value;
+    };
+    Vector<Frame, 32> stack;
+    stack.append({ node_index, false, 0, 0 });
+
+    auto save_slot = [&](size_t slot, size_t value) {
+        stack.append({ 0, true, slot, slots[slot] });
+        slots[slot] = value;
+    };
+
+    while (!stack.is_empty()) {
+        auto frame = stack.take_last();
+        if (frame.is_restore) {
+            slots[frame.slot] = frame.value;
+            continue;
+        }
+
+        auto current = frame.node;
+        for (;;) {
+            if (list.visited[current] == list.generation)
+                break;
+            list.visited[current] = list.generation;
+
+            auto& node = m_nodes[current];
+            switch (node.type) {
+            case NodeType::Jump:
+                current = node.next;
+                continue;
+            case NodeType::Split:
+                stack.append({ node.argument, false, 0, 0 });
+                current = node.next;
+                continue;
+            case NodeType::CheckBegin:
+                if (position != 0)
+                    break;
+                current = node.next;
+                continue;
+            case NodeType::CheckEnd:
+                if (position != input.view.length())
+                    break;
+                current = node.next;
+                continue;
+            case NodeType::CheckBoundary: {
+                MatchState state;
+                state.string_position = position;
+                state.instruction_position = node.argument;
+                MatchOutput output;
+                if (m_bytecode->get_opcode(state)->execute(input, state, output) != ExecutionResult::Continue)
+                    break;
+                current = node.next;
+                continue;
+            }
+            case NodeType::SaveLeftCaptureGroup:
+            case NodeType::SaveLeftNamedCaptureGroup: {
+                auto slot = node.type == NodeType::SaveLeftCaptureGroup ? numbered_slot(node.argument) : named_slot(node.argument);
+                save_slot(slot, position);
+                current = node.next;
+                continue;
+            }
+            case NodeType::SaveRightCaptureGroup: {
+                // Like the bytecode, ignore a group that would start before the previous capture of it.
+                auto slot = numbered_slot(node.argument);
+                auto left = slots[slot];
+                auto previous_start = slots[slot + 1] == c_unset_slot ? 0 : slots[slot + 1];
+                if (left != c_unset_slot && left >= previous_start) {
+                    save_slot(slot + 1, left);
+                    save_slot(slot + 2, position);
+                }
+                current = node.next;
+                continue;
+            }
+            case NodeType::SaveRightNamedCaptureGroup: {
+                auto slot = named_slot(node.argument);
+                if (slots[slot] != c_unset_slot) {
+                    save_slot(slot + 1, slots[slot]);
+                    save_slot(slot + 2, position);
+                }
+                current = node.next;
+                continue;
+            }
+            case NodeType::CharacterSet:
+            case NodeType::Accept:
+                list.nodes.append(current);
+                list.slots.append(slots.data(), slots.size());
+                break;
+            }
+            break;
+        }
+    }
+}
+
+Optional<Automaton::SearchResult> Automaton::search(const MatchInput& input, size_t start_position, bool anchored, size_t& operations) const
+{
+    auto length = input.view.length();
+    if (start_position >= length)
+        return {};
+
+    if (!may_match(input, start_position, anchored))
+        return {};
+
+    auto view = input.view.u8view();
+
+    ThreadList current { m_nodes.size() };
+    ThreadList next { m_nodes.size() };
+
+    Vector<size_t> slots;
+    slots.resize(m_slot_count);
+
+    Optional<SearchResult> result;
+    for (size_t position = start_position;; ++position) {
+        // New threads start with the lowest priority, so an earlier start always wins.
+        if (!result.has_value() && position < length && (position == start_position || !anchored)) {
+            for (auto& slot : slots)
+                slot = c_unset_slot;
+            slots[0] = position;
+            add_thread(current, 0, input, position, slots);
+        }
+
+        if (current.nodes.is_empty())
+            break;
+
+        for (size_t i = 0; i < current.nodes.size(); ++i) {
+            ++operations;
+            auto& node = m_nodes[current.nodes[i]];
+            auto* thread_slots = current.slots.data() + i * m_slot_count;
+
+            if (node.type == NodeType::Accept) {
+                // Every thread after this one has a lower priority, so it can't produce the match anymore.
+                result = SearchResult { thread_slots[0], position, {} };
+                result->slots.append(thread_slots, m_slot_count);
+                break;
+            }
+
+            if (position < length && character_set_contains(m_character_sets[node.argument], (u8)view[position])) {
+                for (size_t slot = 0; slot < m_slot_count; ++slot)
+                    slots[slot] = thread_slots[slot];
+                add_thread(next, node.next, input, position + 1, slots);
+            }
+        }
+
+        if (position == length)
+            break;
+
+        swap(current, next);
+        next.clear();
+    }
+
+    return result;
+}
+
+void Automaton::append_capture_groups(const MatchInput& input, const SearchResult& result, MatchOutput& output) const
+{
+    auto make_match = [&](size_t start, size_t end) -> Match {
+        auto view = input.view.substring_view(start, end - start);
+        if (input.regex_options.has_flag_set(AllFlags::StringCopyMatches))
+            return { view.to_string(), input.line, start, input.global_offset + start };
+        return { view, input.line, start, input.global_offset + start };
+    };
+
+    if (m_capture_group_count) {
+        while (output.capture_group_matches.size() <= input.match_index)
+            output.capture_group_matches.empend();
+        auto& groups = output.capture_group_matches.at(input.match_index);
+        groups.clear();
+        groups.resize(m_capture_group_count);
+        for (size_t id = 0; id < m_capture_group_count; ++id) {
+            auto slot = numbered_slot(id);
+            if (result.slots[slot + 2] != c_unset_slot)
+                groups[id] = make_match(result.slots[slot + 1], result.slots[slot + 2]);
+        }
+    }
+
+    if (!m_capture_group_names.is_empty()) {
+        while (output.named_capture_group_matches.size() <= input.match_index)
+            output.named_capture_group_matches.empend();
+        auto& groups = output.named_capture_group_matches.at(input.match_index);
+        groups.clear();
+        for (size_t i = 0; i < m_capture_group_names.size(); ++i) {
+            auto slot = named_slot(i);
+            if (result.slots[slot + 2] != c_unset_slot)
+                groups.set(m_capture_group_names[i], make_match(result.slots[slot + 1], result.slots[slot + 2]));
+        }
+    }
+}
+
+bool Automaton::may_match(const MatchInput& input, size_t start_position, bool anchored) const
+{
+    // Word boundaries depend on the surrounding characters, which the DFA states don't track.
+    if (m_has_boundary_checks || m_dfa_exhausted)
+        return true;
+
+    auto length = input.view.length();
+    auto view = input.view.u8view();
+    u32 anchoring = anchored ? 0 : dfa_context_unanchored;
+
+    Vector<u32> kernel;
+    kernel.append(0);
+    auto state_index = dfa_state_for(kernel, anchoring | (start_position == 0 ? dfa_context_at_begin : 0) | (start_position == length ? dfa_context_at_end : 0));
+    if (!state_index.has_value())
+        return true;
+
+    for (size_t position = start_position;; ++position) {
+        auto& state = m_dfa_states[state_index.value()];
+        if (state.accepting)
+            return true;
+        if (position == length || (anchored && state.nodes.is_empty()))
+            return false;
+
+        u8 ch = view[position];
+        bool at_end = position + 1 == length;
+        if (!at_end && state.transitions[ch] >= 0) {
+            state_index = state.transitions[ch];
+            continue;
+        }
+
+        kernel.clear_with_capacity();
+        for (auto node : state.nodes) {
+            if (character_set_contains(m_character_sets[m_nodes[node].argument], ch))
+                kernel.append(m_nodes[node].next);
+        }
+
+        if (!anchored && !at_end)
+            kernel.append(0);
+
+        auto source_index = state_index.value();
+        state_index = dfa_state_for(kernel, anchoring | (at_end ? dfa_context_at_end : 0));
+        if (!state_index.has_value())
+            return true;
+
+        // The state at the end of the input is context dependent, so only cache transitions in the middle.
+        if (!at_end)
+            m_dfa_states[source_index].transitions[ch] = state_index.value();
+    }
+}
+
+Optional<u32> Automaton::dfa_state_for(Vector<u32>& kernel, u32 context) const
+{
+    Vector<bool> visited;
+    visited.ensure_capacity(m_nodes.size());
+    for (size_t i = 0; i < m_nodes.size(); ++i)
+        visited.unchecked_append(false);
+    Vector<u32> nodes;
+    bool accepting = false;
+
+    while (!kernel.is_empty()) {
+        auto current = kernel.take_last();
+        if (visited[current])
+            continue;
+        visited[current] = true;
+
+        auto& node = m_nodes[current];
+        switch (node.type) {
+        case NodeType::CharacterSet:
+            nodes.append(current);
+            break;
+        case NodeType::Accept:
+            accepting = true;
+            break;
+        case NodeType::Split:
+            kernel.append(node.argument);
+            kernel.append(node.next);
+            break;
+        case NodeType::CheckBegin:
+            if (context & dfa_context_at_begin)
+                kernel.append(node.next);
+            break;
+        case NodeType::CheckEnd:
+            if (context & dfa_context_at_end)
+                kernel.append(node.next);
+            break;
+        case NodeType::CheckBoundary:
+            VERIFY_NOT_REACHED();
+        default:
+            kernel.append(node.next);
+            break;
+        }
+    }
+
+    quick_sort(nodes);
+    auto key = nodes;
+    key.append(context | (accepting ? dfa_context_accepting : 0));
+
+    if (auto existing = m_dfa_state_map.get(key); existing.has_value())
+        return existing.value();
+
+    if (m_dfa_states.size() >= c_max_dfa_states) {
+        dbgln_if(REGEX_DEBUG, "[automaton] DFA cache is full, falling back to the NFA");
+        m_dfa_exhausted = true;
+        return {};
+    }
+
+    auto index = (u32)m_dfa_states.size();
+    DFAState state;
+    state.nodes = move(nodes);
+    state.accepting = accepting;
+    state.transitions.fill(-1);
+    m_dfa_states.append(move(state));
+    m_dfa_state_map.set(move(key), index);
+    return index;
+}
+
+}
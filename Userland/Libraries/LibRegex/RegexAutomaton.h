@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "RegexByteCode.h"
+#include "RegexMatch.h"
+#include "RegexOptions.h"
+
+#include <AK/Array.h>
+#include <AK/HashMap.h>
+#include <AK/OwnPtr.h>
+#include <AK/Traits.h>
+#include <AK/Vector.h>
+
+namespace regex {
+
+// A Thompson NFA compiled from the backtracking bytecode.
+//
+// Patterns without backreferences, lookarounds and loops that can match nothing can
+// be matched by simulating all bytecode paths in lockstep instead of trying them one
+// after another, which bounds the work to O(input length * pattern size). The threads
+// are kept in the same priority order the backtracker would try them in, so the match
+// extents come out identical (and captures from abandoned paths no longer leak).
+//
+// On top of that, a lazily built DFA (one state per set of NFA states, built on
+// first use and cached) answers whether there is any match at all; this is the
+// common case for grep-like callers, and costs one table lookup per input byte.
+class Automaton {
+public:
+    static OwnPtr<Automaton> compile(const ByteCode&, AllOptions, size_t capture_groups_count);
+
+    struct SearchResult {
+        size_t start { 0 };
+        size_t end { 0 };
+        Vector<size_t> slots;
+    };
+
+    // Whether a match call with these options on this view can be answered by the automaton.
+    bool can_handle(AllOptions, const RegexStringView&) const;
+
+    // Finds the match starting at `start_position` (if anchored), or the leftmost match
+    // starting at or after it (otherwise). Matches never start at the end of the view.
+    Optional<SearchResult> search(const MatchInput&, size_t start_position, bool anchored, size_t& operations) const;
+
+    void append_capture_groups(const MatchInput&, const SearchResult&, MatchOutput&) const;
+
+private:
+    enum class NodeType : u8 {
+        CharacterSet,
+        Jump,
+        Split,
+        CheckBegin,
+        CheckEnd,
+        CheckBoundary,
+        SaveLeftCaptureGroup,
+        SaveRightCaptureGroup,
+        SaveLeftNamedCaptureGroup,
+        SaveRightNamedCaptureGroup,
+        Accept,
+    };
+
+    struct Node {
+        NodeType type;
+        u32 next { 0 };
+        // Split: the lower priority branch. CharacterSet: index into m_character_sets.
+        // CheckBoundary: the bytecode position of the opcode. Save*: the capture group index.
+        u32 argument { 0 };
+    };
+
+    using CharacterSet = Array<u64, 4>;
+
+    static bool character_set_contains(const CharacterSet& set, u8 ch) { return set[ch >> 6] & (1ull << (ch & 63)); }
+    CharacterSet character_set_for_char(u32) const;
+
+    // Whether some loop body can be passed through without consuming any input.
+    bool has_empty_loop() const;
+
+    struct ThreadList;
+    void add_thread(ThreadList&, u32 node, const MatchInput&, size_t position, Vector<size_t>& slots) const;
+
+    struct DFAState {
+        Vector<u32> nodes;
+        bool accepting { false };
+        Array<i32, 256> transitions;
+    };
+
+    // Where in the input a DFA state is, which decides how the assertions in it are resolved.
+    static constexpr u32 dfa_context_at_begin = 1;
+    static constexpr u32 dfa_context_at_end = 2;
+    static constexpr u32 dfa_context_unanchored = 4;
+    static constexpr u32 dfa_context_accepting = 8;
+
+    // Returns false only if no match can start at `start_position` (or later, if not anchored).
+    bool may_match(const MatchInput&, size_t start_position, bool anchored) const;
+    Optional<u32> dfa_state_for(Vector<u32>& kernel, u32 context) const;
+
+    size_t numbered_slot(size_t id) const { return 1 + 3 * id; }
+    size_t named_slot(size_t index) const { return 1 + 3 * m_capture_group_count + 3 * index; }
+
+    Vector<Node> m_nodes;
+    Vector<CharacterSet> m_character_sets;
+    Vector<StringView> m_capture_group_names;
+    size_t m_capture_group_count { 0 };
+    size_t m_slot_count { 0 };
+    bool m_has_boundary_checks { false };
+    bool m_insensitive { false };
+    const ByteCode* m_bytecode { nullptr };
+
+    mutable Vector<DFAState> m_dfa_states;
+    // Keyed on the sorted NFA nodes of a state, followed by its context bits.
+    struct DFAStateKeyTraits : public GenericTraits<Vector<u32>> {
+        static unsigned hash(const Vector<u32>& key)
+        {
+            unsigned hash = 0;
+            for (auto value : key)
+                hash = pair_int_hash(hash, value);
+            return hash;
+        }
+    };
+    mutable HashMap<Vector<u32>, u32, DFAStateKeyTraits> m_dfa_state_map;
+    mutable bool m_dfa_exhausted { false };
+};
+
+}
@@ -445,17 +445,15 @@ ALWAYS_INLINE ExecutionResult OpCode_Compare::execute(const MatchInput& input, M
         } else if (compare_type == CharacterCompareType::String) {
             VERIFY(!current_inversion_state());
 
-            const auto& length = m_bytecode->at(offset++);
-            StringBuilder str_builder;
-            for (size_t i = 0; i < length; ++i)
-                str_builder.append(m_bytecode->at(offset++));
+            auto length = (size_t)m_bytecode->at(offset++);
 
             // We want to compare a string that is definitely longer than the available string
             if (input.view.length() - state.string_position < length)
                 return ExecutionResult::Failed_ExecuteLowPrioForks;
 
-            if (!compare_string(input, state, str_builder.string_view().characters_without_null_termination(), length))
+            if (!compare_string_literal(input, state, offset, length))
                 return ExecutionResult::Failed_ExecuteLowPrioForks;
+            offset += length;
 
         } else if (compare_type == CharacterCompareType::CharClass) {
 
@@ -565,6 +563,26 @@ ALWAYS_INLINE bool OpCode_Compare::compare_string(const MatchInput& input, Match
     return false;
 }
 
+ALWAYS_INLINE bool OpCode_Compare::compare_string_literal(const MatchInput& input, MatchState& state, size_t offset, size_t length) const
+{
+    // Compared one character at a time (exactly like a chain of Char comparisons would be),
+    // so that this works on any kind of view without building a copy of the string.
+    bool insensitive = input.regex_options & AllFlags::Insensitive;
+    for (size_t i = 0; i < length; ++i) {
+        u32 ch1 = m_bytecode->at(offset + i);
+        u32 ch2 = input.view[state.string_position + i];
+        if (insensitive) {
+            ch1 = tolower(ch1);
+            ch2 = tolower(ch2);
+        }
+        if (ch1 != ch2)
+            return false;
+    }
+
+    state.string_position += length;
+    return true;
+}
+
 ALWAYS_INLINE void OpCode_Compare::compare_character_class(const MatchInput& input, MatchState& state, CharClass character_class, u32 ch, bool inverse, bool& inverse_matched)
 {
     switch (character_class) {
@@ -461,7 +461,7 @@ private:
     {
         empend((ByteCodeValueType)view.length());
         for (size_t i = 0; i < view.length(); ++i)
-            empend((ByteCodeValueType)view[i]);
+            empend((ByteCodeValueType)(u8)view[i]);
     }
 
     ALWAYS_INLINE OpCode* get_opcode_by_id(OpCodeId id) const;
@@ -769,6 +769,7 @@ public:
 private:
     ALWAYS_INLINE static void compare_char(const MatchInput& input, MatchState& state, u32 ch1, bool inverse, bool& inverse_matched);
     ALWAYS_INLINE static bool compare_string(const MatchInput& input, MatchState& state, const char* str, size_t length);
+    ALWAYS_INLINE bool compare_string_literal(const MatchInput& input, MatchState& state, size_t offset, size_t length) const;
     ALWAYS_INLINE static void compare_character_class(const MatchInput& input, MatchState& state, CharClass character_class, u32 ch, bool inverse, bool& inverse_matched);
     ALWAYS_INLINE static void compare_character_range(const MatchInput& input, MatchState& state, u32 from, u32 to, u32 ch, bool inverse, bool& inverse_matched);
 };
@@ -28,9 +28,11 @@
 #include "RegexDebug.h"
 #include "RegexParser.h"
 #include <AK/Debug.h>
+#include <AK/MemMem.h>
 #include <AK/ScopedValueRollback.h>
 #include <AK/String.h>
 #include <AK/StringBuilder.h>
+#include <string.h>
 
 namespace regex {
 
@@ -47,8 +49,10 @@ Regex<Parser>::Regex(StringView pattern, typename ParserTraits<Parser>::OptionsT
     Parser parser(lexer, regex_options);
     parser_result = parser.parse();
 
-    if (parser_result.error == regex::Error::NoError)
+    if (parser_result.error == regex::Error::NoError) {
+        Optimizer::fuse_compares(parser_result.bytecode);
         matcher = make<Matcher<Parser>>(*this, regex_options);
+    }
 }
 
 template<class Parser>
@@ -154,6 +158,13 @@ RegexResult Matcher<Parser>::match(const Vector<RegexStringView> views, Optional
         size_t view_index = m_pattern.start_offset;
         state.string_position = view_index;
 
+        bool use_automaton = m_automaton && m_automaton->can_handle(input.regex_options, view);
+        bool searching = continue_search || input.regex_options.has_flag_set(AllFlags::Internal_Stateful);
+
+        // The hints only describe byte strings, compared the way the pattern was compiled.
+        bool use_hints = view.is_u8_view()
+            && input.regex_options.has_flag_set(AllFlags::Insensitive) == (bool)((AllFlags)m_regex_options.value() & AllFlags::Insensitive);
+
         if (view_index == view_length && m_pattern.parser_result.match_length_minimum == 0) {
             // Run the code until it tries to consume something.
             // This allows non-consuming code to run on empty strings, for instance
@@ -180,7 +191,25 @@ RegexResult Matcher<Parser>::match(const Vector<RegexStringView> views, Optional
             }
         }
 
+        if (use_hints && !m_hints.required_substring.is_empty() && view_index < view_length) {
+            // If the input doesn't contain the substring, there is no need to look at it any further.
+            auto& substring = m_hints.required_substring;
+            if (!AK::memmem_optional(view.u8view().characters_without_null_termination() + view_index, view_length - view_index, substring.characters(), substring.length()).has_value()) {
+                state.string_position = 0;
+                view_index = view_length;
+            }
+        }
+
         for (; view_index < view_length; ++view_index) {
+            if (use_hints) {
+                auto possible_start = find_possible_match_start(input, view_index);
+                if (!possible_start.has_value() || (!searching && possible_start.value() != view_index)) {
+                    state.string_position = 0;
+                    break;
+                }
+                view_index = possible_start.value();
+            }
+
             auto& match_length_minimum = m_pattern.parser_result.match_length_minimum;
             // FIXME: More performant would be to know the remaining minimum string
             //        length needed to match from the current position onwards within
@@ -197,7 +226,22 @@ RegexResult Matcher<Parser>::match(const Vector<RegexStringView> views, Optional
             state.string_position = view_index;
             state.instruction_position = 0;
 
-            auto success = execute(input, state, output, 0);
+            Optional<bool> success;
+            if (use_automaton) {
+                // The automaton looks for the leftmost match itself, so if it doesn't find one,
+                // there is no point in trying any of the following positions either.
+                auto result = m_automaton->search(input, view_index, !searching, output.operations);
+                if (!result.has_value()) {
+                    state.string_position = 0;
+                    break;
+                }
+                view_index = result->start;
+                state.string_position = result->end;
+                m_automaton->append_capture_groups(input, *result, output);
+                success = true;
+            } else {
+                success = execute(input, state, output, 0);
+            }
             if (!success.has_value())
                 return { false, 0, {}, {}, {}, output.operations };
 
@@ -363,6 +407,41 @@ Optional<bool> Matcher<Parser>::execute(const MatchInput& input, MatchState& sta
     VERIFY_NOT_REACHED();
 }
 
+template<class Parser>
+Optional<size_t> Matcher<Parser>::find_possible_match_start(const MatchInput& input, size_t view_index) const
+{
+    if (m_hints.anchored_at_begin && view_index > 0 && !input.regex_options.has_flag_set(AllFlags::MatchNotBeginOfLine))
+        return {};
+
+    auto view = input.view.u8view();
+    auto* characters = reinterpret_cast<const u8*>(view.characters_without_null_termination());
+    auto length = view.length();
+
+    if (auto& prefix = m_hints.required_prefix; !prefix.is_empty()) {
+        while (view_index + prefix.length() <= length) {
+            auto* candidate = static_cast<const u8*>(memchr(characters + view_index, prefix[0], length - view_index - prefix.length() + 1));
+            if (!candidate)
+                return {};
+            view_index = candidate - characters;
+            if (!memcmp(candidate, prefix.characters(), prefix.length()))
+                return view_index;
+            ++view_index;
+        }
+        return {};
+    }
+
+    if (m_hints.first_bytes.has_value()) {
+        auto& first_bytes = m_hints.first_bytes.value();
+        for (; view_index < length; ++view_index) {
+            if (Optimizer::byte_set_contains(first_bytes, characters[view_index]))
+                return view_index;
+        }
+        return {};
+    }
+
+    return view_index;
+}
+
 template<class Parser>
 ALWAYS_INLINE Optional<bool> Matcher<Parser>::execute_low_prio_forks(const MatchInput& input, MatchState& original_state, MatchOutput& output, Vector<MatchState> states, size_t recursion_level) const
 {
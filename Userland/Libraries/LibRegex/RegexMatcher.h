@@ -26,8 +26,10 @@
 
 #pragma once
 
+#include "RegexAutomaton.h"
 #include "RegexByteCode.h"
 #include "RegexMatch.h"
+#include "RegexOptimizer.h"
 #include "RegexOptions.h"
 #include "RegexParser.h"
 
@@ -67,6 +69,8 @@ public:
     Matcher(const Regex<Parser>& pattern, Optional<typename ParserTraits<Parser>::OptionsType> regex_options = {})
         : m_pattern(pattern)
         , m_regex_options(regex_options.value_or({}))
+        , m_automaton(Automaton::compile(pattern.parser_result.bytecode, m_regex_options, pattern.parser_result.capture_groups_count))
+        , m_hints(Optimizer::compute_match_hints(pattern.parser_result.bytecode, m_regex_options))
     {
     }
     ~Matcher() = default;
@@ -81,10 +85,15 @@ public:
 
 private:
     Optional<bool> execute(const MatchInput& input, MatchState& state, MatchOutput& output, size_t recursion_level) const;
+    Optional<size_t> find_possible_match_start(const MatchInput&, size_t view_index) const;
     ALWAYS_INLINE Optional<bool> execute_low_prio_forks(const MatchInput& input, MatchState& original_state, MatchOutput& output, Vector<MatchState> states, size_t recursion_level) const;
 
     const Regex<Parser>& m_pattern;
     const typename ParserTraits<Parser>::OptionsType m_regex_options;
+
+    // Present if the pattern can be matched without backtracking (no backreferences or lookarounds).
+    OwnPtr<Automaton> m_automaton;
+    Optimizer::MatchHints m_hints;
 };
 
 template<class Parser>
@@ -0,0 +1,420 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "RegexOptimizer.h"
+#include "RegexMatch.h"
+#include <AK/Debug.h>
+#include <AK/HashMap.h>
+#include <AK/HashTable.h>
+#include <AK/StringBuilder.h>
+
+#include <ctype.h>
+
+namespace regex {
+
+// Finding the literals that every match contains is quadratic in the number of opcodes.
+static constexpr size_t c_max_instructions_for_required_literals = 512;
+
+struct Instruction {
+    size_t position;
+    size_t size;
+    OpCodeId id;
+};
+
+static Vector<Instruction> decode(const ByteCode& bytecode)
+{
+    Vector<Instruction> instructions;
+    MatchState state;
+    while (state.instruction_position < bytecode.size()) {
+        auto* opcode = bytecode.get_opcode(state);
+        if (!opcode)
+            return {};
+        instructions.append({ state.instruction_position, opcode->size(), opcode->opcode_id() });
+        state.instruction_position += opcode->size();
+    }
+    return instructions;
+}
+
+static bool is_jump(OpCodeId id)
+{
+    return id == OpCodeId::Jump || id == OpCodeId::ForkJump || id == OpCodeId::ForkStay;
+}
+
+static size_t jump_target(const ByteCode& bytecode, const Instruction& instruction)
+{
+    // All jumps store their offset relative to the following instruction.
+    return instruction.position + instruction.size + (ssize_t)bytecode.at(instruction.position + 1);
+}
+
+// If the instruction compares against a literal (a single character or a string), appends its characters.
+static bool append_literal(const ByteCode& bytecode, const Instruction& instruction, Vector<ByteCodeValueType>& literal)
+{
+    if (instruction.id != OpCodeId::Compare || bytecode.at(instruction.position + 1) != 1)
+        return false;
+
+    switch ((CharacterCompareType)bytecode.at(instruction.position + 3)) {
+    case CharacterCompareType::Char: {
+        auto ch = bytecode.at(instruction.position + 4);
+        if (ch > 0xff)
+            return false;
+        literal.append(ch);
+        return true;
+    }
+    case CharacterCompareType::String: {
+        auto length = bytecode.at(instruction.position + 4);
+        for (size_t i = 0; i < length; ++i)
+            literal.append(bytecode.at(instruction.position + 5 + i));
+        return length > 0;
+    }
+    default:
+        return false;
+    }
+}
+
+static String literal_to_string(const Vector<ByteCodeValueType>& literal)
+{
+    StringBuilder builder(literal.size());
+    for (auto ch : literal)
+        builder.append((char)ch);
+    return builder.to_string();
+}
+
+void Optimizer::fuse_compares(ByteCode& bytecode)
+{
+    auto instructions = decode(bytecode);
+    if (instructions.size() < 2)
+        return;
+
+    // A run of comparisons can only be merged if nothing jumps into the middle of it.
+    HashTable<size_t> jump_targets;
+    for (auto& instruction : instructions) {
+        if (is_jump(instruction.id))
+            jump_targets.set(jump_target(bytecode, instruction));
+    }
+
+    struct PendingJump {
+        size_t position;
+        size_t old_target;
+    };
+    Vector<PendingJump> pending_jumps;
+    HashMap<size_t, size_t> new_positions;
+    ByteCode fused;
+
+    size_t fused_count = 0;
+    for (size_t i = 0; i < instructions.size();) {
+        auto& instruction = instructions[i];
+        new_positions.set(instruction.position, fused.size());
+
+        Vector<ByteCodeValueType> literal;
+        size_t end = i;
+        while (end < instructions.size() && (end == i || !jump_targets.contains(instructions[end].position)) && append_literal(bytecode, instructions[end], literal))
+            ++end;
+
+        if (end - i > 1) {
+            fused.empend(static_cast<ByteCodeValueType>(OpCodeId::Compare));
+            fused.empend(static_cast<ByteCodeValueType>(1)); // number of arguments
+            fused.empend(literal.size() + 2);                // size of arguments
+            fused.empend(static_cast<ByteCodeValueType>(CharacterCompareType::String));
+            fused.empend(literal.size());
+            fused.append(literal.data(), literal.size());
+            fused_count += end - i;
+            i = end;
+            continue;
+        }
+
+        if (is_jump(instruction.id))
+            pending_jumps.append({ fused.size(), jump_target(bytecode, instruction) });
+        for (size_t j = 0; j < instruction.size; ++j)
+            fused.append(bytecode.at(instruction.position + j));
+        ++i;
+    }
+
+    if (!fused_count)
+        return;
+
+    new_positions.set(bytecode.size(), fused.size());
+    for (auto& jump : pending_jumps) {
+        auto new_target = new_positions.get(jump.old_target);
+        if (!new_target.has_value())
+            return;
+        fused[jump.position + 1] = (ByteCodeValueType)(new_target.value() - (jump.position + 2));
+    }
+
+    dbgln_if(REGEX_DEBUG, "[optimizer] Fused {} comparisons, bytecode size {} -> {}", fused_count, bytecode.size(), fused.size());
+    bytecode = move(fused);
+}
+
+static bool compare_uses_references(const ByteCode& bytecode, size_t position)
+{
+    auto arguments_count = bytecode.at(position + 1);
+    size_t offset = position + 3;
+    for (size_t i = 0; i < arguments_count; ++i) {
+        switch ((CharacterCompareType)bytecode.at(offset++)) {
+        case CharacterCompareType::Inverse:
+        case CharacterCompareType::TemporaryInverse:
+        case CharacterCompareType::AnyChar:
+            break;
+        case CharacterCompareType::String:
+            offset += bytecode.at(offset) + 1;
+            break;
+        case CharacterCompareType::Reference:
+        case CharacterCompareType::NamedReference:
+            return true;
+        default:
+            ++offset;
+            break;
+        }
+    }
+    return false;
+}
+
+Optional<Optimizer::ByteSet> Optimizer::bytes_accepted_by_compare(const ByteCode& bytecode, size_t position, AllOptions options)
+{
+    // References need the captures of an actual match to compare against.
+    if (compare_uses_references(bytecode, position))
+        return {};
+
+    ByteSet set {};
+    MatchInput input;
+    input.regex_options = options;
+    MatchOutput output;
+    for (u32 byte = 0; byte < 256; ++byte) {
+        // Let the opcode itself decide which bytes it accepts, so that all the quirks of inversion,
+        // character classes and case folding carry over. The second copy of the byte tells apart
+        // comparisons that consume more than one character.
+        char buffer[2] = { (char)byte, (char)byte };
+        input.view = StringView { buffer, 2 };
+        MatchState state;
+        state.instruction_position = position;
+        auto result = bytecode.get_opcode(state)->execute(input, state, output);
+        if (result != ExecutionResult::Continue)
+            continue;
+        if (state.string_position != 1)
+            return {};
+        set[byte >> 6] |= 1ull << (byte & 63);
+    }
+    return set;
+}
+
+static Optional<Optimizer::ByteSet> compute_first_bytes(const ByteCode& bytecode, const Vector<Instruction>& instructions, AllOptions options)
+{
+    HashMap<size_t, size_t> index_for_position;
+    for (size_t i = 0; i < instructions.size(); ++i)
+        index_for_position.set(instructions[i].position, i);
+
+    Optimizer::ByteSet set {};
+    HashTable<size_t> visited;
+    Vector<size_t> stack;
+    stack.append(0);
+    while (!stack.is_empty()) {
+        auto position = stack.take_last();
+        if (visited.set(position) != AK::HashSetResult::InsertedNewEntry)
+            continue;
+
+        auto index = index_for_position.get(position);
+        // Falling off the end means that a match can be empty.
+        if (!index.has_value())
+            return {};
+
+        auto& instruction = instructions[index.value()];
+        auto next = instruction.position + instruction.size;
+        switch (instruction.id) {
+        case OpCodeId::Compare: {
+            Optional<Optimizer::ByteSet> bytes;
+            Vector<ByteCodeValueType> literal;
+            if (append_literal(bytecode, instruction, literal)) {
+                bytes = Optimizer::ByteSet {};
+                bool insensitive = options.has_flag_set(AllFlags::Insensitive);
+                for (u32 byte = 0; byte < 256; ++byte) {
+                    if (insensitive ? tolower(byte) == tolower(literal.first()) : byte == literal.first())
+                        bytes.value()[byte >> 6] |= 1ull << (byte & 63);
+                }
+            } else {
+                bytes = Optimizer::bytes_accepted_by_compare(bytecode, position, options);
+            }
+            if (!bytes.has_value())
+                return {};
+            for (size_t i = 0; i < set.size(); ++i)
+                set[i] |= bytes.value()[i];
+            break;
+        }
+        case OpCodeId::Jump:
+            stack.append(jump_target(bytecode, instruction));
+            break;
+        case OpCodeId::ForkJump:
+        case OpCodeId::ForkStay:
+            stack.append(jump_target(bytecode, instruction));
+            stack.append(next);
+            break;
+        case OpCodeId::SaveLeftCaptureGroup:
+        case OpCodeId::SaveRightCaptureGroup:
+        case OpCodeId::SaveLeftNamedCaptureGroup:
+        case OpCodeId::SaveRightNamedCaptureGroup:
+        case OpCodeId::CheckBegin:
+        case OpCodeId::CheckEnd:
+        case OpCodeId::CheckBoundary:
+            stack.append(next);
+            break;
+        default:
+            return {};
+        }
+    }
+
+    for (auto bits : set) {
+        if (bits != NumericLimits<u64>::max())
+            return set;
+    }
+    return {};
+}
+
+// Whether the end of the bytecode can be reached from its start without passing through `avoided_index`.
+static bool can_finish_without(const ByteCode& bytecode, const Vector<Instruction>& instructions, const HashMap<size_t, size_t>& index_for_position, size_t avoided_index)
+{
+    Vector<bool> visited;
+    visited.ensure_capacity(instructions.size());
+    for (size_t i = 0; i < instructions.size(); ++i)
+        visited.unchecked_append(false);
+
+    Vector<size_t> stack;
+    stack.append(0);
+    while (!stack.is_empty()) {
+        auto index = stack.take_last();
+        if (index == instructions.size())
+            return true;
+        if (index == avoided_index || visited[index])
+            continue;
+        visited[index] = true;
+
+        auto& instruction = instructions[index];
+        auto push_position = [&](size_t position) {
+            if (position >= bytecode.size()) {
+                stack.append(instructions.size());
+                return;
+            }
+            if (auto target = index_for_position.get(position); target.has_value())
+                stack.append(target.value());
+        };
+        switch (instruction.id) {
+        case OpCodeId::Exit:
+            stack.append(instructions.size());
+            break;
+        case OpCodeId::Jump:
+            push_position(jump_target(bytecode, instruction));
+            break;
+        case OpCodeId::ForkJump:
+        case OpCodeId::ForkStay:
+            push_position(jump_target(bytecode, instruction));
+            push_position(instruction.position + instruction.size);
+            break;
+        default:
+            push_position(instruction.position + instruction.size);
+            break;
+        }
+    }
+    return false;
+}
+
+Optimizer::MatchHints Optimizer::compute_match_hints(const ByteCode& bytecode, AllOptions options)
+{
+    MatchHints hints;
+    auto instructions = decode(bytecode);
+    if (instructions.is_empty())
+        return hints;
+
+    bool insensitive = options.has_flag_set(AllFlags::Insensitive);
+
+    // Everything up to the first branch is run for every match, in order.
+    Vector<ByteCodeValueType> prefix;
+    size_t prefix_end = 0;
+    for (; prefix_end < instructions.size(); ++prefix_end) {
+        auto& instruction = instructions[prefix_end];
+        if (instruction.id == OpCodeId::CheckBegin) {
+            if (prefix.is_empty())
+                hints.anchored_at_begin = true;
+            continue;
+        }
+        if (instruction.id == OpCodeId::SaveLeftCaptureGroup || instruction.id == OpCodeId::SaveRightCaptureGroup
+            || instruction.id == OpCodeId::SaveLeftNamedCaptureGroup || instruction.id == OpCodeId::SaveRightNamedCaptureGroup
+            || instruction.id == OpCodeId::CheckBoundary)
+            continue;
+        if (!append_literal(bytecode, instruction, prefix))
+            break;
+    }
+    if (!insensitive && !prefix.is_empty())
+        hints.required_prefix = literal_to_string(prefix);
+
+    hints.first_bytes = compute_first_bytes(bytecode, instructions, options);
+    if (hints.required_prefix.is_empty() && hints.first_bytes.has_value()) {
+        // A single possible first byte is as good as a prefix, and can be looked for with memchr().
+        Optional<u8> only_byte;
+        size_t count = 0;
+        for (u32 byte = 0; byte < 256; ++byte) {
+            if (byte_set_contains(hints.first_bytes.value(), byte)) {
+                only_byte = byte;
+                ++count;
+            }
+        }
+        if (count == 1)
+            hints.required_prefix = String { (const char*)&only_byte.value(), 1 };
+    }
+
+    // Past the first branch, look for the longest literal that no path through the pattern can avoid.
+    // Lookarounds are left alone, as what they compare against lies outside of the match.
+    if (insensitive || instructions.size() > c_max_instructions_for_required_literals)
+        return hints;
+    for (auto& instruction : instructions) {
+        switch (instruction.id) {
+        case OpCodeId::Save:
+        case OpCodeId::Restore:
+        case OpCodeId::GoBack:
+        case OpCodeId::FailForks:
+            return hints;
+        default:
+            break;
+        }
+    }
+
+    HashMap<size_t, size_t> index_for_position;
+    for (size_t i = 0; i < instructions.size(); ++i)
+        index_for_position.set(instructions[i].position, i);
+
+    Vector<ByteCodeValueType> required;
+    for (size_t i = prefix_end; i < instructions.size(); ++i) {
+        Vector<ByteCodeValueType> literal;
+        if (!append_literal(bytecode, instructions[i], literal) || literal.size() <= required.size())
+            continue;
+        if (!can_finish_without(bytecode, instructions, index_for_position, i))
+            required = move(literal);
+    }
+    if (!required.is_empty())
+        hints.required_substring = literal_to_string(required);
+
+    dbgln_if(REGEX_DEBUG, "[optimizer] Prefix '{}', required substring '{}', anchored: {}, first bytes known: {}",
+        hints.required_prefix, hints.required_substring, hints.anchored_at_begin, hints.first_bytes.has_value());
+    return hints;
+}
+
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "RegexByteCode.h"
+#include "RegexOptions.h"
+
+#include <AK/Array.h>
+#include <AK/Optional.h>
+#include <AK/String.h>
+
+namespace regex {
+
+class Optimizer {
+public:
+    using ByteSet = Array<u64, 4>;
+
+    static bool byte_set_contains(const ByteSet& set, u8 byte) { return set[byte >> 6] & (1ull << (byte & 63)); }
+
+    // What every match of a pattern looks like, which lets the matcher skip over
+    // positions (or entire inputs) without running the bytecode on them.
+    struct MatchHints {
+        // Matches can only start at the beginning of the input.
+        bool anchored_at_begin { false };
+        // Every match starts with this literal.
+        String required_prefix;
+        // Every match contains this literal.
+        String required_substring;
+        // Every match starts with one of these bytes.
+        Optional<ByteSet> first_bytes;
+    };
+
+    // Merges runs of single character comparisons into string comparisons,
+    // so that a literal is checked by one opcode instead of one per character.
+    static void fuse_compares(ByteCode&);
+
+    static MatchHints compute_match_hints(const ByteCode&, AllOptions);
+
+    // The bytes accepted by the Compare at `position`, found by running it on each of them.
+    // Empty if the comparison may consume more than one character.
+    static Optional<ByteSet> bytes_accepted_by_compare(const ByteCode&, size_t position, AllOptions);
+};
+
+}
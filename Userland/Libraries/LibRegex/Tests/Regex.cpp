@@ -582,6 +582,85 @@ TEST_CASE(ECMA262_match)
     }
 }
 
+TEST_CASE(nested_repetition_is_linear)
+{
+    // With a backtracking matcher, this takes exponential time in the length of the subject.
+    Regex<ECMA262> re("^(a+)+b$");
+    EXPECT_EQ(re.parser_result.error, Error::NoError);
+
+    StringBuilder builder;
+    for (size_t i = 0; i < 64; ++i)
+        builder.append('a');
+    auto subject = builder.to_string();
+    EXPECT_EQ(re.match(subject).success, false);
+
+    builder.append('b');
+    subject = builder.to_string();
+    auto result = re.match(subject);
+    EXPECT_EQ(result.success, true);
+    EXPECT_EQ(result.matches.first().view.length(), 65u);
+}
+
+TEST_CASE(automaton_capture_groups)
+{
+    Regex<ECMA262> re("([a-z]+)@(?<host>[a-z]+|[0-9]+)");
+    EXPECT_EQ(re.parser_result.error, Error::NoError);
+
+    auto result = re.search("mail foo@bar and baz@123!");
+    EXPECT_EQ(result.success, true);
+    EXPECT_EQ(result.count, 2u);
+    EXPECT_EQ(result.matches.at(0).view, "foo@bar");
+    EXPECT_EQ(result.matches.at(0).column, 5u);
+    EXPECT_EQ(result.capture_group_matches.at(0).first().view, "foo");
+    EXPECT_EQ(result.named_capture_group_matches.at(0).get("host").value().view, "bar");
+    EXPECT_EQ(result.matches.at(1).view, "baz@123");
+    EXPECT_EQ(result.capture_group_matches.at(1).first().view, "baz");
+    EXPECT_EQ(result.named_capture_group_matches.at(1).get("host").value().view, "123");
+
+    // Captures made on paths that fail later on must not leak into the result.
+    Regex<ECMA262> alternation("^(a|ab)(c|bcd)$");
+    result = alternation.match("abcd");
+    EXPECT_EQ(result.success, true);
+    EXPECT_EQ(result.matches.first().view, "abcd");
+    EXPECT_EQ(result.capture_group_matches.first().at(0).view, "a");
+    EXPECT_EQ(result.capture_group_matches.first().at(1).view, "bcd");
+
+    // Lookarounds still go through the backtracker.
+    Regex<ECMA262> lookahead("a(?=b)");
+    result = lookahead.search("acab");
+    EXPECT_EQ(result.success, true);
+    EXPECT_EQ(result.matches.first().column, 2u);
+}
+
+TEST_CASE(optimized_literals)
+{
+    Regex<ECMA262> re("ERROR: .*timeout");
+    EXPECT_EQ(re.parser_result.error, Error::NoError);
+
+    auto result = re.search("INFO: ok ERROR: disk timeout, ERROR: none");
+    EXPECT_EQ(result.success, true);
+    EXPECT_EQ(result.count, 1u);
+    EXPECT_EQ(result.matches.first().view, "ERROR: disk timeout");
+    EXPECT_EQ(result.matches.first().column, 9u);
+    EXPECT_EQ(re.search("ERROR: disk full").success, false);
+    EXPECT_EQ(re.search("INFO: timeout").success, false);
+
+    // Comparisons of merged literals still follow the options given at match time.
+    Regex<ECMA262> hello("hello");
+    EXPECT_EQ(hello.search("say HeLLo", ECMAScriptFlags::Insensitive).success, true);
+    EXPECT_EQ(hello.search("say HeLLo").success, false);
+
+    u32 code_points[] = { 's', 'a', 'y', ' ', 'h', 'e', 'l', 'l', 'o' };
+    result = hello.search(Utf32View { code_points, 9 });
+    EXPECT_EQ(result.success, true);
+    EXPECT_EQ(result.matches.first().column, 4u);
+
+    // Only the first position can match an anchored pattern.
+    Regex<ECMA262> anchored("^(ab|cd)");
+    EXPECT_EQ(anchored.search("xxab").success, false);
+    EXPECT_EQ(anchored.search("cdab").count, 1u);
+}
+
 TEST_CASE(replace)
 {
     struct _test {
@@ -88,6 +88,12 @@ ssize_t TLSv12::handle_hello(ReadonlyBytes buffer, WritePacketStage& write_packe
         return (i8)Error::NeedMoreData;
     }
 
+    // The server resumes the session we offered by echoing its session ID.
+    bool is_resuming_session = m_context.session_to_resume.has_value()
+        && session_length
+        && session_length == m_context.session_id_size
+        && memcmp(m_context.session_id, buffer.offset_pointer(res), session_length) == 0;
+
     if (session_length && session_length <= 32) {
         memcpy(m_context.session_id, buffer.offset_pointer(res), session_length);
         m_context.session_id_size = session_length;
@@ -114,9 +120,6 @@ ssize_t TLSv12::handle_hello(ReadonlyBytes buffer, WritePacketStage& write_packe
     m_context.cipher = cipher;
     dbgln_if(TLS_DEBUG, "Cipher: {}", (u16)cipher);
 
-    // The handshake hash function is _always_ SHA256
-    m_context.handshake_hash.initialize(Crypto::Hash::HashKind::SHA256);
-
     if (buffer.size() - res < 1) {
         dbgln("not enough data for compression spec");
         return (i8)Error::NeedMoreData;
@@ -197,9 +200,47 @@ ssize_t TLSv12::handle_hello(ReadonlyBytes buffer, WritePacketStage& write_packe
         }
     }
 
+    if (is_resuming_session) {
+        auto& session = m_context.session_to_resume.value();
+        if (session.cipher != m_context.cipher) {
+            dbgln("Server resumed a session with a different cipher");
+            return (i8)Error::NotSafe;
+        }
+        dbgln_if(TLS_DEBUG, "Resuming session");
+        m_context.is_resumed_session = true;
+        m_context.master_key = session.master_key;
+        if (!expand_key())
+            return (i8)Error::NotSafe;
+        // The server skips straight to changing the cipher spec and its finished message.
+        m_context.connection_status = ConnectionStatus::KeyExchange;
+    }
+
     return res;
 }
 
+ssize_t TLSv12::handle_new_session_ticket(ReadonlyBytes buffer)
+{
+    if (buffer.size() < 3)
+        return (i8)Error::NeedMoreData;
+
+    size_t size = buffer[0] * 0x10000 + buffer[1] * 0x100 + buffer[2];
+    if (buffer.size() - 3 < size)
+        return (i8)Error::NeedMoreData;
+
+    // RFC 5077, section 3.3: u32 ticket_lifetime_hint, opaque ticket<0..2^16-1>
+    if (size < 6)
+        return (i8)Error::BrokenPacket;
+    size_t ticket_length = buffer[7] * 0x100 + buffer[8];
+    if (size - 6 < ticket_length)
+        return (i8)Error::BrokenPacket;
+
+    m_context.session_ticket = ByteBuffer::copy(buffer.offset_pointer(9), ticket_length);
+    m_context.session_ticket_lifetime_hint = AK::convert_between_host_and_network_endian(*(const u32*)buffer.offset_pointer(3));
+    dbgln_if(TLS_DEBUG, "Received a session ticket of {} bytes", ticket_length);
+
+    return size + 3;
+}
+
 ssize_t TLSv12::handle_finished(ReadonlyBytes buffer, WritePacketStage& write_packets)
 {
     if (m_context.connection_status < ConnectionStatus::KeyExchange || m_context.connection_status == ConnectionStatus::Established) {
@@ -222,15 +263,26 @@ ssize_t TLSv12::handle_finished(ReadonlyBytes buffer, WritePacketStage& write_pa
         return (i8)Error::BrokenPacket;
     }
 
-    if (size < buffer.size() - index) {
+    if (buffer.size() - index < size) {
         dbgln_if(TLS_DEBUG, "not enough data after length: {} > {}", size, buffer.size() - index);
         return (i8)Error::NeedMoreData;
     }
 
-// TODO: Compare Hashes
-#if TLS_DEBUG
-    dbgln("FIXME: handle_finished :: Check message validity");
-#endif
+    // RFC 5246, section 7.4.9: The verify_data covers all handshake messages up to, but not including, this one.
+    u8 expected_verify_data[12];
+    compute_verify_data({ expected_verify_data, sizeof(expected_verify_data) }, "server finished");
+    if (size != sizeof(expected_verify_data)) {
+        dbgln("Server finished message has a verify_data of unexpected size {}", size);
+        return (i8)Error::IntegrityCheckFailed;
+    }
+    u8 difference = 0;
+    for (size_t i = 0; i < sizeof(expected_verify_data); ++i)
+        difference |= buffer[index + i] ^ expected_verify_data[i];
+    if (difference) {
+        dbgln("Server finished message does not match the handshake");
+        return (i8)Error::IntegrityCheckFailed;
+    }
+
     m_context.connection_status = ConnectionStatus::Established;
 
     if (m_handshake_timeout_timer) {
@@ -240,12 +292,59 @@ ssize_t TLSv12::handle_finished(ReadonlyBytes buffer, WritePacketStage& write_pa
         m_handshake_timeout_timer = nullptr;
     }
 
-    if (on_tls_ready_to_write)
+    if (!m_context.is_resumed_session)
+        notify_session_resumption_failed();
+
+    if (on_tls_session_established) {
+        if (auto session = resumable_session(); session.has_value())
+            on_tls_session_established(session.value());
+    }
+
+    if (m_context.is_resumed_session) {
+        // In an abbreviated handshake, we still have to send our finished message before any application data.
+        write_packets = WritePacketStage::Finished;
+    } else if (on_tls_ready_to_write) {
         on_tls_ready_to_write(*this);
+    }
 
     return index + size;
 }
 
+Optional<Session> TLSv12::resumable_session() const
+{
+    if (m_context.connection_status != ConnectionStatus::Established || m_context.master_key.is_empty())
+        return {};
+    if (!m_context.session_id_size && m_context.session_ticket.is_empty())
+        return {};
+
+    Session session;
+    session.cipher = m_context.cipher;
+    session.master_key = m_context.master_key;
+    if (!m_context.session_ticket.is_empty()) {
+        session.ticket = m_context.session_ticket;
+        session.ticket_lifetime_hint = m_context.session_ticket_lifetime_hint;
+    } else if (m_context.is_resumed_session && m_context.session_to_resume.has_value()) {
+        // The server accepted our ticket without issuing a new one, so it can be used again.
+        session.ticket = m_context.session_to_resume.value().ticket;
+        session.ticket_lifetime_hint = m_context.session_to_resume.value().ticket_lifetime_hint;
+    }
+    if (session.ticket.is_empty()) {
+        memcpy(session.session_id, m_context.session_id, m_context.session_id_size);
+        session.session_id_size = m_context.session_id_size;
+    }
+    return session;
+}
+
+void TLSv12::notify_session_resumption_failed()
+{
+    if (!m_context.session_to_resume.has_value())
+        return;
+    // Only report the offered session once.
+    m_context.session_to_resume.clear();
+    if (on_tls_session_resumption_failed)
+        on_tls_session_resumption_failed();
+}
+
 void TLSv12::build_random(PacketBuilder& builder)
 {
     u8 random_bytes[48];
@@ -373,6 +472,23 @@ ssize_t TLSv12::handle_payload(ReadonlyBytes vbuffer)
             dbgln("unsupported: DTLS");
             payload_res = (i8)Error::UnexpectedMessage;
             break;
+        case NewSessionTicket:
+            if (m_context.handshake_messages[11] >= 1) {
+                dbgln("unexpected new session ticket message");
+                payload_res = (i8)Error::UnexpectedMessage;
+                break;
+            }
+            ++m_context.handshake_messages[11];
+#if TLS_DEBUG
+            dbgln("new session ticket");
+#endif
+            if (m_context.is_server) {
+                dbgln("unsupported: server mode");
+                VERIFY_NOT_REACHED();
+            } else {
+                payload_res = handle_new_session_ticket(buffer.slice(1, payload_size));
+            }
+            break;
         case CertificateMessage:
             if (m_context.handshake_messages[4] >= 1) {
                 dbgln("unexpected certificate message");
@@ -576,6 +692,16 @@ ssize_t TLSv12::handle_payload(ReadonlyBytes vbuffer)
                 write_packet(packet);
                 break;
             }
+            case Error::NotSafe: {
+                auto packet = build_alert(true, (u8)AlertDescription::IllegalParameter);
+                write_packet(packet);
+                break;
+            }
+            case Error::IntegrityCheckFailed: {
+                auto packet = build_alert(true, (u8)AlertDescription::DecryptError);
+                write_packet(packet);
+                break;
+            }
             case Error::NeedMoreData:
                 // Ignore this, as it's not an "error"
                 break;
@@ -605,6 +731,10 @@ ssize_t TLSv12::handle_payload(ReadonlyBytes vbuffer)
                 dbgln("> Key exchange");
 #endif
                 auto packet = build_client_key_exchange();
+                if (packet.is_empty()) {
+                    // The key exchange has already sent an alert explaining why; don't follow it up with a Finished.
+                    return (i8)Error::NotSafe;
+                }
                 write_packet(packet);
             }
             {
@@ -647,6 +777,8 @@ ssize_t TLSv12::handle_payload(ReadonlyBytes vbuffer)
                 write_packet(packet);
             }
             m_context.connection_status = ConnectionStatus::Established;
+            if (on_tls_ready_to_write)
+                on_tls_ready_to_write(*this);
             break;
         }
         payload_size++;
@@ -26,6 +26,9 @@
 
 #include <AK/Debug.h>
 #include <LibCrypto/ASN1/DER.h>
+#include <LibCrypto/Curves/X25519.h>
+#include <LibCrypto/NumberTheory/ModularFunctions.h>
+#include <LibCrypto/PK/Code/EMSA_PKCS1_V1_5.h>
 #include <LibCrypto/PK/Code/EMSA_PSS.h>
 #include <LibTLS/TLSv12.h>
 
@@ -255,7 +258,12 @@ ByteBuffer TLSv12::build_client_key_exchange()
 {
     PacketBuilder builder { MessageType::Handshake, m_context.version };
     builder.append((u8)HandshakeType::ClientKeyExchange);
-    build_random(builder);
+    if (uses_ecdhe()) {
+        if (!build_ecdhe_key_exchange(builder))
+            return {};
+    } else {
+        build_random(builder);
+    }
 
     m_context.connection_status = ConnectionStatus::KeyExchange;
 
@@ -266,10 +274,137 @@ ByteBuffer TLSv12::build_client_key_exchange()
     return packet;
 }
 
-ssize_t TLSv12::handle_server_key_exchange(ReadonlyBytes)
+bool TLSv12::build_ecdhe_key_exchange(PacketBuilder& builder)
 {
-    dbgln("FIXME: parse_server_key_exchange");
-    return 0;
+    if (m_context.server_ecdhe_public_key.is_empty()) {
+        dbgln("The server did not send us its key exchange parameters");
+        alert(AlertLevel::Critical, AlertDescription::HandshakeFailure);
+        return false;
+    }
+
+    auto private_key = Crypto::Curves::X25519::generate_private_key();
+    auto public_key = Crypto::Curves::X25519::generate_public_key(private_key);
+    m_context.premaster_key = Crypto::Curves::X25519::compute_coordinate(private_key, m_context.server_ecdhe_public_key);
+
+    // RFC 8422, section 5.11: An all-zero shared secret means the server sent us a point of small order.
+    u8 nonzero_bits = 0;
+    for (size_t i = 0; i < m_context.premaster_key.size(); ++i)
+        nonzero_bits |= m_context.premaster_key[i];
+    if (!nonzero_bits) {
+        dbgln("The server's ECDHE public key is not acceptable");
+        alert(AlertLevel::Critical, AlertDescription::IllegalParameter);
+        return false;
+    }
+
+    if (!compute_master_secret(48)) {
+        dbgln("oh noes we could not derive a master key :(");
+        alert(AlertLevel::Critical, AlertDescription::InternalError);
+        return false;
+    }
+
+    builder.append_u24(public_key.size() + 1);
+    builder.append((u8)public_key.size());
+    builder.append(public_key.bytes());
+    return true;
+}
+
+template<typename HashFunction>
+static bool verify_rsa_pkcs1_signature(const Crypto::PK::RSAPublicKey<>& key, ReadonlyBytes message, ReadonlyBytes signature)
+{
+    auto signature_integer = Crypto::UnsignedBigInteger::import_data(signature.data(), signature.size());
+    if (signature.size() > key.length() || !(signature_integer < key.modulus()))
+        return false;
+
+    Crypto::PK::EMSA_PKCS1_V1_5<HashFunction> emsa;
+    ByteBuffer encoded_message;
+    emsa.encode(message, encoded_message, signature.size() * 8);
+    if (encoded_message.is_empty())
+        return false;
+
+    auto decrypted_signature = Crypto::NumberTheory::ModularPower(signature_integer, key.public_exponent(), key.modulus());
+    return decrypted_signature == Crypto::UnsignedBigInteger::import_data(encoded_message.data(), encoded_message.size());
+}
+
+ssize_t TLSv12::handle_server_key_exchange(ReadonlyBytes buffer)
+{
+    if (buffer.size() < 3)
+        return (i8)Error::NeedMoreData;
+
+    size_t size = buffer[0] * 0x10000 + buffer[1] * 0x100 + buffer[2];
+    if (buffer.size() - 3 < size)
+        return (i8)Error::NeedMoreData;
+
+    if (!uses_ecdhe()) {
+        dbgln("unexpected server key exchange for a cipher without one");
+        return (i8)Error::UnexpectedMessage;
+    }
+
+    // RFC 8422, section 5.4: ECParameters curve_params, ECPoint public, then the signature over them.
+    auto message = buffer.slice(3, size);
+    if (message.size() < 4)
+        return (i8)Error::BrokenPacket;
+
+    auto curve_type = (ECCurveType)message[0];
+    auto curve = (NamedCurve)(message[1] * 0x100 + message[2]);
+    size_t public_key_length = message[3];
+    if (curve_type != ECCurveType::NamedCurve || curve != NamedCurve::X25519 || public_key_length != Crypto::Curves::X25519::KeySize) {
+        dbgln("Server picked an elliptic curve we did not offer");
+        return (i8)Error::NotSafe;
+    }
+
+    size_t parameters_length = 4 + public_key_length;
+    if (message.size() < parameters_length + 4)
+        return (i8)Error::BrokenPacket;
+    auto parameters = message.slice(0, parameters_length);
+
+    auto hash_algorithm = (HashAlgorithm)message[parameters_length];
+    auto signature_algorithm = (SignatureAlgorithm)message[parameters_length + 1];
+    size_t signature_length = message[parameters_length + 2] * 0x100 + message[parameters_length + 3];
+    if (message.size() - parameters_length - 4 < signature_length)
+        return (i8)Error::BrokenPacket;
+    auto signature = message.slice(parameters_length + 4, signature_length);
+
+    if (signature_algorithm != SignatureAlgorithm::RSA) {
+        dbgln("Server signed its key exchange parameters with an algorithm we did not offer");
+        return (i8)Error::NotSafe;
+    }
+
+    auto certificate_option = verify_chain_and_get_matching_certificate(m_context.SNI);
+    if (!certificate_option.has_value()) {
+        dbgln("certificate verification failed :(");
+        return (i8)Error::BadCertificate;
+    }
+    auto& public_key = m_context.certificates[certificate_option.value()].public_key;
+
+    // The signature covers both hello randoms, so that it can't be replayed.
+    auto signed_data = ByteBuffer::create_uninitialized(sizeof(m_context.local_random) + sizeof(m_context.remote_random) + parameters.size());
+    signed_data.overwrite(0, m_context.local_random, sizeof(m_context.local_random));
+    signed_data.overwrite(sizeof(m_context.local_random), m_context.remote_random, sizeof(m_context.remote_random));
+    signed_data.overwrite(sizeof(m_context.local_random) + sizeof(m_context.remote_random), parameters.data(), parameters.size());
+
+    bool is_valid_signature = false;
+    switch (hash_algorithm) {
+    case HashAlgorithm::SHA1:
+        is_valid_signature = verify_rsa_pkcs1_signature<Crypto::Hash::SHA1>(public_key, signed_data, signature);
+        break;
+    case HashAlgorithm::SHA256:
+        is_valid_signature = verify_rsa_pkcs1_signature<Crypto::Hash::SHA256>(public_key, signed_data, signature);
+        break;
+    case HashAlgorithm::SHA512:
+        is_valid_signature = verify_rsa_pkcs1_signature<Crypto::Hash::SHA512>(public_key, signed_data, signature);
+        break;
+    default:
+        dbgln("Server signed its key exchange parameters with a hash we did not offer");
+        return (i8)Error::NotSafe;
+    }
+    if (!is_valid_signature) {
+        dbgln("The signature of the server key exchange parameters does not match");
+        return (i8)Error::IntegrityCheckFailed;
+    }
+
+    m_context.server_ecdhe_public_key = ByteBuffer::copy(message.offset_pointer(4), public_key_length);
+
+    return size + 3;
 }
 
 ssize_t TLSv12::handle_verify(ReadonlyBytes)
@@ -50,6 +50,18 @@ ByteBuffer TLSv12::build_hello()
     builder.append(version);
     builder.append(m_context.local_random, sizeof(m_context.local_random));
 
+    if (m_context.session_to_resume.has_value()) {
+        auto& session = m_context.session_to_resume.value();
+        if (!session.ticket.is_empty()) {
+            // RFC 5077, section 3.4: The server echoes a session ID sent along with a ticket if it accepts the ticket.
+            fill_with_random(m_context.session_id, sizeof(m_context.session_id));
+            m_context.session_id_size = sizeof(m_context.session_id);
+        } else {
+            memcpy(m_context.session_id, session.session_id, session.session_id_size);
+            m_context.session_id_size = session.session_id_size;
+        }
+    }
+
     builder.append(m_context.session_id_size);
     if (m_context.session_id_size)
         builder.append(m_context.session_id, m_context.session_id_size);
@@ -72,8 +84,12 @@ ByteBuffer TLSv12::build_hello()
             extension_length += alpn_length + 6;
     }
 
-    // Ciphers
-    builder.append((u16)(5 * sizeof(u16)));
+    // Ciphers, preferring those with forward secrecy
+    builder.append((u16)(9 * sizeof(u16)));
+    builder.append((u16)CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256);
+    builder.append((u16)CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA256);
+    builder.append((u16)CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA);
+    builder.append((u16)CipherSuite::ECDHE_RSA_WITH_AES_256_CBC_SHA);
     builder.append((u16)CipherSuite::RSA_WITH_AES_128_CBC_SHA256);
     builder.append((u16)CipherSuite::RSA_WITH_AES_256_CBC_SHA256);
     builder.append((u16)CipherSuite::RSA_WITH_AES_128_CBC_SHA);
@@ -92,6 +108,20 @@ ByteBuffer TLSv12::build_hello()
     if (sni_length)
         extension_length += sni_length + 9;
 
+    // The elliptic curves we can do ECDHE with, and the only point format there is for them.
+    constexpr NamedCurve supported_curves[] { NamedCurve::X25519 };
+    extension_length += 6 + sizeof(supported_curves);
+    extension_length += 6;
+
+    // We can only verify RSA signatures, with these hashes.
+    constexpr HashAlgorithm signature_hashes[] { HashAlgorithm::SHA512, HashAlgorithm::SHA256, HashAlgorithm::SHA1 };
+    extension_length += 6 + 2 * sizeof(signature_hashes);
+
+    ReadonlyBytes session_ticket;
+    if (m_context.session_to_resume.has_value())
+        session_ticket = m_context.session_to_resume.value().ticket;
+    extension_length += 4 + session_ticket.size();
+
     builder.append((u16)extension_length);
 
     if (sni_length) {
@@ -108,6 +138,31 @@ ByteBuffer TLSv12::build_hello()
         builder.append((const u8*)m_context.SNI.characters(), sni_length);
     }
 
+    builder.append((u16)HandshakeExtension::SupportedGroups);
+    builder.append((u16)(2 + sizeof(supported_curves)));
+    builder.append((u16)sizeof(supported_curves));
+    for (auto curve : supported_curves)
+        builder.append((u16)curve);
+
+    builder.append((u16)HandshakeExtension::ECPointFormats);
+    builder.append((u16)2);
+    builder.append((u8)1);
+    builder.append((u8)ECPointFormat::Uncompressed);
+
+    builder.append((u16)HandshakeExtension::SignatureAlgorithms);
+    builder.append((u16)(2 + 2 * sizeof(signature_hashes)));
+    builder.append((u16)(2 * sizeof(signature_hashes)));
+    for (auto hash : signature_hashes) {
+        builder.append((u8)hash);
+        builder.append((u8)SignatureAlgorithm::RSA);
+    }
+
+    // An empty ticket asks the server for one, which lets us resume the session without it keeping any state.
+    builder.append((u16)HandshakeExtension::SessionTicket);
+    builder.append((u16)session_ticket.size());
+    if (!session_ticket.is_empty())
+        builder.append(session_ticket);
+
     if (alpn_length) {
         // TODO
         VERIFY_NOT_REACHED();
@@ -154,11 +209,7 @@ ByteBuffer TLSv12::build_finished()
 
     u8 out[out_size];
     auto outbuffer = Bytes { out, out_size };
-    auto dummy = ByteBuffer::create_zeroed(0);
-
-    auto digest = m_context.handshake_hash.digest();
-    auto hashbuf = ReadonlyBytes { digest.immutable_data(), m_context.handshake_hash.digest_size() };
-    pseudorandom_function(outbuffer, m_context.master_key, (const u8*)"client finished", 15, hashbuf, dummy);
+    compute_verify_data(outbuffer, "client finished");
 
     builder.append(outbuffer);
     auto packet = builder.build();
@@ -167,6 +218,15 @@ ByteBuffer TLSv12::build_finished()
     return packet;
 }
 
+void TLSv12::compute_verify_data(Bytes output, const char* label)
+{
+    // Finishing a hash can't be undone, and the handshake goes on after a Finished message, so work on a copy.
+    auto handshake_hash = m_context.handshake_hash;
+    auto digest = handshake_hash.digest();
+    auto dummy = ByteBuffer::create_zeroed(0);
+    pseudorandom_function(output, m_context.master_key, (const u8*)label, strlen(label), ReadonlyBytes { digest.immutable_data(), digest.data_length() }, dummy);
+}
+
 void TLSv12::alert(AlertLevel level, AlertDescription code)
 {
     auto the_alert = build_alert(level == AlertLevel::Critical, (u8)code);
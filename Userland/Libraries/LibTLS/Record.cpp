@@ -432,7 +432,8 @@ ssize_t TLSv12::handle_message(ReadonlyBytes buffer)
             if (code == 0) {
                 // close notify
                 res += 2;
-                alert(AlertLevel::Critical, AlertDescription::CloseNotify);
+                // Answering with a fatal alert would make the server throw away our session.
+                alert(AlertLevel::Warning, AlertDescription::CloseNotify);
                 m_context.connection_finished = true;
                 if (!m_context.cipher_spec_set) {
                     // AWS CloudFront hits this.
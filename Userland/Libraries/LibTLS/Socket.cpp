@@ -201,6 +201,9 @@ bool TLSv12::check_connection_state(bool read)
     if (m_context.critical_error) {
         dbgln_if(TLS_DEBUG, "CRITICAL ERROR {} :(", m_context.critical_error);
 
+        if (m_context.connection_status != ConnectionStatus::Established)
+            notify_session_resumption_failed();
+
         if (on_tls_error)
             on_tls_error((AlertDescription)m_context.critical_error);
         return false;
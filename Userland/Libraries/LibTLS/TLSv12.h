@@ -36,6 +36,7 @@
 #include <LibCrypto/BigInt/UnsignedBigInteger.h>
 #include <LibCrypto/Cipher/AES.h>
 #include <LibCrypto/Hash/HashManager.h>
+#include <LibCrypto/Hash/SHA2.h>
 #include <LibCrypto/PK/RSA.h>
 #include <LibTLS/TLSPacketBuilder.h>
 
@@ -73,6 +74,10 @@ enum class CipherSuite {
     RSA_WITH_AES_256_CBC_SHA = 0x0035,
     RSA_WITH_AES_128_CBC_SHA256 = 0x003C,
     RSA_WITH_AES_256_CBC_SHA256 = 0x003D,
+    ECDHE_RSA_WITH_AES_128_CBC_SHA = 0xC013,
+    ECDHE_RSA_WITH_AES_256_CBC_SHA = 0xC014,
+    ECDHE_RSA_WITH_AES_128_CBC_SHA256 = 0xC027,
+    ECDHE_RSA_WITH_AES_128_GCM_SHA256 = 0xC02F,
     // TODO
     RSA_WITH_AES_128_GCM_SHA256 = 0x009C,
     RSA_WITH_AES_256_GCM_SHA384 = 0x009D,
@@ -160,6 +165,7 @@ enum HandshakeType {
     ClientHello = 0x01,
     ServerHello = 0x02,
     HelloVerifyRequest = 0x03,
+    NewSessionTicket = 0x04,
     CertificateMessage = 0x0b,
     ServerKeyExchange = 0x0c,
     CertificateRequest = 0x0d,
@@ -171,8 +177,33 @@ enum HandshakeType {
 
 enum class HandshakeExtension : u16 {
     ServerName = 0x00,
+    SupportedGroups = 0x0a,
+    ECPointFormats = 0x0b,
     ApplicationLayerProtocolNegotiation = 0x10,
     SignatureAlgorithms = 0x0d,
+    SessionTicket = 0x23,
+};
+
+enum class ECCurveType : u8 {
+    NamedCurve = 3,
+};
+
+enum class NamedCurve : u16 {
+    X25519 = 0x001d,
+};
+
+enum class ECPointFormat : u8 {
+    Uncompressed = 0,
+};
+
+enum class HashAlgorithm : u8 {
+    SHA1 = 2,
+    SHA256 = 4,
+    SHA512 = 6,
+};
+
+enum class SignatureAlgorithm : u8 {
+    RSA = 1,
 };
 
 enum class WritePacketStage {
@@ -195,6 +226,18 @@ enum ClientVerificationStaus {
     VerificationNeeded,
 };
 
+// What a client has to remember to resume a session later on with an abbreviated handshake,
+// either by its session ID (RFC 5246, section 7.3) or with a session ticket (RFC 5077).
+struct Session {
+    CipherSuite cipher { CipherSuite::Invalid };
+    ByteBuffer master_key;
+    u8 session_id[32];
+    u8 session_id_size { 0 };
+    ByteBuffer ticket;
+    // How long the server intends to accept the ticket for, in seconds; zero if it didn't say (RFC 5077, section 3.3).
+    u32 ticket_lifetime_hint { 0 };
+};
+
 struct Context {
     String to_string() const;
     bool verify() const;
@@ -215,6 +258,11 @@ struct Context {
     Vector<Certificate> client_certificates;
     ByteBuffer master_key;
     ByteBuffer premaster_key;
+    ByteBuffer server_ecdhe_public_key;
+    Optional<Session> session_to_resume;
+    bool is_resumed_session { false };
+    ByteBuffer session_ticket;
+    u32 session_ticket_lifetime_hint { 0 };
     u8 cipher_spec_set { 0 };
     struct {
         int created { 0 };
@@ -226,7 +274,10 @@ struct Context {
         u8 remote_aead_iv[4];
     } crypto;
 
-    Crypto::Hash::Manager handshake_hash;
+    // The handshake hash function is always SHA256. It's kept as one, rather than behind a
+    // Crypto::Hash::Manager, so that it can be copied to finish a hash for a Finished message
+    // while the handshake goes on.
+    Crypto::Hash::SHA256 handshake_hash;
 
     ByteBuffer message_buffer;
     u64 remote_sequence_number { 0 };
@@ -253,7 +304,7 @@ struct Context {
     bool connection_finished { false };
 
     // message flags
-    u8 handshake_messages[11] { 0 };
+    u8 handshake_messages[12] { 0 };
     ByteBuffer user_data;
     Vector<Certificate> root_ceritificates;
 
@@ -287,6 +338,17 @@ public:
 
     void set_root_certificates(Vector<Certificate>);
 
+    // Offers the server to resume an earlier session instead of doing a full handshake.
+    void set_session_to_resume(Session session)
+    {
+        if (m_context.is_server || m_context.connection_status != ConnectionStatus::Disconnected) {
+            dbgln("invalid state for set_session_to_resume");
+            return;
+        }
+        m_context.session_to_resume = move(session);
+    }
+    Optional<Session> resumable_session() const;
+
     bool add_client_key(ReadonlyBytes certificate_pem_buffer, ReadonlyBytes key_pem_buffer);
     bool add_client_key(Certificate certificate)
     {
@@ -306,7 +368,11 @@ public:
             || suite == CipherSuite::RSA_WITH_AES_256_CBC_SHA256
             || suite == CipherSuite::RSA_WITH_AES_128_CBC_SHA
             || suite == CipherSuite::RSA_WITH_AES_256_CBC_SHA
-            || suite == CipherSuite::RSA_WITH_AES_128_GCM_SHA256;
+            || suite == CipherSuite::RSA_WITH_AES_128_GCM_SHA256
+            || suite == CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA
+            || suite == CipherSuite::ECDHE_RSA_WITH_AES_256_CBC_SHA
+            || suite == CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA256
+            || suite == CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256;
     }
 
     bool supports_version(Version v) const
@@ -330,6 +396,10 @@ public:
     Function<void()> on_tls_connected;
     Function<void()> on_tls_finished;
     Function<void(TLSv12&)> on_tls_certificate_request;
+    Function<void(const Session&)> on_tls_session_established;
+    // Called when the session given to set_session_to_resume() was not resumed, either because
+    // the server wanted a full handshake or because the handshake failed, so it shouldn't be offered again.
+    Function<void()> on_tls_session_resumption_failed;
 
 private:
     explicit TLSv12(Core::Object* parent, Version version = Version::V12);
@@ -351,12 +421,14 @@ private:
 
     ByteBuffer build_hello();
     ByteBuffer build_finished();
+    void compute_verify_data(Bytes output, const char* label);
     ByteBuffer build_certificate();
     ByteBuffer build_done();
     ByteBuffer build_alert(bool critical, u8 code);
     ByteBuffer build_change_cipher_spec();
     ByteBuffer build_verify_request();
     void build_random(PacketBuilder&);
+    bool build_ecdhe_key_exchange(PacketBuilder&);
 
     bool flush();
     void write_into_socket();
@@ -368,6 +440,8 @@ private:
     ssize_t handle_finished(ReadonlyBytes, WritePacketStage&);
     ssize_t handle_certificate(ReadonlyBytes);
     ssize_t handle_server_key_exchange(ReadonlyBytes);
+    ssize_t handle_new_session_ticket(ReadonlyBytes);
+    void notify_session_resumption_failed();
     ssize_t handle_server_hello_done(ReadonlyBytes);
     ssize_t handle_verify(ReadonlyBytes);
     ssize_t handle_payload(ReadonlyBytes);
@@ -388,9 +462,13 @@ private:
         case CipherSuite::RSA_WITH_AES_128_CBC_SHA256:
         case CipherSuite::RSA_WITH_AES_128_CBC_SHA:
         case CipherSuite::RSA_WITH_AES_128_GCM_SHA256:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA256:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256:
         default:
             return 128 / 8;
         case CipherSuite::AES_256_GCM_SHA384:
+        case CipherSuite::ECDHE_RSA_WITH_AES_256_CBC_SHA:
         case CipherSuite::RSA_WITH_AES_256_CBC_SHA:
         case CipherSuite::RSA_WITH_AES_256_CBC_SHA256:
         case CipherSuite::RSA_WITH_AES_256_GCM_SHA384:
@@ -402,6 +480,8 @@ private:
         switch (m_context.cipher) {
         case CipherSuite::RSA_WITH_AES_128_CBC_SHA:
         case CipherSuite::RSA_WITH_AES_256_CBC_SHA:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA:
+        case CipherSuite::ECDHE_RSA_WITH_AES_256_CBC_SHA:
             return Crypto::Hash::SHA1::digest_size();
         case CipherSuite::AES_256_GCM_SHA384:
         case CipherSuite::RSA_WITH_AES_256_GCM_SHA384:
@@ -433,6 +513,7 @@ private:
         case CipherSuite::AES_256_GCM_SHA384:
         case CipherSuite::RSA_WITH_AES_128_GCM_SHA256:
         case CipherSuite::RSA_WITH_AES_256_GCM_SHA384:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256:
             return 8; // 4 bytes of fixed IV, 8 random (nonce) bytes, 4 bytes for counter
                       // GCM specifically asks us to transmit only the nonce, the counter is zero
                       // and the fixed IV is derived from the premaster key.
@@ -446,6 +527,20 @@ private:
         case CipherSuite::AES_256_GCM_SHA384:
         case CipherSuite::RSA_WITH_AES_128_GCM_SHA256:
         case CipherSuite::RSA_WITH_AES_256_GCM_SHA384:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool uses_ecdhe() const
+    {
+        switch (m_context.cipher) {
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA:
+        case CipherSuite::ECDHE_RSA_WITH_AES_256_CBC_SHA:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA256:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256:
             return true;
         default:
             return false;
@@ -30,24 +30,12 @@
 #include <AK/Vector.h>
 #include <LibGfx/AffineTransform.h>
 #include <LibGfx/Bitmap.h>
+#include <LibGfx/PathRasterizer.h>
 #include <LibTTF/Tables.h>
 #include <math.h>
 
 namespace TTF {
 
-class Rasterizer {
-public:
-    Rasterizer(Gfx::IntSize);
-    void draw_path(Gfx::Path&);
-    RefPtr<Gfx::Bitmap> accumulate();
-
-private:
-    void draw_line(Gfx::FloatPoint, Gfx::FloatPoint);
-
-    Gfx::IntSize m_size;
-    Vector<float> m_data;
-};
-
 class Loca {
 public:
     static Optional<Loca> from_slice(const ReadonlyBytes&, u32 num_glyphs, IndexToLocFormat);
@@ -121,14 +109,14 @@ public:
             u32 m_offset { 0 };
         };
 
-        void raster_inner(Rasterizer&, Gfx::AffineTransform&) const;
+        void raster_inner(Gfx::PathRasterizer&, Gfx::AffineTransform&) const;
         RefPtr<Gfx::Bitmap> raster_simple(float x_scale, float y_scale) const;
         template<typename GlyphCb>
         RefPtr<Gfx::Bitmap> raster_composite(float x_scale, float y_scale, GlyphCb glyph_callback) const
         {
             u32 width = (u32)(ceil((m_xmax - m_xmin) * x_scale)) + 1;
             u32 height = (u32)(ceil((m_ymax - m_ymin) * y_scale)) + 1;
-            Rasterizer rasterizer(Gfx::IntSize(width, height));
+            Gfx::PathRasterizer rasterizer(Gfx::IntSize(width, height));
             auto affine = Gfx::AffineTransform().scale(x_scale, -y_scale).translate(-m_xmin, -m_ymax);
             ComponentIterator component_iterator(m_slice);
             while (true) {
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Function.h>
+#include <AK/NonnullRefPtr.h>
+#include <AK/Optional.h>
+#include <LibCore/Event.h>
+#include <LibCore/EventLoop.h>
+#include <LibCore/Object.h>
+#include <pthread.h>
+
+namespace LibThread {
+
+// The result of a task run on a ThreadPool, once it is done.
+//
+// The callback given to on_complete() runs on the main event loop, as a deferred invocation,
+// so it may freely touch objects of the main thread. It's posted to the main loop rather than
+// the current one, as a nested loop may be gone by the time the task is done; while a nested
+// loop runs, the callback waits for it to exit. Alternatively, await() blocks until the result
+// is there. The result can be taken once, by either of them.
+template<typename Result>
+class Future final : public Core::Object {
+    C_OBJECT(Future);
+
+public:
+    virtual ~Future() override
+    {
+        pthread_mutex_destroy(&m_mutex);
+        pthread_cond_destroy(&m_condition);
+    }
+
+    bool is_resolved() const
+    {
+        pthread_mutex_lock(&m_mutex);
+        bool resolved = m_is_resolved;
+        pthread_mutex_unlock(&m_mutex);
+        return resolved;
+    }
+
+    void on_complete(Function<void(Result)> callback)
+    {
+        VERIFY(!m_on_complete);
+        m_on_complete = move(callback);
+        if (is_resolved())
+            deferred_invoke([this, protector = NonnullRefPtr(*this)](auto&) { run_on_complete(); });
+    }
+
+    Result await()
+    {
+        pthread_mutex_lock(&m_mutex);
+        while (!m_is_resolved)
+            pthread_cond_wait(&m_condition, &m_mutex);
+        auto result = m_result.release_value();
+        pthread_mutex_unlock(&m_mutex);
+        return result;
+    }
+
+    // Called on the pool thread that ran the task. The future's reference is handed over to the
+    // event loop, so it's never destroyed on a pool thread (Core::Object isn't thread safe).
+    static void resolve(NonnullRefPtr<Future>&& future, Result&& result)
+    {
+        pthread_mutex_lock(&future->m_mutex);
+        future->m_result = move(result);
+        future->m_is_resolved = true;
+        pthread_cond_broadcast(&future->m_condition);
+        pthread_mutex_unlock(&future->m_mutex);
+
+        auto& receiver = *future;
+        Core::EventLoop::main().post_event(receiver, make<Core::DeferredInvocationEvent>([future = move(future)](auto&) mutable {
+            future->run_on_complete();
+        }));
+        Core::EventLoop::wake();
+    }
+
+private:
+    Future()
+        : Core::Object(nullptr)
+    {
+        pthread_mutex_init(&m_mutex, nullptr);
+        pthread_cond_init(&m_condition, nullptr);
+        // Make sure the weak link exists before pool threads start posting events to us.
+        [[maybe_unused]] auto weak_this = make_weak_ptr();
+    }
+
+    void run_on_complete()
+    {
+        if (!m_on_complete)
+            return;
+        pthread_mutex_lock(&m_mutex);
+        auto result = m_result.release_value();
+        pthread_mutex_unlock(&m_mutex);
+        auto on_complete = move(m_on_complete);
+        on_complete(move(result));
+    }
+
+    mutable pthread_mutex_t m_mutex;
+    pthread_cond_t m_condition;
+    bool m_is_resolved { false };
+    Optional<Result> m_result;
+    Function<void(Result)> m_on_complete;
+};
+
+}
@@ -41,21 +41,25 @@ LibThread::Thread::Thread(Function<int()> action, StringView thread_name)
 LibThread::Thread::~Thread()
 {
     if (m_tid) {
-        dbgln("Destroying thread \"{}\"({}) while it is still running!", m_thread_name, m_tid);
+        // A thread that has finished but was never joined still needs to be joined to release it.
+        if (!m_has_exited)
+            dbgln("Destroying thread \"{}\"({}) while it is still running!", m_thread_name, m_tid);
         [[maybe_unused]] auto res = join();
     }
 }
 
 void LibThread::Thread::start()
 {
+    m_has_exited = false;
     int rc = pthread_create(
         &m_tid,
         nullptr,
         [](void* arg) -> void* {
             Thread* self = static_cast<Thread*>(arg);
             int exit_code = self->m_action();
-            self->m_tid = 0;
-            return (void*)exit_code;
+            // m_tid is only cleared by join(), as clearing it here would race with it.
+            self->m_has_exited = true;
+            return (void*)static_cast<FlatPtr>(exit_code);
         },
         static_cast<void*>(this));
 
@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <AK/Atomic.h>
 #include <AK/DistinctNumeric.h>
 #include <AK/Function.h>
 #include <AK/Result.h>
@@ -55,6 +56,7 @@ private:
     explicit Thread(Function<int()> action, StringView thread_name = nullptr);
     Function<int()> m_action;
     pthread_t m_tid { 0 };
+    Atomic<bool> m_has_exited { false };
     String m_thread_name;
 };
 
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Vector.h>
+#include <LibThread/Thread.h>
+#include <LibThread/ThreadPool.h>
+#include <unistd.h>
+
+namespace LibThread {
+
+struct ThreadPool::Worker {
+    Worker(ThreadPool& pool, size_t index)
+        : pool(pool)
+        , index(index)
+    {
+        pthread_mutex_init(&mutex, nullptr);
+    }
+
+    ~Worker()
+    {
+        pthread_mutex_destroy(&mutex);
+    }
+
+    void push(Function<void()>&& task)
+    {
+        pthread_mutex_lock(&mutex);
+        tasks.append(move(task));
+        pthread_mutex_unlock(&mutex);
+    }
+
+    // Takes the newest task; only the worker itself does this.
+    Function<void()> pop()
+    {
+        pthread_mutex_lock(&mutex);
+        Function<void()> task;
+        if (first_task < tasks.size()) {
+            task = tasks.take_last();
+            compact();
+        }
+        pthread_mutex_unlock(&mutex);
+        return task;
+    }
+
+    // Takes the oldest task, on behalf of another worker.
+    Function<void()> steal()
+    {
+        pthread_mutex_lock(&mutex);
+        Function<void()> task;
+        if (first_task < tasks.size()) {
+            task = move(tasks[first_task++]);
+            compact();
+        }
+        pthread_mutex_unlock(&mutex);
+        return task;
+    }
+
+    // Drops the slots stolen tasks leave behind at the front once they make up half the deque.
+    void compact()
+    {
+        if (first_task == tasks.size()) {
+            tasks.clear_with_capacity();
+            first_task = 0;
+        } else if (first_task >= 32 && first_task * 2 >= tasks.size()) {
+            tasks.remove(0, first_task);
+            first_task = 0;
+        }
+    }
+
+    ThreadPool& pool;
+    size_t index { 0 };
+    RefPtr<Thread> thread;
+    pthread_mutex_t mutex;
+    Vector<Function<void()>> tasks;
+    size_t first_task { 0 };
+};
+
+__thread ThreadPool::Worker* ThreadPool::s_current_worker;
+
+static ThreadPool* s_the;
+static pthread_once_t s_the_once = PTHREAD_ONCE_INIT;
+
+ThreadPool& ThreadPool::the()
+{
+    // Tasks on other pools may be the first to ask for the shared pool, so it's created exactly once.
+    pthread_once(&s_the_once, [] {
+        auto cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+        s_the = new ThreadPool(cpu_count > 0 ? cpu_count : 1);
+    });
+    return *s_the;
+}
+
+ThreadPool::ThreadPool(size_t thread_count)
+{
+    VERIFY(thread_count > 0);
+    pthread_mutex_init(&m_idle_mutex, nullptr);
+    pthread_cond_init(&m_idle_condition, nullptr);
+
+    for (size_t i = 0; i < thread_count; ++i)
+        m_workers.append(make<Worker>(*this, i));
+    for (auto& worker : m_workers) {
+        worker.thread = Thread::construct([this, &worker] { return worker_loop(worker); }, String::formatted("ThreadPool {}", worker.index));
+        worker.thread->start();
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    pthread_mutex_lock(&m_idle_mutex);
+    m_should_exit = true;
+    pthread_cond_broadcast(&m_idle_condition);
+    pthread_mutex_unlock(&m_idle_mutex);
+
+    for (auto& worker : m_workers)
+        [[maybe_unused]] auto result = worker.thread->join();
+
+    pthread_mutex_destroy(&m_idle_mutex);
+    pthread_cond_destroy(&m_idle_condition);
+}
+
+void ThreadPool::submit(Function<void()> task)
+{
+    // Counted before it's visible, so a thread that finds it can always account for it.
+    ++m_queued_task_count;
+
+    auto* worker = s_current_worker;
+    if (!worker || &worker->pool != this)
+        worker = &m_workers[m_next_worker++ % m_workers.size()];
+    worker->push(move(task));
+
+    pthread_mutex_lock(&m_idle_mutex);
+    pthread_cond_signal(&m_idle_condition);
+    pthread_mutex_unlock(&m_idle_mutex);
+}
+
+Function<void()> ThreadPool::find_task(Worker& worker)
+{
+    auto task = worker.pop();
+    for (size_t i = 1; !task && i < m_workers.size(); ++i)
+        task = m_workers[(worker.index + i) % m_workers.size()].steal();
+    if (task)
+        --m_queued_task_count;
+    return task;
+}
+
+int ThreadPool::worker_loop(Worker& worker)
+{
+    s_current_worker = &worker;
+    for (;;) {
+        if (auto task = find_task(worker)) {
+            task();
+            continue;
+        }
+
+        pthread_mutex_lock(&m_idle_mutex);
+        while (m_queued_task_count == 0 && !m_should_exit)
+            pthread_cond_wait(&m_idle_condition, &m_idle_mutex);
+        bool should_exit = m_should_exit && m_queued_task_count == 0;
+        pthread_mutex_unlock(&m_idle_mutex);
+        if (should_exit)
+            return 0;
+    }
+}
+
+}
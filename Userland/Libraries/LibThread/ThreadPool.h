@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/Function.h>
+#include <AK/Noncopyable.h>
+#include <AK/NonnullOwnPtrVector.h>
+#include <AK/StdLibExtras.h>
+#include <LibThread/Future.h>
+#include <pthread.h>
+
+namespace LibThread {
+
+// A fixed set of threads that run submitted tasks.
+//
+// Every thread has its own deque of tasks. Tasks submitted from inside a task go to the
+// back of the current thread's deque and are taken from there again, newest first, which
+// keeps related work on one CPU. Other submissions are spread across the threads round robin.
+// A thread that runs out of work steals the oldest task from another thread's deque, so
+// uneven work still keeps all threads busy.
+class ThreadPool {
+    AK_MAKE_NONCOPYABLE(ThreadPool);
+    AK_MAKE_NONMOVABLE(ThreadPool);
+
+public:
+    // The shared pool, with one thread per online CPU. It's created on first use.
+    static ThreadPool& the();
+
+    explicit ThreadPool(size_t thread_count);
+    // Finishes all queued tasks, then joins the threads.
+    ~ThreadPool();
+
+    size_t thread_count() const { return m_workers.size(); }
+
+    void submit(Function<void()>);
+
+    // Runs `task` on the pool. The returned future resolves to its result.
+    template<typename Callback>
+    auto run(Callback task) -> NonnullRefPtr<Future<decltype(task())>>
+    {
+        using Result = decltype(task());
+        auto future = Future<Result>::construct();
+        submit([future, task = move(task)]() mutable {
+            Future<Result>::resolve(move(future), task());
+        });
+        return future;
+    }
+
+private:
+    struct Worker;
+    static __thread Worker* s_current_worker;
+
+    int worker_loop(Worker&);
+    Function<void()> find_task(Worker&);
+
+    NonnullOwnPtrVector<Worker> m_workers;
+    Atomic<size_t> m_next_worker { 0 };
+
+    // Guards sleeping and waking up idle threads; the deques have their own locks.
+    pthread_mutex_t m_idle_mutex;
+    pthread_cond_t m_idle_condition;
+    Atomic<size_t> m_queued_task_count { 0 };
+    Atomic<bool> m_should_exit { false };
+};
+
+}
@@ -35,6 +35,8 @@ JS::VM& main_thread_vm()
     if (!vm) {
         vm = JS::VM::create();
         vm->set_should_log_exceptions(true);
+        // Large DOMs make full collections long enough to be noticeable, so mark them in small steps.
+        vm->heap().set_incremental(true);
     }
     return *vm;
 }
@@ -54,6 +54,7 @@ WindowObject::WindowObject(DOM::Window& impl)
     : m_impl(impl)
 {
     impl.set_wrapper({}, *this);
+    track_weak_references();
 }
 
 void WindowObject::initialize()
@@ -76,6 +76,7 @@ public:
 private:
     virtual const char* class_name() const override { return "WindowObject"; }
     virtual void visit_edges(Visitor&) override;
+    virtual void revoke_weak_references() override { revoke_weak_ptrs(); }
 
     JS_DECLARE_NATIVE_GETTER(document_getter);
     JS_DECLARE_NATIVE_SETTER(document_setter);
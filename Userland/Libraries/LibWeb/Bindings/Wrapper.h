@@ -43,7 +43,11 @@ protected:
     explicit Wrapper(Object& prototype)
         : Object(prototype)
     {
+        // The wrapped object keeps a WeakPtr to us, and must not hand us out again once we're dead.
+        track_weak_references();
     }
+
+    virtual void revoke_weak_references() override { revoke_weak_ptrs(); }
 };
 
 }
@@ -116,11 +116,39 @@ void ImageBox::paint(PaintContext& context, PaintPhase phase)
                 alt = image_element.src();
             context.painter().draw_text(enclosing_int_rect(absolute_rect()), alt, Gfx::TextAlignment::Center, computed_values().color(), Gfx::TextElision::Right);
         } else if (auto bitmap = m_image_loader.bitmap(m_image_loader.current_frame_index())) {
-            context.painter().draw_scaled_bitmap(enclosing_int_rect(absolute_rect()), *bitmap, bitmap->rect());
+            auto rect = enclosing_int_rect(absolute_rect());
+            if (auto* scaled = scaled_bitmap(*bitmap, rect.size(), context.painter().target()->scale()))
+                context.painter().blit(rect.location(), *scaled, scaled->rect());
+            else
+                context.painter().draw_scaled_bitmap(rect, *bitmap, bitmap->rect(), 1.0f, Gfx::Painter::ScalingMode::BilinearBlend);
         }
     }
 }
 
+// Returns nullptr if the bitmap doesn't need scaling, or there's no memory for a scaled copy.
+const Gfx::Bitmap* ImageBox::scaled_bitmap(const Gfx::Bitmap& bitmap, const Gfx::IntSize& size, int scale)
+{
+    if (bitmap.size() == size && bitmap.scale() == scale) {
+        m_scaled_bitmap = nullptr;
+        m_scaled_bitmap_source = nullptr;
+        return nullptr;
+    }
+
+    if (m_scaled_bitmap && m_scaled_bitmap_source == &bitmap && m_scaled_bitmap->size() == size && m_scaled_bitmap->scale() == scale)
+        return m_scaled_bitmap;
+
+    auto format = bitmap.has_alpha_channel() ? Gfx::BitmapFormat::RGBA32 : Gfx::BitmapFormat::RGB32;
+    m_scaled_bitmap = Gfx::Bitmap::create(format, size, scale);
+    m_scaled_bitmap_source = nullptr;
+    if (!m_scaled_bitmap)
+        return nullptr;
+    m_scaled_bitmap_source = &bitmap;
+    m_scaled_bitmap->fill(Color::Transparent);
+    Gfx::Painter painter(*m_scaled_bitmap);
+    painter.draw_scaled_bitmap(m_scaled_bitmap->rect(), bitmap, bitmap.rect(), 1.0f, Gfx::Painter::ScalingMode::BilinearBlend);
+    return m_scaled_bitmap;
+}
+
 bool ImageBox::renders_as_alt_text() const
 {
     if (is<HTML::HTMLImageElement>(dom_node()))
@@ -52,7 +52,13 @@ private:
     int preferred_width() const;
     int preferred_height() const;
 
+    const Gfx::Bitmap* scaled_bitmap(const Gfx::Bitmap&, const Gfx::IntSize&, int scale);
+
     const ImageLoader& m_image_loader;
+
+    // The current frame scaled to the size of the box, so that repainting it (e.g. while scrolling) is just a blit.
+    RefPtr<Gfx::Bitmap> m_scaled_bitmap;
+    RefPtr<const Gfx::Bitmap> m_scaled_bitmap_source;
 };
 
 }
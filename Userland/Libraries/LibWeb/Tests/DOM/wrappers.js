@@ -0,0 +1,23 @@
+loadPage("file:///home/anon/web-tests/Pages/ParentNode.html");
+
+afterInitialPageLoad(() => {
+    test("Nodes get working wrappers after their old ones were collected", () => {
+        for (let i = 0; i < 100; ++i) document.body.appendChild(document.createElement("div"));
+
+        // Nothing holds on to the wrappers between rounds, so each round of allocations lets incremental
+        // marking find them dead while their blocks are still waiting to be swept. A node must not hand
+        // out such a wrapper again.
+        for (let round = 0; round < 10; ++round) {
+            for (let i = 0; i < 50000; ++i) ({ round, i });
+
+            let childCount = 0;
+            for (let child = document.body.firstChild; child; child = child.nextSibling) {
+                if (child.nodeName !== "DIV") continue;
+                expect(child.parentNode).toBe(document.body);
+                expect(child.tagName).toBe("DIV");
+                ++childCount;
+            }
+            expect(childCount).toBe(105);
+        }
+    });
+});
@@ -34,6 +34,7 @@ WebContentClient::WebContentClient(OutOfProcessWebView& view)
     : IPC::ServerConnection<WebContentClientEndpoint, WebContentServerEndpoint>(*this, "/tmp/portal/webcontent")
     , m_view(view)
 {
+    enable_shared_memory_transport();
     handshake();
 }
 
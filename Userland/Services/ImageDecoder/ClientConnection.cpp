@@ -66,6 +66,9 @@ OwnPtr<Messages::ImageDecoderServer::DecodeImageResponse> ClientConnection::hand
         return {};
     }
 
+    // NOTE: This decodes on the connection's thread rather than on LibThread::ThreadPool on purpose.
+    //       SystemServer starts one ImageDecoder per client, and the client waits for this response
+    //       synchronously, so there is never a second request that a pool could work on meanwhile.
     auto decoder = Gfx::ImageDecoder::create(encoded_buffer.data<u8>(), encoded_buffer.size());
 
     if (!decoder->frame_count()) {
@@ -27,6 +27,7 @@
 #pragma once
 
 #include <AK/ByteBuffer.h>
+#include <AK/Function.h>
 #include <AK/HashMap.h>
 #include <AK/NonnullOwnPtr.h>
 #include <AK/Optional.h>
@@ -73,7 +74,7 @@ void init(TSelf* self, TJob job)
 }
 
 template<typename TBadgedProtocol, typename TPipeResult>
-OwnPtr<Download> start_download(TBadgedProtocol&& protocol, ClientConnection& client, const String& method, const URL& url, const HashMap<String, String>& headers, ReadonlyBytes body, TPipeResult&& pipe_result)
+OwnPtr<Download> start_download(TBadgedProtocol&& protocol, ClientConnection& client, const String& method, const URL& url, const HashMap<String, String>& headers, ReadonlyBytes body, TPipeResult&& pipe_result, Function<void(typename TBadgedProtocol::Type::JobType&)> prepare_job = nullptr)
 {
     using TJob = TBadgedProtocol::Type::JobType;
     using TDownload = TBadgedProtocol::Type::DownloadType;
@@ -96,6 +97,8 @@ OwnPtr<Download> start_download(TBadgedProtocol&& protocol, ClientConnection& cl
     auto job = TJob::construct(request, *output_stream);
     auto download = TDownload::create_with_job(forward<TBadgedProtocol>(protocol), client, (TJob&)*job, move(output_stream));
     download->set_download_fd(pipe_result.value().read_fd);
+    if (prepare_job)
+        prepare_job(*job);
     job->start();
     return download;
 }
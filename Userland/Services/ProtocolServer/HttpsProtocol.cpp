@@ -46,7 +46,58 @@ HttpsProtocol::HttpsProtocol()
 
 OwnPtr<Download> HttpsProtocol::start_download(ClientConnection& client, const String& method, const URL& url, const HashMap<String, String>& headers, ReadonlyBytes body)
 {
-    return Detail::start_download(Badge<HttpsProtocol> {}, client, method, url, headers, body, get_pipe_for_download());
+    auto session_key = String::formatted("{}:{}", url.host(), url.port());
+    return Detail::start_download(Badge<HttpsProtocol> {}, client, method, url, headers, body, get_pipe_for_download(), [this, session_key](HTTP::HttpsJob& job) {
+        if (auto session = cached_session(session_key); session.has_value()) {
+            job.set_tls_session_to_resume(session.value());
+            job.on_tls_session_resumption_failed = [this, session_key, session = session.release_value()] {
+                forget_session(session_key, session);
+            };
+        }
+        job.on_tls_session_established = [this, session_key](auto& session) {
+            cache_session(session_key, session);
+        };
+    });
+}
+
+Optional<TLS::Session> HttpsProtocol::cached_session(const String& key)
+{
+    auto it = m_tls_sessions.find(key);
+    if (it == m_tls_sessions.end())
+        return {};
+    if (time(nullptr) >= it->value.expiration_time) {
+        m_tls_sessions.remove(it);
+        return {};
+    }
+    it->value.last_used = ++m_session_use_counter;
+    return it->value.session;
+}
+
+void HttpsProtocol::cache_session(const String& key, const TLS::Session& session)
+{
+    // RFC 5246 suggests not keeping a session ID for more than a day; a ticket may be good for less if the server says so.
+    time_t lifetime = 24 * 60 * 60;
+    if (session.ticket_lifetime_hint)
+        lifetime = min(lifetime, (time_t)session.ticket_lifetime_hint);
+
+    if (!m_tls_sessions.contains(key) && m_tls_sessions.size() >= max_cached_sessions) {
+        auto least_recently_used = m_tls_sessions.begin();
+        for (auto it = m_tls_sessions.begin(); it != m_tls_sessions.end(); ++it) {
+            if (it->value.last_used < least_recently_used->value.last_used)
+                least_recently_used = it;
+        }
+        m_tls_sessions.remove(least_recently_used);
+    }
+
+    m_tls_sessions.set(key, { session, time(nullptr) + lifetime, ++m_session_use_counter });
+}
+
+void HttpsProtocol::forget_session(const String& key, const TLS::Session& session)
+{
+    // Another connection may have cached a newer session for the same server in the meantime.
+    auto it = m_tls_sessions.find(key);
+    if (it != m_tls_sessions.end() && it->value.session.master_key == session.master_key)
+        m_tls_sessions.remove(it);
 }
 
 }
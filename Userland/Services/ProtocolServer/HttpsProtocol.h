@@ -36,6 +36,7 @@
 #include <ProtocolServer/Download.h>
 #include <ProtocolServer/HttpsDownload.h>
 #include <ProtocolServer/Protocol.h>
+#include <time.h>
 
 namespace ProtocolServer {
 
@@ -48,6 +49,23 @@ public:
     ~HttpsProtocol() override = default;
 
     virtual OwnPtr<Download> start_download(ClientConnection&, const String& method, const URL&, const HashMap<String, String>& headers, ReadonlyBytes body) override;
+
+private:
+    struct CachedSession {
+        TLS::Session session;
+        time_t expiration_time { 0 };
+        u64 last_used { 0 };
+    };
+
+    Optional<TLS::Session> cached_session(const String& key);
+    void cache_session(const String& key, const TLS::Session&);
+    void forget_session(const String& key, const TLS::Session&);
+
+    // Sessions are keyed by "host:port", so that the next connection to the same server can skip the full handshake.
+    // Only the most recently used few are kept around.
+    static constexpr size_t max_cached_sessions = 32;
+    HashMap<String, CachedSession> m_tls_sessions;
+    u64 m_session_use_counter { 0 };
 };
 
 }
@@ -52,6 +52,7 @@ ClientConnection::ClientConnection(NonnullRefPtr<Core::LocalSocket> socket, int
     , m_page_host(PageHost::create(*this))
 {
     s_connections.set(client_id, *this);
+    set_batching(true);
     m_paint_flush_timer = Core::Timer::create_single_shot(0, [this] { flush_pending_paint_requests(); });
 }
 
@@ -105,10 +105,29 @@ void Compositor::init_bitmaps()
     m_temp_painter = make<Gfx::Painter>(*m_temp_bitmap);
 
     m_buffers_are_flipped = false;
+    m_stretched_wallpaper = nullptr;
 
     invalidate_screen();
 }
 
+const Gfx::Bitmap& Compositor::stretched_wallpaper()
+{
+    VERIFY(m_wallpaper);
+    if (m_stretched_wallpaper)
+        return *m_stretched_wallpaper;
+
+    // Scaling the whole wallpaper at once keeps the filtering seamless across dirty rects. A translucent
+    // wallpaper stays translucent, so that it's still blended onto the background color like the others.
+    auto& screen = Screen::the();
+    auto format = m_wallpaper->has_alpha_channel() ? Gfx::BitmapFormat::RGBA32 : Gfx::BitmapFormat::RGB32;
+    m_stretched_wallpaper = Gfx::Bitmap::create(format, screen.size(), screen.scale_factor());
+    VERIFY(m_stretched_wallpaper);
+    m_stretched_wallpaper->fill(Color::Transparent);
+    Gfx::Painter painter(*m_stretched_wallpaper);
+    painter.draw_scaled_bitmap(m_stretched_wallpaper->rect(), *m_wallpaper, m_wallpaper->rect(), 1.0f, Gfx::Painter::ScalingMode::BilinearBlend);
+    return *m_stretched_wallpaper;
+}
+
 void Compositor::did_construct_window_manager(Badge<WindowManager>)
 {
     auto& wm = WindowManager::the();
@@ -254,12 +273,7 @@ void Compositor::compose()
             } else if (m_wallpaper_mode == WallpaperMode::Tile) {
                 painter.draw_tiled_bitmap(rect, *m_wallpaper);
             } else if (m_wallpaper_mode == WallpaperMode::Stretch) {
-                float hscale = (float)m_wallpaper->width() / (float)ws.width();
-                float vscale = (float)m_wallpaper->height() / (float)ws.height();
-
-                // TODO: this may look ugly, we should scale to a backing bitmap and then blit
-                auto src_rect = Gfx::FloatRect { rect.x() * hscale, rect.y() * vscale, rect.width() * hscale, rect.height() * vscale };
-                painter.draw_scaled_bitmap(rect, *m_wallpaper, src_rect);
+                painter.blit(rect.location(), stretched_wallpaper(), rect);
             } else {
                 VERIFY_NOT_REACHED();
             }
@@ -625,6 +639,7 @@ bool Compositor::set_wallpaper_mode(const String& mode)
 
     if (ret_val) {
         m_wallpaper_mode = mode_to_enum(mode);
+        m_stretched_wallpaper = nullptr;
         Compositor::invalidate_screen();
     }
 
@@ -641,6 +656,7 @@ bool Compositor::set_wallpaper(const String& path, Function<void(bool)>&& callba
         [this, path, callback = move(callback)](RefPtr<Gfx::Bitmap> bitmap) {
             m_wallpaper_path = path;
             m_wallpaper = move(bitmap);
+            m_stretched_wallpaper = nullptr;
             invalidate_screen();
             callback(true);
         });
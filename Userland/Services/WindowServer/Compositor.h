@@ -79,6 +79,7 @@ public:
 private:
     Compositor();
     void init_bitmaps();
+    const Gfx::Bitmap& stretched_wallpaper();
     void flip_buffers();
     void flush(const Gfx::IntRect&);
     void draw_menubar();
@@ -121,6 +122,8 @@ private:
     String m_wallpaper_path { "" };
     WallpaperMode m_wallpaper_mode { WallpaperMode::Unchecked };
     RefPtr<Gfx::Bitmap> m_wallpaper;
+    // The wallpaper scaled to the screen once, so WallpaperMode::Stretch only has to blit it.
+    RefPtr<Gfx::Bitmap> m_stretched_wallpaper;
 
     const Cursor* m_current_cursor { nullptr };
     unsigned m_current_cursor_frame { 0 };
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <malloc.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// These chunks land in the 500-byte size class, which is thread cached and not used much by anything else here.
+static constexpr size_t chunk_size = 400;
+static constexpr size_t chunk_count = 256;
+
+struct MallocInfoForSizeClass {
+    size_t thread_caches { 0 };
+    size_t cached_chunks { 0 };
+};
+
+static size_t parse_attribute(const char* line, const char* name)
+{
+    auto* attribute = strstr(line, name);
+    VERIFY(attribute);
+    return strtoul(attribute + strlen(name), nullptr, 10);
+}
+
+static MallocInfoForSizeClass malloc_info_for_size_class(size_t size)
+{
+    FILE* stream = tmpfile();
+    VERIFY(stream);
+    VERIFY(malloc_info(0, stream) == 0);
+    rewind(stream);
+
+    char size_attribute[32];
+    snprintf(size_attribute, sizeof(size_attribute), "<size size=\"%zu\" ", size);
+
+    MallocInfoForSizeClass info;
+    char line[256];
+    while (fgets(line, sizeof(line), stream)) {
+        if (strstr(line, size_attribute))
+            info.cached_chunks = parse_attribute(line, "cached_chunks=\"");
+        else if (strstr(line, "type=\"thread_caches\""))
+            info.thread_caches = parse_attribute(line, "count=\"");
+    }
+    fclose(stream);
+    return info;
+}
+
+static void fill(u8* chunk, size_t size, u8 seed)
+{
+    for (size_t i = 0; i < size; ++i)
+        chunk[i] = static_cast<u8>(seed + i);
+}
+
+static bool has_pattern(const u8* chunk, size_t size, u8 seed)
+{
+    for (size_t i = 0; i < size; ++i) {
+        if (chunk[i] != static_cast<u8>(seed + i))
+            return false;
+    }
+    return true;
+}
+
+TEST_CASE(malloc_info_rejects_bad_arguments)
+{
+    EXPECT_EQ(malloc_info(0, nullptr), -1);
+    EXPECT_EQ(malloc_info(1, stdout), -1);
+}
+
+static void* free_chunks_thread(void* argument)
+{
+    auto** chunks = static_cast<u8**>(argument);
+    for (size_t i = 0; i < chunk_count; ++i) {
+        if (!has_pattern(chunks[i], chunk_size, i))
+            return reinterpret_cast<void*>(1);
+        free(chunks[i]);
+    }
+    return nullptr;
+}
+
+TEST_CASE(free_from_another_thread)
+{
+    for (size_t round = 0; round < 4; ++round) {
+        u8* chunks[chunk_count];
+        for (size_t i = 0; i < chunk_count; ++i) {
+            chunks[i] = static_cast<u8*>(malloc(chunk_size));
+            EXPECT(chunks[i]);
+            fill(chunks[i], chunk_size, i);
+        }
+
+        pthread_t thread;
+        EXPECT_EQ(pthread_create(&thread, nullptr, free_chunks_thread, chunks), 0);
+        void* result = nullptr;
+        EXPECT_EQ(pthread_join(thread, &result), 0);
+        EXPECT_EQ(result, nullptr);
+
+        // The freed chunks must be usable again from this thread, without clobbering each other.
+        for (size_t i = 0; i < chunk_count; ++i) {
+            chunks[i] = static_cast<u8*>(malloc(chunk_size));
+            EXPECT(chunks[i]);
+            fill(chunks[i], chunk_size, i + round);
+        }
+        for (size_t i = 0; i < chunk_count; ++i) {
+            EXPECT(has_pattern(chunks[i], chunk_size, i + round));
+            free(chunks[i]);
+        }
+    }
+}
+
+TEST_CASE(realloc_across_size_classes)
+{
+    // Grow one allocation through every chunked size class and into big allocations, then shrink it again.
+    size_t sizes[] = { 1, 8, 9, 31, 64, 100, 500, 501, 1016, 2000, 4088, 8000, 16376, 32752, 32753, 65536, 300000 };
+
+    size_t filled_size = sizes[0];
+    auto* data = static_cast<u8*>(malloc(filled_size));
+    EXPECT(data);
+    fill(data, filled_size, 42);
+
+    for (size_t size : sizes) {
+        data = static_cast<u8*>(realloc(data, size));
+        EXPECT(data);
+        EXPECT(malloc_size(data) >= size);
+        EXPECT(has_pattern(data, filled_size, 42));
+        fill(data, size, 42);
+        filled_size = size;
+    }
+
+    for (ssize_t i = sizeof(sizes) / sizeof(sizes[0]) - 1; i >= 0; --i) {
+        data = static_cast<u8*>(realloc(data, sizes[i]));
+        EXPECT(data);
+        EXPECT(has_pattern(data, sizes[i], 42));
+    }
+    free(data);
+}
+
+static void* fill_thread_cache_thread(void* argument)
+{
+    auto* info_while_running = static_cast<MallocInfoForSizeClass*>(argument);
+    u8* chunks[chunk_count];
+    for (size_t i = 0; i < chunk_count; ++i)
+        chunks[i] = static_cast<u8*>(malloc(chunk_size));
+    for (size_t i = 0; i < chunk_count; ++i)
+        free(chunks[i]);
+    *info_while_running = malloc_info_for_size_class(500);
+    return nullptr;
+}
+
+TEST_CASE(thread_cache_is_flushed_on_thread_exit)
+{
+    auto info_before = malloc_info_for_size_class(500);
+
+    MallocInfoForSizeClass info_while_running;
+    pthread_t thread;
+    EXPECT_EQ(pthread_create(&thread, nullptr, fill_thread_cache_thread, &info_while_running), 0);
+    EXPECT_EQ(pthread_join(thread, nullptr), 0);
+
+    auto info_after = malloc_info_for_size_class(500);
+
+    // While the thread was running, its cache held some of the chunks it had freed.
+    EXPECT_EQ(info_while_running.thread_caches, info_before.thread_caches + 1);
+    EXPECT(info_while_running.cached_chunks > info_before.cached_chunks);
+
+    // Once it exited, the cache was unregistered and its chunks went back to their blocks.
+    EXPECT_EQ(info_after.thread_caches, info_before.thread_caches);
+    EXPECT_EQ(info_after.cached_chunks, info_before.cached_chunks);
+}
+
+TEST_MAIN(Malloc)
@@ -50,6 +50,23 @@ static int compare_sortable_object(const void* a, const void* b)
     }
 }
 
+static const int* s_sorted_ints_begin;
+static const int* s_sorted_ints_end;
+static bool s_compared_outside_of_array;
+
+// Breaks ties by address, like comparators that want a stable order do. This only
+// works if qsort() passes pointers into the array, never to copies of the elements.
+static int compare_int_by_value_then_address(const void* a, const void* b)
+{
+    auto* int1 = static_cast<const int*>(a);
+    auto* int2 = static_cast<const int*>(b);
+    if (int1 < s_sorted_ints_begin || int1 >= s_sorted_ints_end || int2 < s_sorted_ints_begin || int2 >= s_sorted_ints_end)
+        s_compared_outside_of_array = true;
+    if (*int1 != *int2)
+        return *int1 < *int2 ? -1 : 1;
+    return int1 < int2 ? -1 : (int1 == int2 ? 0 : 1);
+}
+
 static int calc_payload_for_pos(size_t pos)
 {
     pos *= 231;
@@ -95,6 +112,25 @@ int main()
             }
         }
     }
+    // Check that words are compared in place, both in small and in large arrays
+    for (size_t size : { 10, 1000 }) {
+        Vector<int> ints;
+        for (size_t i = 0; i < size; ++i)
+            ints.append(rand() % 50);
+        s_sorted_ints_begin = ints.data();
+        s_sorted_ints_end = ints.data() + ints.size();
+        qsort(ints.data(), ints.size(), sizeof(int), compare_int_by_value_then_address);
+        if (s_compared_outside_of_array) {
+            printf("\x1b[01;35mTests failed: comparator was passed a pointer outside of the array\n");
+            return 1;
+        }
+        for (auto i = 0u; i + 1 < ints.size(); ++i) {
+            if (ints[i] > ints[i + 1]) {
+                printf("\x1b[01;35mTests failed: saw %d before %d\n", ints[i], ints[i + 1]);
+                return 1;
+            }
+        }
+    }
     printf("PASS\n");
     return 0;
 }
@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <limits.h>
+#include <string.h>
+#include <sys/mman.h>
+
+// The strings are placed right before a page that can't be accessed, so that reading past their end crashes.
+struct GuardedBuffer {
+    GuardedBuffer()
+    {
+        base = (char*)mmap(nullptr, 3 * PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0);
+        VERIFY(base != MAP_FAILED);
+        VERIFY(mprotect(base + 2 * PAGE_SIZE, PAGE_SIZE, PROT_NONE) == 0);
+    }
+    ~GuardedBuffer() { munmap(base, 3 * PAGE_SIZE); }
+
+    char* at_end(size_t size) { return base + 2 * PAGE_SIZE - size; }
+
+    char* base { nullptr };
+};
+
+static int sign(int value)
+{
+    return value < 0 ? -1 : (value > 0 ? 1 : 0);
+}
+
+static size_t naive_strlen(const char* str)
+{
+    size_t length = 0;
+    while (str[length])
+        ++length;
+    return length;
+}
+
+static const char* naive_memchr(const char* str, char ch, size_t size)
+{
+    for (size_t i = 0; i < size; ++i) {
+        if (str[i] == ch)
+            return str + i;
+    }
+    return nullptr;
+}
+
+static int naive_strcmp(const char* s1, const char* s2)
+{
+    for (size_t i = 0;; ++i) {
+        if (s1[i] != s2[i] || !s1[i])
+            return (u8)s1[i] - (u8)s2[i];
+    }
+}
+
+static void fill(char* str, size_t length, u32 seed)
+{
+    for (size_t i = 0; i < length; ++i) {
+        seed = seed * 1103515245 + 12345;
+        str[i] = "ab\xff"[(seed >> 16) % 3];
+    }
+    str[length] = 0;
+}
+
+TEST_CASE(strlen_and_strnlen)
+{
+    GuardedBuffer buffer;
+    for (size_t length = 0; length < 80; ++length) {
+        for (size_t padding = 0; padding < 20; ++padding) {
+            auto* str = buffer.at_end(length + 1 + padding);
+            fill(str, length, length * 31 + padding);
+            EXPECT_EQ(strlen(str), length);
+            for (size_t maxlen = 0; maxlen < length + 2 + padding; ++maxlen)
+                EXPECT_EQ(strnlen(str, maxlen), min(length, maxlen));
+        }
+    }
+}
+
+TEST_CASE(memchr_and_strchr)
+{
+    GuardedBuffer buffer;
+    for (size_t length = 0; length < 80; ++length) {
+        for (size_t padding = 0; padding < 20; ++padding) {
+            auto* str = buffer.at_end(length + 1 + padding);
+            fill(str, length, length * 17 + padding);
+            for (char ch : { 'a', 'b', '\xff', 'c', '\0' }) {
+                for (size_t size = 0; size <= length + 1; ++size)
+                    EXPECT_EQ((const char*)memchr(str, ch, size), naive_memchr(str, ch, size));
+                EXPECT_EQ((const char*)strchr(str, ch), naive_memchr(str, ch, length + 1));
+            }
+        }
+    }
+}
+
+TEST_CASE(memcmp_and_strcmp)
+{
+    GuardedBuffer buffer1;
+    GuardedBuffer buffer2;
+    for (size_t length = 0; length < 80; ++length) {
+        for (size_t padding = 0; padding < 20; ++padding) {
+            auto* s1 = buffer1.at_end(length + 1 + padding);
+            auto* s2 = buffer2.at_end(length + 1 + (padding * 7) % 20);
+            fill(s1, length, length);
+            for (size_t difference = 0; difference <= length; ++difference) {
+                memcpy(s2, s1, length + 1);
+                if (difference < length)
+                    s2[difference] = s2[difference] == 'a' ? '\xff' : 'a';
+                EXPECT_EQ(sign(strcmp(s1, s2)), sign(naive_strcmp(s1, s2)));
+                EXPECT_EQ(sign(strcmp(s2, s1)), sign(naive_strcmp(s2, s1)));
+                EXPECT_EQ(sign(memcmp(s1, s2, length)), sign(naive_strcmp(s1, s2)));
+            }
+            s2[0] = 0;
+            EXPECT_EQ(sign(strcmp(s1, s2)), length ? 1 : 0);
+        }
+    }
+}
+
+// These measure the functions on strings of a few representative sizes, and are run with --bench.
+static constexpr size_t benchmark_sizes[] = { 8, 64, 512, 4096, 65536 };
+static constexpr size_t benchmark_bytes_per_size = 256 * MiB;
+
+template<typename Callback>
+static void benchmark(Callback callback)
+{
+    for (auto size : benchmark_sizes) {
+        auto* str = (char*)malloc(size + 1);
+        auto* other = (char*)malloc(size + 1);
+        memset(str, 'a', size);
+        str[size] = 0;
+        memcpy(other, str, size + 1);
+        size_t result = 0;
+        for (size_t i = 0; i < benchmark_bytes_per_size / size; ++i) {
+            result += callback(str, other, size);
+            asm volatile(""
+                         :
+                         : "g"(str)
+                         : "memory");
+        }
+        EXPECT(result != 0);
+        free(str);
+        free(other);
+    }
+}
+
+BENCHMARK_CASE(strlen)
+{
+    benchmark([](auto* str, auto*, size_t) { return strlen(str); });
+}
+
+BENCHMARK_CASE(strnlen)
+{
+    benchmark([](auto* str, auto*, size_t size) { return strnlen(str, size + 1); });
+}
+
+BENCHMARK_CASE(memchr)
+{
+    benchmark([](auto* str, auto*, size_t size) { return (size_t)memchr(str, 0, size + 1); });
+}
+
+BENCHMARK_CASE(strchr)
+{
+    benchmark([](auto* str, auto*, size_t) { return (size_t)strchr(str, 'b') + 1; });
+}
+
+BENCHMARK_CASE(memcmp)
+{
+    benchmark([](auto* str, auto* other, size_t size) { return (size_t)memcmp(str, other, size) + 1; });
+}
+
+BENCHMARK_CASE(strcmp)
+{
+    benchmark([](auto* str, auto* other, size_t) { return (size_t)strcmp(str, other) + 1; });
+}
+
+TEST_MAIN(StringFunctions)
@@ -0,0 +1,362 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <LibCore/EventLoop.h>
+#include <LibCore/Notifier.h>
+#include <LibCore/Timer.h>
+#include <unistd.h>
+
+// Core::EventLoop expects a single main loop for the lifetime of the process, so all tests share this one.
+static Core::EventLoop& event_loop()
+{
+    static Core::EventLoop* event_loop = new Core::EventLoop;
+    return *event_loop;
+}
+
+// Runs the event loop until something quits it, or until the timeout expires and fails the test.
+static void run_event_loop(int timeout_ms = 2000)
+{
+    bool timed_out = false;
+    auto timeout = Core::Timer::create_single_shot(timeout_ms, [&] {
+        timed_out = true;
+        event_loop().quit(0);
+    });
+    timeout->start();
+    event_loop().unquit();
+    event_loop().exec();
+    timeout->stop();
+    EXPECT(!timed_out);
+}
+
+[[nodiscard]] static NonnullRefPtr<Core::Timer> quit_after(int ms)
+{
+    auto timer = Core::Timer::create_single_shot(ms, [] { event_loop().quit(0); });
+    timer->start();
+    return timer;
+}
+
+struct Pipe {
+    Pipe() { VERIFY(pipe(fds) == 0); }
+    ~Pipe()
+    {
+        close(fds[0]);
+        close(fds[1]);
+    }
+
+    int read_fd() const { return fds[0]; }
+    void write_byte() { VERIFY(write(fds[1], "x", 1) == 1); }
+    void read_byte()
+    {
+        char byte;
+        VERIFY(read(fds[0], &byte, 1) == 1);
+    }
+
+    int fds[2];
+};
+
+TEST_CASE(timers_fire_in_order_of_expiration)
+{
+    // Timers can only be registered once the event loop exists.
+    event_loop();
+    Vector<int> fired;
+    Vector<NonnullRefPtr<Core::Timer>> timers;
+    for (int interval : { 90, 15, 60, 30, 75, 45 }) {
+        timers.append(Core::Timer::create_single_shot(interval, [&fired, interval] {
+            fired.append(interval);
+            if (fired.size() == 6)
+                event_loop().quit(0);
+        }));
+        timers.last()->start();
+    }
+
+    run_event_loop();
+    EXPECT_EQ(fired.size(), 6u);
+    for (size_t i = 0; i < fired.size(); ++i)
+        EXPECT_EQ(fired[i], 15 * ((int)i + 1));
+}
+
+TEST_CASE(single_shot_timer_fires_once)
+{
+    size_t fire_count = 0;
+    auto timer = Core::Timer::create_single_shot(5, [&] { ++fire_count; });
+    timer->start();
+    auto quit_timer = quit_after(80);
+
+    run_event_loop();
+    EXPECT_EQ(fire_count, 1u);
+    EXPECT(!timer->is_active());
+}
+
+TEST_CASE(single_shot_timer_restarted_in_callback)
+{
+    size_t fire_count = 0;
+    RefPtr<Core::Timer> timer;
+    timer = Core::Timer::create_single_shot(5, [&] {
+        if (++fire_count < 3)
+            timer->start();
+    });
+    timer->start();
+    auto quit_timer = quit_after(100);
+
+    run_event_loop();
+    EXPECT_EQ(fire_count, 3u);
+}
+
+TEST_CASE(repeating_timer_stopped_in_callback)
+{
+    size_t fire_count = 0;
+    auto timer = Core::Timer::construct();
+    timer->on_timeout = [&] {
+        if (++fire_count == 4)
+            timer->stop();
+    };
+    timer->start(5);
+    auto quit_timer = quit_after(120);
+
+    run_event_loop();
+    EXPECT_EQ(fire_count, 4u);
+}
+
+TEST_CASE(repeating_timer_rearmed_in_callback)
+{
+    // Re-arming with a longer interval moves the timer behind one that would have fired later.
+    Vector<String> fired;
+    auto repeating = Core::Timer::construct();
+    repeating->on_timeout = [&] {
+        fired.append("repeating");
+        repeating->restart(60);
+    };
+    repeating->start(10);
+    auto single_shot = Core::Timer::create_single_shot(40, [&] {
+        fired.append("single-shot");
+        repeating->stop();
+        event_loop().quit(0);
+    });
+    single_shot->start();
+
+    run_event_loop();
+    EXPECT_EQ(fired.size(), 2u);
+    EXPECT_EQ(fired[0], "repeating");
+    EXPECT_EQ(fired[1], "single-shot");
+}
+
+TEST_CASE(timer_cancelled_by_another_timer)
+{
+    bool cancelled_timer_fired = false;
+    auto cancelled = Core::Timer::create_single_shot(50, [&] { cancelled_timer_fired = true; });
+    cancelled->start();
+    auto canceller = Core::Timer::create_single_shot(5, [&] { cancelled->stop(); });
+    canceller->start();
+    auto quit_timer = quit_after(100);
+
+    run_event_loop();
+    EXPECT(!cancelled_timer_fired);
+}
+
+TEST_CASE(many_timers_with_cancellations)
+{
+    // Stop every third timer up front, and have each firing timer stop the next-but-one timer in line.
+    constexpr int timer_count = 30;
+    Vector<int> fired;
+    Vector<NonnullRefPtr<Core::Timer>> timers;
+    for (int i = 0; i < timer_count; ++i) {
+        timers.append(Core::Timer::create_single_shot(10 + i * 5, [&, i] {
+            fired.append(i);
+            if (i % 4 == 0 && i + 2 < timer_count)
+                timers[i + 2]->stop();
+        }));
+    }
+    for (int i = 0; i < timer_count; ++i) {
+        if (i % 3 != 0)
+            timers[i]->start();
+    }
+    auto quit_timer = quit_after(10 + timer_count * 5 + 50);
+
+    run_event_loop();
+
+    Vector<int> expected;
+    for (int i = 0; i < timer_count; ++i) {
+        if (i % 3 == 0)
+            continue;
+        if (i >= 2 && (i - 2) % 4 == 0 && (i - 2) % 3 != 0)
+            continue;
+        expected.append(i);
+    }
+    EXPECT_EQ(fired.size(), expected.size());
+    for (size_t i = 0; i < min(fired.size(), expected.size()); ++i)
+        EXPECT_EQ(fired[i], expected[i]);
+}
+
+TEST_CASE(notifier_fires_for_readable_fd)
+{
+    Pipe pipe;
+    size_t read_count = 0;
+    auto notifier = Core::Notifier::construct(pipe.read_fd(), Core::Notifier::Read);
+    notifier->on_ready_to_read = [&] {
+        pipe.read_byte();
+        if (++read_count == 3)
+            event_loop().quit(0);
+        else
+            pipe.write_byte();
+    };
+    pipe.write_byte();
+
+    run_event_loop();
+    EXPECT_EQ(read_count, 3u);
+}
+
+TEST_CASE(disabled_notifier_does_not_fire)
+{
+    Pipe pipe;
+    bool fired = false;
+    auto notifier = Core::Notifier::construct(pipe.read_fd(), Core::Notifier::Read);
+    notifier->on_ready_to_read = [&] {
+        pipe.read_byte();
+        fired = true;
+    };
+    notifier->set_enabled(false);
+    pipe.write_byte();
+    auto quit_timer = quit_after(30);
+
+    run_event_loop();
+    EXPECT(!fired);
+
+    notifier->set_enabled(true);
+    notifier->on_ready_to_read = [&] {
+        pipe.read_byte();
+        fired = true;
+        event_loop().quit(0);
+    };
+    run_event_loop();
+    EXPECT(fired);
+}
+
+TEST_CASE(notifier_event_mask_changes)
+{
+    Pipe pipe;
+    bool fired = false;
+    auto notifier = Core::Notifier::construct(pipe.read_fd(), Core::Notifier::None);
+    notifier->on_ready_to_read = [&] {
+        pipe.read_byte();
+        fired = true;
+        event_loop().quit(0);
+    };
+    pipe.write_byte();
+    auto enable_timer = Core::Timer::create_single_shot(20, [&] {
+        EXPECT(!fired);
+        notifier->set_event_mask(Core::Notifier::Read);
+    });
+    enable_timer->start();
+
+    run_event_loop();
+    EXPECT(fired);
+}
+
+TEST_CASE(notifier_added_during_dispatch)
+{
+    Pipe first_pipe;
+    Pipe second_pipe;
+    RefPtr<Core::Notifier> second_notifier;
+    bool second_fired = false;
+
+    auto first_notifier = Core::Notifier::construct(first_pipe.read_fd(), Core::Notifier::Read);
+    first_notifier->on_ready_to_read = [&] {
+        first_pipe.read_byte();
+        second_notifier = Core::Notifier::construct(second_pipe.read_fd(), Core::Notifier::Read);
+        second_notifier->on_ready_to_read = [&] {
+            second_pipe.read_byte();
+            second_fired = true;
+            event_loop().quit(0);
+        };
+    };
+    first_pipe.write_byte();
+    second_pipe.write_byte();
+
+    run_event_loop();
+    EXPECT(second_fired);
+}
+
+TEST_CASE(notifier_removed_during_dispatch)
+{
+    // Both notifiers watch the same fd, so their events are posted in the same iteration.
+    Pipe pipe;
+    size_t fire_count = 0;
+    RefPtr<Core::Notifier> first_notifier;
+    RefPtr<Core::Notifier> second_notifier;
+
+    first_notifier = Core::Notifier::construct(pipe.read_fd(), Core::Notifier::Read);
+    first_notifier->on_ready_to_read = [&] {
+        ++fire_count;
+        pipe.read_byte();
+        second_notifier = nullptr;
+    };
+    second_notifier = Core::Notifier::construct(pipe.read_fd(), Core::Notifier::Read);
+    second_notifier->on_ready_to_read = [&] {
+        ++fire_count;
+        pipe.read_byte();
+        first_notifier->set_enabled(false);
+    };
+    pipe.write_byte();
+    auto quit_timer = quit_after(50);
+
+    run_event_loop();
+    EXPECT_EQ(fire_count, 1u);
+    if (first_notifier)
+        first_notifier->set_enabled(false);
+
+    // Neither notifier is registered anymore, so the fd no longer wakes the loop.
+    auto notifier_events_before = Core::EventLoop::statistics().notifier_events;
+    pipe.write_byte();
+    auto second_quit_timer = quit_after(30);
+    run_event_loop();
+    EXPECT_EQ(Core::EventLoop::statistics().notifier_events, notifier_events_before);
+    pipe.read_byte();
+}
+
+TEST_CASE(notifier_removed_and_other_kept_on_same_fd)
+{
+    Pipe pipe;
+    size_t kept_count = 0;
+    auto removed = Core::Notifier::construct(pipe.read_fd(), Core::Notifier::Read);
+    removed->on_ready_to_read = [] { VERIFY_NOT_REACHED(); };
+    auto kept = Core::Notifier::construct(pipe.read_fd(), Core::Notifier::Read);
+    kept->on_ready_to_read = [&] {
+        pipe.read_byte();
+        if (++kept_count == 2)
+            event_loop().quit(0);
+        else
+            pipe.write_byte();
+    };
+    removed->set_enabled(false);
+    pipe.write_byte();
+
+    run_event_loop();
+    EXPECT_EQ(kept_count, 2u);
+}
+
+TEST_MAIN(EventLoop)
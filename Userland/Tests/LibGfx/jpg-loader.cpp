@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <LibGfx/Bitmap.h>
+#include <LibGfx/JPGLoader.h>
+#include <LibGfx/PNGLoader.h>
+#include <stdlib.h>
+
+// The images in test-inputs/jpg were all encoded at quality 95 from reference.png, which is 83x61,
+// so that the last row and column of MCUs are partial.
+#ifdef __serenity__
+#    define TEST_INPUT(x) ("/usr/Tests/LibGfx/test-inputs/jpg/" x)
+#else
+#    define TEST_INPUT(x) ("test-inputs/jpg/" x)
+#endif
+
+static NonnullRefPtr<Gfx::Bitmap> reference_bitmap()
+{
+    static RefPtr<Gfx::Bitmap> reference = Gfx::load_png(TEST_INPUT("reference.png"));
+    VERIFY(reference);
+    return *reference;
+}
+
+static Color to_grayscale(Color color)
+{
+    u8 luma = (color.red() * 299 + color.green() * 587 + color.blue() * 114 + 500) / 1000;
+    return Color(luma, luma, luma);
+}
+
+// The average of the reference pixels that end up in one pixel of the image scaled down by `denominator`.
+static Color reference_block_average(int x, int y, int denominator)
+{
+    auto reference = reference_bitmap();
+    int sums[3] {};
+    int count = 0;
+    for (int reference_y = y * denominator; reference_y < min(reference->height(), (y + 1) * denominator); ++reference_y) {
+        for (int reference_x = x * denominator; reference_x < min(reference->width(), (x + 1) * denominator); ++reference_x) {
+            auto color = reference->get_pixel(reference_x, reference_y);
+            sums[0] += color.red();
+            sums[1] += color.green();
+            sums[2] += color.blue();
+            ++count;
+        }
+    }
+    return Color(sums[0] / count, sums[1] / count, sums[2] / count);
+}
+
+// The mean absolute difference per color channel. JPEG is lossy, and the decoder scales chroma
+// back up by repeating samples, so images are compared with a tolerance rather than exactly.
+template<typename Callback>
+static double mean_error(const Gfx::Bitmap& bitmap, Callback expected_pixel)
+{
+    u64 total_error = 0;
+    for (int y = 0; y < bitmap.height(); ++y) {
+        for (int x = 0; x < bitmap.width(); ++x) {
+            auto actual = bitmap.get_pixel(x, y);
+            auto expected = expected_pixel(x, y);
+            total_error += abs(actual.red() - expected.red()) + abs(actual.green() - expected.green()) + abs(actual.blue() - expected.blue());
+        }
+    }
+    return (double)total_error / (bitmap.width() * bitmap.height() * 3);
+}
+
+static RefPtr<Gfx::Bitmap> expect_close_to_reference(const char* path, double tolerance, bool is_grayscale = false)
+{
+    auto bitmap = Gfx::load_jpg(path);
+    EXPECT(bitmap);
+    if (!bitmap)
+        return nullptr;
+    EXPECT_EQ(bitmap->size(), reference_bitmap()->size());
+    if (bitmap->size() != reference_bitmap()->size())
+        return nullptr;
+
+    auto error = mean_error(*bitmap, [&](int x, int y) {
+        auto color = reference_bitmap()->get_pixel(x, y);
+        return is_grayscale ? to_grayscale(color) : color;
+    });
+    if (error > tolerance)
+        warnln("{}: mean error {} exceeds {}", path, error, tolerance);
+    EXPECT(error <= tolerance);
+    return bitmap;
+}
+
+static void expect_identical(const Gfx::Bitmap& bitmap, const Gfx::Bitmap& other)
+{
+    EXPECT_EQ(bitmap.size(), other.size());
+    if (bitmap.size() != other.size())
+        return;
+    size_t mismatches = 0;
+    for (int y = 0; y < bitmap.height(); ++y) {
+        for (int x = 0; x < bitmap.width(); ++x)
+            mismatches += bitmap.get_pixel(x, y) != other.get_pixel(x, y);
+    }
+    EXPECT_EQ(mismatches, 0u);
+}
+
+TEST_CASE(baseline)
+{
+    expect_close_to_reference(TEST_INPUT("baseline-444.jpg"), 1.5);
+    expect_close_to_reference(TEST_INPUT("baseline-422.jpg"), 3);
+    expect_close_to_reference(TEST_INPUT("baseline-420.jpg"), 4);
+    expect_close_to_reference(TEST_INPUT("grayscale.jpg"), 1, true);
+}
+
+TEST_CASE(restart_intervals)
+{
+    auto baseline = Gfx::load_jpg(TEST_INPUT("baseline-420.jpg"));
+    auto with_restarts = expect_close_to_reference(TEST_INPUT("baseline-420-restart.jpg"), 4);
+    if (baseline && with_restarts)
+        expect_identical(*with_restarts, *baseline);
+}
+
+// Progressive images carry the same coefficients as the baseline ones, only spread over several scans.
+TEST_CASE(progressive)
+{
+    auto baseline_444 = Gfx::load_jpg(TEST_INPUT("baseline-444.jpg"));
+    auto progressive_444 = expect_close_to_reference(TEST_INPUT("progressive-444.jpg"), 1.5);
+    if (baseline_444 && progressive_444)
+        expect_identical(*progressive_444, *baseline_444);
+
+    auto baseline_420 = Gfx::load_jpg(TEST_INPUT("baseline-420.jpg"));
+    auto progressive_420 = expect_close_to_reference(TEST_INPUT("progressive-420.jpg"), 4);
+    if (baseline_420 && progressive_420)
+        expect_identical(*progressive_420, *baseline_420);
+
+    auto baseline_grayscale = Gfx::load_jpg(TEST_INPUT("grayscale.jpg"));
+    auto progressive_grayscale = expect_close_to_reference(TEST_INPUT("grayscale-progressive.jpg"), 1, true);
+    if (baseline_grayscale && progressive_grayscale)
+        expect_identical(*progressive_grayscale, *baseline_grayscale);
+}
+
+// An extended sequential image with 8-bit samples only differs from a baseline one in its frame marker.
+TEST_CASE(extended_sequential)
+{
+    auto baseline = Gfx::load_jpg(TEST_INPUT("baseline-420.jpg"));
+    auto extended = expect_close_to_reference(TEST_INPUT("sof1-420.jpg"), 4);
+    if (baseline && extended)
+        expect_identical(*extended, *baseline);
+}
+
+TEST_CASE(downscaled_sizes)
+{
+    auto expect_size = [](const Gfx::IntSize& minimum_size, const Gfx::IntSize& expected_size) {
+        auto bitmap = Gfx::load_jpg_downscaled(TEST_INPUT("baseline-420.jpg"), minimum_size);
+        EXPECT(bitmap);
+        if (bitmap)
+            EXPECT_EQ(bitmap->size(), expected_size);
+    };
+
+    // Partial blocks round the size up.
+    expect_size({ 1, 1 }, { 11, 8 });
+    expect_size({ 11, 8 }, { 11, 8 });
+    expect_size({ 12, 8 }, { 21, 16 });
+    expect_size({ 21, 16 }, { 21, 16 });
+    expect_size({ 21, 17 }, { 42, 31 });
+    expect_size({ 42, 31 }, { 42, 31 });
+    expect_size({ 43, 31 }, { 83, 61 });
+    expect_size({ 1000, 1000 }, { 83, 61 });
+}
+
+TEST_CASE(downscaled_content)
+{
+    for (int denominator : { 2, 4, 8 }) {
+        Gfx::IntSize size { (83 + denominator - 1) / denominator, (61 + denominator - 1) / denominator };
+        for (auto* path : { TEST_INPUT("baseline-444.jpg"), TEST_INPUT("baseline-420.jpg"), TEST_INPUT("progressive-420.jpg") }) {
+            auto bitmap = Gfx::load_jpg_downscaled(path, size);
+            EXPECT(bitmap);
+            if (!bitmap)
+                continue;
+            EXPECT_EQ(bitmap->size(), size);
+            if (bitmap->size() != size)
+                continue;
+            auto error = mean_error(*bitmap, [&](int x, int y) { return reference_block_average(x, y, denominator); });
+            if (error > 4)
+                warnln("{} at 1/{}: mean error {} exceeds 4", path, denominator, error);
+            EXPECT(error <= 4);
+        }
+    }
+
+    auto grayscale = Gfx::load_jpg_downscaled(TEST_INPUT("grayscale.jpg"), { 11, 8 });
+    EXPECT(grayscale);
+    if (grayscale) {
+        auto error = mean_error(*grayscale, [&](int x, int y) { return to_grayscale(reference_block_average(x, y, 8)); });
+        EXPECT(error <= 2);
+    }
+}
+
+TEST_MAIN(JPGLoader)
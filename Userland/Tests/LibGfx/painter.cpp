@@ -0,0 +1,427 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <LibGfx/Bitmap.h>
+#include <LibGfx/Painter.h>
+#include <LibGfx/Path.h>
+#include <LibGfx/PathRasterizer.h>
+#include <math.h>
+
+static u32 s_seed = 1;
+
+static u32 next_random()
+{
+    s_seed = s_seed * 1103515245 + 12345;
+    return s_seed >> 8;
+}
+
+// Random colors, with the fully transparent and fully opaque alphas overrepresented.
+static Color random_color()
+{
+    auto color = Color::from_rgba(next_random() | next_random() << 24);
+    switch (next_random() % 4) {
+    case 0:
+        return color.with_alpha(0);
+    case 1:
+        return color.with_alpha(255);
+    default:
+        return color;
+    }
+}
+
+static NonnullRefPtr<Gfx::Bitmap> create_random_bitmap(Gfx::BitmapFormat format, const Gfx::IntSize& size)
+{
+    auto bitmap = Gfx::Bitmap::create(format, size);
+    VERIFY(bitmap);
+    for (int y = 0; y < size.height(); ++y) {
+        for (int x = 0; x < size.width(); ++x)
+            bitmap->scanline(y)[x] = random_color().value();
+    }
+    return bitmap.release_nonnull();
+}
+
+static NonnullRefPtr<Gfx::Bitmap> copy_of(const Gfx::Bitmap& bitmap)
+{
+    auto copy = bitmap.clone();
+    VERIFY(copy);
+    return copy.release_nonnull();
+}
+
+TEST_CASE(blit_matches_color_blend)
+{
+    auto target = create_random_bitmap(Gfx::BitmapFormat::RGBA32, { 37, 23 });
+    auto source = create_random_bitmap(Gfx::BitmapFormat::RGBA32, { 37, 23 });
+    auto expected = copy_of(target);
+    for (int y = 0; y < 23; ++y) {
+        for (int x = 0; x < 37; ++x)
+            expected->scanline(y)[x] = Color::from_rgba(expected->scanline(y)[x]).blend(Color::from_rgba(source->scanline(y)[x])).value();
+    }
+
+    Gfx::Painter painter(*target);
+    painter.blit({}, *source, source->rect());
+    for (int y = 0; y < 23; ++y) {
+        for (int x = 0; x < 37; ++x)
+            EXPECT_EQ(target->scanline(y)[x], expected->scanline(y)[x]);
+    }
+}
+
+TEST_CASE(blit_with_opacity_onto_opaque_target)
+{
+    auto target = create_random_bitmap(Gfx::BitmapFormat::RGB32, { 29, 7 });
+    auto source = create_random_bitmap(Gfx::BitmapFormat::RGB32, { 29, 7 });
+    auto expected = copy_of(target);
+    for (int y = 0; y < 7; ++y) {
+        for (int x = 0; x < 29; ++x) {
+            auto color = Color::from_rgb(source->scanline(y)[x]).with_alpha(127);
+            expected->scanline(y)[x] = Color::from_rgb(expected->scanline(y)[x]).blend(color).value();
+        }
+    }
+
+    Gfx::Painter painter(*target);
+    painter.blit({}, *source, source->rect(), 127 / 255.0f);
+    for (int y = 0; y < 7; ++y) {
+        for (int x = 0; x < 29; ++x)
+            EXPECT_EQ(target->scanline(y)[x], expected->scanline(y)[x]);
+    }
+}
+
+TEST_CASE(fill_rect_matches_color_blend)
+{
+    for (int i = 0; i < 16; ++i) {
+        auto target = create_random_bitmap(Gfx::BitmapFormat::RGBA32, { 19, 5 });
+        auto expected = copy_of(target);
+        auto color = random_color();
+        Gfx::IntRect rect { 1, 1, 17, 3 };
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            for (int x = rect.left(); x <= rect.right(); ++x) {
+                if (color.alpha())
+                    expected->scanline(y)[x] = Color::from_rgba(expected->scanline(y)[x]).blend(color).value();
+            }
+        }
+
+        Gfx::Painter painter(*target);
+        painter.fill_rect(rect, color);
+        for (int y = 0; y < 5; ++y) {
+            for (int x = 0; x < 19; ++x)
+                EXPECT_EQ(target->scanline(y)[x], expected->scanline(y)[x]);
+        }
+    }
+}
+
+TEST_CASE(fill_rect_with_draw_op)
+{
+    auto target = create_random_bitmap(Gfx::BitmapFormat::RGBA32, { 9, 9 });
+    auto original = copy_of(target);
+    auto color = Color(0x12, 0x34, 0x56, 0x78);
+
+    Gfx::Painter painter(*target);
+    painter.set_draw_op(Gfx::Painter::DrawOp::Xor);
+    painter.fill_rect({ 0, 0, 9, 4 }, color);
+    painter.set_draw_op(Gfx::Painter::DrawOp::Invert);
+    painter.fill_rect({ 0, 4, 9, 5 }, color);
+    for (int x = 0; x < 9; ++x) {
+        for (int y = 0; y < 4; ++y)
+            EXPECT_EQ(target->scanline(y)[x], color.xored(Color::from_rgba(original->scanline(y)[x])).value());
+        for (int y = 4; y < 9; ++y)
+            EXPECT_EQ(target->scanline(y)[x], Color::from_rgba(original->scanline(y)[x]).inverted().value());
+    }
+}
+
+TEST_CASE(bilinear_scaling)
+{
+    // A two pixel gradient, stretched out horizontally, interpolates smoothly from one end to the other.
+    auto source = Gfx::Bitmap::create(Gfx::BitmapFormat::RGB32, { 2, 1 });
+    source->set_pixel(0, 0, Color(0, 0, 0));
+    source->set_pixel(1, 0, Color(200, 100, 0));
+    auto target = Gfx::Bitmap::create(Gfx::BitmapFormat::RGB32, { 64, 8 });
+    Gfx::Painter painter(*target);
+    painter.draw_scaled_bitmap(target->rect(), *source, source->rect(), 1.0f, Gfx::Painter::ScalingMode::BilinearBlend);
+
+    EXPECT_EQ(target->get_pixel(0, 0), Color(0, 0, 0));
+    EXPECT_EQ(target->get_pixel(63, 7), Color(200, 100, 0));
+    for (int x = 1; x < 64; ++x) {
+        EXPECT(target->get_pixel(x, 0).red() >= target->get_pixel(x - 1, 0).red());
+        EXPECT_EQ(target->get_pixel(x, 0), target->get_pixel(x, 7));
+    }
+    EXPECT(target->get_pixel(31, 0).red() > 90 && target->get_pixel(31, 0).red() < 110);
+}
+
+TEST_CASE(box_filter_scaling)
+{
+    // A checkerboard scaled down by a factor of two averages out to a flat gray.
+    auto source = Gfx::Bitmap::create(Gfx::BitmapFormat::RGB32, { 64, 64 });
+    for (int y = 0; y < 64; ++y) {
+        for (int x = 0; x < 64; ++x)
+            source->set_pixel(x, y, (x + y) % 2 ? Color::White : Color::Black);
+    }
+    auto target = Gfx::Bitmap::create(Gfx::BitmapFormat::RGB32, { 32, 32 });
+    Gfx::Painter painter(*target);
+    painter.draw_scaled_bitmap(target->rect(), *source, source->rect(), 1.0f, Gfx::Painter::ScalingMode::BilinearBlend);
+    for (int y = 0; y < 32; ++y) {
+        for (int x = 0; x < 32; ++x)
+            EXPECT_EQ(target->get_pixel(x, y), Color(127, 127, 127));
+    }
+}
+
+TEST_CASE(scaling_reads_all_formats_alike)
+{
+    // RGB32 pixels are scaled in place with whatever is in their alpha byte, and an Indexed8 bitmap is converted
+    // a row at a time; both have to give the same opaque result. The odd sizes leave partial groups of four pixels.
+    struct {
+        Gfx::IntSize source_size;
+        Gfx::IntSize target_size;
+    } cases[] = {
+        { { 13, 7 }, { 37, 23 } },
+        { { 61, 45 }, { 19, 14 } },
+        { { 600, 5 }, { 2, 2 } },
+    };
+    for (auto& test_case : cases) {
+        auto indexed = Gfx::Bitmap::create(Gfx::BitmapFormat::Indexed8, test_case.source_size);
+        auto rgb = Gfx::Bitmap::create(Gfx::BitmapFormat::RGB32, test_case.source_size);
+        for (int i = 0; i < 256; ++i)
+            indexed->set_palette_color(i, random_color().with_alpha(255));
+        for (int y = 0; y < test_case.source_size.height(); ++y) {
+            for (int x = 0; x < test_case.source_size.width(); ++x) {
+                u8 index = next_random();
+                indexed->scanline_u8(y)[x] = index;
+                rgb->scanline(y)[x] = (indexed->palette_color(index).value() & 0x00ffffff) | (next_random() << 24);
+            }
+        }
+
+        auto indexed_target = Gfx::Bitmap::create(Gfx::BitmapFormat::RGBA32, test_case.target_size);
+        auto rgb_target = Gfx::Bitmap::create(Gfx::BitmapFormat::RGBA32, test_case.target_size);
+        indexed_target->fill(Color::Transparent);
+        rgb_target->fill(Color::Transparent);
+        Gfx::Painter(*indexed_target).draw_scaled_bitmap(indexed_target->rect(), *indexed, indexed->rect(), 1.0f, Gfx::Painter::ScalingMode::BilinearBlend);
+        Gfx::Painter(*rgb_target).draw_scaled_bitmap(rgb_target->rect(), *rgb, rgb->rect(), 1.0f, Gfx::Painter::ScalingMode::BilinearBlend);
+        for (int y = 0; y < test_case.target_size.height(); ++y) {
+            for (int x = 0; x < test_case.target_size.width(); ++x) {
+                EXPECT_EQ(rgb_target->scanline(y)[x], indexed_target->scanline(y)[x]);
+                EXPECT_EQ(rgb_target->get_pixel(x, y).alpha(), 255);
+            }
+        }
+    }
+}
+
+static Gfx::Path rectangle_path(float left, float top, float right, float bottom)
+{
+    Gfx::Path path;
+    path.move_to({ left, top });
+    path.line_to({ right, top });
+    path.line_to({ right, bottom });
+    path.line_to({ left, bottom });
+    path.close();
+    return path;
+}
+
+TEST_CASE(fill_path_antialiases_edges)
+{
+    auto target = Gfx::Bitmap::create(Gfx::BitmapFormat::RGB32, { 10, 8 });
+    target->fill(Color::Black);
+    Gfx::Painter painter(*target);
+    auto path = rectangle_path(2.5f, 2, 7.5f, 6);
+    painter.fill_path(path, Color::White);
+
+    for (int y = 0; y < 8; ++y) {
+        for (int x = 0; x < 10; ++x) {
+            auto color = target->get_pixel(x, y);
+            if (y < 2 || y >= 6 || x < 2 || x > 7)
+                EXPECT_EQ(color, Color::Black);
+            else if (x == 2 || x == 7)
+                EXPECT(color.red() >= 127 && color.red() <= 128);
+            else
+                EXPECT_EQ(color, Color::White);
+        }
+    }
+}
+
+TEST_CASE(path_rasterizer_winding_rules)
+{
+    // Two squares, one inside the other, going the same way around.
+    auto path = rectangle_path(0, 0, 12, 12);
+    path.move_to({ 4, 4 });
+    path.line_to({ 8, 4 });
+    path.line_to({ 8, 8 });
+    path.line_to({ 4, 8 });
+    path.close();
+
+    for (auto rule : { Gfx::Painter::WindingRule::Nonzero, Gfx::Painter::WindingRule::EvenOdd }) {
+        Gfx::PathRasterizer rasterizer({ 12, 12 });
+        rasterizer.draw_path(path);
+        auto bitmap = rasterizer.accumulate(rule);
+        EXPECT_EQ(bitmap->get_pixel(1, 1).alpha(), 255);
+        EXPECT_EQ(bitmap->get_pixel(6, 6).alpha(), rule == Gfx::Painter::WindingRule::Nonzero ? 255 : 0);
+    }
+}
+
+TEST_CASE(path_rasterizer_clips_to_its_size)
+{
+    // Spilling over every edge, and with an unclosed subpath, which is filled as if it was closed.
+    Gfx::Path path;
+    path.move_to({ -10, -10 });
+    path.line_to({ 30, -5 });
+    path.line_to({ 25, 40 });
+    path.line_to({ -20, 30 });
+
+    Gfx::PathRasterizer rasterizer({ 16, 16 });
+    rasterizer.draw_path(path);
+    auto bitmap = rasterizer.accumulate();
+    for (int y = 0; y < 16; ++y) {
+        for (int x = 0; x < 16; ++x)
+            EXPECT_EQ(bitmap->get_pixel(x, y).alpha(), 255);
+    }
+}
+
+TEST_CASE(path_rasterizer_coverage_adds_up_to_the_area)
+{
+    Gfx::Path path;
+    for (int i = 0; i < 360; ++i) {
+        Gfx::FloatPoint point { 32 + 20 * cosf(i * M_PI / 180), 32 + 20 * sinf(i * M_PI / 180) };
+        if (i == 0)
+            path.move_to(point);
+        else
+            path.line_to(point);
+    }
+
+    Gfx::PathRasterizer rasterizer({ 64, 64 });
+    rasterizer.draw_path(path);
+    float area = 0;
+    rasterizer.for_each_row(Gfx::Painter::WindingRule::Nonzero, [&](int, int, ReadonlyBytes coverage) {
+        for (auto value : coverage)
+            area += value / 255.0f;
+    });
+    EXPECT(fabsf(area - 20 * 20 * M_PI) < 2);
+}
+
+// These paint onto an opaque 1080p frame several times over, and are run with --bench.
+static constexpr int benchmark_iterations = 50;
+static const Gfx::IntSize benchmark_size { 1920, 1080 };
+
+static NonnullRefPtr<Gfx::Bitmap> create_benchmark_target()
+{
+    auto target = Gfx::Bitmap::create(Gfx::BitmapFormat::RGB32, benchmark_size);
+    VERIFY(target);
+    target->fill(Color::MidGray);
+    return target.release_nonnull();
+}
+
+BENCHMARK_CASE(fill_rect_translucent)
+{
+    auto target = create_benchmark_target();
+    Gfx::Painter painter(*target);
+    for (int i = 0; i < benchmark_iterations; ++i)
+        painter.fill_rect(target->rect(), Color(10, 20, 30, 128));
+}
+
+BENCHMARK_CASE(blit_opaque)
+{
+    auto target = create_benchmark_target();
+    auto source = create_random_bitmap(Gfx::BitmapFormat::RGB32, benchmark_size);
+    Gfx::Painter painter(*target);
+    for (int i = 0; i < benchmark_iterations; ++i)
+        painter.blit({}, *source, source->rect());
+}
+
+BENCHMARK_CASE(blit_with_alpha)
+{
+    auto target = create_benchmark_target();
+    auto source = create_random_bitmap(Gfx::BitmapFormat::RGBA32, benchmark_size);
+    Gfx::Painter painter(*target);
+    for (int i = 0; i < benchmark_iterations; ++i)
+        painter.blit({}, *source, source->rect());
+}
+
+BENCHMARK_CASE(blit_with_opacity)
+{
+    auto target = create_benchmark_target();
+    auto source = create_random_bitmap(Gfx::BitmapFormat::RGB32, benchmark_size);
+    Gfx::Painter painter(*target);
+    for (int i = 0; i < benchmark_iterations; ++i)
+        painter.blit({}, *source, source->rect(), 0.5f);
+}
+
+static void benchmark_scaling(const Gfx::IntSize& source_size, Gfx::Painter::ScalingMode scaling_mode)
+{
+    auto target = create_benchmark_target();
+    auto source = create_random_bitmap(Gfx::BitmapFormat::RGBA32, source_size);
+    Gfx::Painter painter(*target);
+    for (int i = 0; i < benchmark_iterations; ++i)
+        painter.draw_scaled_bitmap(target->rect(), *source, source->rect(), 1.0f, scaling_mode);
+}
+
+BENCHMARK_CASE(draw_scaled_bitmap_nearest_neighbor)
+{
+    benchmark_scaling({ 1280, 720 }, Gfx::Painter::ScalingMode::NearestNeighbor);
+}
+
+BENCHMARK_CASE(draw_scaled_bitmap_bilinear)
+{
+    benchmark_scaling({ 1280, 720 }, Gfx::Painter::ScalingMode::BilinearBlend);
+}
+
+BENCHMARK_CASE(draw_scaled_bitmap_box_filter)
+{
+    benchmark_scaling({ 3840, 2160 }, Gfx::Painter::ScalingMode::BilinearBlend);
+}
+
+// A star with many points, like the big paths of an SVG illustration.
+static Gfx::Path star_path(int points)
+{
+    Gfx::Path path;
+    for (int i = 0; i < points * 2; ++i) {
+        float radius = i % 2 ? 200 : 530;
+        float angle = i * M_PI / points;
+        Gfx::FloatPoint point { 960 + radius * cosf(angle), 540 + radius * sinf(angle) };
+        if (i == 0)
+            path.move_to(point);
+        else
+            path.line_to(point);
+    }
+    path.close();
+    return path;
+}
+
+BENCHMARK_CASE(fill_path_nonzero)
+{
+    auto target = create_benchmark_target();
+    auto path = star_path(500);
+    Gfx::Painter painter(*target);
+    for (int i = 0; i < benchmark_iterations; ++i)
+        painter.fill_path(path, Color(200, 100, 50), Gfx::Painter::WindingRule::Nonzero);
+}
+
+BENCHMARK_CASE(fill_path_even_odd)
+{
+    auto target = create_benchmark_target();
+    auto path = star_path(500);
+    Gfx::Painter painter(*target);
+    for (int i = 0; i < benchmark_iterations; ++i)
+        painter.fill_path(path, Color(200, 100, 50, 128), Gfx::Painter::WindingRule::EvenOdd);
+}
+
+TEST_MAIN(Painter)
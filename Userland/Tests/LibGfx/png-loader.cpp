@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <AK/MappedFile.h>
+#include <LibGfx/Bitmap.h>
+#include <LibGfx/PNGLoader.h>
+
+// The images in test-inputs/png are filled with the samples below, so the expected pixels can be
+// computed here. Unless an image's name says otherwise, its scanlines cycle through all filter types.
+#ifdef __serenity__
+#    define TEST_INPUT(x) ("/usr/Tests/LibGfx/test-inputs/png/" x)
+#else
+#    define TEST_INPUT(x) ("test-inputs/png/" x)
+#endif
+
+enum class ColorType {
+    Gray = 0,
+    RGB = 2,
+    Palette = 3,
+    GrayAlpha = 4,
+    RGBA = 6,
+};
+
+static u32 sample(int x, int y, int channel, u32 max_value)
+{
+    u32 value = ((u32)x * 73856093u) ^ ((u32)y * 19349663u) ^ ((u32)channel * 83492791u);
+    value ^= value >> 13;
+    value *= 0x5bd1e995u;
+    value ^= value >> 15;
+    return value % (max_value + 1);
+}
+
+// Only the high byte of 16-bit samples is used, and smaller samples are scaled to the full range.
+static u8 expected_channel(int x, int y, int channel, int bit_depth)
+{
+    u32 max_value = (1u << bit_depth) - 1;
+    auto value = sample(x, y, channel, max_value);
+    if (bit_depth == 16)
+        return value >> 8;
+    return value * 255 / max_value;
+}
+
+static Color expected_palette_color(size_t index, size_t transparency_entries)
+{
+    u8 alpha = index < transparency_entries ? sample(index, 1000, 3, 255) : 255;
+    return Color(sample(index, 1000, 0, 255), sample(index, 1000, 1, 255), sample(index, 1000, 2, 255), alpha);
+}
+
+static Color expected_pixel(ColorType color_type, int bit_depth, int x, int y, size_t transparency_entries = 0)
+{
+    auto channel = [&](int index) { return expected_channel(x, y, index, bit_depth); };
+    switch (color_type) {
+    case ColorType::Gray:
+        return Color(channel(0), channel(0), channel(0));
+    case ColorType::RGB:
+        return Color(channel(0), channel(1), channel(2));
+    case ColorType::Palette:
+        return expected_palette_color(sample(x, y, 0, (1u << bit_depth) - 1), transparency_entries);
+    case ColorType::GrayAlpha:
+        return Color(channel(0), channel(0), channel(0), channel(1));
+    case ColorType::RGBA:
+        return Color(channel(0), channel(1), channel(2), channel(3));
+    }
+    VERIFY_NOT_REACHED();
+}
+
+static void expect_image(const char* path, ColorType color_type, int bit_depth, const Gfx::IntSize& size = { 37, 29 }, size_t transparency_entries = 0)
+{
+    auto bitmap = Gfx::load_png(path);
+    EXPECT(bitmap);
+    if (!bitmap)
+        return;
+    EXPECT_EQ(bitmap->size(), size);
+
+    size_t mismatches = 0;
+    for (int y = 0; y < min(bitmap->height(), size.height()); ++y) {
+        for (int x = 0; x < min(bitmap->width(), size.width()); ++x) {
+            auto expected = expected_pixel(color_type, bit_depth, x, y, transparency_entries);
+            if (bitmap->get_pixel(x, y) != expected && mismatches++ < 4)
+                warnln("{}: pixel {},{} is {}, expected {}", path, x, y, bitmap->get_pixel(x, y), expected);
+        }
+    }
+    EXPECT_EQ(mismatches, 0u);
+}
+
+TEST_CASE(gray)
+{
+    expect_image(TEST_INPUT("gray-1.png"), ColorType::Gray, 1);
+    expect_image(TEST_INPUT("gray-2.png"), ColorType::Gray, 2);
+    expect_image(TEST_INPUT("gray-4.png"), ColorType::Gray, 4);
+    expect_image(TEST_INPUT("gray-8.png"), ColorType::Gray, 8);
+    expect_image(TEST_INPUT("gray-16.png"), ColorType::Gray, 16);
+}
+
+TEST_CASE(gray_alpha)
+{
+    expect_image(TEST_INPUT("gray-alpha-8.png"), ColorType::GrayAlpha, 8);
+    expect_image(TEST_INPUT("gray-alpha-16.png"), ColorType::GrayAlpha, 16);
+}
+
+TEST_CASE(rgb)
+{
+    expect_image(TEST_INPUT("rgb-8.png"), ColorType::RGB, 8);
+    expect_image(TEST_INPUT("rgb-16.png"), ColorType::RGB, 16);
+}
+
+TEST_CASE(rgba)
+{
+    expect_image(TEST_INPUT("rgba-8.png"), ColorType::RGBA, 8);
+    expect_image(TEST_INPUT("rgba-16.png"), ColorType::RGBA, 16);
+}
+
+TEST_CASE(palette)
+{
+    expect_image(TEST_INPUT("palette-1.png"), ColorType::Palette, 1);
+    expect_image(TEST_INPUT("palette-2.png"), ColorType::Palette, 2);
+    expect_image(TEST_INPUT("palette-4.png"), ColorType::Palette, 4);
+    expect_image(TEST_INPUT("palette-8.png"), ColorType::Palette, 8);
+    // Only the first 100 palette entries have a transparency.
+    expect_image(TEST_INPUT("palette-8-trns.png"), ColorType::Palette, 8, { 37, 29 }, 100);
+}
+
+TEST_CASE(adam7)
+{
+    expect_image(TEST_INPUT("gray-1-adam7.png"), ColorType::Gray, 1);
+    expect_image(TEST_INPUT("gray-alpha-8-adam7.png"), ColorType::GrayAlpha, 8);
+    expect_image(TEST_INPUT("palette-4-adam7.png"), ColorType::Palette, 4);
+    expect_image(TEST_INPUT("rgb-8-adam7.png"), ColorType::RGB, 8);
+    expect_image(TEST_INPUT("rgba-8-adam7.png"), ColorType::RGBA, 8);
+    expect_image(TEST_INPUT("rgba-16-adam7.png"), ColorType::RGBA, 16);
+    // Some of the passes of an image this small are empty.
+    expect_image(TEST_INPUT("rgba-8-adam7-tiny.png"), ColorType::RGBA, 8, { 3, 5 });
+}
+
+// Every scanline of these images uses the same filter type.
+TEST_CASE(filter_types)
+{
+    expect_image(TEST_INPUT("rgb-8-filter-0.png"), ColorType::RGB, 8);
+    expect_image(TEST_INPUT("rgb-8-filter-1.png"), ColorType::RGB, 8);
+    expect_image(TEST_INPUT("rgb-8-filter-2.png"), ColorType::RGB, 8);
+    expect_image(TEST_INPUT("rgb-8-filter-3.png"), ColorType::RGB, 8);
+    expect_image(TEST_INPUT("rgb-8-filter-4.png"), ColorType::RGB, 8);
+
+    expect_image(TEST_INPUT("rgba-8-filter-0.png"), ColorType::RGBA, 8);
+    expect_image(TEST_INPUT("rgba-8-filter-1.png"), ColorType::RGBA, 8);
+    expect_image(TEST_INPUT("rgba-8-filter-2.png"), ColorType::RGBA, 8);
+    expect_image(TEST_INPUT("rgba-8-filter-3.png"), ColorType::RGBA, 8);
+    expect_image(TEST_INPUT("rgba-8-filter-4.png"), ColorType::RGBA, 8);
+
+    expect_image(TEST_INPUT("gray-2-filter-0.png"), ColorType::Gray, 2);
+    expect_image(TEST_INPUT("gray-2-filter-1.png"), ColorType::Gray, 2);
+    expect_image(TEST_INPUT("gray-2-filter-2.png"), ColorType::Gray, 2);
+    expect_image(TEST_INPUT("gray-2-filter-3.png"), ColorType::Gray, 2);
+    expect_image(TEST_INPUT("gray-2-filter-4.png"), ColorType::Gray, 2);
+
+    expect_image(TEST_INPUT("gray-16-filter-0.png"), ColorType::Gray, 16);
+    expect_image(TEST_INPUT("gray-16-filter-1.png"), ColorType::Gray, 16);
+    expect_image(TEST_INPUT("gray-16-filter-2.png"), ColorType::Gray, 16);
+    expect_image(TEST_INPUT("gray-16-filter-3.png"), ColorType::Gray, 16);
+    expect_image(TEST_INPUT("gray-16-filter-4.png"), ColorType::Gray, 16);
+}
+
+TEST_CASE(truncated_image_data)
+{
+    auto file_or_error = MappedFile::map(TEST_INPUT("rgba-8.png"));
+    EXPECT(!file_or_error.is_error());
+    if (file_or_error.is_error())
+        return;
+    auto data = file_or_error.value()->bytes();
+
+    // Cut the file off in the middle of the image data.
+    EXPECT(Gfx::load_png_from_memory(data.data(), data.size()));
+    EXPECT(!Gfx::load_png_from_memory(data.data(), data.size() / 2));
+}
+
+TEST_MAIN(PNGLoader)
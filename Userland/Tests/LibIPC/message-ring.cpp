@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <LibIPC/MessageRing.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static constexpr size_t capacity = 4096;
+
+// Both ends of a ring, mapped separately like they would be in two processes.
+struct RingPair {
+    RingPair()
+        : writer(IPC::MessageRing::create(capacity))
+    {
+        VERIFY(writer.has_value());
+        reader = IPC::MessageRing::create_from_anon_fd(dup(writer->fd()), writer->size());
+        VERIFY(reader.has_value());
+    }
+
+    Optional<IPC::MessageRing> writer;
+    Optional<IPC::MessageRing> reader;
+};
+
+static ByteBuffer make_message(size_t size, u8 seed)
+{
+    auto message = ByteBuffer::create_uninitialized(size);
+    for (size_t i = 0; i < size; ++i)
+        message[i] = seed + i * 7;
+    return message;
+}
+
+TEST_CASE(messages_arrive_in_order)
+{
+    RingPair rings;
+    auto first = make_message(100, 1);
+    auto second = make_message(200, 2);
+    EXPECT(rings.writer->try_write(first));
+    EXPECT(rings.writer->try_write(second));
+
+    ByteBuffer received;
+    EXPECT(rings.reader->read_all(received));
+    EXPECT_EQ(received.size(), 300u);
+    EXPECT(!memcmp(received.data(), first.data(), first.size()));
+    EXPECT(!memcmp(received.data() + first.size(), second.data(), second.size()));
+
+    // Nothing is read twice.
+    ByteBuffer nothing;
+    EXPECT(rings.reader->read_all(nothing));
+    EXPECT(nothing.is_empty());
+}
+
+TEST_CASE(messages_wrap_around_the_end)
+{
+    RingPair rings;
+    for (u8 round = 0; round < 10; ++round) {
+        // 3000 bytes don't divide the capacity, so every other message is split at the end of the ring.
+        auto message = make_message(3000, round);
+        EXPECT(rings.writer->try_write(message));
+
+        ByteBuffer received;
+        EXPECT(rings.reader->read_all(received));
+        EXPECT_EQ(received.size(), message.size());
+        EXPECT(!memcmp(received.data(), message.data(), message.size()));
+    }
+}
+
+TEST_CASE(full_ring_rejects_messages)
+{
+    RingPair rings;
+    auto message = make_message(capacity / 2, 3);
+    EXPECT(rings.writer->try_write(message));
+    EXPECT(rings.writer->try_write(message));
+
+    auto byte = make_message(1, 4);
+    EXPECT(!rings.writer->try_write(byte));
+    EXPECT(!rings.writer->try_write(make_message(capacity + 1, 5)));
+
+    // Messages are written whole or not at all, so the rejected ones don't show up.
+    ByteBuffer received;
+    EXPECT(rings.reader->read_all(received));
+    EXPECT_EQ(received.size(), capacity);
+
+    EXPECT(rings.writer->try_write(byte));
+    received.clear();
+    EXPECT(rings.reader->read_all(received));
+    EXPECT_EQ(received.size(), 1u);
+    EXPECT_EQ(received[0], byte[0]);
+}
+
+TEST_CASE(corrupted_write_offset_is_detected)
+{
+    RingPair rings;
+    EXPECT(rings.writer->try_write(make_message(16, 6)));
+
+    // The write offset is the first field of the header. Move it further ahead than the ring can hold.
+    auto* mapping = (u8*)mmap(nullptr, rings.writer->size(), PROT_READ | PROT_WRITE, MAP_SHARED, rings.writer->fd(), 0);
+    VERIFY(mapping != MAP_FAILED);
+    u32 bogus_write_offset = capacity + 17;
+    memcpy(mapping, &bogus_write_offset, sizeof(bogus_write_offset));
+    munmap(mapping, rings.writer->size());
+
+    ByteBuffer received;
+    EXPECT(!rings.reader->read_all(received));
+    EXPECT(received.is_empty());
+    EXPECT(!rings.writer->try_write(make_message(1, 7)));
+}
+
+TEST_CASE(reader_waiting_handshake)
+{
+    RingPair rings;
+
+    // A new reader hasn't looked at the ring yet, so the first write has to wake it up.
+    EXPECT(rings.writer->take_reader_waiting());
+    EXPECT(!rings.writer->take_reader_waiting());
+
+    rings.reader->set_reader_waiting();
+    EXPECT(rings.writer->try_write(make_message(8, 8)));
+    EXPECT(rings.writer->take_reader_waiting());
+
+    // The reader is busy until it announces that it will wait again.
+    EXPECT(rings.writer->try_write(make_message(8, 9)));
+    EXPECT(!rings.writer->take_reader_waiting());
+}
+
+TEST_MAIN(MessageRing)
@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <LibCore/EventLoop.h>
+#include <LibCore/LocalSocket.h>
+#include <LibIPC/ClientConnection.h>
+#include <LibIPC/Connection.h>
+#include <Tests/LibIPC/TestClientEndpoint.h>
+#include <Tests/LibIPC/TestServerEndpoint.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Runs in a child process, like a service would.
+class TestClientConnection final
+    : public IPC::ClientConnection<TestClientEndpoint, TestServerEndpoint>
+    , public TestServerEndpoint {
+    C_OBJECT(TestClientConnection);
+
+public:
+    virtual void die() override { Core::EventLoop::current().quit(0); }
+
+private:
+    explicit TestClientConnection(NonnullRefPtr<Core::LocalSocket> socket)
+        : IPC::ClientConnection<TestClientEndpoint, TestServerEndpoint>(*this, move(socket), 1)
+    {
+        set_batching(true);
+    }
+
+    virtual OwnPtr<Messages::TestServer::EchoResponse> handle(const Messages::TestServer::Echo& message) override
+    {
+        return make<Messages::TestServer::EchoResponse>(message.value());
+    }
+
+    virtual void handle(const Messages::TestServer::Append& message) override
+    {
+        m_values.append(message.value());
+    }
+
+    virtual void handle(const Messages::TestServer::AppendWithFile& message) override
+    {
+        // The file holds the value as well, so that a file descriptor handed to the wrong message is noticed.
+        i32 value_in_file = -1;
+        if (pread(message.file().fd(), &value_in_file, sizeof(value_in_file), 0) != sizeof(value_in_file) || value_in_file != message.value())
+            value_in_file = -1;
+        m_values.append(value_in_file);
+    }
+
+    virtual OwnPtr<Messages::TestServer::TakeValuesResponse> handle(const Messages::TestServer::TakeValues&) override
+    {
+        post_message(Messages::TestClient::ValueAppended(m_values.size()));
+        return make<Messages::TestServer::TakeValuesResponse>(move(m_values));
+    }
+
+    Vector<i32> m_values;
+};
+
+class TestServerConnection final
+    : public IPC::Connection<TestClientEndpoint, TestServerEndpoint>
+    , public TestClientEndpoint {
+    C_OBJECT(TestServerConnection);
+
+public:
+    Vector<i32> notifications;
+
+private:
+    explicit TestServerConnection(NonnullRefPtr<Core::LocalSocket> socket)
+        : IPC::Connection<TestClientEndpoint, TestServerEndpoint>(*this, move(socket))
+    {
+        this->socket().set_blocking(true);
+    }
+
+    virtual void handle(const Messages::TestClient::ValueAppended& message) override
+    {
+        notifications.append(message.value());
+    }
+};
+
+// Core::EventLoop expects to be the only main loop there ever is, so all tests (and the forked servers) share one.
+static Core::EventLoop& event_loop()
+{
+    static auto* event_loop = new Core::EventLoop;
+    return *event_loop;
+}
+
+static pid_t start_server(int& client_fd)
+{
+    int fds[2];
+    VERIFY(socketpair(AF_LOCAL, SOCK_STREAM, 0, fds) == 0);
+    pid_t pid = fork();
+    VERIFY(pid >= 0);
+    if (pid == 0) {
+        close(fds[0]);
+        auto connection = TestClientConnection::construct(Core::LocalSocket::construct(fds[1]));
+        _exit(event_loop().exec());
+    }
+    close(fds[1]);
+    client_fd = fds[0];
+    return pid;
+}
+
+static bool server_exited_cleanly(pid_t pid)
+{
+    int status = 0;
+    return waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+[[maybe_unused]] static int create_file_containing(i32 value)
+{
+    char path[] = "/tmp/shared-memory-transport.XXXXXX";
+    int fd = mkstemp(path);
+    VERIFY(fd >= 0);
+    unlink(path);
+    VERIFY(write(fd, &value, sizeof(value)) == sizeof(value));
+    return fd;
+}
+
+TEST_CASE(negotiation)
+{
+    event_loop();
+    int fd = -1;
+    auto pid = start_server(fd);
+    auto connection = TestServerConnection::construct(Core::LocalSocket::construct(fd));
+
+#ifdef __serenity__
+    EXPECT(connection->enable_shared_memory_transport(4096));
+#else
+    // File descriptors can't be passed elsewhere, so the connection has to stay on the socket.
+    EXPECT(!connection->enable_shared_memory_transport(4096));
+#endif
+
+    // The first request goes into the ring before the server has mapped it, and its answer
+    // is the first message the server sends back through its own ring.
+    for (i32 i = 0; i < 100; ++i) {
+        auto response = connection->send_sync<Messages::TestServer::Echo>(i);
+        EXPECT_EQ(response->value(), i);
+    }
+
+    connection->shutdown();
+    EXPECT(server_exited_cleanly(pid));
+}
+
+TEST_CASE(messages_stay_in_order_across_ring_and_socket)
+{
+    event_loop();
+    int fd = -1;
+    auto pid = start_server(fd);
+    auto connection = TestServerConnection::construct(Core::LocalSocket::construct(fd));
+    connection->enable_shared_memory_transport(4096);
+
+    static constexpr i32 value_count = 1000;
+    Vector<i32> expected_values;
+    for (i32 value = 0; value < value_count; ++value) {
+        expected_values.append(value);
+#ifdef __serenity__
+        if (value == value_count / 2) {
+            // Passing a file descriptor sends this message over the socket.
+            connection->post_message(Messages::TestServer::AppendWithFile(value, IPC::File(create_file_containing(value), IPC::File::CloseAfterSending)));
+            continue;
+        }
+#endif
+        // Every tenth message is too large for the ring, so it has to take the socket.
+        auto padding = ByteBuffer::create_zeroed(value % 10 == 0 ? 8192 : 16);
+        connection->post_message(Messages::TestServer::Append(value, move(padding)));
+    }
+
+    auto response = connection->send_sync<Messages::TestServer::TakeValues>();
+    EXPECT_EQ(response->values().size(), expected_values.size());
+    EXPECT(response->values() == expected_values);
+
+    // The notification was posted right before the response, and is handled from the event loop.
+    event_loop().pump(Core::EventLoop::WaitMode::PollForEvents);
+    EXPECT_EQ(connection->notifications.size(), 1u);
+    if (!connection->notifications.is_empty())
+        EXPECT_EQ(connection->notifications[0], value_count);
+
+    connection->shutdown();
+    EXPECT(server_exited_cleanly(pid));
+}
+
+TEST_CASE(ring_is_used_again_after_messages_with_file_descriptors)
+{
+    event_loop();
+    int fd = -1;
+    auto pid = start_server(fd);
+    auto connection = TestServerConnection::construct(Core::LocalSocket::construct(fd));
+    connection->enable_shared_memory_transport();
+
+    Vector<i32> expected_values;
+    i32 next_value = 0;
+    auto append_small_messages = [&] {
+        auto messages_sent_through_ring = connection->messages_sent_through_ring();
+        for (int i = 0; i < 10; ++i) {
+            expected_values.append(next_value);
+            connection->post_message(Messages::TestServer::Append(next_value++, ByteBuffer::create_zeroed(16)));
+        }
+#ifdef __serenity__
+        EXPECT_EQ(connection->messages_sent_through_ring(), messages_sent_through_ring + 10);
+#else
+        EXPECT_EQ(connection->messages_sent_through_ring(), messages_sent_through_ring);
+#endif
+    };
+
+    append_small_messages();
+
+#ifdef __serenity__
+    expected_values.append(next_value);
+    connection->post_message(Messages::TestServer::AppendWithFile(next_value, IPC::File(create_file_containing(next_value), IPC::File::CloseAfterSending)));
+    ++next_value;
+    append_small_messages();
+#endif
+
+    // A payload this large is passed as an anonymous file, which takes the socket as well.
+    expected_values.append(next_value);
+    connection->post_message(Messages::TestServer::Append(next_value++, ByteBuffer::create_zeroed(IPC::anonymous_payload_threshold)));
+    append_small_messages();
+
+    auto response = connection->send_sync<Messages::TestServer::TakeValues>();
+    EXPECT(response->values() == expected_values);
+
+    connection->shutdown();
+    EXPECT(server_exited_cleanly(pid));
+}
+
+TEST_MAIN(SharedMemoryTransport)
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <AK/Atomic.h>
+#include <AK/HashTable.h>
+#include <LibCore/EventLoop.h>
+#include <LibCore/Timer.h>
+#include <LibThread/ThreadPool.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// Core::EventLoop expects a single main loop for the lifetime of the process, so all tests share this one.
+static Core::EventLoop& event_loop()
+{
+    static Core::EventLoop* event_loop = new Core::EventLoop;
+    return *event_loop;
+}
+
+static void run_event_loop_until(Function<bool()> condition)
+{
+    auto timeout = Core::Timer::create_single_shot(5000, [] { event_loop().quit(0); });
+    timeout->start();
+    event_loop().unquit();
+    while (!condition() && !event_loop().was_exit_requested())
+        event_loop().pump();
+    EXPECT(condition());
+}
+
+TEST_CASE(runs_all_submitted_tasks)
+{
+    Atomic<size_t> count { 0 };
+    {
+        LibThread::ThreadPool pool(4);
+        EXPECT_EQ(pool.thread_count(), 4u);
+        for (size_t i = 0; i < 1000; ++i)
+            pool.submit([&] { ++count; });
+    }
+    EXPECT_EQ(count.load(), 1000u);
+}
+
+TEST_CASE(shutdown_finishes_queued_and_nested_tasks)
+{
+    Atomic<size_t> count { 0 };
+    {
+        LibThread::ThreadPool pool(2);
+        for (size_t i = 0; i < 10; ++i) {
+            pool.submit([&] {
+                usleep(1000);
+                // Submitted while the pool may already be shutting down.
+                for (size_t j = 0; j < 10; ++j)
+                    pool.submit([&] { ++count; });
+                ++count;
+            });
+        }
+    }
+    EXPECT_EQ(count.load(), 110u);
+}
+
+TEST_CASE(idle_threads_steal_work)
+{
+    // All subtasks are submitted from one pool thread, so they start out on that thread's deque.
+    constexpr size_t subtask_count = 64;
+    pthread_mutex_t mutex;
+    pthread_mutex_init(&mutex, nullptr);
+    HashTable<pthread_t> threads;
+    {
+        LibThread::ThreadPool pool(4);
+        pool.submit([&] {
+            for (size_t i = 0; i < subtask_count; ++i) {
+                pool.submit([&] {
+                    usleep(1000);
+                    pthread_mutex_lock(&mutex);
+                    threads.set(pthread_self());
+                    pthread_mutex_unlock(&mutex);
+                });
+            }
+        });
+    }
+    pthread_mutex_destroy(&mutex);
+    EXPECT(threads.size() > 1);
+}
+
+TEST_CASE(await_returns_result)
+{
+    event_loop();
+    LibThread::ThreadPool pool(2);
+    auto future = pool.run([] { return 42; });
+    EXPECT_EQ(future->await(), 42);
+    EXPECT(future->is_resolved());
+}
+
+TEST_CASE(futures_complete_on_the_event_loop_in_order_of_completion)
+{
+    event_loop();
+    auto main_thread = pthread_self();
+    LibThread::ThreadPool pool(4);
+
+    // The tasks that are submitted first take longest, so they finish last.
+    constexpr int task_count = 4;
+    Vector<int> completed;
+    Vector<NonnullRefPtr<LibThread::Future<int>>> futures;
+    for (int i = 0; i < task_count; ++i) {
+        futures.append(pool.run([i] {
+            usleep((task_count - i) * 30000);
+            return i;
+        }));
+        futures.last()->on_complete([&](int result) {
+            EXPECT_EQ(pthread_self(), main_thread);
+            completed.append(result);
+        });
+    }
+
+    run_event_loop_until([&] { return completed.size() == task_count; });
+    EXPECT_EQ(completed.size(), (size_t)task_count);
+    for (int i = 0; i < (int)completed.size(); ++i)
+        EXPECT_EQ(completed[i], task_count - 1 - i);
+}
+
+TEST_CASE(on_complete_after_resolution)
+{
+    event_loop();
+    LibThread::ThreadPool pool(1);
+    auto future = pool.run([] { return String("done"); });
+    while (!future->is_resolved())
+        usleep(1000);
+
+    String result;
+    future->on_complete([&](String value) { result = move(value); });
+    EXPECT(result.is_null());
+    run_event_loop_until([&] { return !result.is_null(); });
+    EXPECT_EQ(result, "done");
+}
+
+TEST_CASE(shared_pool_is_created_once)
+{
+    LibThread::ThreadPool pool(4);
+    Atomic<LibThread::ThreadPool*> shared_pools[8] {};
+    for (size_t i = 0; i < 8; ++i)
+        pool.submit([&, i] { shared_pools[i] = &LibThread::ThreadPool::the(); });
+    while (true) {
+        bool all_done = true;
+        for (auto& shared_pool : shared_pools)
+            all_done &= shared_pool.load() != nullptr;
+        if (all_done)
+            break;
+        usleep(1000);
+    }
+    for (auto& shared_pool : shared_pools)
+        EXPECT_EQ(shared_pool.load(), &LibThread::ThreadPool::the());
+}
+
+TEST_MAIN(ThreadPool)
@@ -24,15 +24,68 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/ByteBuffer.h>
+#include <AK/StringBuilder.h>
+#include <AK/Vector.h>
 #include <LibCore/ArgsParser.h>
-#include <LibCore/File.h>
 #include <LibCrypto/Hash/HashManager.h>
+#include <LibThread/ThreadPool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 
+struct ChecksumResult {
+    String hex_digest;
+    String error;
+    bool is_done { false };
+};
+
+static ChecksumResult checksum_file(Crypto::Hash::HashKind hash_kind, const char* path)
+{
+    int fd = STDIN_FILENO;
+    if (StringView { path } != "-") {
+        fd = open(path, O_RDONLY);
+        if (fd < 0)
+            return { {}, strerror(errno) };
+    }
+
+    Crypto::Hash::Manager hash;
+    hash.initialize(hash_kind);
+
+    // The file is hashed as it is read, so it never has to fit into memory as a whole.
+    auto buffer = ByteBuffer::create_uninitialized(64 * KiB);
+    String error;
+    for (;;) {
+        auto nread = read(fd, buffer.data(), buffer.size());
+        if (nread < 0) {
+            if (errno == EINTR)
+                continue;
+            error = strerror(errno);
+            break;
+        }
+        if (nread == 0)
+            break;
+        hash.update(buffer.data(), nread);
+    }
+    if (fd != STDIN_FILENO)
+        close(fd);
+    if (!error.is_null())
+        return { {}, error };
+
+    auto digest = hash.digest();
+    auto digest_data = digest.immutable_data();
+    StringBuilder builder;
+    for (size_t i = 0; i < hash.digest_size(); ++i)
+        builder.appendf("%02x", digest_data[i]);
+    return { builder.build(), {} };
+}
+
 int main(int argc, char** argv)
 {
-    if (pledge("stdio rpath", nullptr) < 0) {
+    if (pledge("stdio rpath thread", nullptr) < 0) {
         perror("pledge");
         return 1;
     }
@@ -66,33 +119,50 @@ int main(int argc, char** argv)
     if (paths.is_empty())
         paths.append("-");
 
-    Crypto::Hash::Manager hash;
-    hash.initialize(hash_kind);
+    // The files are hashed on the thread pool, several at a time, but the results are still
+    // printed in the order the files were given in, as soon as each one is known.
+    // Standard input is hashed on the main thread when its turn comes, so that every "-"
+    // gets its own share of the input, in order.
+    auto is_standard_input = [](const char* path) { return StringView { path } == "-"; };
+    Vector<ChecksumResult> results;
+    results.resize(paths.size());
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t condition = PTHREAD_COND_INITIALIZER;
 
-    bool success;
-    auto has_error = false;
-    auto file = Core::File::construct();
+    auto& thread_pool = LibThread::ThreadPool::the();
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (is_standard_input(paths[i]))
+            continue;
+        thread_pool.submit([&, i] {
+            auto result = checksum_file(hash_kind, paths[i]);
+            pthread_mutex_lock(&mutex);
+            results[i] = move(result);
+            results[i].is_done = true;
+            pthread_cond_broadcast(&condition);
+            pthread_mutex_unlock(&mutex);
+        });
+    }
 
-    for (auto path : paths) {
-        if (StringView { path } == "-") {
-            success = file->open(STDIN_FILENO, Core::IODevice::OpenMode::ReadOnly, Core::File::ShouldCloseFileDescriptor::No);
+    auto has_error = false;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        ChecksumResult result;
+        if (is_standard_input(paths[i])) {
+            result = checksum_file(hash_kind, paths[i]);
         } else {
-            file->set_filename(path);
-            success = file->open(Core::IODevice::OpenMode::ReadOnly);
+            pthread_mutex_lock(&mutex);
+            while (!results[i].is_done)
+                pthread_cond_wait(&condition, &mutex);
+            result = move(results[i]);
+            pthread_mutex_unlock(&mutex);
         }
-        if (!success) {
-            fprintf(stderr, "%s: %s: %s\n", argv[0], path, file->error_string());
+
+        if (!result.error.is_null()) {
+            fflush(stdout);
+            fprintf(stderr, "%s: %s: %s\n", argv[0], paths[i], result.error.characters());
             has_error = true;
             continue;
         }
-        hash.update(file->read_all());
-        auto digest = hash.digest();
-        auto digest_data = digest.immutable_data();
-        StringBuilder builder;
-        for (size_t i = 0; i < hash.digest_size(); ++i)
-            builder.appendf("%02x", digest_data[i]);
-        auto hash_sum_hex = builder.build();
-        printf("%s  %s\n", hash_sum_hex.characters(), path);
+        printf("%s  %s\n", result.hex_digest.characters(), paths[i]);
     }
     return has_error ? 1 : 0;
 }
@@ -30,6 +30,7 @@
 #include <AK/NonnullOwnPtr.h>
 #include <AK/StringBuilder.h>
 #include <LibCore/ArgsParser.h>
+#include <LibCore/ElapsedTimer.h>
 #include <LibCore/File.h>
 #include <LibCore/StandardPaths.h>
 #include <LibJS/AST.h>
@@ -83,6 +84,12 @@ static RefPtr<Line::Editor> s_editor;
 static String s_history_path = String::formatted("{}/.js-history", Core::StandardPaths::home_directory());
 static int s_repl_line_level = 0;
 static bool s_fail_repl = false;
+static bool s_print_gc_statistics = false;
+static bool s_lazy_function_compilation = false;
+static bool s_print_parse_statistics = false;
+static u64 s_parse_time_us = 0;
+static size_t s_ast_node_bytes = 0;
+static Vector<NonnullRefPtr<const JS::PreparsedSource>> s_preparsed_sources;
 
 static String prompt_for_level(int level)
 {
@@ -451,8 +458,16 @@ static bool write_to_file(const String& path)
 
 static bool parse_and_run(JS::Interpreter& interpreter, const StringView& source)
 {
+    Core::ElapsedTimer parse_timer(true);
+    parse_timer.start();
     auto parser = JS::Parser(JS::Lexer(source));
+    if (s_lazy_function_compilation)
+        parser.enable_lazy_function_compilation();
     auto program = parser.parse_program();
+    s_parse_time_us += parse_timer.elapsed_microseconds();
+    s_ast_node_bytes += parser.ast_node_bytes();
+    if (auto* preparsed_source = parser.preparsed_source())
+        s_preparsed_sources.append(*preparsed_source);
 
     if (s_dump_ast)
         program->dump(0);
@@ -664,9 +679,53 @@ public:
     }
 };
 
+static void print_gc_statistics(const JS::Heap& heap)
+{
+    auto& statistics = heap.statistics();
+    auto average = [](u64 total, size_t count) { return count ? total / count : 0; };
+    outln("Garbage collection statistics ({}, {})", heap.is_generational() ? "generational" : "non-generational", heap.is_incremental() ? "incremental" : "non-incremental");
+    outln("  Minor collections: {} (total {} us, average {} us, max {} us)", statistics.minor_collections, statistics.minor_collection_time_us, average(statistics.minor_collection_time_us, statistics.minor_collections), statistics.max_minor_collection_time_us);
+    outln("  Major collections: {} (total {} us, average {} us, max {} us)", statistics.major_collections, statistics.major_collection_time_us, average(statistics.major_collection_time_us, statistics.major_collections), statistics.max_major_collection_time_us);
+    outln("      Marking steps: {} (total {} us, average {} us, max {} us)", statistics.incremental_marking_steps, statistics.incremental_marking_time_us, average(statistics.incremental_marking_time_us, statistics.incremental_marking_steps), statistics.max_incremental_marking_step_time_us);
+    outln("        Lazy sweeps: {} (total {} us, average {} us)", statistics.lazy_sweeps, statistics.lazy_sweep_time_us, average(statistics.lazy_sweep_time_us, statistics.lazy_sweeps));
+    outln("     Promoted cells: {}", statistics.promoted_cells);
+    outln("    Collected cells: {}", statistics.collected_cells);
+    outln("  Pause times:");
+    for (size_t bucket = 0; bucket < JS::Heap::pause_histogram_bucket_count; ++bucket) {
+        if (!statistics.pause_histogram[bucket])
+            continue;
+        if (bucket == JS::Heap::pause_histogram_bucket_count - 1)
+            outln("    >= {} us: {}", JS::Heap::pause_histogram_bucket_limit_us(bucket - 1), statistics.pause_histogram[bucket]);
+        else
+            outln("    < {} us: {}", JS::Heap::pause_histogram_bucket_limit_us(bucket), statistics.pause_histogram[bucket]);
+    }
+}
+
+static void print_parse_statistics()
+{
+    size_t preparsed_functions = 0;
+    size_t compiled_functions = 0;
+    u64 compile_time_us = 0;
+    size_t compile_ast_node_bytes = 0;
+    for (auto& source : s_preparsed_sources) {
+        preparsed_functions += source->preparsed_function_count();
+        compiled_functions += source->compiled_function_count();
+        compile_time_us += source->compile_time_us();
+        compile_ast_node_bytes += source->compile_ast_node_bytes();
+    }
+    outln("Parse statistics ({})", s_lazy_function_compilation ? "lazy function compilation" : "eager function compilation");
+    outln("           Parse time: {} us", s_parse_time_us);
+    outln("            AST nodes: {} bytes", s_ast_node_bytes);
+    outln("  Preparsed functions: {}", preparsed_functions);
+    outln("   Compiled functions: {} (total {} us, {} bytes of AST nodes)", compiled_functions, compile_time_us, compile_ast_node_bytes);
+}
+
 int main(int argc, char** argv)
 {
     bool gc_on_every_allocation = false;
+    bool generational_gc = false;
+    bool incremental_gc = false;
+    int gc_max_pause_us = -1;
     bool disable_syntax_highlight = false;
     const char* script_path = nullptr;
 
@@ -675,6 +734,12 @@ int main(int argc, char** argv)
     args_parser.add_option(s_dump_ast, "Dump the AST", "dump-ast", 'A');
     args_parser.add_option(s_print_last_result, "Print last result", "print-last-result", 'l');
     args_parser.add_option(gc_on_every_allocation, "GC on every allocation", "gc-on-every-allocation", 'g');
+    args_parser.add_option(generational_gc, "Use generational garbage collection", "generational-gc", 'G');
+    args_parser.add_option(incremental_gc, "Use incremental garbage collection", "incremental-gc", 'I');
+    args_parser.add_option(gc_max_pause_us, "Maximum duration of an incremental marking step", "gc-max-pause", 0, "microseconds");
+    args_parser.add_option(s_print_gc_statistics, "Print garbage collection statistics on exit", "gc-statistics", 0);
+    args_parser.add_option(s_lazy_function_compilation, "Parse function bodies when they are first called", "lazy-functions", 'L');
+    args_parser.add_option(s_print_parse_statistics, "Print parse time and AST size on exit", "parse-statistics", 0);
     args_parser.add_option(disable_syntax_highlight, "Disable live syntax highlighting", "no-syntax-highlight", 's');
     args_parser.add_positional_argument(script_path, "Path to script file", "script", Core::ArgsParser::Required::No);
     args_parser.parse(argc, argv);
@@ -695,6 +760,10 @@ int main(int argc, char** argv)
         ReplConsoleClient console_client(interpreter->global_object().console());
         interpreter->global_object().console().set_client(console_client);
         interpreter->heap().set_should_collect_on_every_allocation(gc_on_every_allocation);
+        interpreter->heap().set_generational(generational_gc);
+        interpreter->heap().set_incremental(incremental_gc);
+        if (gc_max_pause_us > 0)
+            interpreter->heap().set_max_pause_time_us(gc_max_pause_us);
         interpreter->vm().set_underscore_is_last_value(true);
 
         s_editor = Line::Editor::construct();
@@ -892,11 +961,19 @@ int main(int argc, char** argv)
         s_editor->on_tab_complete = move(complete);
         repl(*interpreter);
         s_editor->save_history(s_history_path);
+        if (s_print_gc_statistics)
+            print_gc_statistics(interpreter->heap());
+        if (s_print_parse_statistics)
+            print_parse_statistics();
     } else {
         interpreter = JS::Interpreter::create<JS::GlobalObject>(*vm);
         ReplConsoleClient console_client(interpreter->global_object().console());
         interpreter->global_object().console().set_client(console_client);
         interpreter->heap().set_should_collect_on_every_allocation(gc_on_every_allocation);
+        interpreter->heap().set_generational(generational_gc);
+        interpreter->heap().set_incremental(incremental_gc);
+        if (gc_max_pause_us > 0)
+            interpreter->heap().set_max_pause_time_us(gc_max_pause_us);
 
         signal(SIGINT, [](int) {
             sigint_handler();
@@ -916,7 +993,12 @@ int main(int argc, char** argv)
             source = file_contents;
         }
 
-        if (!parse_and_run(*interpreter, source))
+        bool succeeded = parse_and_run(*interpreter, source);
+        if (s_print_gc_statistics)
+            print_gc_statistics(interpreter->heap());
+        if (s_print_parse_statistics)
+            print_parse_statistics();
+        if (!succeeded)
             return 1;
     }
 
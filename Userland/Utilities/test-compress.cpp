@@ -221,4 +221,162 @@ TEST_CASE(gzip_decompress_repeat_around_buffer)
     EXPECT(uncompressed == decompressed.value().bytes());
 }
 
+static ByteBuffer generate_test_data(size_t size, size_t alphabet_size, u32 seed)
+{
+    // Words from a small vocabulary with some noise in between, so there are matches of all lengths and distances.
+    static const char* words[] { "the ", "quick ", "brown ", "fox ", "jumps ", "over ", "lazy ", "dog ", "\n", "deflate " };
+    auto buffer = ByteBuffer::create_uninitialized(size);
+    for (size_t i = 0; i < size;) {
+        seed = seed * 1103515245 + 12345;
+        if ((seed >> 16) % 4 == 0) {
+            buffer[i++] = static_cast<u8>((seed >> 8) % alphabet_size);
+            continue;
+        }
+        for (auto* word = words[(seed >> 16) % 10]; *word && i < size; ++word)
+            buffer[i++] = *word;
+    }
+    return buffer;
+}
+
+static const Compress::DeflateCompressor::CompressionLevel all_compression_levels[] {
+    Compress::DeflateCompressor::CompressionLevel::Store,
+    Compress::DeflateCompressor::CompressionLevel::Fastest,
+    Compress::DeflateCompressor::CompressionLevel::Fast,
+    Compress::DeflateCompressor::CompressionLevel::Good,
+    Compress::DeflateCompressor::CompressionLevel::Best,
+};
+
+TEST_CASE(deflate_round_trip_empty)
+{
+    for (auto level : all_compression_levels) {
+        const auto compressed = Compress::DeflateCompressor::compress_all({}, level);
+        EXPECT(compressed.has_value());
+        const auto decompressed = Compress::DeflateDecompressor::decompress_all(compressed.value());
+        EXPECT(decompressed.has_value());
+        EXPECT(decompressed.value().is_empty());
+    }
+}
+
+TEST_CASE(deflate_round_trip_text)
+{
+    for (size_t size : { 1, 3, 100, 4096, 70000, 300000 }) {
+        auto data = generate_test_data(size, 256, size);
+        for (auto level : all_compression_levels) {
+            const auto compressed = Compress::DeflateCompressor::compress_all(data, level);
+            EXPECT(compressed.has_value());
+            if (size >= 4096 && level != Compress::DeflateCompressor::CompressionLevel::Store)
+                EXPECT(compressed.value().size() < data.size() / 2);
+            const auto decompressed = Compress::DeflateDecompressor::decompress_all(compressed.value());
+            EXPECT(decompressed.has_value());
+            EXPECT(decompressed.value() == data);
+        }
+    }
+}
+
+TEST_CASE(deflate_round_trip_incompressible)
+{
+    auto data = ByteBuffer::create_uninitialized(200000);
+    u32 seed = 1;
+    for (auto& byte : data.bytes()) {
+        seed = seed * 1103515245 + 12345;
+        byte = seed >> 16;
+    }
+
+    for (auto level : all_compression_levels) {
+        const auto compressed = Compress::DeflateCompressor::compress_all(data, level);
+        EXPECT(compressed.has_value());
+        // This should fall back to stored blocks, which only add a few bytes each.
+        EXPECT(compressed.value().size() <= data.size() + data.size() / 1000);
+        const auto decompressed = Compress::DeflateDecompressor::decompress_all(compressed.value());
+        EXPECT(decompressed.value() == data);
+    }
+}
+
+TEST_CASE(deflate_round_trip_long_runs)
+{
+    // Runs longer than the maximum match length, and repeats right at the window size.
+    auto data = ByteBuffer::create_zeroed(200000);
+    for (size_t i = 0; i < data.size(); i += 32767)
+        data[i] = 1;
+    data.bytes().slice(100000, 1000).fill('x');
+
+    for (auto level : all_compression_levels) {
+        const auto compressed = Compress::DeflateCompressor::compress_all(data, level);
+        const auto decompressed = Compress::DeflateDecompressor::decompress_all(compressed.value());
+        EXPECT(decompressed.value() == data);
+        if (level != Compress::DeflateCompressor::CompressionLevel::Store)
+            EXPECT(compressed.value().size() < 1000);
+    }
+}
+
+TEST_CASE(deflate_round_trip_streamed)
+{
+    // Writing in odd-sized pieces has to give the same result as writing everything at once.
+    auto data = generate_test_data(250000, 64, 42);
+    DuplexMemoryStream output_stream;
+    Compress::DeflateCompressor deflate_stream { output_stream };
+    for (size_t offset = 0; offset < data.size();) {
+        auto count = min<size_t>(data.size() - offset, 1 + offset % 7919);
+        EXPECT(deflate_stream.write_or_error(data.bytes().slice(offset, count)));
+        offset += count;
+    }
+    deflate_stream.final_flush();
+
+    auto compressed = output_stream.copy_into_contiguous_buffer();
+    EXPECT(compressed == Compress::DeflateCompressor::compress_all(data).value());
+    EXPECT(Compress::DeflateDecompressor::decompress_all(compressed).value() == data);
+}
+
+TEST_CASE(gzip_round_trip)
+{
+    auto data = generate_test_data(100000, 256, 7);
+    const auto compressed = Compress::GzipCompressor::compress_all(data);
+    EXPECT(compressed.has_value());
+    EXPECT(Compress::GzipDecompressor::is_likely_compressed(compressed.value()));
+    const auto decompressed = Compress::GzipDecompressor::decompress_all(compressed.value());
+    EXPECT(decompressed.value() == data);
+}
+
+TEST_CASE(zlib_round_trip)
+{
+    auto data = generate_test_data(100000, 256, 9);
+    for (auto level : all_compression_levels) {
+        const auto compressed = Compress::Zlib::compress_all(data, level);
+        EXPECT(compressed.has_value());
+        const auto decompressed = Compress::Zlib::decompress_all(compressed.value());
+        EXPECT(decompressed.value() == data);
+    }
+}
+
+TEST_CASE(deflate_decompress_truncated)
+{
+    auto data = generate_test_data(100000, 256, 7);
+    const auto compressed = Compress::GzipCompressor::compress_all(data);
+    EXPECT(compressed.has_value());
+
+    for (size_t size = 0; size < compressed.value().size(); size += 997) {
+        const auto decompressed = Compress::GzipDecompressor::decompress_all(compressed.value().bytes().trim(size));
+        EXPECT(!decompressed.has_value() || decompressed.value().is_empty());
+    }
+}
+
+BENCHMARK_CASE(deflate_compress_text)
+{
+    auto data = generate_test_data(8 * MiB, 256, 1);
+    auto compressed = Compress::DeflateCompressor::compress_all(data);
+    EXPECT(compressed.has_value());
+}
+
+BENCHMARK_CASE(gzip_decompress_text)
+{
+    auto data = generate_test_data(8 * MiB, 256, 1);
+    const auto compressed = Compress::GzipCompressor::compress_all(data);
+    EXPECT(compressed.has_value());
+
+    for (size_t i = 0; i < 8; ++i) {
+        const auto decompressed = Compress::GzipDecompressor::decompress_all(compressed.value());
+        EXPECT(decompressed.value().size() == data.size());
+    }
+}
+
 TEST_MAIN(Compress)
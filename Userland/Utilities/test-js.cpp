@@ -50,6 +50,9 @@
 RefPtr<JS::VM> vm;
 
 static bool collect_on_every_allocation = false;
+static bool generational_gc = false;
+static bool incremental_gc = false;
+static bool lazy_function_compilation = false;
 static String currently_running_test;
 
 struct ParserError {
@@ -157,14 +160,31 @@ JS_DEFINE_NATIVE_FUNCTION(TestRunnerGlobalObject::is_strict_mode)
     return JS::Value(vm.in_strict_mode());
 }
 
+// With lazy function compilation, most syntax errors in a function body are only reported once the function is
+// called. Parse all bodies, and the ones nested in them, the way a call would to see whether any of them fails.
+static bool can_parse_lazy_function_bodies(NonnullRefPtrVector<JS::LazyFunctionBody>& bodies)
+{
+    for (auto& body : bodies) {
+        auto parser = JS::Parser(body.lexer());
+        parser.parse_lazy_function_body(body);
+        if (parser.has_errors() || !can_parse_lazy_function_bodies(parser.lazy_function_bodies()))
+            return false;
+    }
+    return true;
+}
+
 JS_DEFINE_NATIVE_FUNCTION(TestRunnerGlobalObject::can_parse_source)
 {
     auto source = vm.argument(0).to_string(global_object);
     if (vm.exception())
         return {};
     auto parser = JS::Parser(JS::Lexer(source));
+    if (lazy_function_compilation)
+        parser.enable_lazy_function_compilation();
     parser.parse_program();
-    return JS::Value(!parser.has_errors());
+    if (parser.has_errors())
+        return JS::Value(false);
+    return JS::Value(can_parse_lazy_function_bodies(parser.lazy_function_bodies()));
 }
 
 static void cleanup_and_exit()
@@ -246,6 +266,8 @@ static Result<NonnullRefPtr<JS::Program>, ParserError> parse_file(const String&
     file->close();
 
     auto parser = JS::Parser(JS::Lexer(test_file_string));
+    if (lazy_function_compilation)
+        parser.enable_lazy_function_compilation();
     auto program = parser.parse_program();
 
     if (parser.has_errors()) {
@@ -279,6 +301,8 @@ JSFileResult TestRunner::run_file_test(const String& test_path)
     JS::VM::InterpreterExecutionScope scope(*interpreter);
 
     interpreter->heap().set_should_collect_on_every_allocation(collect_on_every_allocation);
+    interpreter->heap().set_generational(generational_gc);
+    interpreter->heap().set_incremental(incremental_gc);
 
     if (!m_test_program) {
         auto result = parse_file(String::formatted("{}/test-common.js", m_test_root));
@@ -715,6 +739,9 @@ int main(int argc, char** argv)
         },
     });
     args_parser.add_option(collect_on_every_allocation, "Collect garbage after every allocation", "collect-often", 'g');
+    args_parser.add_option(generational_gc, "Use generational garbage collection", "generational-gc", 'G');
+    args_parser.add_option(incremental_gc, "Use incremental garbage collection", "incremental-gc", 'I');
+    args_parser.add_option(lazy_function_compilation, "Parse function bodies when they are first called", "lazy-functions", 'L');
     args_parser.add_option(test262_parser_tests, "Run test262 parser tests", "test262-parser-tests", 0);
     args_parser.add_positional_argument(specified_test_root, "Tests root directory", "path", Core::ArgsParser::Required::No);
     args_parser.parse(argc, argv);